@@ -1,27 +1,111 @@
 #include "accelerator/Accelerator.hpp"
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <stdexcept>
 
 namespace pas::accelerator {
 
 Accelerator::Accelerator() = default;
 
+std::shared_ptr<Accelerator> Accelerator::clone() const {
+    auto copy = std::make_shared<Accelerator>();
+    copy->m_components.reserve(m_components.size());
+    std::unordered_map<const Component*, std::shared_ptr<Component>> clones;
+    for (const auto& component : m_components) {
+        auto& clone = clones[component.get()];
+        if (!clone) {
+            clone = component->clone();
+        }
+        copy->m_components.push_back(clone);
+    }
+    copy->m_nameIndex = m_nameIndex;
+    copy->m_latticeType = m_latticeType;
+    copy->m_totalLength = m_totalLength;
+    copy->m_driftCounter = m_driftCounter;
+    copy->m_referenceRigidity = m_referenceRigidity;
+    copy->m_compiled.build(copy->m_components, m_referenceRigidity);
+    return copy;
+}
+
 void Accelerator::addComponent(std::shared_ptr<Component> component) {
     if (component) {
+        m_nameIndex.try_emplace(component->getName(), m_components.size());
         m_components.push_back(std::move(component));
+        m_layoutChanged = true;
+    }
+}
+
+bool Accelerator::addLine(const Beamline& beamline, const std::string& line) {
+    m_components.reserve(m_components.size() + beamline.getElementCount(line));
+    return beamline.expand(line, [this](const Beamline::Occurrence& occurrence) {
+        const auto& element = occurrence.element;
+        if (element->observesCrossings()) {
+            addComponent(element->clone());
+        } else {
+            m_templates.insert(element.get());
+            addComponent(element);
+        }
+    });
+}
+
+std::shared_ptr<Component> Accelerator::makeUnique(size_t index) {
+    if (index >= m_components.size()) {
+        return nullptr;
     }
+    auto occurrences = static_cast<size_t>(
+        std::count(m_components.begin(), m_components.end(), m_components[index]));
+    return splitOff(index, occurrences);
+}
+
+void Accelerator::makeUnique(std::span<const size_t> indices) {
+    // One pass over the lattice instead of one per index
+    std::unordered_map<const Component*, size_t> occurrences;
+    for (const auto& component : m_components) {
+        ++occurrences[component.get()];
+    }
+    for (size_t index : indices) {
+        if (index < m_components.size()) {
+            splitOff(index, occurrences[m_components[index].get()]);
+        }
+    }
+}
+
+std::shared_ptr<Component> Accelerator::splitOff(size_t index, size_t& occurrences) {
+    auto& component = m_components[index];
+    if (occurrences > 1 || m_templates.count(component.get()) > 0) {
+        --occurrences;
+        component = component->clone();
+        m_layoutChanged = true;
+    }
+    return component;
 }
 
 void Accelerator::insertComponent(size_t index, std::shared_ptr<Component> component) {
     if (component && index <= m_components.size()) {
         m_components.insert(m_components.begin() + static_cast<ptrdiff_t>(index),
                             std::move(component));
+        m_layoutChanged = true;
+        rebuildNameIndex();
+    }
+}
+
+void Accelerator::replaceComponent(size_t index, std::shared_ptr<Component> component) {
+    if (component && index < m_components.size()) {
+        const bool renamed = component->getName() != m_components[index]->getName();
+        m_components[index] = std::move(component);
+        m_layoutChanged = true;
+        if (renamed) {
+            rebuildNameIndex();
+        }
     }
 }
 
 void Accelerator::removeComponent(size_t index) {
     if (index < m_components.size()) {
         m_components.erase(m_components.begin() + static_cast<ptrdiff_t>(index));
+        m_layoutChanged = true;
+        rebuildNameIndex();
     }
 }
 
@@ -31,12 +115,17 @@ void Accelerator::removeComponent(const std::string& name) {
                        [&name](const auto& c) { return c->getName() == name; }),
         m_components.end()
     );
+    m_layoutChanged = true;
+    rebuildNameIndex();
 }
 
 void Accelerator::clear() {
     m_components.clear();
+    m_nameIndex.clear();
+    m_templates.clear();
     m_totalLength = 0.0;
     m_driftCounter = 0;
+    m_layoutChanged = true;
 }
 
 std::shared_ptr<Component> Accelerator::getComponent(size_t index) const {
@@ -47,27 +136,42 @@ std::shared_ptr<Component> Accelerator::getComponent(size_t index) const {
 }
 
 std::shared_ptr<Component> Accelerator::getComponent(const std::string& name) const {
-    auto it = std::find_if(m_components.begin(), m_components.end(),
-                           [&name](const auto& c) { return c->getName() == name; });
-    if (it != m_components.end()) {
-        return *it;
+    auto it = m_nameIndex.find(name);
+    if (it != m_nameIndex.end()) {
+        return m_components[it->second];
     }
     return nullptr;
 }
 
+double Accelerator::getSPosition(size_t index) const {
+    if (index >= m_components.size()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return layout().getSStarts()[index];
+}
+
 std::shared_ptr<Component> Accelerator::getComponentAtS(double s) const {
+    if (auto index = findComponentIndexAtS(s)) {
+        return m_components[*index];
+    }
+    return nullptr;
+}
+
+std::optional<size_t> Accelerator::findComponentIndexAtS(double s) const {
+    return layout().findIndexAtS(wrapS(s));
+}
+
+std::optional<size_t> Accelerator::findComponentIndexAtS(double s, size_t& cursor) const {
+    return layout().findIndexAtS(wrapS(s), cursor);
+}
+
+double Accelerator::wrapS(double s) const {
     // Handle circular case
     if (m_latticeType == LatticeType::Circular && m_totalLength > 0) {
         s = std::fmod(s, m_totalLength);
         if (s < 0) s += m_totalLength;
     }
-
-    for (const auto& component : m_components) {
-        if (component->containsS(s)) {
-            return component;
-        }
-    }
-    return nullptr;
+    return s;
 }
 
 void Accelerator::buildFODOCell(const FODOCellParams& params,
@@ -112,11 +216,28 @@ void Accelerator::buildFODOCell(const FODOCellParams& params,
     addDrift(driftLength, cellName + "_D2");
 }
 
-void Accelerator::buildFODOLattice(const FODOCellParams& params, size_t numCells) {
-    for (size_t i = 0; i < numCells; ++i) {
-        std::string cellName = "FODO_" + std::to_string(i + 1);
-        buildFODOCell(params, cellName);
+void Accelerator::buildFODOLattice(const FODOCellParams& params, size_t numCells, bool shareCells) {
+    if (!shareCells) {
+        for (size_t i = 0; i < numCells; ++i) {
+            std::string cellName = "FODO_" + std::to_string(i + 1);
+            buildFODOCell(params, cellName);
+        }
+        return;
+    }
+
+    // One cell template, repeated
+    Accelerator cell;
+    cell.buildFODOCell(params, "FODO");
+
+    Beamline beamline;
+    std::vector<Beamline::Item> items;
+    for (const auto& component : cell.getComponents()) {
+        beamline.defineElement(component);
+        items.push_back({component->getName()});
     }
+    beamline.defineLine("FODO_CELL", items);
+    beamline.defineLine("FODO_CELLS", {{"FODO_CELL", numCells}});
+    addLine(beamline, "FODO_CELLS");
 }
 
 void Accelerator::addDrift(double length, const std::string& name) {
@@ -130,11 +251,41 @@ void Accelerator::addDrift(double length, const std::string& name) {
 
 void Accelerator::computeLattice() {
     updateSPositions();
+    m_compiled.build(m_components, m_referenceRigidity);
+    m_layoutChanged = false;
 }
 
 void Accelerator::closeRing() {
     m_latticeType = LatticeType::Circular;
     updateSPositions();
+    m_compiled.build(m_components, m_referenceRigidity);
+    m_layoutChanged = false;
+}
+
+void Accelerator::setReferenceRigidity(double rigidity) {
+    m_referenceRigidity = rigidity;
+    m_compiled.build(m_components, m_referenceRigidity);
+    m_layoutChanged = false;
+}
+
+const CompiledLattice& Accelerator::getCompiledLattice() const {
+    if (!m_compiled.refresh(m_components)) {
+        m_compiled.build(m_components, m_referenceRigidity);
+    }
+    m_layoutChanged = false;
+    return m_compiled;
+}
+
+const CompiledLattice& Accelerator::layout() const {
+    // s-starts only move with the component list, so strength edits need no scan
+    return m_layoutChanged ? getCompiledLattice() : m_compiled;
+}
+
+void Accelerator::rebuildNameIndex() {
+    m_nameIndex.clear();
+    for (size_t i = 0; i < m_components.size(); ++i) {
+        m_nameIndex.try_emplace(m_components[i]->getName(), i);
+    }
 }
 
 void Accelerator::updateSPositions() {
@@ -147,10 +298,13 @@ void Accelerator::updateSPositions() {
 }
 
 void Accelerator::populateFieldManager(physics::EMFieldManager& manager) const {
-    for (const auto& component : m_components) {
-        auto field = component->getFieldSource();
+    const CompiledLattice& lattice = getCompiledLattice();
+    for (size_t i = 0; i < m_components.size(); ++i) {
+        auto field = m_components[i]->getFieldSource();
         if (field) {
-            manager.addSource(field);
+            const Placement frame = lattice.getCenterFrame(i);
+            manager.addSource(std::make_shared<physics::PlacedField>(std::move(field), frame.origin,
+                                                                     frame.rotation));
         }
     }
 }
@@ -175,6 +329,16 @@ std::vector<std::shared_ptr<Quadrupole>> Accelerator::getQuadrupoles() const {
     return quads;
 }
 
+std::vector<std::shared_ptr<Sextupole>> Accelerator::getSextupoles() const {
+    std::vector<std::shared_ptr<Sextupole>> sextupoles;
+    for (const auto& component : m_components) {
+        if (component->getType() == ComponentType::Sextupole) {
+            sextupoles.push_back(std::dynamic_pointer_cast<Sextupole>(component));
+        }
+    }
+    return sextupoles;
+}
+
 std::vector<std::shared_ptr<RFCavity>> Accelerator::getRFCavities() const {
     std::vector<std::shared_ptr<RFCavity>> cavities;
     for (const auto& component : m_components) {
@@ -185,6 +349,26 @@ std::vector<std::shared_ptr<RFCavity>> Accelerator::getRFCavities() const {
     return cavities;
 }
 
+std::vector<std::shared_ptr<Detector>> Accelerator::getDetectors() const {
+    std::vector<std::shared_ptr<Detector>> detectors;
+    for (const auto& component : m_components) {
+        if (component->getType() == ComponentType::Detector) {
+            detectors.push_back(std::dynamic_pointer_cast<Detector>(component));
+        }
+    }
+    return detectors;
+}
+
+std::vector<std::shared_ptr<BeamPositionMonitor>> Accelerator::getMonitors() const {
+    std::vector<std::shared_ptr<BeamPositionMonitor>> monitors;
+    for (const auto& component : m_components) {
+        if (component->getType() == ComponentType::Monitor) {
+            monitors.push_back(std::dynamic_pointer_cast<BeamPositionMonitor>(component));
+        }
+    }
+    return monitors;
+}
+
 size_t Accelerator::getDipoleCount() const {
     return std::count_if(m_components.begin(), m_components.end(),
                          [](const auto& c) { return c->getType() == ComponentType::Dipole; });
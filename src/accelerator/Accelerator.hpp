@@ -1,10 +1,17 @@
 #pragma once
 
 #include "accelerator/Component.hpp"
+#include "accelerator/Beamline.hpp"
+#include "accelerator/BeamPositionMonitor.hpp"
+#include "accelerator/CompiledLattice.hpp"
 #include "physics/EMField.hpp"
 #include <vector>
 #include <memory>
 #include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace pas::accelerator {
 
@@ -37,6 +44,15 @@ class Accelerator {
 public:
     Accelerator();
 
+    /**
+     * @brief Deep copy of the lattice with cloned components.
+     *
+     * Changing a component of the copy leaves this lattice untouched, so
+     * copies can be modified and analysed on separate threads. Components
+     * shared by several places are cloned once and stay shared.
+     */
+    std::shared_ptr<Accelerator> clone() const;
+
     /**
      * @brief Set the lattice type.
      */
@@ -48,11 +64,42 @@ public:
      */
     void addComponent(std::shared_ptr<Component> component);
 
+    /**
+     * @brief Append the expansion of a beamline line.
+     *
+     * Occurrences of an element share its template, so a ring of identical
+     * cells holds one object (and one field source) per unique element.
+     * Components that record crossings are cloned per occurrence.
+     * @return False if the line is not defined.
+     */
+    bool addLine(const Beamline& beamline, const std::string& line);
+
+    /**
+     * @brief Give the component at an index its own copy if it is shared.
+     *
+     * Shared means placed more than once in this lattice, or taken from a
+     * Beamline template by addLine(). Use before editing one occurrence.
+     * @return The component now at the index; nullptr if out of range.
+     */
+    std::shared_ptr<Component> makeUnique(size_t index);
+
+    /**
+     * @brief makeUnique() for several indices, counting occurrences once.
+     *
+     * Out-of-range indices are skipped.
+     */
+    void makeUnique(std::span<const size_t> indices);
+
     /**
      * @brief Insert a component at a specific index.
      */
     void insertComponent(size_t index, std::shared_ptr<Component> component);
 
+    /**
+     * @brief Replace the component at an index, keeping its place in the lattice.
+     */
+    void replaceComponent(size_t index, std::shared_ptr<Component> component);
+
     /**
      * @brief Remove a component by index.
      */
@@ -80,6 +127,8 @@ public:
 
     /**
      * @brief Get a component by name.
+     *
+     * Hash lookup; with duplicate names the first component is returned.
      */
     std::shared_ptr<Component> getComponent(const std::string& name) const;
 
@@ -90,11 +139,41 @@ public:
         return m_components;
     }
 
+    /**
+     * @brief s-position of the occurrence at an index.
+     *
+     * Taken from the compiled lattice, so edits to the component list are
+     * picked up without computeLattice(); only the first call after an edit
+     * scans the components. NaN if the index is out of range. Loops over all
+     * entries should read CompiledLattice::getSStarts() instead.
+     */
+    double getSPosition(size_t index) const;
+
     /**
      * @brief Find the component at a given s-position.
      */
     std::shared_ptr<Component> getComponentAtS(double s) const;
 
+    /**
+     * @brief Find the index of the component at a given s-position.
+     *
+     * Binary search over the compiled lattice's s-positions, which follow
+     * edits to the component list.
+     * @return Component index, or std::nullopt if s is outside the lattice.
+     */
+    std::optional<size_t> findComponentIndexAtS(double s) const;
+
+    /**
+     * @brief Find the component index starting from a per-particle cursor.
+     *
+     * Amortised O(1) for particles moving forward in s. The first lookup after
+     * an edit to the component list refreshes the compiled lattice, so it is
+     * not thread-safe; parallel kernels use CompiledLattice::findIndexAtS()
+     * on a lattice fetched beforehand.
+     * @see CompiledLattice::findIndexAtS()
+     */
+    std::optional<size_t> findComponentIndexAtS(double s, size_t& cursor) const;
+
     // Lattice construction helpers
 
     /**
@@ -111,8 +190,15 @@ public:
 
     /**
      * @brief Build multiple FODO cells.
+     *
+     * Each cell has its own components, named per cell (FODO_1_QF,
+     * FODO_2_QF, ...). With shareCells, every cell instead repeats one set
+     * of components named after the template (FODO_QF, FODO_D1, FODO_QD,
+     * FODO_D2), sharing field sources and maps: a name then finds the first
+     * cell only, and editing a shared magnet retunes every cell (see
+     * makeUnique()).
      */
-    void buildFODOLattice(const FODOCellParams& params, size_t numCells);
+    void buildFODOLattice(const FODOCellParams& params, size_t numCells, bool shareCells = false);
 
     /**
      * @brief Add a drift section.
@@ -123,6 +209,7 @@ public:
      * @brief Compute the lattice (calculate s-positions).
      *
      * Should be called after adding all components and before simulation.
+     * Also rebuilds the compiled lattice.
      */
     void computeLattice();
 
@@ -150,12 +237,37 @@ public:
      */
     bool isClosed() const { return m_latticeType == LatticeType::Circular; }
 
+    /**
+     * @brief Set the magnetic rigidity B rho of the reference particle [T m].
+     *
+     * Dipoles bend the surveyed reference orbit by B * L / (B rho); the
+     * default 0 lays the lattice out straight along z. Resurveys the lattice.
+     */
+    void setReferenceRigidity(double rigidity);
+    double getReferenceRigidity() const { return m_referenceRigidity; }
+
+    /**
+     * @brief Wrap s into [0, total length) on circular lattices.
+     */
+    double wrapS(double s) const;
+
+    /**
+     * @brief Flat arrays of the lattice for tracking and loss kernels.
+     *
+     * Strength changes are picked up on access, and changed bends resurvey
+     * the frames downstream of them. Alignment, aperture and layout changes
+     * take effect after computeLattice(). Not thread-safe; call it from the
+     * controlling thread before fanning out.
+     */
+    const CompiledLattice& getCompiledLattice() const;
+
     // Field integration
 
     /**
      * @brief Populate the field manager with all component fields.
      *
-     * Call this to register all fields with the physics engine.
+     * Each occurrence is registered at its surveyed place, so shared
+     * components contribute one field per place.
      */
     void populateFieldManager(physics::EMFieldManager& manager) const;
 
@@ -169,11 +281,26 @@ public:
      */
     std::vector<std::shared_ptr<Quadrupole>> getQuadrupoles() const;
 
+    /**
+     * @brief Get all sextupoles in the lattice.
+     */
+    std::vector<std::shared_ptr<Sextupole>> getSextupoles() const;
+
     /**
      * @brief Get all RF cavities in the lattice.
      */
     std::vector<std::shared_ptr<RFCavity>> getRFCavities() const;
 
+    /**
+     * @brief Get all detectors in the lattice.
+     */
+    std::vector<std::shared_ptr<Detector>> getDetectors() const;
+
+    /**
+     * @brief Get all beam position monitors in the lattice.
+     */
+    std::vector<std::shared_ptr<BeamPositionMonitor>> getMonitors() const;
+
     // Statistics
 
     /**
@@ -193,11 +320,19 @@ public:
 
 private:
     void updateSPositions();
+    void rebuildNameIndex();
+    const CompiledLattice& layout() const;
+    std::shared_ptr<Component> splitOff(size_t index, size_t& occurrences);
 
     std::vector<std::shared_ptr<Component>> m_components;
+    std::unordered_map<std::string, size_t> m_nameIndex;
+    std::unordered_set<const Component*> m_templates;  // Placed by addLine(), owned by a Beamline
     LatticeType m_latticeType = LatticeType::Linear;
     double m_totalLength = 0.0;
     size_t m_driftCounter = 0;
+    double m_referenceRigidity = 0.0;
+    mutable CompiledLattice m_compiled;
+    mutable bool m_layoutChanged = false;  // Component list edited since m_compiled was built
 };
 
 } // namespace pas::accelerator
@@ -0,0 +1,483 @@
+#include "accelerator/BeamPositionMonitor.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+namespace pas::accelerator {
+
+namespace {
+
+constexpr char BPM_MAGIC[8] = {'P', 'A', 'S', 'B', 'P', 'M', '0', '1'};
+constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+// A writer that died mid-slot must not hang readers of a mapped file
+constexpr int MAX_READ_ATTEMPTS = 1000;
+
+// Slot contents are accessed atomically so a reader racing a rewrite is well defined
+template <typename T>
+T loadRelaxed(const T& value) {
+    return std::atomic_ref<T>(const_cast<T&>(value)).load(std::memory_order_relaxed);
+}
+
+template <typename T>
+void storeRelaxed(T& value, T newValue) {
+    std::atomic_ref<T>(value).store(newValue, std::memory_order_relaxed);
+}
+
+} // namespace
+
+// BPMBuffer implementation
+
+size_t BPMBuffer::storageSize(size_t capacity, size_t trackedCount) {
+    return sizeof(Header) + capacity * sizeof(Record) + capacity * trackedCount * 2 * sizeof(double);
+}
+
+void BPMBuffer::allocate(size_t capacity, size_t trackedCount) {
+    m_file.close();
+    capacity = std::max<size_t>(capacity, 1);
+    size_t bytes = storageSize(capacity, trackedCount);
+    m_memory.assign((bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+    m_base = reinterpret_cast<std::byte*>(m_memory.data());
+    initialize(capacity, trackedCount);
+}
+
+bool BPMBuffer::createFile(const std::string& filepath, size_t capacity, size_t trackedCount) {
+    capacity = std::max<size_t>(capacity, 1);
+    if (!m_file.create(filepath, storageSize(capacity, trackedCount))) {
+        return false;
+    }
+    m_memory.clear();
+    m_memory.shrink_to_fit();
+    m_base = m_file.data();
+    initialize(capacity, trackedCount);
+    return true;
+}
+
+bool BPMBuffer::openFile(const std::string& filepath) {
+    m_base = nullptr;
+    m_memory.clear();
+    if (!m_file.openReadOnly(filepath)) {
+        return false;
+    }
+
+    const auto* h = reinterpret_cast<const Header*>(m_file.data());
+    if (m_file.size() < sizeof(Header) || std::memcmp(h->magic, BPM_MAGIC, sizeof(BPM_MAGIC)) != 0 ||
+        m_file.size() < storageSize(h->capacity, h->trackedCount)) {
+        PAS_ERROR("BPMBuffer: {} is not a valid BPM file", filepath);
+        m_file.close();
+        return false;
+    }
+
+    m_base = m_file.data();
+    return true;
+}
+
+void BPMBuffer::initialize(size_t capacity, size_t trackedCount) {
+    Header* h = header();
+    std::memcpy(h->magic, BPM_MAGIC, sizeof(BPM_MAGIC));
+    h->capacity = capacity;
+    h->trackedCount = trackedCount;
+    h->turnCount = 0;
+
+    // No turn is valid until written
+    Record* r = records();
+    for (size_t i = 0; i < capacity; ++i) {
+        r[i] = Record{};
+        r[i].turn = std::numeric_limits<uint64_t>::max();
+    }
+    std::fill(particles(), particles() + capacity * trackedCount * 2, NaN);
+}
+
+size_t BPMBuffer::getCapacity() const {
+    return isValid() ? static_cast<size_t>(header()->capacity) : 0;
+}
+
+size_t BPMBuffer::getTrackedCount() const {
+    return isValid() ? static_cast<size_t>(header()->trackedCount) : 0;
+}
+
+uint64_t BPMBuffer::getTurnCount() const {
+    if (!isValid()) {
+        return 0;
+    }
+    auto& count = const_cast<uint64_t&>(header()->turnCount);
+    return std::atomic_ref<uint64_t>(count).load(std::memory_order_acquire);
+}
+
+const double* BPMBuffer::particles() const {
+    return reinterpret_cast<const double*>(m_base + sizeof(Header) + getCapacity() * sizeof(Record));
+}
+
+double* BPMBuffer::particles() {
+    return reinterpret_cast<double*>(m_base + sizeof(Header) + getCapacity() * sizeof(Record));
+}
+
+std::optional<BPMBuffer::TurnData> BPMBuffer::getTurn(uint64_t turn) const {
+    if (!isValid() || turn >= getTurnCount()) {
+        return std::nullopt;
+    }
+
+    const Record& r = records()[turn % getCapacity()];
+    auto& sequence = const_cast<uint64_t&>(r.sequence);
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+        const uint64_t before = std::atomic_ref<uint64_t>(sequence).load(std::memory_order_acquire);
+        if (before % 2 != 0) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        TurnData data{loadRelaxed(r.turn),    loadRelaxed(r.count),   loadRelaxed(r.meanX),
+                      loadRelaxed(r.meanY),   loadRelaxed(r.sigmaXX), loadRelaxed(r.sigmaYY),
+                      loadRelaxed(r.sigmaXY)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (std::atomic_ref<uint64_t>(sequence).load(std::memory_order_relaxed) != before) {
+            continue;  // Rewritten while copying
+        }
+        if (data.turn != turn) {
+            return std::nullopt;  // Overwritten by a later turn
+        }
+        return data;
+    }
+    return std::nullopt;
+}
+
+double BPMBuffer::getParticleCoordinate(uint64_t turn, size_t trackedIndex,
+                                        TransversePlane plane) const {
+    if (!isValid() || turn >= getTurnCount() || trackedIndex >= getTrackedCount()) {
+        return NaN;
+    }
+
+    size_t slot = static_cast<size_t>(turn % getCapacity());
+    size_t offset = (slot * getTrackedCount() + trackedIndex) * 2;
+    const double& coordinate = particles()[offset + (plane == TransversePlane::Horizontal ? 0 : 1)];
+    const Record& r = records()[slot];
+    auto& sequence = const_cast<uint64_t&>(r.sequence);
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+        const uint64_t before = std::atomic_ref<uint64_t>(sequence).load(std::memory_order_acquire);
+        if (before % 2 != 0) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const uint64_t recordTurn = loadRelaxed(r.turn);
+        const double value = loadRelaxed(coordinate);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (std::atomic_ref<uint64_t>(sequence).load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+        return recordTurn == turn ? value : NaN;
+    }
+    return NaN;
+}
+
+std::vector<uint64_t> BPMBuffer::retainedTurns() const {
+    std::vector<uint64_t> turns;
+    uint64_t count = getTurnCount();
+    uint64_t first = count > getCapacity() ? count - getCapacity() : 0;
+    turns.reserve(static_cast<size_t>(count - first));
+    for (uint64_t t = first; t < count; ++t) {
+        turns.push_back(t);
+    }
+    return turns;
+}
+
+std::vector<double> BPMBuffer::getCentroidSeries(TransversePlane plane) const {
+    std::vector<double> series;
+    for (uint64_t turn : retainedTurns()) {
+        auto data = getTurn(turn);
+        if (!data) continue;
+        series.push_back(plane == TransversePlane::Horizontal ? data->meanX : data->meanY);
+    }
+    return series;
+}
+
+std::vector<double> BPMBuffer::getParticleSeries(size_t trackedIndex, TransversePlane plane) const {
+    std::vector<double> series;
+    for (uint64_t turn : retainedTurns()) {
+        series.push_back(getParticleCoordinate(turn, trackedIndex, plane));
+    }
+    return series;
+}
+
+void BPMBuffer::beginWrite(size_t slot) {
+    std::atomic_ref<uint64_t> sequence(records()[slot].sequence);
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void BPMBuffer::endWrite(size_t slot) {
+    std::atomic_ref<uint64_t> sequence(records()[slot].sequence);
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void BPMBuffer::writeTurn(const TurnData& data) {
+    const size_t slot = static_cast<size_t>(data.turn % getCapacity());
+    Record& r = records()[slot];
+    beginWrite(slot);
+    if (r.turn != data.turn) {
+        // The particle row goes with the turn it replaces
+        double* row = particles() + slot * getTrackedCount() * 2;
+        for (size_t i = 0; i < getTrackedCount() * 2; ++i) {
+            storeRelaxed(row[i], NaN);
+        }
+    }
+    storeRelaxed(r.turn, data.turn);
+    storeRelaxed(r.count, data.count);
+    storeRelaxed(r.meanX, data.meanX);
+    storeRelaxed(r.meanY, data.meanY);
+    storeRelaxed(r.sigmaXX, data.sigmaXX);
+    storeRelaxed(r.sigmaYY, data.sigmaYY);
+    storeRelaxed(r.sigmaXY, data.sigmaXY);
+    endWrite(slot);
+
+    // Single writer, so a plain read of the current count is enough
+    const uint64_t count = std::max(header()->turnCount, data.turn + 1);
+    std::atomic_ref<uint64_t>(header()->turnCount).store(count, std::memory_order_release);
+}
+
+void BPMBuffer::setParticleCoordinates(uint64_t turn, size_t trackedIndex, double x, double y) {
+    size_t slot = static_cast<size_t>(turn % getCapacity());
+    size_t offset = (slot * getTrackedCount() + trackedIndex) * 2;
+    beginWrite(slot);
+    storeRelaxed(particles()[offset], x);
+    storeRelaxed(particles()[offset + 1], y);
+    endWrite(slot);
+}
+
+// BeamPositionMonitor implementation
+
+void BeamPositionMonitor::TurnMoments::add(double x, double y) {
+    count++;
+    const double n = static_cast<double>(count);
+    const double dx = x - meanX;
+    const double dy = y - meanY;
+    meanX += dx / n;
+    meanY += dy / n;
+    m2X += dx * (x - meanX);
+    m2Y += dy * (y - meanY);
+    cXY += dx * (y - meanY);
+}
+
+void BeamPositionMonitor::TurnMoments::merge(const TurnMoments& other) {
+    if (other.count == 0) {
+        return;
+    }
+    const double na = static_cast<double>(count);
+    const double nb = static_cast<double>(other.count);
+    const double n = na + nb;
+    const double dx = other.meanX - meanX;
+    const double dy = other.meanY - meanY;
+
+    count += other.count;
+    meanX += dx * nb / n;
+    meanY += dy * nb / n;
+    m2X += other.m2X + dx * dx * na * nb / n;
+    m2Y += other.m2Y + dy * dy * na * nb / n;
+    cXY += other.cXY + dx * dy * na * nb / n;
+}
+
+BeamPositionMonitor::BeamPositionMonitor(const std::string& name, size_t capacity,
+                                         const Aperture& aperture)
+    : Component(name, 0.001, aperture)  // Thin monitor
+    , m_capacity(std::max<size_t>(capacity, 1)) {
+    m_buffer.allocate(m_capacity, 0);
+    prepareCrossings(utils::getMaxThreads());
+}
+
+std::shared_ptr<Component> BeamPositionMonitor::clone() const {
+    auto copy = std::make_shared<BeamPositionMonitor>(m_name, m_capacity, m_aperture);
+    copy->copyPlacement(*this);
+    if (!m_trackedIds.empty()) {
+        copy->setTrackedParticles(m_trackedIds);
+    }
+    return copy;
+}
+
+void BeamPositionMonitor::setTrackedParticles(std::vector<uint64_t> particleIds) {
+    std::sort(particleIds.begin(), particleIds.end());
+    particleIds.erase(std::unique(particleIds.begin(), particleIds.end()), particleIds.end());
+    m_trackedIds = std::move(particleIds);
+    reset();
+}
+
+bool BeamPositionMonitor::mapToFile(const std::string& filepath) {
+    if (!m_buffer.createFile(filepath, m_capacity, m_trackedIds.size())) {
+        PAS_ERROR("BeamPositionMonitor {}: Could not map {}", m_name, filepath);
+        return false;
+    }
+    m_mappedPath = filepath;
+    m_openTurns.clear();
+    m_pendingSamples.clear();
+    m_latestTurn.reset();
+    m_droppedCrossings = 0;
+    return true;
+}
+
+void BeamPositionMonitor::reset() {
+    if (!m_mappedPath.empty()) {
+        m_buffer.createFile(m_mappedPath, m_capacity, m_trackedIds.size());
+    } else {
+        m_buffer.allocate(m_capacity, m_trackedIds.size());
+    }
+
+    for (auto& state : m_threadStates) {
+        state.moments.clear();
+        state.samples.clear();
+    }
+    m_openTurns.clear();
+    m_pendingSamples.clear();
+    m_latestTurn.reset();
+    m_droppedCrossings = 0;
+}
+
+void BeamPositionMonitor::prepareCrossings(int threadCount) {
+    size_t count = static_cast<size_t>(std::max(threadCount, 1));
+    if (m_threadStates.size() < count) {
+        m_threadStates.resize(count);
+    }
+}
+
+void BeamPositionMonitor::recordCrossing(const PlaneCrossing& crossing) {
+    const double x = crossing.x;
+    const double y = crossing.y;
+    if (!m_aperture.isInside(x, y)) {
+        return;
+    }
+
+    ThreadState& state = m_threadStates[static_cast<size_t>(utils::getThreadIndex())];
+
+    // Usually only one turn is in flight per step, so a linear search is enough
+    auto it = std::find_if(state.moments.begin(), state.moments.end(),
+                           [&crossing](const TurnMoments& m) { return m.turn == crossing.turn; });
+    if (it == state.moments.end()) {
+        state.moments.push_back(TurnMoments{crossing.turn});
+        it = state.moments.end() - 1;
+    }
+    it->add(x, y);
+
+    auto tracked = std::lower_bound(m_trackedIds.begin(), m_trackedIds.end(), crossing.particleId);
+    if (tracked != m_trackedIds.end() && *tracked == crossing.particleId) {
+        size_t index = static_cast<size_t>(tracked - m_trackedIds.begin());
+        state.samples.push_back({crossing.turn, index, x, y});
+    }
+}
+
+void BeamPositionMonitor::commitCrossings() {
+    // Merge per-thread moments into the open turns
+    for (auto& state : m_threadStates) {
+        for (const TurnMoments& moments : state.moments) {
+            auto [it, inserted] = m_openTurns.try_emplace(moments.turn, TurnMoments{moments.turn});
+            it->second.merge(moments);
+        }
+        state.moments.clear();
+    }
+
+    if (m_openTurns.empty()) {
+        return;
+    }
+
+    uint64_t newest = m_openTurns.rbegin()->first;
+    if (!m_latestTurn || newest > *m_latestTurn) {
+        m_latestTurn = newest;
+    }
+
+    // Open turns still share their slot with a retained turn, so their samples
+    // wait for the record; a late sample must not land in a row reused since
+    const uint64_t written = m_buffer.getTurnCount();
+    for (auto& state : m_threadStates) {
+        for (const TrackedSample& sample : state.samples) {
+            if (sample.turn >= written) {
+                m_pendingSamples.push_back(sample);
+            } else if (sample.turn + m_capacity >= written) {
+                m_buffer.setParticleCoordinates(sample.turn, sample.index, sample.x, sample.y);
+            }
+        }
+        state.samples.clear();
+    }
+
+    // A turn is complete once any particle has reached the next one
+    completeTurnsBefore(newest);
+}
+
+void BeamPositionMonitor::flush() {
+    if (m_latestTurn) {
+        completeTurnsBefore(*m_latestTurn + 1);
+    }
+    m_buffer.flush();
+}
+
+void BeamPositionMonitor::completeTurnsBefore(uint64_t turn) {
+    while (!m_openTurns.empty() && m_openTurns.begin()->first < turn) {
+        const TurnMoments& moments = m_openTurns.begin()->second;
+        const uint64_t written = m_buffer.getTurnCount();
+
+        if (moments.turn < written) {
+            foldLateTurn(moments);
+        } else {
+            // Turns nobody crossed get empty records so every slot stays in sequence;
+            // only the ones the ring still holds once this turn is written
+            uint64_t skipped = written;
+            if (moments.turn - skipped >= m_capacity) {
+                skipped = moments.turn - m_capacity + 1;
+            }
+            for (; skipped < moments.turn; ++skipped) {
+                writeTurn(TurnMoments{skipped});
+            }
+            writeTurn(moments);
+
+            auto samples = std::partition(m_pendingSamples.begin(), m_pendingSamples.end(),
+                                          [&moments](const TrackedSample& sample) {
+                                              return sample.turn != moments.turn;
+                                          });
+            for (auto it = samples; it != m_pendingSamples.end(); ++it) {
+                m_buffer.setParticleCoordinates(it->turn, it->index, it->x, it->y);
+            }
+            m_pendingSamples.erase(samples, m_pendingSamples.end());
+        }
+        m_openTurns.erase(m_openTurns.begin());
+    }
+}
+
+void BeamPositionMonitor::foldLateTurn(const TurnMoments& moments) {
+    auto existing = m_buffer.getTurn(moments.turn);
+    if (!existing) {
+        m_droppedCrossings += moments.count;
+        PAS_WARN("BeamPositionMonitor {}: Dropped {} crossings of overwritten turn {}", m_name,
+                 moments.count, moments.turn);
+        return;
+    }
+
+    // Recover the moments from the stored record and add the stragglers
+    TurnMoments merged{moments.turn};
+    const double n = static_cast<double>(existing->count);
+    merged.count = existing->count;
+    merged.meanX = existing->meanX;
+    merged.meanY = existing->meanY;
+    merged.m2X = n * existing->sigmaXX;
+    merged.m2Y = n * existing->sigmaYY;
+    merged.cXY = n * existing->sigmaXY;
+    merged.merge(moments);
+    writeTurn(merged);
+}
+
+void BeamPositionMonitor::writeTurn(const TurnMoments& moments) {
+    TurnData data;
+    data.turn = moments.turn;
+    data.count = moments.count;
+    if (moments.count > 0) {
+        double n = static_cast<double>(moments.count);
+        data.meanX = moments.meanX;
+        data.meanY = moments.meanY;
+        data.sigmaXX = moments.m2X / n;
+        data.sigmaYY = moments.m2Y / n;
+        data.sigmaXY = moments.cXY / n;
+    }
+    m_buffer.writeTurn(data);
+}
+
+} // namespace pas::accelerator
@@ -0,0 +1,284 @@
+#pragma once
+
+#include "accelerator/Component.hpp"
+#include "utils/MappedFile.hpp"
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pas::accelerator {
+
+/**
+ * @brief Transverse plane selector.
+ */
+enum class TransversePlane {
+    Horizontal,
+    Vertical
+};
+
+/**
+ * @brief Fixed-capacity ring buffer of turn-by-turn BPM data.
+ *
+ * Storage is either in memory or a memory-mapped file. The file layout is
+ * plain and versioned so external tools can map it while a run is going:
+ *
+ *   Header     64 bytes (magic "PASBPM01", capacity, tracked count, turn count)
+ *   Records    capacity x 64 bytes, turn t stored in slot t % capacity
+ *   Particles  capacity x trackedCount x {x, y} doubles, NaN if not seen
+ *
+ * The turn count only grows and is published with release ordering after
+ * each record is written. A slot can still be rewritten in place, when the
+ * ring wraps or a late crossing is folded into its turn, so every record
+ * carries a sequence number that is odd while its slot (record and particle
+ * row) is being written. Readers retry until they see the same even value
+ * before and after copying.
+ */
+class BPMBuffer {
+public:
+    /**
+     * @brief Centroid and second moments for one turn.
+     */
+    struct TurnData {
+        uint64_t turn = 0;
+        uint64_t count = 0;         // Particles seen
+        double meanX = 0.0;         // m
+        double meanY = 0.0;         // m
+        double sigmaXX = 0.0;       // <(x - <x>)^2> [m^2]
+        double sigmaYY = 0.0;       // <(y - <y>)^2> [m^2]
+        double sigmaXY = 0.0;       // <(x - <x>)(y - <y>)> [m^2]
+    };
+
+    BPMBuffer() = default;
+
+    /**
+     * @brief Allocate in-memory storage (clears existing data).
+     */
+    void allocate(size_t capacity, size_t trackedCount);
+
+    /**
+     * @brief Create a memory-mapped file as storage (clears existing data).
+     */
+    bool createFile(const std::string& filepath, size_t capacity, size_t trackedCount);
+
+    /**
+     * @brief Open a BPM file read-only, e.g. from an analysis tool.
+     */
+    bool openFile(const std::string& filepath);
+
+    bool isValid() const { return m_base != nullptr; }
+    bool isMapped() const { return m_file.isOpen(); }
+    size_t getCapacity() const;
+    size_t getTrackedCount() const;
+
+    /**
+     * @brief Number of completed turns written (including overwritten ones).
+     */
+    uint64_t getTurnCount() const;
+
+    /**
+     * @brief Get data for a turn, or std::nullopt if not written or overwritten.
+     */
+    std::optional<TurnData> getTurn(uint64_t turn) const;
+
+    /**
+     * @brief Get a tracked particle's coordinate at a turn (NaN if unavailable).
+     */
+    double getParticleCoordinate(uint64_t turn, size_t trackedIndex, TransversePlane plane) const;
+
+    /**
+     * @brief Centroid of the retained turns, oldest first.
+     */
+    std::vector<double> getCentroidSeries(TransversePlane plane) const;
+
+    /**
+     * @brief Coordinates of one tracked particle for the retained turns, oldest first.
+     */
+    std::vector<double> getParticleSeries(size_t trackedIndex, TransversePlane plane) const;
+
+    // Writer interface
+
+    /**
+     * @brief Store a completed turn and publish it.
+     *
+     * Rewriting an earlier turn updates its record without moving the turn
+     * count back. A turn that replaces another in its slot starts with a
+     * NaN particle row.
+     */
+    void writeTurn(const TurnData& data);
+
+    /**
+     * @brief Store a tracked particle's coordinates for a turn.
+     */
+    void setParticleCoordinates(uint64_t turn, size_t trackedIndex, double x, double y);
+
+    /**
+     * @brief Flush mapped storage to disk.
+     */
+    void flush() { m_file.flush(); }
+
+private:
+    struct Header {
+        char magic[8];
+        uint64_t capacity;
+        uint64_t trackedCount;
+        uint64_t turnCount;
+        uint64_t reserved[4];
+    };
+
+    struct Record {
+        uint64_t turn;
+        uint64_t count;
+        double meanX;
+        double meanY;
+        double sigmaXX;
+        double sigmaYY;
+        double sigmaXY;
+        uint64_t sequence;  // Odd while the slot is being written
+    };
+
+    static_assert(sizeof(Header) == 64, "BPM header layout changed");
+    static_assert(sizeof(Record) == 64, "BPM record layout changed");
+
+    static size_t storageSize(size_t capacity, size_t trackedCount);
+    void initialize(size_t capacity, size_t trackedCount);
+    std::vector<uint64_t> retainedTurns() const;
+    void beginWrite(size_t slot);
+    void endWrite(size_t slot);
+
+    const Header* header() const { return reinterpret_cast<const Header*>(m_base); }
+    Header* header() { return reinterpret_cast<Header*>(m_base); }
+    const Record* records() const { return reinterpret_cast<const Record*>(m_base + sizeof(Header)); }
+    Record* records() { return reinterpret_cast<Record*>(m_base + sizeof(Header)); }
+    const double* particles() const;
+    double* particles();
+
+    std::vector<uint64_t> m_memory;   // 8-byte aligned in-memory storage
+    utils::MappedFile m_file;
+    std::byte* m_base = nullptr;
+};
+
+/**
+ * @brief Beam position monitor for turn-by-turn measurements.
+ *
+ * Records the centroid and second moments of every particle crossing its
+ * plane, once per turn, plus the coordinates of an optional set of tracked
+ * particles. Coordinates are the crossing's offsets from the reference
+ * orbit (PlaneCrossing::x and y), so they hold on curved lattices.
+ * Crossings are summed per thread during a step and merged into the ring
+ * buffer afterwards. A turn is completed once any particle reaches the next
+ * turn, or on flush(). Crossings that arrive after their turn was completed
+ * are folded into its record while it is retained, and counted as dropped
+ * once the ring has overwritten it.
+ */
+class BeamPositionMonitor : public Component {
+public:
+    using TurnData = BPMBuffer::TurnData;
+
+    /**
+     * @brief Construct a beam position monitor.
+     * @param name Component name.
+     * @param capacity Number of turns retained in the ring buffer.
+     * @param aperture Aperture specification.
+     */
+    BeamPositionMonitor(const std::string& name, size_t capacity = 1024,
+                        const Aperture& aperture = Aperture());
+
+    ComponentType getType() const override { return ComponentType::Monitor; }
+    std::shared_ptr<physics::FieldSource> getFieldSource() const override { return nullptr; }
+    std::shared_ptr<Component> clone() const override;
+
+    /**
+     * @brief Select particles whose individual coordinates are recorded.
+     *
+     * Reallocates storage and discards recorded data.
+     */
+    void setTrackedParticles(std::vector<uint64_t> particleIds);
+    const std::vector<uint64_t>& getTrackedParticles() const { return m_trackedIds; }
+
+    /**
+     * @brief Move storage to a memory-mapped file. Discards recorded data.
+     */
+    bool mapToFile(const std::string& filepath);
+
+    /**
+     * @brief Complete all open turns.
+     */
+    void flush();
+
+    /**
+     * @brief Discard all recorded data.
+     */
+    void reset();
+
+    size_t getCapacity() const { return m_capacity; }
+    uint64_t getTurnCount() const { return m_buffer.getTurnCount(); }
+
+    /**
+     * @brief Crossings discarded because their turn had already been overwritten.
+     */
+    uint64_t getDroppedCrossings() const { return m_droppedCrossings; }
+    const BPMBuffer& getBuffer() const { return m_buffer; }
+
+    std::optional<TurnData> getTurn(uint64_t turn) const { return m_buffer.getTurn(turn); }
+    std::vector<double> getCentroidSeries(TransversePlane plane) const {
+        return m_buffer.getCentroidSeries(plane);
+    }
+
+    // Observation plane
+    bool observesCrossings() const override { return true; }
+    void prepareCrossings(int threadCount) override;
+    void recordCrossing(const PlaneCrossing& crossing) override;
+    void commitCrossings() override;
+
+private:
+    /**
+     * @brief Running means and centred second moments of one turn's crossings.
+     *
+     * Welford updates and the pairwise merge keep the variance accurate for
+     * offsets large compared to the beam size, where sum(x^2)/n - mean^2
+     * cancels.
+     */
+    struct TurnMoments {
+        uint64_t turn = 0;
+        uint64_t count = 0;
+        double meanX = 0.0;
+        double meanY = 0.0;
+        double m2X = 0.0;  // Sum of squared deviations from the mean
+        double m2Y = 0.0;
+        double cXY = 0.0;  // Sum of products of the deviations
+
+        void add(double x, double y);
+        void merge(const TurnMoments& other);
+    };
+
+    struct TrackedSample {
+        uint64_t turn;
+        size_t index;
+        double x;
+        double y;
+    };
+
+    struct alignas(64) ThreadState {
+        std::vector<TurnMoments> moments;
+        std::vector<TrackedSample> samples;
+    };
+
+    void completeTurnsBefore(uint64_t turn);
+    void foldLateTurn(const TurnMoments& moments);
+    void writeTurn(const TurnMoments& moments);
+
+    size_t m_capacity;
+    BPMBuffer m_buffer;
+    std::string m_mappedPath;               // Empty for in-memory storage
+    std::vector<uint64_t> m_trackedIds;     // Sorted
+    std::vector<ThreadState> m_threadStates;
+    std::map<uint64_t, TurnMoments> m_openTurns;
+    std::vector<TrackedSample> m_pendingSamples;  // Samples of open turns, stored with their record
+    std::optional<uint64_t> m_latestTurn;
+    uint64_t m_droppedCrossings = 0;
+};
+
+} // namespace pas::accelerator
@@ -0,0 +1,190 @@
+#include "accelerator/Beamline.hpp"
+#include "utils/Logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pas::accelerator {
+
+bool Beamline::defineElement(std::shared_ptr<Component> element) {
+    if (!element) {
+        return false;
+    }
+    const std::string& name = element->getName();
+    if (hasElement(name) || hasLine(name)) {
+        PAS_WARN("Beamline: {} is already defined", name);
+        return false;
+    }
+    m_elements.emplace(name, std::move(element));
+    return true;
+}
+
+bool Beamline::defineLine(const std::string& name, const std::vector<Item>& items) {
+    if (hasElement(name) || hasLine(name)) {
+        PAS_WARN("Beamline: {} is already defined", name);
+        return false;
+    }
+
+    // Only earlier definitions can be referenced, so lines cannot recurse
+    Line line;
+    line.items.reserve(items.size());
+    for (const Item& item : items) {
+        ResolvedItem resolved;
+        if (auto element = m_elements.find(item.name); element != m_elements.end()) {
+            resolved.element = element->second;
+            resolved.unitLength = element->second->getLength();
+            resolved.unitCount = 1;
+        } else if (auto sub = m_lineIndices.find(item.name); sub != m_lineIndices.end()) {
+            resolved.line = sub->second;
+            resolved.unitLength = m_lines[sub->second].length;
+            resolved.unitCount = m_lines[sub->second].count;
+        } else {
+            PAS_WARN("Beamline: Line {} references undefined {}", name, item.name);
+            return false;
+        }
+        resolved.repeat = item.repeat;
+        resolved.reflected = item.reflected;
+        resolved.start = line.length;
+        resolved.firstIndex = line.count;
+        line.length += resolved.unitLength * static_cast<double>(item.repeat);
+        line.count += resolved.unitCount * item.repeat;
+        line.items.push_back(std::move(resolved));
+    }
+
+    m_lineIndices.emplace(name, m_lines.size());
+    m_lines.push_back(std::move(line));
+    return true;
+}
+
+const Beamline::Line* Beamline::findLine(const std::string& name) const {
+    auto it = m_lineIndices.find(name);
+    return it != m_lineIndices.end() ? &m_lines[it->second] : nullptr;
+}
+
+std::shared_ptr<Component> Beamline::getElement(const std::string& name) const {
+    auto it = m_elements.find(name);
+    return it != m_elements.end() ? it->second : nullptr;
+}
+
+size_t Beamline::getElementCount(const std::string& line) const {
+    const Line* found = findLine(line);
+    return found ? found->count : 0;
+}
+
+double Beamline::getLength(const std::string& line) const {
+    const Line* found = findLine(line);
+    return found ? found->length : 0.0;
+}
+
+std::optional<Beamline::Occurrence> Beamline::findAtS(const std::string& line, double s) const {
+    const Line* found = findLine(line);
+    if (!found || s < 0.0 || s >= found->length) {
+        return std::nullopt;
+    }
+    return locate(*found, s, 0.0, 0, false);
+}
+
+std::optional<Beamline::Occurrence> Beamline::getOccurrence(const std::string& line,
+                                                            size_t index) const {
+    const Line* found = findLine(line);
+    if (!found || index >= found->count) {
+        return std::nullopt;
+    }
+    return locateIndex(*found, index, 0.0, 0, false);
+}
+
+bool Beamline::expand(const std::string& line,
+                      const std::function<void(const Occurrence&)>& visit) const {
+    const Line* found = findLine(line);
+    if (!found) {
+        PAS_WARN("Beamline: Unknown line {}", line);
+        return false;
+    }
+    double s = 0.0;
+    size_t index = 0;
+    expandLine(*found, false, s, index, visit);
+    return true;
+}
+
+std::optional<Beamline::Occurrence> Beamline::locate(const Line& line, double s, double lineStart,
+                                                     size_t lineIndex, bool flipped) const {
+    // Position in the definition frame of the line. Traversing a reflected
+    // line turns [start, end) into (start, end], and rounding in the parent
+    // offsets must not push s out of the unit it was found in.
+    double u = flipped ? lineStart + line.length - s : s - lineStart;
+    u = flipped ? std::clamp(u, std::nextafter(0.0, 1.0), line.length)
+                : std::clamp(u, 0.0, std::nextafter(line.length, 0.0));
+
+    auto it = flipped
+        ? std::lower_bound(line.items.begin(), line.items.end(), u,
+                           [](const ResolvedItem& item, double value) { return item.start < value; })
+        : std::upper_bound(line.items.begin(), line.items.end(), u,
+                           [](double value, const ResolvedItem& item) { return value < item.start; });
+    if (it == line.items.begin()) {
+        return std::nullopt;
+    }
+    const ResolvedItem& item = *(it - 1);
+    const double local = u - item.start;
+    const double total = item.unitLength * static_cast<double>(item.repeat);
+    if (item.unitLength <= 0.0 || (flipped ? local > total : local >= total)) {
+        return std::nullopt;
+    }
+
+    // Copy k of the item in the definition frame
+    const double copies = flipped ? std::ceil(local / item.unitLength) - 1.0
+                                  : std::floor(local / item.unitLength);
+    const auto k = static_cast<size_t>(std::clamp(copies, 0.0, static_cast<double>(item.repeat - 1)));
+    const double unitOffset = item.start + static_cast<double>(k) * item.unitLength;
+    const size_t unitFirst = item.firstIndex + k * item.unitCount;
+
+    const double unitStart = flipped ? lineStart + line.length - (unitOffset + item.unitLength)
+                                     : lineStart + unitOffset;
+    const size_t unitIndex = flipped ? lineIndex + line.count - (unitFirst + item.unitCount)
+                                     : lineIndex + unitFirst;
+    if (item.element) {
+        return Occurrence{item.element, unitIndex, unitStart};
+    }
+    return locate(m_lines[item.line], s, unitStart, unitIndex, flipped != item.reflected);
+}
+
+std::optional<Beamline::Occurrence> Beamline::locateIndex(const Line& line, size_t index,
+                                                          double lineStart, size_t lineIndex,
+                                                          bool flipped) const {
+    const size_t position = index - lineIndex;
+    const size_t j = flipped ? line.count - 1 - position : position;
+
+    auto it = std::upper_bound(line.items.begin(), line.items.end(), j,
+                               [](size_t value, const ResolvedItem& item) { return value < item.firstIndex; });
+    const ResolvedItem& item = *(it - 1);
+    const size_t k = (j - item.firstIndex) / item.unitCount;
+    const double unitOffset = item.start + static_cast<double>(k) * item.unitLength;
+    const size_t unitFirst = item.firstIndex + k * item.unitCount;
+
+    const double unitStart = flipped ? lineStart + line.length - (unitOffset + item.unitLength)
+                                     : lineStart + unitOffset;
+    const size_t unitIndex = flipped ? lineIndex + line.count - (unitFirst + item.unitCount)
+                                     : lineIndex + unitFirst;
+    if (item.element) {
+        return Occurrence{item.element, unitIndex, unitStart};
+    }
+    return locateIndex(m_lines[item.line], index, unitStart, unitIndex, flipped != item.reflected);
+}
+
+void Beamline::expandLine(const Line& line, bool flipped, double& s, size_t& index,
+                          const std::function<void(const Occurrence&)>& visit) const {
+    const size_t count = line.items.size();
+    for (size_t n = 0; n < count; ++n) {
+        const ResolvedItem& item = line.items[flipped ? count - 1 - n : n];
+        for (size_t copy = 0; copy < item.repeat; ++copy) {
+            if (item.element) {
+                visit(Occurrence{item.element, index, s});
+                s += item.unitLength;
+                ++index;
+            } else {
+                expandLine(m_lines[item.line], flipped != item.reflected, s, index, visit);
+            }
+        }
+    }
+}
+
+} // namespace pas::accelerator
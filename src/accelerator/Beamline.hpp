@@ -0,0 +1,132 @@
+#pragma once
+
+#include "accelerator/Component.hpp"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pas::accelerator {
+
+/**
+ * @brief MAD-style beamline definition built from shared element templates.
+ *
+ * Elements are defined once and referenced by name from lines. A line is a
+ * sequence of elements and previously defined lines, each with a repeat
+ * count and an optional reflection (MAD's -LINE). Lines are never expanded
+ * to answer queries: counts and lengths are cached per definition and
+ * s-lookups descend the definition tree, so memory scales with the number
+ * of definitions rather than the number of elements in the machine.
+ */
+class Beamline {
+public:
+    /**
+     * @brief Reference from a line to an element or another line.
+     */
+    struct Item {
+        std::string name;
+        size_t repeat = 1;
+        bool reflected = false;  // Traverse a line in reverse order
+    };
+
+    /**
+     * @brief One element of the expanded line.
+     */
+    struct Occurrence {
+        std::shared_ptr<Component> element;  // Template shared by all occurrences
+        size_t index = 0;                    // Position in the expanded line
+        double sStart = 0.0;                 // m
+    };
+
+    /**
+     * @brief Define an element template under its component name.
+     * @return False if the name is already used.
+     */
+    bool defineElement(std::shared_ptr<Component> element);
+
+    /**
+     * @brief Define a line from elements and lines defined earlier.
+     * @return False if the name is taken or an item is unknown.
+     */
+    bool defineLine(const std::string& name, const std::vector<Item>& items);
+
+    bool hasElement(const std::string& name) const { return m_elements.count(name) > 0; }
+    bool hasLine(const std::string& name) const { return m_lineIndices.count(name) > 0; }
+
+    /**
+     * @brief Get an element template; nullptr if it is not defined.
+     */
+    std::shared_ptr<Component> getElement(const std::string& name) const;
+
+    /**
+     * @brief Number of element templates.
+     */
+    size_t getUniqueElementCount() const { return m_elements.size(); }
+
+    /**
+     * @brief Number of elements in the expanded line; 0 for unknown lines.
+     */
+    size_t getElementCount(const std::string& line) const;
+
+    /**
+     * @brief Length of the expanded line [m]; 0 for unknown lines.
+     */
+    double getLength(const std::string& line) const;
+
+    /**
+     * @brief Element whose [sStart, sStart + length) contains s.
+     */
+    std::optional<Occurrence> findAtS(const std::string& line, double s) const;
+
+    /**
+     * @brief Element at an index of the expanded line.
+     */
+    std::optional<Occurrence> getOccurrence(const std::string& line, size_t index) const;
+
+    /**
+     * @brief Visit the expanded line in order without materialising it.
+     * @return False if the line is unknown.
+     */
+    bool expand(const std::string& line,
+                const std::function<void(const Occurrence&)>& visit) const;
+
+private:
+    struct Line;
+
+    struct ResolvedItem {
+        std::shared_ptr<Component> element;  // Set for element references
+        size_t line = 0;                     // Index into m_lines for line references
+        size_t repeat = 1;
+        bool reflected = false;
+        double unitLength = 0.0;
+        size_t unitCount = 0;
+        double start = 0.0;       // Offset within the line, unreflected
+        size_t firstIndex = 0;
+    };
+
+    struct Line {
+        std::vector<ResolvedItem> items;
+        double length = 0.0;
+        size_t count = 0;
+    };
+
+    // Lookups in a line placed at lineStart/lineIndex, traversed in reverse if flipped
+    std::optional<Occurrence> locate(const Line& line, double s, double lineStart, size_t lineIndex,
+                                     bool flipped) const;
+    std::optional<Occurrence> locateIndex(const Line& line, size_t index, double lineStart,
+                                          size_t lineIndex, bool flipped) const;
+    void expandLine(const Line& line, bool flipped, double& s, size_t& index,
+                    const std::function<void(const Occurrence&)>& visit) const;
+
+    const Line* findLine(const std::string& name) const;
+
+    // Sub-lines are referenced by index, so copies of a Beamline stay self-contained
+    std::map<std::string, std::shared_ptr<Component>> m_elements;
+    std::vector<Line> m_lines;
+    std::map<std::string, size_t> m_lineIndices;
+};
+
+} // namespace pas::accelerator
@@ -0,0 +1,429 @@
+#include "accelerator/CompiledLattice.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace pas::accelerator {
+
+namespace {
+
+// Entries checked after the cursor before falling back to binary search
+constexpr size_t CURSOR_LOOKAHEAD = 4;
+
+// Exit frame offset below which a survey counts as closed [m]
+constexpr double SURVEY_CLOSURE = 1e-6;
+
+double strengthOf(const Component& component) {
+    if (const auto* magnet = dynamic_cast<const Magnet*>(&component)) {
+        return magnet->getMainStrength();
+    }
+    if (const auto* solenoid = dynamic_cast<const Solenoid*>(&component)) {
+        return solenoid->getField();
+    }
+    if (const auto* cavity = dynamic_cast<const RFCavity*>(&component)) {
+        return cavity->getVoltage();
+    }
+    return 0.0;
+}
+
+double bendAngleOf(const Component& component, double referenceRigidity) {
+    if (referenceRigidity == 0.0) {
+        return 0.0;
+    }
+    if (const auto* dipole = dynamic_cast<const Dipole*>(&component)) {
+        return dipole->getField() * dipole->getLength() / referenceRigidity;
+    }
+    return 0.0;
+}
+
+// Entrance-to-exit displacement of the reference orbit, in the entrance frame
+glm::dvec3 chordOf(double angle, double length) {
+    if (angle == 0.0) {
+        return glm::dvec3(0.0, 0.0, length);
+    }
+    const double rho = length / angle;
+    const double halfSine = std::sin(0.5 * angle);
+    return glm::dvec3(-2.0 * rho * halfSine * halfSine, 0.0, rho * std::sin(angle));
+}
+
+// Positive angles turn the orbit from +z towards -x
+glm::dquat turnOf(double angle) {
+    return glm::angleAxis(-angle, glm::dvec3(0.0, 1.0, 0.0));
+}
+
+// (x, y, ds) of a point given in the entrance frame of a bend; the centre of
+// curvature is at x = -rho and x grows away from it for positive angles
+glm::dvec3 bendCoordinates(double angle, double length, const glm::dvec3& local) {
+    const double rho = length / angle;
+    const double dx = local.x + rho;
+    const double radius = std::copysign(std::sqrt(dx * dx + local.z * local.z), rho);
+    const double phi = std::atan2(local.z / radius, dx / radius);
+    return glm::dvec3(radius - rho, local.y, rho * phi);
+}
+
+// Frame of n successive turns: turn applied n times
+Placement powerOf(Placement turn, unsigned n) {
+    Placement result;
+    while (n > 0) {
+        if (n & 1u) {
+            result.origin = result.origin + result.rotation * turn.origin;
+            result.rotation = result.rotation * turn.rotation;
+        }
+        turn.origin = turn.origin + turn.rotation * turn.origin;
+        turn.rotation = turn.rotation * turn.rotation;
+        n >>= 1u;
+    }
+    return result;
+}
+
+} // namespace
+
+void CompiledLattice::build(const std::vector<std::shared_ptr<Component>>& components,
+                            double referenceRigidity) {
+    const size_t count = components.size();
+    m_referenceRigidity = referenceRigidity;
+    m_types.resize(count);
+    m_sStarts.resize(count);
+    m_lengths.resize(count);
+    m_apertureShapes.resize(count);
+    m_apertureX.resize(count);
+    m_apertureY.resize(count);
+    m_strengths.resize(count);
+    m_angles.resize(count);
+    m_referenceOrigins.resize(count);
+    m_referenceRotations.resize(count);
+    m_origins.resize(count);
+    m_rotations.resize(count);
+    m_inverseRotations.resize(count);
+    m_transfers.resize(count);
+    m_aligned.resize(count);
+    m_apertureSStarts.resize(count);
+    m_apertureSEnds.resize(count);
+    m_components.resize(count);
+    m_versions.resize(count);
+
+    // s is per occurrence; shared components appear at several places
+    double s = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        compile(i, *components[i]);
+        m_sStarts[i] = s;
+        s += m_lengths[i];
+    }
+    survey(0);
+}
+
+bool CompiledLattice::refresh(const std::vector<std::shared_ptr<Component>>& components) {
+    ++m_refreshCount;
+    if (components.size() != m_components.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < components.size(); ++i) {
+        if (components[i].get() != m_components[i]) {
+            return false;
+        }
+    }
+
+    // Frames downstream of a changed bend move; everything else is placed in place
+    size_t firstMoved = components.size();
+    for (size_t i = 0; i < components.size(); ++i) {
+        if (components[i]->getVersion() != m_versions[i]) {
+            const double angle = m_angles[i];
+            compile(i, *components[i]);
+            if (m_angles[i] != angle) {
+                firstMoved = std::min(firstMoved, i);
+            } else {
+                place(i);
+            }
+        }
+    }
+    if (firstMoved < components.size()) {
+        survey(firstMoved);
+    } else {
+        findDisplaced();
+    }
+    return true;
+}
+
+OrbitPosition CompiledLattice::toOrbit(const glm::dvec3& globalPos, size_t cursor, bool closed,
+                                       int turn) const {
+    OrbitPosition orbit;
+    if (m_types.empty()) {
+        return orbit;
+    }
+
+    const size_t last = m_types.size() - 1;
+    size_t index = std::min(cursor, last);
+    glm::dvec3 point = globalPos;
+    if (closed && turn != 0 && !m_turnCloses) {
+        // Back to the first turn
+        const Placement turns = powerOf(m_exitFrame, static_cast<unsigned>(std::abs(turn)));
+        point = turn > 0 ? turns.toLocal(point) : turns.toGlobal(point);
+    }
+    glm::dvec3 local = toCurvilinear(index, point);
+
+    // Walk one way only, so rounding at a shared boundary cannot ping-pong.
+    // Wrapping carries the point from the exit frame to the start frame,
+    // which are the same for a ring whose survey closes.
+    int direction = 0;
+    for (size_t step = 0; step <= 2 * last + 1; ++step) {
+        if (local.z < 0.0 && direction <= 0 && (index > 0 || closed)) {
+            direction = -1;
+            if (index == 0) {
+                index = last;
+                point = m_turnCloses ? point : m_exitFrame.toGlobal(point);
+                --orbit.wraps;
+            } else {
+                --index;
+            }
+        } else if (local.z >= m_lengths[index] && direction >= 0 && (index < last || closed)) {
+            direction = 1;
+            if (index == last) {
+                index = 0;
+                point = m_turnCloses ? point : m_exitFrame.toLocal(point);
+                ++orbit.wraps;
+            } else {
+                ++index;
+            }
+        } else {
+            break;
+        }
+        local = toCurvilinear(index, point);
+    }
+
+    orbit.index = index;
+    orbit.x = local.x;
+    orbit.y = local.y;
+    orbit.ds = local.z;
+    return orbit;
+}
+
+glm::dvec3 CompiledLattice::toGlobal(const OrbitPosition& orbit, int turn) const {
+    const glm::dvec3 point = getReferenceFrame(orbit.index).toGlobal(toFrame(orbit));
+    if (turn == 0 || m_turnCloses) {
+        return point;
+    }
+    const Placement turns = powerOf(m_exitFrame, static_cast<unsigned>(std::abs(turn)));
+    return turn > 0 ? turns.toGlobal(point) : turns.toLocal(point);
+}
+
+glm::dvec3 CompiledLattice::toFrame(const OrbitPosition& orbit) const {
+    const double angle = m_angles[orbit.index];
+    if (angle == 0.0) {
+        return glm::dvec3(orbit.x, orbit.y, orbit.ds);
+    }
+    const double rho = m_lengths[orbit.index] / angle;
+    const double phi = orbit.ds / rho;
+    return glm::dvec3((orbit.x + rho) * std::cos(phi) - rho, orbit.y, (orbit.x + rho) * std::sin(phi));
+}
+
+OrbitPosition CompiledLattice::fromFrame(size_t index, const glm::dvec3& local) const {
+    const glm::dvec3 orbit = m_angles[index] == 0.0 ? local
+                                                    : bendCoordinates(m_angles[index], m_lengths[index], local);
+    OrbitPosition position;
+    position.index = index;
+    position.x = orbit.x;
+    position.y = orbit.y;
+    position.ds = orbit.z;
+    return position;
+}
+
+Placement CompiledLattice::getReferenceFrame(size_t index, int turn) const {
+    const Placement frame = getReferenceFrame(index);
+    if (turn == 0 || m_turnCloses) {
+        return frame;
+    }
+    Placement turns = powerOf(m_exitFrame, static_cast<unsigned>(std::abs(turn)));
+    if (turn < 0) {
+        const glm::dquat inverse = glm::inverse(turns.rotation);
+        turns = Placement{-(inverse * turns.origin), inverse};
+    }
+    return Placement{turns.toGlobal(frame.origin), turns.rotation * frame.rotation};
+}
+
+Placement CompiledLattice::getCenterFrame(size_t index) const {
+    const double angle = m_angles[index];
+    const glm::dquat& rotation = m_referenceRotations[index];
+    return Placement{m_referenceOrigins[index] + rotation * (0.5 * chordOf(angle, m_lengths[index])),
+                     rotation * turnOf(0.5 * angle)};
+}
+
+bool CompiledLattice::isInsideAnyAperture(const glm::dvec3& globalPos) const {
+    for (size_t i = 0; i < m_types.size(); ++i) {
+        if (isInsideAperture(i, globalPos)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CompiledLattice::isInsideApertureAtS(const glm::dvec3& globalPos, double s, size_t& cursor) const {
+    if (m_types.empty()) {
+        return false;
+    }
+
+    // Before or after the lattice, the first or last entry
+    size_t index = 0;
+    if (auto found = findIndexAtS(s, cursor)) {
+        index = *found;
+    } else {
+        auto it = std::upper_bound(m_sStarts.begin(), m_sStarts.end(), s);
+        index = it == m_sStarts.begin() ? 0 : static_cast<size_t>(it - m_sStarts.begin()) - 1;
+    }
+    if (isInsideAperture(index, globalPos)) {
+        return true;
+    }
+
+    // A neighbour shares the boundary or holds a position moved by a small alignment offset
+    if (index > 0 && isInsideAperture(index - 1, globalPos)) {
+        return true;
+    }
+    if (index + 1 < m_types.size() && isInsideAperture(index + 1, globalPos)) {
+        return true;
+    }
+    for (size_t displaced : m_displaced) {
+        if (isInsideAperture(displaced, globalPos)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::optional<size_t> CompiledLattice::findIndexAtS(double s) const {
+    // Last entry starting at or before s; zero-length entries never contain s
+    auto it = std::upper_bound(m_sStarts.begin(), m_sStarts.end(), s);
+    if (it == m_sStarts.begin()) {
+        return std::nullopt;
+    }
+    const auto index = static_cast<size_t>(it - m_sStarts.begin()) - 1;
+    if (s < m_sStarts[index] + m_lengths[index]) {
+        return index;
+    }
+    return std::nullopt;
+}
+
+std::optional<size_t> CompiledLattice::findIndexAtS(double s, size_t& cursor) const {
+    if (cursor < m_sStarts.size() && s >= m_sStarts[cursor]) {
+        const size_t last = std::min(cursor + CURSOR_LOOKAHEAD, m_sStarts.size() - 1);
+        for (size_t index = cursor; index <= last; ++index) {
+            if (s < m_sStarts[index] + m_lengths[index]) {
+                cursor = index;
+                return index;
+            }
+            if (index + 1 < m_sStarts.size() && s < m_sStarts[index + 1]) {
+                return std::nullopt;
+            }
+        }
+    }
+
+    auto index = findIndexAtS(s);
+    if (index) {
+        cursor = *index;
+    }
+    return index;
+}
+
+void CompiledLattice::compile(size_t index, const Component& component) {
+    const Aperture& aperture = component.getAperture();
+    m_types[index] = component.getType();
+    m_lengths[index] = component.getLength();
+    m_apertureShapes[index] = aperture.shape;
+    m_apertureX[index] = aperture.radiusX;
+    m_apertureY[index] = aperture.radiusY;
+    m_strengths[index] = strengthOf(component);
+    m_angles[index] = bendAngleOf(component, m_referenceRigidity);
+    m_components[index] = &component;
+    m_versions[index] = component.getVersion();
+}
+
+void CompiledLattice::place(size_t index) {
+    const Component& component = *m_components[index];
+    const glm::dquat& reference = m_referenceRotations[index];
+    m_origins[index] = m_referenceOrigins[index] + reference * component.getPosition();
+    m_rotations[index] = reference * component.getRotation();
+    m_inverseRotations[index] = glm::inverse(m_rotations[index]);
+
+    const glm::dvec3& offset = component.getPosition();
+    const glm::dquat& rotation = component.getRotation();
+    m_aligned[index] = offset.x != 0.0 || offset.y != 0.0 || offset.z != 0.0 ||
+                       rotation.x != 0.0 || rotation.y != 0.0 || rotation.z != 0.0;
+
+    // Extent of the aperture box along s, from its corners
+    const double length = m_lengths[index];
+    m_apertureSStarts[index] = m_sStarts[index];
+    m_apertureSEnds[index] = m_sStarts[index] + length;
+    if (m_aligned[index]) {
+        const Aperture aperture = getAperture(index);
+        double first = std::numeric_limits<double>::infinity();
+        double last = -first;
+        for (int corner = 0; corner < 8; ++corner) {
+            const glm::dvec3 local((corner & 1) ? aperture.radiusX : -aperture.radiusX,
+                                   (corner & 2) ? aperture.radiusY : -aperture.radiusY,
+                                   (corner & 4) ? length : 0.0);
+            const double s = offset.z + (rotation * local).z;
+            first = std::min(first, s);
+            last = std::max(last, s);
+        }
+        m_apertureSStarts[index] += first;
+        m_apertureSEnds[index] = m_sStarts[index] + last;
+    }
+}
+
+void CompiledLattice::findDisplaced() {
+    // isInsideApertureAtS() reaches entry i from entries i - 1 to i + 1, and from
+    // anything before or after the lattice when i is one of the first or last two
+    m_displaced.clear();
+    const size_t count = m_types.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (!m_aligned[i]) {
+            continue;
+        }
+        const double lower = i <= 1 ? -std::numeric_limits<double>::infinity() : m_sStarts[i - 1];
+        const double upper = i + 2 >= count ? std::numeric_limits<double>::infinity()
+                                            : m_sStarts[i + 1] + m_lengths[i + 1];
+        if (m_apertureSStarts[i] < lower || m_apertureSEnds[i] > upper) {
+            m_displaced.push_back(i);
+        }
+    }
+}
+
+void CompiledLattice::survey(size_t first) {
+    Placement frame = first == 0 ? Placement{} : getReferenceFrame(first);
+    for (size_t i = first; i < m_types.size(); ++i) {
+        m_referenceOrigins[i] = frame.origin;
+        m_referenceRotations[i] = frame.rotation;
+        place(i);
+
+        m_transfers[i] = Placement{chordOf(m_angles[i], m_lengths[i]), turnOf(m_angles[i])};
+        frame.origin += frame.rotation * m_transfers[i].origin;
+        if (m_angles[i] != 0.0) {
+            // Renormalised so long rings do not drift
+            frame.rotation = glm::normalize(frame.rotation * m_transfers[i].rotation);
+        }
+    }
+    m_exitFrame = frame;
+
+    // Within survey rounding the ring closes and every turn is the same place
+    const glm::dvec3 heading = frame.rotation * glm::dvec3(0.0, 0.0, 1.0);
+    m_turnCloses = glm::length(frame.origin) < SURVEY_CLOSURE && 1.0 - heading.z < SURVEY_CLOSURE;
+    ++m_surveyVersion;
+    findDisplaced();
+}
+
+bool CompiledLattice::isInsideBend(size_t index, const glm::dvec3& local) const {
+    const glm::dvec3 orbit = bendCoordinates(m_angles[index], m_lengths[index], local);
+    if (orbit.z < 0.0 || orbit.z > m_lengths[index]) {
+        return false;
+    }
+    return getAperture(index).isInside(orbit.x, orbit.y);
+}
+
+glm::dvec3 CompiledLattice::toCurvilinear(size_t index, const glm::dvec3& globalPos) const {
+    const glm::dvec3 local = glm::inverse(m_referenceRotations[index]) * (globalPos - m_referenceOrigins[index]);
+    if (m_angles[index] == 0.0) {
+        return local;
+    }
+    return bendCoordinates(m_angles[index], m_lengths[index], local);
+}
+
+} // namespace pas::accelerator
@@ -0,0 +1,294 @@
+#pragma once
+
+#include "accelerator/Component.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace pas::accelerator {
+
+/**
+ * @brief Rigid placement of a local frame in global coordinates.
+ */
+struct Placement {
+    glm::dvec3 origin{0.0};
+    glm::dquat rotation{1.0, 0.0, 0.0, 0.0};
+
+    glm::dvec3 toGlobal(const glm::dvec3& localPos) const { return origin + rotation * localPos; }
+    glm::dvec3 toLocal(const glm::dvec3& globalPos) const {
+        return glm::inverse(rotation) * (globalPos - origin);
+    }
+};
+
+/**
+ * @brief Position relative to the reference orbit, in the frame of one entry.
+ *
+ * x is the offset from the orbit along the frame's x axis (outwards for
+ * bends turning towards -x), y the vertical offset and ds the path length
+ * along the orbit from the entrance of the entry. All three stay small, so
+ * they keep their precision in single precision anywhere in a large ring.
+ */
+struct OrbitPosition {
+    size_t index = 0;  // Entry the position is in
+    double x = 0.0;    // m
+    double y = 0.0;    // m
+    double ds = 0.0;   // m
+    int wraps = 0;     // Ring closures passed locating it: +1 forward, -1 backward
+};
+
+/**
+ * @brief Flat structure-of-arrays copy of a lattice for tracking kernels.
+ *
+ * Entry i of every array describes component i. Kernels walk these
+ * contiguous arrays instead of chasing component pointers and virtual
+ * calls; the components remain the editable model.
+ *
+ * The strength of an entry is the main field coefficient of a magnet
+ * (Magnet::getMainStrength()), the field of a solenoid [T] or the voltage
+ * of an RF cavity [V]; it is 0 for everything else.
+ *
+ * The build also surveys the lattice: the reference orbit starts at the
+ * origin along +z and turns in each dipole by theta = B * L / (B rho),
+ * positive fields bending towards -x. Every entry stores the reference
+ * frame at its entrance and its global frame, which is the reference frame
+ * moved by the component's own position and rotation (its alignment).
+ * With no reference rigidity the lattice is laid out along z.
+ */
+class CompiledLattice {
+public:
+    /**
+     * @brief Rebuild all arrays from the components and survey the lattice.
+     * @param referenceRigidity B rho of the reference particle [T m]; 0 for a straight layout.
+     */
+    void build(const std::vector<std::shared_ptr<Component>>& components, double referenceRigidity = 0.0);
+
+    /**
+     * @brief Update the entries of components whose version changed.
+     *
+     * A changed bend angle surveys again from that entry on; upstream
+     * frames are kept.
+     * @return False if the component list no longer matches the arrays.
+     */
+    bool refresh(const std::vector<std::shared_ptr<Component>>& components);
+
+    /**
+     * @brief Number of refresh() calls so far; each one scans every entry.
+     */
+    size_t getRefreshCount() const { return m_refreshCount; }
+
+    size_t size() const { return m_types.size(); }
+    bool empty() const { return m_types.empty(); }
+
+    /**
+     * @brief Aperture test of entry i in its global frame.
+     *
+     * Straight entries use the Component::isInsideAperture() test; bends
+     * measure the offset from the arc of the reference orbit.
+     */
+    bool isInsideAperture(size_t index, const glm::dvec3& globalPos) const {
+        const glm::dvec3 local = m_inverseRotations[index] * (globalPos - m_origins[index]);
+        if (m_angles[index] != 0.0) {
+            return isInsideBend(index, local);
+        }
+        if (local.z < 0.0 || local.z > m_lengths[index]) {
+            return false;
+        }
+        return getAperture(index).isInside(local.x, local.y);
+    }
+
+    /**
+     * @brief Aperture test of a position relative to the reference orbit.
+     *
+     * Needs no transform unless the entry is misaligned.
+     */
+    bool isInsideAperture(const OrbitPosition& orbit) const {
+        const size_t index = orbit.index;
+        if (orbit.ds < 0.0 || orbit.ds > m_lengths[index]) {
+            return false;
+        }
+        if (m_aligned[index]) {
+            return isInsideAperture(index, toGlobal(orbit));
+        }
+        return getAperture(index).isInside(orbit.x, orbit.y);
+    }
+
+    /**
+     * @brief Check if a position is inside the aperture of any entry.
+     */
+    bool isInsideAnyAperture(const glm::dvec3& globalPos) const;
+
+    /**
+     * @brief Same test on a straight survey, looking only near s.
+     *
+     * s is the global z of the position. Tests the entry containing s,
+     * found from the cursor, its two neighbours and the few entries whose
+     * alignment moves their aperture beyond their neighbours, so the result
+     * equals isInsideAnyAperture() except exactly on entry boundaries, in
+     * amortised O(1). Keep one cursor per particle; it is updated to the
+     * entry found.
+     */
+    bool isInsideApertureAtS(const glm::dvec3& globalPos, double s, size_t& cursor) const;
+
+    /**
+     * @brief Entry whose [s-start, s-start + length) contains s, by binary search.
+     * @return Entry index, or std::nullopt if no entry contains s.
+     */
+    std::optional<size_t> findIndexAtS(double s) const;
+
+    /**
+     * @brief Same lookup starting from the entry found last time.
+     *
+     * Particles move forward in s, so the answer is usually the cursor
+     * entry or one of the next few; only jumps fall back to binary search.
+     * Keep one cursor per particle; it is updated to the entry found.
+     */
+    std::optional<size_t> findIndexAtS(double s, size_t& cursor) const;
+
+    /**
+     * @brief Locate a global position relative to the reference orbit.
+     *
+     * Starts at the cursor entry and walks to the neighbouring entries until
+     * ds lies within one, so a cursor kept per particle finds the entry in
+     * a step or two. Closed lattices wrap around at their ends, carrying
+     * the position from the exit frame to the start frame (a no-op when the
+     * survey closes, a shift by the length for a straight ring); open ones
+     * leave positions before or after the lattice in the first or last entry
+     * with ds out of range.
+     * @param turn Turn the cursor is on; in a ring whose survey does not
+     *        close, the position is first carried back that many turns.
+     */
+    OrbitPosition toOrbit(const glm::dvec3& globalPos, size_t cursor, bool closed = false,
+                          int turn = 0) const;
+
+    /**
+     * @brief Global position of a position relative to the reference orbit.
+     *
+     * @param turn Turn the position is on; only moves it in a ring whose
+     *        survey does not close.
+     */
+    glm::dvec3 toGlobal(const OrbitPosition& orbit, int turn = 0) const;
+
+    /**
+     * @brief Point in the reference frame of its entry, from orbit coordinates.
+     *
+     * The frame sits at the entrance with z along the orbit there; in a bend
+     * the orbit curves away from z. Unlike (x, y, ds), these are Cartesian,
+     * so the equations of motion keep their form in them.
+     */
+    glm::dvec3 toFrame(const OrbitPosition& orbit) const;
+
+    /**
+     * @brief Orbit coordinates of a point given in the reference frame of entry i.
+     */
+    OrbitPosition fromFrame(size_t index, const glm::dvec3& local) const;
+
+    Aperture getAperture(size_t index) const {
+        return Aperture{m_apertureShapes[index], m_apertureX[index], m_apertureY[index]};
+    }
+
+    /**
+     * @brief Component an entry was compiled from.
+     */
+    const Component& getComponent(size_t index) const { return *m_components[index]; }
+
+    const std::vector<ComponentType>& getTypes() const { return m_types; }
+    const std::vector<double>& getSStarts() const { return m_sStarts; }
+    const std::vector<double>& getLengths() const { return m_lengths; }
+    const std::vector<ApertureShape>& getApertureShapes() const { return m_apertureShapes; }
+    const std::vector<double>& getApertureX() const { return m_apertureX; }
+    const std::vector<double>& getApertureY() const { return m_apertureY; }
+    const std::vector<double>& getStrengths() const { return m_strengths; }
+    const std::vector<double>& getAngles() const { return m_angles; }
+    const std::vector<glm::dvec3>& getOrigins() const { return m_origins; }
+    const std::vector<glm::dquat>& getRotations() const { return m_rotations; }
+    const std::vector<glm::dquat>& getInverseRotations() const { return m_inverseRotations; }
+
+    double getReferenceRigidity() const { return m_referenceRigidity; }
+
+    /**
+     * @brief Reference frame at the entrance of entry i.
+     */
+    Placement getReferenceFrame(size_t index) const {
+        return Placement{m_referenceOrigins[index], m_referenceRotations[index]};
+    }
+
+    /**
+     * @brief Reference frame at the entrance of entry i on a given turn.
+     *
+     * Differs from the first turn's only in a ring whose survey does not close.
+     */
+    Placement getReferenceFrame(size_t index, int turn) const;
+
+    /**
+     * @brief Entrance frame of the next entry, in the reference frame of entry i.
+     *
+     * Carries positions and momenta held in one entry's frame into the next
+     * without going through global coordinates, so they stay small. After
+     * the last entry of a ring the next is the first, on the next turn.
+     */
+    const Placement& getTransfer(size_t index) const { return m_transfers[index]; }
+
+    /**
+     * @brief Reference frame at the middle of entry i.
+     *
+     * Centred on the chord and turned by half the bend angle. Field sources
+     * and geometry built around the origin along z are placed with it.
+     */
+    Placement getCenterFrame(size_t index) const;
+
+    /**
+     * @brief Reference frame at the end of the last entry.
+     *
+     * Equals the start frame for a closed ring whose bends add up to 2 pi.
+     */
+    const Placement& getExitFrame() const { return m_exitFrame; }
+
+    /**
+     * @brief Incremented every time frames are surveyed again.
+     */
+    uint64_t getSurveyVersion() const { return m_surveyVersion; }
+
+private:
+    void compile(size_t index, const Component& component);
+    void place(size_t index);
+    void survey(size_t first);
+    void findDisplaced();
+    bool isInsideBend(size_t index, const glm::dvec3& local) const;
+    glm::dvec3 toCurvilinear(size_t index, const glm::dvec3& globalPos) const;
+
+    std::vector<ComponentType> m_types;
+    std::vector<double> m_sStarts;
+    std::vector<double> m_lengths;
+    std::vector<ApertureShape> m_apertureShapes;
+    std::vector<double> m_apertureX;
+    std::vector<double> m_apertureY;
+    std::vector<double> m_strengths;
+    std::vector<double> m_angles;
+
+    // Survey: reference frames at the entrances, and global frames with alignment
+    std::vector<glm::dvec3> m_referenceOrigins;
+    std::vector<glm::dquat> m_referenceRotations;
+    std::vector<glm::dvec3> m_origins;
+    std::vector<glm::dquat> m_rotations;
+    std::vector<glm::dquat> m_inverseRotations;
+    std::vector<Placement> m_transfers;  // Next entrance in each reference frame
+    std::vector<uint8_t> m_aligned;  // Global frame differs from the reference frame
+    std::vector<double> m_apertureSStarts;  // s-range the aligned aperture spans
+    std::vector<double> m_apertureSEnds;
+    std::vector<size_t> m_displaced;  // Apertures reaching past their neighbours in s
+    Placement m_exitFrame;
+    bool m_turnCloses = true;  // Exit frame is the start frame within rounding
+    double m_referenceRigidity = 0.0;
+    uint64_t m_surveyVersion = 0;
+
+    // Change tracking
+    std::vector<const Component*> m_components;
+    std::vector<uint64_t> m_versions;
+    size_t m_refreshCount = 0;
+};
+
+} // namespace pas::accelerator
@@ -1,21 +1,30 @@
 #include "accelerator/Component.hpp"
 #include "physics/Constants.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Parallel.hpp"
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
 #include <cmath>
+#include <fstream>
 
 namespace pas::accelerator {
 
 using namespace physics;
 using namespace physics::constants;
 
+std::atomic<uint64_t> Component::s_nextVersion{1};
+
 std::string componentTypeToString(ComponentType type) {
     switch (type) {
         case ComponentType::BeamPipe:   return "BeamPipe";
         case ComponentType::Dipole:     return "Dipole";
         case ComponentType::Quadrupole: return "Quadrupole";
         case ComponentType::Sextupole:  return "Sextupole";
+        case ComponentType::Multipole:  return "Multipole";
+        case ComponentType::Solenoid:   return "Solenoid";
         case ComponentType::RFCavity:   return "RFCavity";
         case ComponentType::Detector:   return "Detector";
+        case ComponentType::Monitor:    return "Monitor";
         case ComponentType::Custom:     return "Custom";
         default:                        return "Unknown";
     }
@@ -47,7 +56,8 @@ bool Aperture::isInside(double x, double y) const {
 Component::Component(std::string name, double length, const Aperture& aperture)
     : m_name(std::move(name))
     , m_length(length)
-    , m_aperture(aperture) {
+    , m_aperture(aperture)
+    , m_version(s_nextVersion.fetch_add(1, std::memory_order_relaxed)) {
 }
 
 glm::dvec3 Component::toLocal(const glm::dvec3& globalPos) const {
@@ -74,21 +84,107 @@ bool Component::isInsideAperture(const glm::dvec3& globalPos) const {
     return m_aperture.isInside(local.x, local.y);
 }
 
+void Component::copyPlacement(const Component& other) {
+    m_sPosition = other.m_sPosition;
+    m_position = other.m_position;
+    m_rotation = other.m_rotation;
+}
+
 // BeamPipe implementation
 
 BeamPipe::BeamPipe(const std::string& name, double length, const Aperture& aperture)
     : Component(name, length, aperture) {
 }
 
+std::shared_ptr<Component> BeamPipe::clone() const {
+    auto copy = std::make_shared<BeamPipe>(m_name, m_length, m_aperture);
+    copy->copyPlacement(*this);
+    return copy;
+}
+
+// Magnet implementation
+
+Magnet::Magnet(std::string name, double length, const Aperture& aperture)
+    : Component(std::move(name), length, aperture) {
+}
+
+void Magnet::setErrors(const MagnetErrors& errors) {
+    m_errors = errors;
+    m_fieldSource.reset();
+    markChanged();
+}
+
+void Magnet::clearErrors() {
+    setErrors(MagnetErrors());
+}
+
+void Magnet::setFringe(const EngeFunction& fringe) {
+    m_fringe = fringe;
+    m_fieldSource.reset();
+    markChanged();
+}
+
+void Magnet::clearFringe() {
+    m_fringe.reset();
+    m_fieldSource.reset();
+    markChanged();
+}
+
+void Magnet::setRamp(std::shared_ptr<const physics::Waveform> ramp) {
+    m_ramp = std::move(ramp);
+    markChanged();
+}
+
+physics::MultipoleExpansion Magnet::getMultipoles() const {
+    return m_errors.expand(getMainOrder(), getMainStrength());
+}
+
+void Magnet::updateMultipoleField() const {
+    std::static_pointer_cast<MultipoleField>(m_fieldSource)->setMultipoles(getMultipoles());
+}
+
+std::shared_ptr<FieldSource> Magnet::createMultipoleField() const {
+    glm::dvec3 center = m_position + glm::dvec3(m_errors.offsetX, m_errors.offsetY, 0.0);
+    return std::make_shared<MultipoleField>(
+        getMultipoles(),
+        center,
+        m_length,
+        m_aperture.radiusX,
+        m_errors.roll,
+        m_fringe
+    );
+}
+
 // Dipole implementation
 
 Dipole::Dipole(const std::string& name, double length, double field, const Aperture& aperture)
-    : Component(name, length, aperture)
+    : Magnet(name, length, aperture)
     , m_field(field) {
 }
 
+std::shared_ptr<Component> Dipole::clone() const {
+    auto copy = std::make_shared<Dipole>(m_name, m_length, m_field, m_aperture);
+    copy->copyPlacement(*this);
+    copy->m_errors = m_errors;
+    copy->m_fringe = m_fringe;
+    copy->m_ramp = m_ramp;
+    return copy;
+}
+
 std::shared_ptr<FieldSource> Dipole::getFieldSource() const {
-    if (!m_fieldSource) {
+    if (isFieldSourceCurrent()) {
+        return m_fieldSource;
+    }
+    if (isSourceStale()) {
+        // Strength changed: update the published source in place
+        if (usesMultipoleField()) {
+            updateMultipoleField();
+        } else {
+            std::static_pointer_cast<UniformBField>(m_fieldSource)->setField(glm::dvec3(0.0, m_field, 0.0));
+        }
+    } else if (!m_fieldSource && usesMultipoleField()) {
+        m_fieldSource = createMultipoleField();
+    } else if (!m_fieldSource) {
         // Vertical magnetic field (bends in horizontal plane)
         glm::dvec3 B(0.0, m_field, 0.0);
 
@@ -102,12 +198,13 @@ std::shared_ptr<FieldSource> Dipole::getFieldSource() const {
 
         m_fieldSource = std::make_shared<UniformBField>(B, bounds);
     }
+    m_sourceVersion = m_version;
     return m_fieldSource;
 }
 
 void Dipole::setField(double field) {
     m_field = field;
-    m_fieldSource.reset();  // Force recreation
+    markChanged();
 }
 
 double Dipole::getBendingAngle(double momentum) const {
@@ -127,12 +224,32 @@ double Dipole::getBendingRadius(double momentum) const {
 
 Quadrupole::Quadrupole(const std::string& name, double length, double gradient,
                        const Aperture& aperture)
-    : Component(name, length, aperture)
+    : Magnet(name, length, aperture)
     , m_gradient(gradient) {
 }
 
+std::shared_ptr<Component> Quadrupole::clone() const {
+    auto copy = std::make_shared<Quadrupole>(m_name, m_length, m_gradient, m_aperture);
+    copy->copyPlacement(*this);
+    copy->m_errors = m_errors;
+    copy->m_fringe = m_fringe;
+    copy->m_ramp = m_ramp;
+    return copy;
+}
+
 std::shared_ptr<FieldSource> Quadrupole::getFieldSource() const {
-    if (!m_fieldSource) {
+    if (isFieldSourceCurrent()) {
+        return m_fieldSource;
+    }
+    if (isSourceStale()) {
+        if (usesMultipoleField()) {
+            updateMultipoleField();
+        } else {
+            std::static_pointer_cast<QuadrupoleField>(m_fieldSource)->setGradient(m_gradient);
+        }
+    } else if (!m_fieldSource && usesMultipoleField()) {
+        m_fieldSource = createMultipoleField();
+    } else if (!m_fieldSource) {
         m_fieldSource = std::make_shared<QuadrupoleField>(
             m_gradient,
             m_position,
@@ -140,12 +257,13 @@ std::shared_ptr<FieldSource> Quadrupole::getFieldSource() const {
             m_aperture.radiusX
         );
     }
+    m_sourceVersion = m_version;
     return m_fieldSource;
 }
 
 void Quadrupole::setGradient(double gradient) {
     m_gradient = gradient;
-    m_fieldSource.reset();
+    markChanged();
 }
 
 double Quadrupole::getK1(double momentum) const {
@@ -153,6 +271,150 @@ double Quadrupole::getK1(double momentum) const {
     return e * m_gradient / momentum;
 }
 
+// Sextupole implementation
+
+Sextupole::Sextupole(const std::string& name, double length, double strength,
+                     const Aperture& aperture)
+    : Magnet(name, length, aperture)
+    , m_strength(strength) {
+}
+
+std::shared_ptr<Component> Sextupole::clone() const {
+    auto copy = std::make_shared<Sextupole>(m_name, m_length, m_strength, m_aperture);
+    copy->copyPlacement(*this);
+    copy->m_errors = m_errors;
+    copy->m_fringe = m_fringe;
+    copy->m_ramp = m_ramp;
+    return copy;
+}
+
+std::shared_ptr<FieldSource> Sextupole::getFieldSource() const {
+    if (isFieldSourceCurrent()) {
+        return m_fieldSource;
+    }
+    if (isSourceStale()) {
+        updateMultipoleField();
+    } else if (!m_fieldSource) {
+        m_fieldSource = createMultipoleField();
+    }
+    m_sourceVersion = m_version;
+    return m_fieldSource;
+}
+
+void Sextupole::setStrength(double strength) {
+    m_strength = strength;
+    markChanged();
+}
+
+double Sextupole::getK2(double momentum) const {
+    // K2 = (q * B'') / p  [m^-3]
+    return e * m_strength / momentum;
+}
+
+// Multipole implementation
+
+Multipole::Multipole(const std::string& name, double length, MultipoleExpansion multipoles,
+                     const Aperture& aperture)
+    : Magnet(name, length, aperture)
+    , m_multipoles(std::move(multipoles)) {
+}
+
+std::shared_ptr<Component> Multipole::clone() const {
+    auto copy = std::make_shared<Multipole>(m_name, m_length, m_multipoles, m_aperture);
+    copy->copyPlacement(*this);
+    copy->m_errors = m_errors;
+    copy->m_fringe = m_fringe;
+    copy->m_ramp = m_ramp;
+    return copy;
+}
+
+std::shared_ptr<FieldSource> Multipole::getFieldSource() const {
+    if (isFieldSourceCurrent()) {
+        return m_fieldSource;
+    }
+    if (isSourceStale()) {
+        updateMultipoleField();
+    } else if (!m_fieldSource) {
+        m_fieldSource = createMultipoleField();
+    }
+    m_sourceVersion = m_version;
+    return m_fieldSource;
+}
+
+void Multipole::setCoefficients(MultipoleExpansion multipoles) {
+    m_multipoles = std::move(multipoles);
+    markChanged();
+}
+
+int Multipole::getMainOrder() const {
+    for (int n = m_multipoles.getOrder(); n > 0; --n) {
+        if (m_multipoles.getNormal(n) != 0.0) {
+            return n;
+        }
+    }
+    return 1;
+}
+
+double Multipole::getMainStrength() const {
+    return m_multipoles.getNormal(getMainOrder());
+}
+
+MultipoleExpansion Multipole::getMultipoles() const {
+    MultipoleExpansion multipoles = m_multipoles;
+    m_errors.addTo(multipoles, getMainOrder(), getMainStrength());
+    return multipoles;
+}
+
+// Solenoid implementation
+
+Solenoid::Solenoid(const std::string& name, double length, double field, const Aperture& aperture)
+    : Component(name, length, aperture)
+    , m_field(field) {
+    m_fringe.gap = 2.0 * aperture.radiusX;
+}
+
+std::shared_ptr<Component> Solenoid::clone() const {
+    auto copy = std::make_shared<Solenoid>(m_name, m_length, m_field, m_aperture);
+    copy->copyPlacement(*this);
+    copy->m_fringe = m_fringe;
+    return copy;
+}
+
+std::shared_ptr<FieldSource> Solenoid::getFieldSource() const {
+    if (isFieldSourceCurrent()) {
+        return m_fieldSource;
+    }
+    if (m_fieldSource) {
+        m_fieldSource->setField(m_field);
+    } else {
+        m_fieldSource = std::make_shared<SolenoidField>(
+            m_field,
+            m_position,
+            m_length,
+            m_aperture.radiusX,
+            m_fringe
+        );
+    }
+    m_sourceVersion = m_version;
+    return m_fieldSource;
+}
+
+void Solenoid::setField(double field) {
+    m_field = field;
+    markChanged();
+}
+
+void Solenoid::setFringe(const EngeFunction& fringe) {
+    m_fringe = fringe;
+    m_fieldSource.reset();
+    markChanged();
+}
+
+double Solenoid::getKs(double momentum) const {
+    // Ks = (q * B) / (2 * p)  [m^-1]
+    return e * m_field / (2.0 * momentum);
+}
+
 // RFCavity implementation
 
 RFCavity::RFCavity(const std::string& name, double length, double voltage,
@@ -163,8 +425,21 @@ RFCavity::RFCavity(const std::string& name, double length, double voltage,
     , m_phase(phase) {
 }
 
+std::shared_ptr<Component> RFCavity::clone() const {
+    auto copy = std::make_shared<RFCavity>(m_name, m_length, m_voltage, m_frequency, m_phase, m_aperture);
+    copy->copyPlacement(*this);
+    return copy;
+}
+
 std::shared_ptr<FieldSource> RFCavity::getFieldSource() const {
-    if (!m_fieldSource) {
+    if (isFieldSourceCurrent()) {
+        return m_fieldSource;
+    }
+    if (m_fieldSource) {
+        m_fieldSource->setVoltage(m_voltage);
+        m_fieldSource->setFrequency(m_frequency);
+        m_fieldSource->setPhase(m_phase);
+    } else {
         m_fieldSource = std::make_shared<RFField>(
             m_voltage,
             m_frequency,
@@ -174,22 +449,23 @@ std::shared_ptr<FieldSource> RFCavity::getFieldSource() const {
             m_aperture.radiusX
         );
     }
+    m_sourceVersion = m_version;
     return m_fieldSource;
 }
 
 void RFCavity::setVoltage(double voltage) {
     m_voltage = voltage;
-    m_fieldSource.reset();
+    markChanged();
 }
 
 void RFCavity::setFrequency(double frequency) {
     m_frequency = frequency;
-    m_fieldSource.reset();
+    markChanged();
 }
 
 void RFCavity::setPhase(double phase) {
     m_phase = phase;
-    m_fieldSource.reset();
+    markChanged();
 }
 
 double RFCavity::getEnergyGain(double phase) const {
@@ -200,11 +476,141 @@ double RFCavity::getEnergyGain(double phase) const {
 
 Detector::Detector(const std::string& name, const Aperture& aperture)
     : Component(name, 0.001, aperture) {  // Thin detector
+    prepareCrossings(utils::getMaxThreads());
+}
+
+std::shared_ptr<Component> Detector::clone() const {
+    auto copy = std::make_shared<Detector>(m_name, m_aperture);
+    copy->copyPlacement(*this);
+    return copy;
+}
+
+Detector::~Detector() {
+    disableHitStreaming();
+}
+
+void Detector::prepareCrossings(int threadCount) {
+    size_t count = static_cast<size_t>(std::max(threadCount, 1));
+    if (m_threadHits.size() < count) {
+        m_threadHits.resize(count);
+    }
 }
 
 void Detector::recordHit(double time, const glm::dvec3& position,
                          const glm::dvec3& momentum, uint64_t particleId) {
-    m_hits.push_back({time, position, momentum, particleId});
+    size_t index = static_cast<size_t>(utils::getThreadIndex());
+    m_threadHits[index].buffer.push_back({time, position, momentum, particleId});
+}
+
+void Detector::recordCrossing(const PlaneCrossing& crossing) {
+    if (!m_aperture.isInside(crossing.x, crossing.y)) {
+        return;
+    }
+    recordHit(crossing.time, crossing.position, crossing.momentum, crossing.particleId);
+}
+
+void Detector::commitCrossings() {
+    if (m_stream) {
+        for (auto& thread : m_threadHits) {
+            m_streamedHits += thread.buffer.drainFullChunks(
+                [this](std::span<const Hit> hits) { writeHits(hits); });
+        }
+    }
+}
+
+const std::vector<Detector::Hit>& Detector::getHits() const {
+    bool pending = false;
+    for (auto& thread : m_threadHits) {
+        if (!thread.buffer.empty()) {
+            thread.buffer.moveInto(m_hits);
+            pending = true;
+        }
+    }
+
+    if (pending) {
+        std::stable_sort(m_hits.begin(), m_hits.end(),
+                         [](const Hit& a, const Hit& b) {
+                             return a.time < b.time ||
+                                    (a.time == b.time && a.particleId < b.particleId);
+                         });
+    }
+    return m_hits;
+}
+
+void Detector::clearHits() {
+    m_hits.clear();
+    for (auto& thread : m_threadHits) {
+        thread.buffer.clear();
+    }
+}
+
+size_t Detector::getHitCount() const {
+    size_t count = m_hits.size();
+    for (const auto& thread : m_threadHits) {
+        count += thread.buffer.size();
+    }
+    return count;
+}
+
+bool Detector::enableHitStreaming(const std::string& filepath) {
+    disableHitStreaming();
+
+    auto stream = std::make_unique<std::ofstream>(filepath, std::ios::binary | std::ios::trunc);
+    if (!stream->is_open()) {
+        PAS_ERROR("Detector {}: Could not create hit stream: {}", m_name, filepath);
+        return false;
+    }
+
+    m_stream = std::move(stream);
+    m_streamedHits = 0;
+    return true;
+}
+
+void Detector::disableHitStreaming() {
+    if (!m_stream) {
+        return;
+    }
+
+    // Flush everything still buffered, including partial chunks and merged hits
+    writeHits(getHits());
+    m_streamedHits += m_hits.size();
+    m_hits.clear();
+
+    m_stream.reset();
+}
+
+void Detector::writeHits(std::span<const Hit> hits) {
+    for (const Hit& hit : hits) {
+        const double record[7] = {
+            hit.time,
+            hit.position.x, hit.position.y, hit.position.z,
+            hit.momentum.x, hit.momentum.y, hit.momentum.z
+        };
+        m_stream->write(reinterpret_cast<const char*>(record), sizeof(record));
+        m_stream->write(reinterpret_cast<const char*>(&hit.particleId), sizeof(hit.particleId));
+    }
+}
+
+std::vector<Detector::Hit> Detector::readHitStream(const std::string& filepath) {
+    std::vector<Hit> hits;
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        PAS_WARN("Detector: Could not open hit stream: {}", filepath);
+        return hits;
+    }
+
+    double record[7];
+    uint64_t particleId = 0;
+    while (file.read(reinterpret_cast<char*>(record), sizeof(record)) &&
+           file.read(reinterpret_cast<char*>(&particleId), sizeof(particleId))) {
+        hits.push_back({
+            record[0],
+            glm::dvec3(record[1], record[2], record[3]),
+            glm::dvec3(record[4], record[5], record[6]),
+            particleId
+        });
+    }
+    return hits;
 }
 
 } // namespace pas::accelerator
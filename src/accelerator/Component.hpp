@@ -2,10 +2,18 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
+#include "accelerator/MagnetErrors.hpp"
 #include "physics/EMField.hpp"
+#include "physics/Waveform.hpp"
+#include "utils/ChunkedBuffer.hpp"
 
 namespace pas::accelerator {
 
@@ -17,8 +25,11 @@ enum class ComponentType {
     Dipole,
     Quadrupole,
     Sextupole,
+    Multipole,
+    Solenoid,
     RFCavity,
     Detector,
+    Monitor,
     Custom
 };
 
@@ -50,6 +61,24 @@ struct Aperture {
     bool isInside(double x, double y) const;
 };
 
+/**
+ * @brief A particle crossing a component's observation plane.
+ *
+ * Position, momentum and time are interpolated to the plane between the
+ * two integration steps that bracket it. x and y are the transverse offsets
+ * from the reference orbit at the plane, which is what monitors measure;
+ * on a curved lattice the global position is metres away from them.
+ */
+struct PlaneCrossing {
+    uint64_t particleId = 0;
+    uint64_t turn = 0;          // Turn number (0 for linear lattices)
+    double time = 0.0;          // Crossing time [s]
+    double x = 0.0;             // Horizontal offset from the reference orbit [m]
+    double y = 0.0;             // Vertical offset from the reference orbit [m]
+    glm::dvec3 position{0.0};   // Global position [m]
+    glm::dvec3 momentum{0.0};   // Momentum [kg*m/s]
+};
+
 /**
  * @brief Abstract base class for all accelerator components.
  *
@@ -72,9 +101,44 @@ public:
     virtual ComponentType getType() const = 0;
     virtual std::string getTypeName() const { return componentTypeToString(getType()); }
 
-    // Field access
+    /**
+     * @brief Get the field source, creating it on first use.
+     *
+     * Strength setters only bump the version; the next call updates the
+     * existing source in place. Structural changes (errors, fringe) create a
+     * new source, which PhysicsEngine swaps into its field manager. Once the
+     * source is current the call only reads, so engines sharing the
+     * component may call it concurrently.
+     */
     virtual std::shared_ptr<physics::FieldSource> getFieldSource() const = 0;
 
+    /**
+     * @brief Check if getFieldSource() would return its cached source unchanged.
+     *
+     * False while the source is unbuilt or predates a strength change: the
+     * next getFieldSource() call then writes to the component, so a component
+     * shared between engines must be current before they run concurrently.
+     */
+    virtual bool isFieldSourceCurrent() const { return true; }
+
+    /**
+     * @brief Parameter version, renewed by every setter that changes the field.
+     *
+     * Versions come from one counter shared by all components, so no two
+     * components ever hold the same one. A cache keyed on the component's
+     * address and version cannot mistake a new component allocated where a
+     * freed one was for the old one. PhysicsEngine compares versions at each
+     * step boundary and publishes the field sources of changed components.
+     */
+    uint64_t getVersion() const { return m_version; }
+
+    /**
+     * @brief Create an independent copy of the component's configuration.
+     *
+     * Recorded data (detector hits, monitor turns) is not copied.
+     */
+    virtual std::shared_ptr<Component> clone() const = 0;
+
     // Geometry
     const std::string& getName() const { return m_name; }
     double getLength() const { return m_length; }
@@ -82,6 +146,9 @@ public:
 
     /**
      * @brief Get the s-position (longitudinal position along beamline).
+     *
+     * A component shared by several places of a lattice reports its last
+     * one; use Accelerator::getSPosition() for a particular occurrence.
      */
     double getSPosition() const { return m_sPosition; }
 
@@ -100,7 +167,8 @@ public:
      */
     double getExitS() const { return m_sPosition + m_length; }
 
-    // Position and orientation in global coordinates
+    // Alignment relative to the reference frame at the entrance; the survey
+    // of CompiledLattice places that frame globally
     const glm::dvec3& getPosition() const { return m_position; }
     void setPosition(const glm::dvec3& pos) { m_position = pos; }
 
@@ -108,17 +176,20 @@ public:
     void setRotation(const glm::dquat& rot) { m_rotation = rot; }
 
     /**
-     * @brief Transform a global position to local component coordinates.
+     * @brief Transform a position in the entrance reference frame to local component coordinates.
      */
     glm::dvec3 toLocal(const glm::dvec3& globalPos) const;
 
     /**
-     * @brief Transform a local position to global coordinates.
+     * @brief Transform a local position to the entrance reference frame.
      */
     glm::dvec3 toGlobal(const glm::dvec3& localPos) const;
 
     /**
-     * @brief Check if a global position is inside this component's aperture.
+     * @brief Check if a position in the entrance reference frame is inside the aperture.
+     *
+     * Treats the component as straight; CompiledLattice::isInsideAperture()
+     * takes global positions and follows the arc of bends.
      */
     bool isInsideAperture(const glm::dvec3& globalPos) const;
 
@@ -129,13 +200,49 @@ public:
         return s >= m_sPosition && s < m_sPosition + m_length;
     }
 
+    // Observation plane (entrance plane at getSPosition())
+
+    /**
+     * @brief Check if the physics engine should report plane crossings.
+     */
+    virtual bool observesCrossings() const { return false; }
+
+    /**
+     * @brief Size per-thread crossing storage. Called before each parallel step.
+     */
+    virtual void prepareCrossings(int /*threadCount*/) {}
+
+    /**
+     * @brief Record a plane crossing. Called concurrently from tracking threads.
+     */
+    virtual void recordCrossing(const PlaneCrossing& /*crossing*/) {}
+
+    /**
+     * @brief Merge or flush per-thread crossing data. Called after each step.
+     */
+    virtual void commitCrossings() {}
+
 protected:
+    /**
+     * @brief Copy s-position, global position and rotation (used by clone()).
+     */
+    void copyPlacement(const Component& other);
+
+    /**
+     * @brief Record a parameter change.
+     */
+    void markChanged() { m_version = s_nextVersion.fetch_add(1, std::memory_order_relaxed); }
+
     std::string m_name;
     double m_length;
     Aperture m_aperture;
     double m_sPosition = 0.0;
     glm::dvec3 m_position{0.0};
     glm::dquat m_rotation{1.0, 0.0, 0.0, 0.0};  // Identity quaternion
+    uint64_t m_version;
+
+private:
+    static std::atomic<uint64_t> s_nextVersion;
 };
 
 /**
@@ -149,12 +256,97 @@ public:
 
     ComponentType getType() const override { return ComponentType::BeamPipe; }
     std::shared_ptr<physics::FieldSource> getFieldSource() const override { return nullptr; }
+    std::shared_ptr<Component> clone() const override;
+};
+
+/**
+ * @brief Base class for magnets, which can carry field and alignment errors.
+ *
+ * A perfect hard-edge magnet uses the dedicated field source of its type.
+ * With errors or a fringe set, the field source is a MultipoleField holding
+ * the main field plus the error multipoles, centered at the offset position,
+ * rolled, and falling off with the fringe profile.
+ */
+class Magnet : public Component {
+public:
+    Magnet(std::string name, double length, const Aperture& aperture = Aperture());
+
+    /**
+     * @brief Order of the main field (1 dipole, 2 quadrupole, ...).
+     */
+    virtual int getMainOrder() const = 0;
+
+    /**
+     * @brief Main field coefficient [T/m^(order-1)].
+     */
+    virtual double getMainStrength() const = 0;
+
+    const MagnetErrors& getErrors() const { return m_errors; }
+    void setErrors(const MagnetErrors& errors);
+    void clearErrors();
+    bool hasErrors() const { return !m_errors.isZero(); }
+
+    /**
+     * @brief Set an Enge fringe field at both ends.
+     *
+     * The effective length is unchanged. LatticeTracker adds the linear
+     * fringe maps; optics functions keep the hard-edge model.
+     */
+    void setFringe(const physics::EngeFunction& fringe);
+    void clearFringe();
+    const std::optional<physics::EngeFunction>& getFringe() const { return m_fringe; }
+
+    /**
+     * @brief Drive the strength with a waveform of relative strength versus time.
+     *
+     * PhysicsEngine evaluates each waveform once per step and scales its
+     * own placements of all magnets sharing it; the magnet's field source is
+     * left untouched. Optics and LatticeTracker use the nominal strength.
+     */
+    void setRamp(std::shared_ptr<const physics::Waveform> ramp);
+    const std::shared_ptr<const physics::Waveform>& getRamp() const { return m_ramp; }
+
+    bool isFieldSourceCurrent() const override {
+        return m_fieldSource && m_sourceVersion == m_version;
+    }
+
+    /**
+     * @brief Field expansion in the magnet frame, including errors.
+     */
+    virtual physics::MultipoleExpansion getMultipoles() const;
+
+protected:
+    /**
+     * @brief Create a MultipoleField from getMultipoles(), offset and rolled.
+     */
+    std::shared_ptr<physics::FieldSource> createMultipoleField() const;
+
+    /**
+     * @brief Check if the field source is a MultipoleField (errors or fringe set).
+     */
+    bool usesMultipoleField() const { return hasErrors() || m_fringe.has_value(); }
+
+    /**
+     * @brief Check if the field source predates the last strength change.
+     */
+    bool isSourceStale() const { return m_fieldSource && m_sourceVersion != m_version; }
+
+    /**
+     * @brief Copy getMultipoles() into the existing MultipoleField.
+     */
+    void updateMultipoleField() const;
+
+    MagnetErrors m_errors;
+    std::optional<physics::EngeFunction> m_fringe;
+    std::shared_ptr<const physics::Waveform> m_ramp;
+    mutable std::shared_ptr<physics::FieldSource> m_fieldSource;
+    mutable uint64_t m_sourceVersion = 0;
 };
 
 /**
  * @brief Dipole magnet for beam bending.
  */
-class Dipole : public Component {
+class Dipole : public Magnet {
 public:
     /**
      * @brief Construct a dipole magnet.
@@ -168,10 +360,14 @@ public:
 
     ComponentType getType() const override { return ComponentType::Dipole; }
     std::shared_ptr<physics::FieldSource> getFieldSource() const override;
+    std::shared_ptr<Component> clone() const override;
 
     double getField() const { return m_field; }
     void setField(double field);
 
+    int getMainOrder() const override { return 1; }
+    double getMainStrength() const override { return m_field; }
+
     /**
      * @brief Calculate the bending angle for a given momentum.
      * @param momentum Reference momentum in kg*m/s.
@@ -186,13 +382,12 @@ public:
 
 private:
     double m_field;  // Tesla
-    mutable std::shared_ptr<physics::UniformBField> m_fieldSource;
 };
 
 /**
  * @brief Quadrupole magnet for focusing/defocusing.
  */
-class Quadrupole : public Component {
+class Quadrupole : public Magnet {
 public:
     /**
      * @brief Construct a quadrupole magnet.
@@ -206,10 +401,14 @@ public:
 
     ComponentType getType() const override { return ComponentType::Quadrupole; }
     std::shared_ptr<physics::FieldSource> getFieldSource() const override;
+    std::shared_ptr<Component> clone() const override;
 
     double getGradient() const { return m_gradient; }
     void setGradient(double gradient);
 
+    int getMainOrder() const override { return 2; }
+    double getMainStrength() const override { return m_gradient; }
+
     /**
      * @brief Calculate K1 strength (normalized gradient).
      * @param momentum Reference momentum in kg*m/s.
@@ -224,7 +423,126 @@ public:
 
 private:
     double m_gradient;  // T/m
-    mutable std::shared_ptr<physics::QuadrupoleField> m_fieldSource;
+};
+
+/**
+ * @brief Sextupole magnet for chromaticity correction.
+ *
+ * By + i*Bx = (B''/2) * (x + i*y)^2
+ */
+class Sextupole : public Magnet {
+public:
+    /**
+     * @brief Construct a sextupole magnet.
+     * @param name Component name.
+     * @param length Effective length in meters.
+     * @param strength Second field derivative B'' in T/m^2.
+     * @param aperture Aperture specification.
+     */
+    Sextupole(const std::string& name, double length, double strength,
+              const Aperture& aperture = Aperture());
+
+    ComponentType getType() const override { return ComponentType::Sextupole; }
+    std::shared_ptr<physics::FieldSource> getFieldSource() const override;
+    std::shared_ptr<Component> clone() const override;
+
+    double getStrength() const { return m_strength; }
+    void setStrength(double strength);
+
+    int getMainOrder() const override { return 3; }
+    double getMainStrength() const override { return m_strength / 2.0; }
+
+    /**
+     * @brief Calculate K2 strength (normalized second derivative).
+     * @param momentum Reference momentum in kg*m/s.
+     * @return K2 in m^-3.
+     */
+    double getK2(double momentum) const;
+
+private:
+    double m_strength;  // T/m^2
+};
+
+/**
+ * @brief General multipole magnet with arbitrary normal and skew coefficients.
+ *
+ * Optics and the linear maps of LatticeTracker treat it as a drift; the
+ * tracker applies its whole field as thin kicks. Errors are relative to the
+ * highest normal order present.
+ */
+class Multipole : public Magnet {
+public:
+    /**
+     * @brief Construct a multipole magnet.
+     * @param name Component name.
+     * @param length Effective length in meters.
+     * @param multipoles Absolute coefficients [T/m^(n-1)].
+     * @param aperture Aperture specification.
+     */
+    Multipole(const std::string& name, double length, physics::MultipoleExpansion multipoles,
+              const Aperture& aperture = Aperture());
+
+    ComponentType getType() const override { return ComponentType::Multipole; }
+    std::shared_ptr<physics::FieldSource> getFieldSource() const override;
+    std::shared_ptr<Component> clone() const override;
+
+    const physics::MultipoleExpansion& getCoefficients() const { return m_multipoles; }
+    void setCoefficients(physics::MultipoleExpansion multipoles);
+
+    int getMainOrder() const override;
+    double getMainStrength() const override;
+    physics::MultipoleExpansion getMultipoles() const override;
+
+private:
+    physics::MultipoleExpansion m_multipoles;
+};
+
+/**
+ * @brief Solenoid for coupled focusing of both planes.
+ *
+ * The field always has Enge fringes: the focusing of a solenoid comes from
+ * the radial field at its ends, which a hard-edge field would not have.
+ */
+class Solenoid : public Component {
+public:
+    /**
+     * @brief Construct a solenoid.
+     * @param name Component name.
+     * @param length Effective length in meters.
+     * @param field Central longitudinal field in Tesla.
+     * @param aperture Aperture specification.
+     */
+    Solenoid(const std::string& name, double length, double field,
+             const Aperture& aperture = Aperture());
+
+    ComponentType getType() const override { return ComponentType::Solenoid; }
+    std::shared_ptr<physics::FieldSource> getFieldSource() const override;
+    bool isFieldSourceCurrent() const override {
+        return m_fieldSource && m_sourceVersion == m_version;
+    }
+    std::shared_ptr<Component> clone() const override;
+
+    double getField() const { return m_field; }
+    void setField(double field);
+
+    /**
+     * @brief Fringe fall-off; the default gap is the bore diameter.
+     */
+    const physics::EngeFunction& getFringe() const { return m_fringe; }
+    void setFringe(const physics::EngeFunction& fringe);
+
+    /**
+     * @brief Calculate the solenoid strength Ks = q * B / (2 * p).
+     * @param momentum Reference momentum in kg*m/s.
+     * @return Ks in m^-1.
+     */
+    double getKs(double momentum) const;
+
+private:
+    double m_field;  // Tesla
+    physics::EngeFunction m_fringe;
+    mutable std::shared_ptr<physics::SolenoidField> m_fieldSource;
+    mutable uint64_t m_sourceVersion = 0;
 };
 
 /**
@@ -247,6 +565,10 @@ public:
 
     ComponentType getType() const override { return ComponentType::RFCavity; }
     std::shared_ptr<physics::FieldSource> getFieldSource() const override;
+    bool isFieldSourceCurrent() const override {
+        return m_fieldSource && m_sourceVersion == m_version;
+    }
+    std::shared_ptr<Component> clone() const override;
 
     double getVoltage() const { return m_voltage; }
     void setVoltage(double voltage);
@@ -269,10 +591,15 @@ private:
     double m_frequency;  // Hz
     double m_phase;      // radians
     mutable std::shared_ptr<physics::RFField> m_fieldSource;
+    mutable uint64_t m_sourceVersion = 0;
 };
 
 /**
  * @brief Detector for recording particle passage.
+ *
+ * Hits are appended to per-thread chunked buffers while tracking and merged
+ * into a single list only when requested. With streaming enabled, full
+ * chunks are written to disk after each step and released from memory.
  */
 class Detector : public Component {
 public:
@@ -292,33 +619,79 @@ public:
      * @param aperture Aperture specification.
      */
     Detector(const std::string& name, const Aperture& aperture = Aperture());
+    ~Detector() override;
 
     ComponentType getType() const override { return ComponentType::Detector; }
     std::shared_ptr<physics::FieldSource> getFieldSource() const override { return nullptr; }
+    std::shared_ptr<Component> clone() const override;
 
     /**
-     * @brief Record a particle hit.
+     * @brief Record a particle hit. Safe to call from parallel tracking threads.
      */
     void recordHit(double time, const glm::dvec3& position,
                    const glm::dvec3& momentum, uint64_t particleId);
 
     /**
-     * @brief Get all recorded hits.
+     * @brief Get all in-memory hits, ordered by time.
+     *
+     * Merges per-thread buffers on first access after new hits. Hits already
+     * streamed to disk are not included. Must not be called while tracking.
+     */
+    const std::vector<Hit>& getHits() const;
+
+    /**
+     * @brief Clear all in-memory hits.
+     */
+    void clearHits();
+
+    /**
+     * @brief Get the number of in-memory hits.
+     */
+    size_t getHitCount() const;
+
+    /**
+     * @brief Stream hits to a binary file instead of keeping them in memory.
+     * @return True if the file could be opened.
      */
-    const std::vector<Hit>& getHits() const { return m_hits; }
+    bool enableHitStreaming(const std::string& filepath);
 
     /**
-     * @brief Clear all hits.
+     * @brief Flush all buffered hits to the stream and close it.
      */
-    void clearHits() { m_hits.clear(); }
+    void disableHitStreaming();
+
+    bool isStreaming() const { return m_stream != nullptr; }
 
     /**
-     * @brief Get the number of hits.
+     * @brief Get the number of hits written to the stream.
      */
-    size_t getHitCount() const { return m_hits.size(); }
+    size_t getStreamedHitCount() const { return m_streamedHits; }
+
+    /**
+     * @brief Read a hit stream written by enableHitStreaming().
+     */
+    static std::vector<Hit> readHitStream(const std::string& filepath);
+
+    // Observation plane
+    bool observesCrossings() const override { return true; }
+    void prepareCrossings(int threadCount) override;
+    void recordCrossing(const PlaneCrossing& crossing) override;
+    void commitCrossings() override;
 
 private:
-    std::vector<Hit> m_hits;
+    using HitBuffer = utils::ChunkedBuffer<Hit>;
+
+    struct alignas(64) ThreadHits {
+        HitBuffer buffer;
+    };
+
+    void writeHits(std::span<const Hit> hits);
+
+    mutable std::vector<ThreadHits> m_threadHits;
+    mutable std::vector<Hit> m_hits;
+
+    std::unique_ptr<std::ofstream> m_stream;
+    size_t m_streamedHits = 0;
 };
 
 } // namespace pas::accelerator
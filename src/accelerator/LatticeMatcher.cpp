@@ -0,0 +1,362 @@
+#include "accelerator/LatticeMatcher.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace pas::accelerator {
+
+namespace {
+
+// Damping limits; above the maximum the search has stalled
+constexpr double MIN_DAMPING = 1e-12;
+constexpr double MAX_DAMPING = 1e12;
+
+double cost(const std::vector<double>& residuals) {
+    double sum = 0.0;
+    for (double r : residuals) {
+        sum += r * r;
+    }
+    return 0.5 * sum;
+}
+
+/**
+ * @brief Solve A x = b in place by Gaussian elimination with partial pivoting.
+ * @return False if A is singular.
+ */
+bool solveLinear(std::vector<double>& A, std::vector<double>& b, size_t n) {
+    for (size_t col = 0; col < n; ++col) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < n; ++row) {
+            if (std::abs(A[row * n + col]) > std::abs(A[pivot * n + col])) {
+                pivot = row;
+            }
+        }
+        if (A[pivot * n + col] == 0.0) {
+            return false;
+        }
+        if (pivot != col) {
+            for (size_t k = 0; k < n; ++k) {
+                std::swap(A[col * n + k], A[pivot * n + k]);
+            }
+            std::swap(b[col], b[pivot]);
+        }
+        for (size_t row = col + 1; row < n; ++row) {
+            double factor = A[row * n + col] / A[col * n + col];
+            for (size_t k = col; k < n; ++k) {
+                A[row * n + k] -= factor * A[col * n + k];
+            }
+            b[row] -= factor * b[col];
+        }
+    }
+    for (size_t i = n; i-- > 0;) {
+        double sum = b[i];
+        for (size_t k = i + 1; k < n; ++k) {
+            sum -= A[i * n + k] * b[k];
+        }
+        b[i] = sum / A[i * n + i];
+    }
+    return true;
+}
+
+} // namespace
+
+LatticeMatcher::LatticeMatcher(const Accelerator& lattice, double referenceMomentum, double charge)
+    : m_lattice(lattice.clone())
+    , m_referenceMomentum(referenceMomentum)
+    , m_charge(charge) {}
+
+bool LatticeMatcher::resolveTargets(const Accelerator& lattice, const MatchKnob& knob,
+                                    std::vector<std::shared_ptr<Component>>& targets) {
+    const ComponentType type = knob.parameter == KnobParameter::QuadrupoleGradient
+        ? ComponentType::Quadrupole : ComponentType::Dipole;
+
+    targets.clear();
+    for (const auto& name : knob.components) {
+        auto component = lattice.getComponent(name);
+        if (!component || component->getType() != type) {
+            PAS_ERROR("LatticeMatcher: Knob '{}' needs a {} named '{}'",
+                      knob.name, componentTypeToString(type), name);
+            return false;
+        }
+        targets.push_back(std::move(component));
+    }
+    return !targets.empty();
+}
+
+void LatticeMatcher::setParameter(Component& component, KnobParameter parameter, double value) {
+    if (parameter == KnobParameter::QuadrupoleGradient) {
+        static_cast<Quadrupole&>(component).setGradient(value);
+    } else {
+        static_cast<Dipole&>(component).setField(value);
+    }
+}
+
+bool LatticeMatcher::addKnob(const MatchKnob& knob) {
+    std::vector<std::shared_ptr<Component>> targets;
+    if (!resolveTargets(*m_lattice, knob, targets)) {
+        return false;
+    }
+
+    const Component& first = *targets.front();
+    double value = knob.parameter == KnobParameter::QuadrupoleGradient
+        ? static_cast<const Quadrupole&>(first).getGradient()
+        : static_cast<const Dipole&>(first).getField();
+
+    m_knobs.push_back(knob);
+    m_startValues.push_back(std::clamp(value, knob.minimum, knob.maximum));
+    return true;
+}
+
+bool LatticeMatcher::addConstraint(const MatchConstraint& constraint) {
+    if (constraint.quantity == ConstraintQuantity::Custom && !constraint.evaluate) {
+        PAS_ERROR("LatticeMatcher: Custom constraint without an evaluation function");
+        return false;
+    }
+
+    std::optional<size_t> location;
+    if (!constraint.location.empty()) {
+        const auto& components = m_lattice->getComponents();
+        for (size_t i = 0; i < components.size(); ++i) {
+            if (components[i]->getName() == constraint.location) {
+                location = i;
+                break;
+            }
+        }
+        if (!location) {
+            PAS_ERROR("LatticeMatcher: Unknown constraint location '{}'", constraint.location);
+            return false;
+        }
+    }
+
+    m_constraints.push_back(constraint);
+    m_locations.push_back(location);
+    return true;
+}
+
+LatticeMatcher::Workspace LatticeMatcher::makeWorkspace() const {
+    Workspace workspace;
+    workspace.lattice = m_lattice->clone();
+    workspace.optics = std::make_unique<Optics>(workspace.lattice, m_referenceMomentum, m_charge);
+    workspace.knobTargets.resize(m_knobs.size());
+    for (size_t k = 0; k < m_knobs.size(); ++k) {
+        resolveTargets(*workspace.lattice, m_knobs[k], workspace.knobTargets[k]);
+    }
+    workspace.applied.assign(m_knobs.size(), std::numeric_limits<double>::quiet_NaN());
+    return workspace;
+}
+
+double LatticeMatcher::clamp(size_t knob, double value) const {
+    return std::clamp(value, m_knobs[knob].minimum, m_knobs[knob].maximum);
+}
+
+bool LatticeMatcher::evaluate(Workspace& workspace, const std::vector<double>& values,
+                              std::vector<double>& residuals) const {
+    // Setters mark their component changed, so unchanged knobs are skipped
+    // to keep the optics cache valid upstream of the perturbed magnet
+    for (size_t k = 0; k < m_knobs.size(); ++k) {
+        if (values[k] == workspace.applied[k]) {
+            continue;
+        }
+        for (const auto& component : workspace.knobTargets[k]) {
+            setParameter(*component, m_knobs[k].parameter, values[k]);
+        }
+        workspace.applied[k] = values[k];
+    }
+
+    Optics& optics = *workspace.optics;
+    if (!optics.compute()) {
+        return false;
+    }
+
+    residuals.resize(m_constraints.size());
+    for (size_t i = 0; i < m_constraints.size(); ++i) {
+        const MatchConstraint& constraint = m_constraints[i];
+        const OpticsPoint& point = m_locations[i] ? optics.getPoints()[*m_locations[i]] : optics.getStart();
+
+        double value = 0.0;
+        switch (constraint.quantity) {
+            case ConstraintQuantity::TuneX:      value = optics.getTuneX(); break;
+            case ConstraintQuantity::TuneY:      value = optics.getTuneY(); break;
+            case ConstraintQuantity::BetaX:      value = point.x.beta; break;
+            case ConstraintQuantity::BetaY:      value = point.y.beta; break;
+            case ConstraintQuantity::AlphaX:     value = point.x.alpha; break;
+            case ConstraintQuantity::AlphaY:     value = point.y.alpha; break;
+            case ConstraintQuantity::Dispersion: value = point.dispersion; break;
+            case ConstraintQuantity::Custom:     value = constraint.evaluate(*workspace.lattice, optics); break;
+        }
+        if (!std::isfinite(value)) {
+            return false;
+        }
+        residuals[i] = constraint.weight * (value - constraint.target);
+    }
+    return true;
+}
+
+MatchResult LatticeMatcher::match(const MatchSettings& settings) const {
+    MatchResult result;
+    result.values = m_startValues;
+
+    const size_t n = m_knobs.size();
+    const size_t m = m_constraints.size();
+
+    std::vector<Workspace> workspaces;
+    workspaces.reserve(static_cast<size_t>(utils::getMaxThreads()));
+    for (int t = 0; t < utils::getMaxThreads(); ++t) {
+        workspaces.push_back(makeWorkspace());
+    }
+
+    std::vector<double> residuals;
+    ++result.evaluations;
+    if (!evaluate(workspaces.front(), result.values, residuals)) {
+        PAS_ERROR("LatticeMatcher: Optics cannot be computed at the start values");
+        return result;
+    }
+    result.initialCost = cost(residuals);
+    result.finalCost = result.initialCost;
+
+    std::vector<double> scale(n);
+    for (size_t k = 0; k < n; ++k) {
+        scale[k] = std::max(std::abs(m_startValues[k]), 1.0);
+    }
+
+    std::vector<double> jacobian(m * n);
+    double damping = settings.initialDamping;
+    size_t evaluations = 0;
+
+    while (result.finalCost > settings.tolerance && result.iterations < settings.maxIterations &&
+           damping < MAX_DAMPING && n > 0) {
+        ++result.iterations;
+
+        // Forward-difference Jacobian, one knob per column
+        const auto columns = static_cast<ptrdiff_t>(n);
+#ifdef PAS_ENABLE_OPENMP
+        #pragma omp parallel for schedule(dynamic, 1) reduction(+:evaluations)
+#endif
+        for (ptrdiff_t c = 0; c < columns; ++c) {
+            const size_t k = static_cast<size_t>(c);
+            Workspace& workspace = workspaces[static_cast<size_t>(utils::getThreadIndex())];
+
+            std::vector<double> probe = result.values;
+            double step = settings.relativeStep * std::max(std::abs(probe[k]), 1.0);
+            if (probe[k] + step > m_knobs[k].maximum) {
+                step = -step;
+            }
+            probe[k] += step;
+
+            std::vector<double> probed;
+            ++evaluations;
+            bool valid = evaluate(workspace, probe, probed);
+            for (size_t i = 0; i < m; ++i) {
+                jacobian[i * n + k] = valid ? (probed[i] - residuals[i]) / step : 0.0;
+            }
+        }
+
+        // Levenberg step in knob units scaled by the start values. With fewer
+        // constraints than knobs, the equivalent m x m system is solved:
+        // (J^T J + lambda I)^-1 J^T = J^T (J J^T + lambda I)^-1
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t k = 0; k < n; ++k) {
+                jacobian[i * n + k] *= scale[k];
+            }
+        }
+        const bool constraintSpace = m < n;
+        const size_t size = constraintSpace ? m : n;
+        std::vector<double> normal(size * size, 0.0);
+        std::vector<double> rhs(size, 0.0);
+        if (constraintSpace) {
+            for (size_t a = 0; a < m; ++a) {
+                for (size_t b = 0; b < m; ++b) {
+                    for (size_t k = 0; k < n; ++k) {
+                        normal[a * m + b] += jacobian[a * n + k] * jacobian[b * n + k];
+                    }
+                }
+                rhs[a] = -residuals[a];
+            }
+        } else {
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t a = 0; a < n; ++a) {
+                    rhs[a] -= jacobian[i * n + a] * residuals[i];
+                    for (size_t b = 0; b < n; ++b) {
+                        normal[a * n + b] += jacobian[i * n + a] * jacobian[i * n + b];
+                    }
+                }
+            }
+        }
+        double diagonal = 0.0;
+        for (size_t a = 0; a < size; ++a) {
+            diagonal = std::max(diagonal, normal[a * size + a]);
+        }
+        diagonal = std::max(diagonal, MIN_DAMPING);
+
+        // Increase damping until a step lowers the cost
+        bool improved = false;
+        while (!improved && damping < MAX_DAMPING) {
+            std::vector<double> system = normal;
+            std::vector<double> solution = rhs;
+            for (size_t a = 0; a < size; ++a) {
+                system[a * size + a] += damping * diagonal;
+            }
+            if (!solveLinear(system, solution, size)) {
+                damping *= 10.0;
+                continue;
+            }
+
+            std::vector<double> trial(n);
+            for (size_t k = 0; k < n; ++k) {
+                double step = 0.0;
+                if (constraintSpace) {
+                    for (size_t i = 0; i < m; ++i) {
+                        step += jacobian[i * n + k] * solution[i];
+                    }
+                } else {
+                    step = solution[k];
+                }
+                trial[k] = clamp(k, result.values[k] + step * scale[k]);
+            }
+
+            std::vector<double> trialResiduals;
+            ++evaluations;
+            if (evaluate(workspaces.front(), trial, trialResiduals) &&
+                cost(trialResiduals) < result.finalCost) {
+                result.values = std::move(trial);
+                residuals = std::move(trialResiduals);
+                result.finalCost = cost(residuals);
+                damping = std::max(damping * 0.1, MIN_DAMPING);
+                improved = true;
+            } else {
+                damping *= 10.0;
+            }
+        }
+    }
+
+    result.evaluations += evaluations;
+    result.residuals = residuals;
+    result.converged = result.finalCost <= settings.tolerance;
+
+    PAS_INFO("LatticeMatcher: {} knobs, {} constraints, cost {:.3e} -> {:.3e} in {} iterations ({} evaluations)",
+             n, m, result.initialCost, result.finalCost, result.iterations, result.evaluations);
+    return result;
+}
+
+bool LatticeMatcher::apply(Accelerator& lattice, const MatchResult& result) const {
+    if (result.values.size() != m_knobs.size()) {
+        PAS_ERROR("LatticeMatcher: Result has {} values for {} knobs", result.values.size(), m_knobs.size());
+        return false;
+    }
+
+    std::vector<std::shared_ptr<Component>> targets;
+    for (size_t k = 0; k < m_knobs.size(); ++k) {
+        if (!resolveTargets(lattice, m_knobs[k], targets)) {
+            return false;
+        }
+        for (const auto& component : targets) {
+            setParameter(*component, m_knobs[k].parameter, result.values[k]);
+        }
+    }
+    return true;
+}
+
+} // namespace pas::accelerator
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "accelerator/Accelerator.hpp"
+#include "accelerator/Optics.hpp"
+#include "physics/Constants.hpp"
+
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pas::accelerator {
+
+/**
+ * @brief Component parameter driven by a matching knob.
+ */
+enum class KnobParameter {
+    QuadrupoleGradient,  // T/m
+    DipoleField          // T
+};
+
+/**
+ * @brief A variable of the matching problem.
+ *
+ * All listed components are set to the same value, so a knob can drive a
+ * single magnet or a whole family (e.g. every QF of a FODO lattice).
+ */
+struct MatchKnob {
+    std::string name;                       // Label used in log messages
+    std::vector<std::string> components;    // Component names driven together
+    KnobParameter parameter = KnobParameter::QuadrupoleGradient;
+    double minimum = -std::numeric_limits<double>::infinity();
+    double maximum = std::numeric_limits<double>::infinity();
+};
+
+/**
+ * @brief Quantity constrained by the matcher.
+ */
+enum class ConstraintQuantity {
+    TuneX,
+    TuneY,
+    BetaX,
+    BetaY,
+    AlphaX,
+    AlphaY,
+    Dispersion,
+    Custom       // Value returned by MatchConstraint::evaluate
+};
+
+/**
+ * @brief A target of the matching problem.
+ *
+ * Optics quantities are taken at the exit of the named component, or at the
+ * lattice start if no location is given. Custom constraints (for example a
+ * quantity from a LatticeTracker run) are evaluated on a private copy of the
+ * lattice and may be called concurrently from several threads.
+ */
+struct MatchConstraint {
+    ConstraintQuantity quantity = ConstraintQuantity::TuneX;
+    std::string location;
+    double target = 0.0;
+    double weight = 1.0;
+    std::function<double(const Accelerator&, const Optics&)> evaluate;
+};
+
+/**
+ * @brief Levenberg-Marquardt settings.
+ */
+struct MatchSettings {
+    size_t maxIterations = 100;
+    double tolerance = 1e-16;        // Stop once the weighted cost 1/2 |r|^2 is below this
+    double initialDamping = 1e-3;    // Initial lambda
+    double relativeStep = 1e-7;      // Finite-difference step relative to max(|value|, 1)
+};
+
+/**
+ * @brief Outcome of a matching run.
+ */
+struct MatchResult {
+    bool converged = false;          // Cost reached the tolerance
+    size_t iterations = 0;
+    size_t evaluations = 0;          // Optics evaluations, including the Jacobians
+    double initialCost = 0.0;
+    double finalCost = 0.0;
+    std::vector<double> values;      // Knob values, in the order they were added
+    std::vector<double> residuals;   // Weighted residuals at the final values
+};
+
+/**
+ * @brief Lattice matching with Levenberg-Marquardt.
+ *
+ * Knobs and constraints are declared against a snapshot of the lattice taken
+ * at construction. Each Jacobian is built by forward differences, one knob
+ * per column, with the columns evaluated in parallel on per-thread clones of
+ * the lattice. Each clone keeps its own Optics and only writes knobs whose
+ * value changed, so perturbing a knob only rebuilds the transfer matrices
+ * downstream of the first magnet that changed. Steps are
+ * damped in knob units scaled by the start values, and solved in constraint
+ * space when there are fewer constraints than knobs.
+ */
+class LatticeMatcher {
+public:
+    /**
+     * @brief Create a matcher for a lattice.
+     * @param lattice Lattice to match; copied, so it is not modified by match().
+     * @param referenceMomentum Reference momentum p0 [kg*m/s].
+     * @param charge Particle charge [C].
+     */
+    LatticeMatcher(const Accelerator& lattice, double referenceMomentum,
+                   double charge = physics::constants::e);
+
+    /**
+     * @brief Add a knob. Its start value is read from the first component.
+     * @return False if a component is missing or of the wrong type.
+     */
+    bool addKnob(const MatchKnob& knob);
+
+    /**
+     * @brief Add a constraint.
+     * @return False if the location is unknown or a custom constraint has no function.
+     */
+    bool addConstraint(const MatchConstraint& constraint);
+
+    size_t getKnobCount() const { return m_knobs.size(); }
+    size_t getConstraintCount() const { return m_constraints.size(); }
+
+    /**
+     * @brief Run the optimization from the current knob values.
+     *
+     * Fails (converged = false, no iterations) if the optics cannot be
+     * computed at the start values.
+     */
+    MatchResult match(const MatchSettings& settings = MatchSettings()) const;
+
+    /**
+     * @brief Write matched knob values into a lattice, looked up by component name.
+     * @return False if a component is missing or of the wrong type.
+     */
+    bool apply(Accelerator& lattice, const MatchResult& result) const;
+
+private:
+    /**
+     * @brief Private lattice copy with its optics, used by one thread.
+     */
+    struct Workspace {
+        std::shared_ptr<Accelerator> lattice;
+        std::unique_ptr<Optics> optics;
+        std::vector<std::vector<std::shared_ptr<Component>>> knobTargets;
+        std::vector<double> applied;  // Last value set per knob, NaN before the first
+    };
+
+    static bool resolveTargets(const Accelerator& lattice, const MatchKnob& knob,
+                               std::vector<std::shared_ptr<Component>>& targets);
+    static void setParameter(Component& component, KnobParameter parameter, double value);
+
+    Workspace makeWorkspace() const;
+    bool evaluate(Workspace& workspace, const std::vector<double>& values,
+                  std::vector<double>& residuals) const;
+    double clamp(size_t knob, double value) const;
+
+    std::shared_ptr<const Accelerator> m_lattice;
+    double m_referenceMomentum;
+    double m_charge;
+
+    std::vector<MatchKnob> m_knobs;
+    std::vector<double> m_startValues;
+    std::vector<MatchConstraint> m_constraints;
+    std::vector<std::optional<size_t>> m_locations;  // Element index per constraint
+};
+
+} // namespace pas::accelerator
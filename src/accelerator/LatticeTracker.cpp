@@ -0,0 +1,417 @@
+#include "accelerator/LatticeTracker.hpp"
+#include "accelerator/Optics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <unordered_map>
+
+namespace pas::accelerator {
+
+namespace {
+
+// Below this |K L^2| a focusing element is treated as a drift
+constexpr double WEAK_FOCUSING = 1e-12;
+
+// Offset [m] of the central differences that linearise a kick
+constexpr double LINEARISATION_STEP = 1e-6;
+
+/**
+ * @brief Thick-lens matrix of x'' + K x = 0 over a length.
+ */
+void focusingMatrix(double K, double length, double (&m)[4]) {
+    if (std::abs(K) * length * length < WEAK_FOCUSING) {
+        m[0] = 1.0; m[1] = length;
+        m[2] = 0.0; m[3] = 1.0;
+    } else if (K > 0.0) {
+        double k = std::sqrt(K);
+        double c = std::cos(k * length);
+        double s = std::sin(k * length);
+        m[0] = c;      m[1] = s / k;
+        m[2] = -k * s; m[3] = c;
+    } else {
+        double k = std::sqrt(-K);
+        double c = std::cosh(k * length);
+        double s = std::sinh(k * length);
+        m[0] = c;     m[1] = s / k;
+        m[2] = k * s; m[3] = c;
+    }
+}
+
+/**
+ * @brief m = a * m (2x2 row-major).
+ */
+void multiplyLeft(const double (&a)[4], double (&m)[4]) {
+    const double m0 = a[0] * m[0] + a[1] * m[2];
+    const double m1 = a[0] * m[1] + a[1] * m[3];
+    const double m2 = a[2] * m[0] + a[3] * m[2];
+    const double m3 = a[2] * m[1] + a[3] * m[3];
+    m[0] = m0; m[1] = m1; m[2] = m2; m[3] = m3;
+}
+
+/**
+ * @brief m = m * a (2x2 row-major).
+ */
+void multiplyRight(double (&m)[4], const double (&a)[4]) {
+    const double m0 = m[0] * a[0] + m[1] * a[2];
+    const double m1 = m[0] * a[1] + m[1] * a[3];
+    const double m2 = m[2] * a[0] + m[3] * a[2];
+    const double m3 = m[2] * a[1] + m[3] * a[3];
+    m[0] = m0; m[1] = m1; m[2] = m2; m[3] = m3;
+}
+
+/**
+ * @brief Add soft quadrupole edges of x'' + K p(s) x = 0 to a hard-edge body map.
+ *
+ * First order in K with I1 = int s (p - theta) ds, I2 = int s^2 (p - theta) ds
+ * of one edge; the exponentials keep the edge maps symplectic.
+ */
+void addQuadrupoleFringe(double K, const physics::EngeFunction::Integrals& fringe,
+                         bool entrance, bool exit, double (&m)[4]) {
+    const double a = std::exp(K * fringe.first);
+    if (entrance) {
+        const double edge[4] = {a, K * fringe.second, 0.0, 1.0 / a};
+        multiplyRight(m, edge);
+    }
+    if (exit) {
+        const double edge[4] = {1.0 / a, K * fringe.second, 0.0, a};
+        multiplyLeft(edge, m);
+    }
+}
+
+} // namespace
+
+LatticeTracker::LatticeTracker(const Accelerator& accelerator, double referenceMomentum,
+                               double charge, size_t multipoleSlices)
+    : m_referenceMomentum(referenceMomentum) {
+    const CompiledLattice& lattice = accelerator.getCompiledLattice();
+    const auto& lengths = lattice.getLengths();
+    const auto& strengths = lattice.getStrengths();
+    m_elements.reserve(lattice.size());
+    const size_t slices = std::max<size_t>(multipoleSlices, 1);
+
+    // Occurrences of a shared component reuse its maps and kick; the map key
+    // is the component and the piece of it (whole, entry, middle, exit slice)
+    std::map<std::pair<const Component*, int>, size_t> mapIndices;
+    std::unordered_map<const Component*, int> kickIndices;
+
+    for (size_t index = 0; index < lattice.size(); ++index) {
+        const Component& component = lattice.getComponent(index);
+        auto addElement = [&](Element piece, int role) {
+            auto [it, added] = mapIndices.try_emplace({&component, role}, m_mapElements.size());
+            if (added) {
+                m_mapElements.push_back(m_elements.size());
+            }
+            piece.map = it->second;
+            m_elements.push_back(piece);
+        };
+
+        Element element = describeElement(component, lengths[index], strengths[index],
+                                          referenceMomentum, charge);
+        element.aperture = lattice.getAperture(index);
+        m_length += element.length;
+
+        // Linear elements are exact; everything else gets thin kicks
+        const auto* magnet = dynamic_cast<const Magnet*>(&component);
+        const bool linear = element.kind != ElementKind::Drift;
+        if (!magnet || (linear && !magnet->hasErrors())) {
+            addElement(element, 0);
+            continue;
+        }
+
+        auto [kickIt, newKick] = kickIndices.try_emplace(&component, static_cast<int>(m_kicks.size()));
+        if (newKick) {
+            m_kicks.push_back(makeKick(*magnet, linear, charge * element.length /
+                                       static_cast<double>(slices) / referenceMomentum));
+        }
+
+        // Half slice, kick, (full slice, kick)..., half slice
+        const double sliceLength = element.length / static_cast<double>(slices);
+        Element slice = element;
+        slice.kick = kickIt->second;
+        slice.length = sliceLength / 2.0;
+        slice.exitFringe = false;
+        addElement(slice, 1);
+        slice.length = sliceLength;
+        slice.entranceFringe = false;
+        for (size_t i = 1; i < slices; ++i) {
+            addElement(slice, 2);
+        }
+        slice.kick = -1;
+        slice.length = sliceLength / 2.0;
+        slice.exitFringe = element.exitFringe;
+        addElement(slice, 3);
+    }
+}
+
+LatticeTracker::Element LatticeTracker::describeElement(const Component& component, double length,
+                                                       double strength, double referenceMomentum,
+                                                       double charge) {
+    Element element;
+    element.length = length;
+
+    if (component.getType() == ComponentType::Quadrupole) {
+        element.kind = ElementKind::Quadrupole;
+        element.k1 = charge * strength / referenceMomentum;
+    } else if (component.getType() == ComponentType::Dipole) {
+        element.kind = ElementKind::SectorBend;
+        element.h = charge * strength / referenceMomentum;
+    } else if (component.getType() == ComponentType::Solenoid) {
+        const auto& solenoid = static_cast<const Solenoid&>(component);
+        element.kind = ElementKind::Solenoid;
+        element.ks = charge * strength / (2.0 * referenceMomentum);
+        element.entranceFringe = true;
+        element.exitFringe = true;
+        element.fringe = solenoid.getFringe().integrals();
+        element.fringeGap = solenoid.getFringe().gap;
+    }
+
+    const auto* magnet = dynamic_cast<const Magnet*>(&component);
+    if (magnet && element.kind != ElementKind::Drift && magnet->getFringe()) {
+        element.entranceFringe = true;
+        element.exitFringe = true;
+        element.fringe = magnet->getFringe()->integrals();
+        element.fringeGap = magnet->getFringe()->gap;
+    }
+    return element;
+}
+
+LatticeTracker::MultipoleKick LatticeTracker::makeKick(const Magnet& magnet, bool linear, double strength) {
+    const MagnetErrors& errors = magnet.getErrors();
+    MultipoleKick kick;
+    kick.actual = magnet.getMultipoles();
+    if (linear) {
+        kick.ideal.setNormal(magnet.getMainOrder(), magnet.getMainStrength());
+    }
+    kick.offsetX = errors.offsetX;
+    kick.offsetY = errors.offsetY;
+    kick.cosRoll = std::cos(errors.roll);
+    kick.sinRoll = std::sin(errors.roll);
+    kick.strength = strength;
+    return kick;
+}
+
+TransferMatrix LatticeTracker::linearMatrix(const Component& component, double referenceMomentum,
+                                            double charge) {
+    double strength = 0.0;
+    const auto* magnet = dynamic_cast<const Magnet*>(&component);
+    if (magnet) {
+        strength = magnet->getMainStrength();
+    } else if (component.getType() == ComponentType::Solenoid) {
+        strength = static_cast<const Solenoid&>(component).getField();
+    }
+    const Element element = describeElement(component, component.getLength(), strength,
+                                            referenceMomentum, charge);
+
+    // One piece, or half slice, kick, half slice as trackTurn() with one slice
+    const bool linear = element.kind != ElementKind::Drift;
+    std::vector<Element> pieces;
+    if (!magnet || (linear && !magnet->hasErrors())) {
+        pieces.push_back(element);
+    } else {
+        Element half = element;
+        half.length = element.length / 2.0;
+        half.exitFringe = false;
+        pieces.push_back(half);
+        half.entranceFringe = false;
+        half.exitFringe = element.exitFringe;
+        pieces.push_back(half);
+    }
+
+    TransferMatrix result;
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        if (i > 0) {
+            // Gradient of the kick field at the reference orbit
+            const MultipoleKick kick = makeKick(*magnet, linear, charge * element.length / referenceMomentum);
+            const double step = LINEARISATION_STEP;
+            const glm::dvec2 dx = kickField(kick, step, 0.0) - kickField(kick, -step, 0.0);
+            const glm::dvec2 dy = kickField(kick, 0.0, step) - kickField(kick, 0.0, -step);
+            TransferMatrix thin;
+            thin.x[1][0] = -kick.strength * dx.y / (2.0 * step);
+            thin.y[1][0] = kick.strength * dy.x / (2.0 * step);
+            result = thin * result;
+        }
+
+        const Element& piece = pieces[i];
+        const ElementMap map = computeMap(piece, 0.0);
+        TransferMatrix m;
+        m.x[0][0] = map.mx[0]; m.x[0][1] = map.mx[1];
+        m.x[1][0] = map.mx[2]; m.x[1][1] = map.mx[3];
+        m.y[0][0] = map.my[0]; m.y[0][1] = map.my[1];
+        m.y[1][0] = map.my[2]; m.y[1][1] = map.my[3];
+
+        // Dispersion column: d ox / d delta at delta = 0
+        if (piece.kind == ElementKind::SectorBend &&
+            piece.h * piece.h * piece.length * piece.length >= WEAK_FOCUSING) {
+            m.x[0][2] = (1.0 - map.mx[0]) / piece.h;
+            m.x[1][2] = -map.mx[2] / piece.h;
+        }
+        result = m * result;
+    }
+    return result;
+}
+
+LatticeTracker::ElementMap LatticeTracker::computeMap(const Element& element, double delta) {
+    const double L = element.length;
+    const double scale = 1.0 / (1.0 + delta);
+
+    ElementMap map{};
+    switch (element.kind) {
+        case ElementKind::Drift:
+            focusingMatrix(0.0, L, map.mx);
+            focusingMatrix(0.0, L, map.my);
+            break;
+
+        case ElementKind::Quadrupole: {
+            const double K = element.k1 * scale;
+            focusingMatrix(K, L, map.mx);
+            focusingMatrix(-K, L, map.my);
+            if (element.entranceFringe || element.exitFringe) {
+                addQuadrupoleFringe(K, element.fringe, element.entranceFringe,
+                                    element.exitFringe, map.mx);
+                addQuadrupoleFringe(-K, element.fringe, element.entranceFringe,
+                                    element.exitFringe, map.my);
+            }
+            break;
+        }
+
+        case ElementKind::SectorBend: {
+            // Weak focusing h^2 around the dispersive orbit x = delta / h
+            double K = element.h * element.h * scale;
+            focusingMatrix(K, L, map.mx);
+            focusingMatrix(0.0, L, map.my);
+            if (K * L * L >= WEAK_FOCUSING) {
+                double orbit = delta / element.h;
+                map.ox[0] = orbit * (1.0 - map.mx[0]);
+                map.ox[1] = -orbit * map.mx[2];
+            }
+            if (element.entranceFringe || element.exitFringe) {
+                // Vertical edge focusing -h tan(e - psi) with e = 0, psi = FINT * gap * h
+                const double hp = element.h * scale;
+                const double psi = element.fringe.fint * element.fringeGap * hp;
+                const double edge[4] = {1.0, 0.0, hp * std::tan(psi), 1.0};
+                if (element.entranceFringe) {
+                    multiplyRight(map.my, edge);
+                }
+                if (element.exitFringe) {
+                    multiplyLeft(edge, map.my);
+                }
+            }
+            break;
+        }
+
+        case ElementKind::Solenoid: {
+            // Focusing K^2 in both planes, then rotation by K L
+            const double K = element.ks * scale;
+            focusingMatrix(K * K, L, map.mx);
+            focusingMatrix(K * K, L, map.my);
+
+            // The focusing follows B^2, whose soft edges integrate to
+            // L - 2 * FINT * gap; thin lenses at the ends remove the excess.
+            // They are rotationally symmetric and commute with the rotation.
+            const double lens = K * K * element.fringe.fint * element.fringeGap;
+            const double edge[4] = {1.0, 0.0, lens, 1.0};
+            multiplyRight(map.mx, edge);
+            multiplyLeft(edge, map.mx);
+            multiplyRight(map.my, edge);
+            multiplyLeft(edge, map.my);
+            map.rc = std::cos(K * L);
+            map.rs = std::sin(K * L);
+            break;
+        }
+    }
+    return map;
+}
+
+void LatticeTracker::applyMap(const ElementMap& map, PhaseSpace& state) {
+    const double x = state.x;
+    const double y = state.y;
+    state.x = map.mx[0] * x + map.mx[1] * state.px + map.ox[0];
+    state.px = map.mx[2] * x + map.mx[3] * state.px + map.ox[1];
+    state.y = map.my[0] * y + map.my[1] * state.py;
+    state.py = map.my[2] * y + map.my[3] * state.py;
+
+    if (map.rs != 0.0) {
+        const double x1 = state.x;
+        const double px1 = state.px;
+        state.x = map.rc * x1 + map.rs * state.y;
+        state.px = map.rc * px1 + map.rs * state.py;
+        state.y = -map.rs * x1 + map.rc * state.y;
+        state.py = -map.rs * px1 + map.rc * state.py;
+    }
+}
+
+glm::dvec2 LatticeTracker::kickField(const MultipoleKick& kick, double x, double y) {
+    // Real field: evaluated in the offset and rolled magnet frame
+    const double u0 = x - kick.offsetX;
+    const double v0 = y - kick.offsetY;
+    const double u = kick.cosRoll * u0 + kick.sinRoll * v0;
+    const double v = -kick.sinRoll * u0 + kick.cosRoll * v0;
+    const glm::dvec3 local = kick.actual.evaluate(u, v);
+    const double bx = kick.cosRoll * local.x - kick.sinRoll * local.y;
+    const double by = kick.sinRoll * local.x + kick.cosRoll * local.y;
+
+    const glm::dvec3 ideal = kick.ideal.evaluate(x, y);
+    return glm::dvec2(bx - ideal.x, by - ideal.y);
+}
+
+void LatticeTracker::applyKick(const MultipoleKick& kick, PhaseSpace& state) {
+    const glm::dvec2 field = kickField(kick, state.x, state.y);
+    const double scale = kick.strength / (1.0 + state.delta);
+    state.px -= scale * field.y;
+    state.py += scale * field.x;
+}
+
+bool LatticeTracker::trackElement(const Element& element, const ElementMap& map, PhaseSpace& state) const {
+    applyMap(map, state);
+    if (!std::isfinite(state.x) || !std::isfinite(state.y) ||
+        !element.aperture.isInside(state.x, state.y)) {
+        return false;
+    }
+    if (element.kick >= 0) {
+        applyKick(m_kicks[static_cast<size_t>(element.kick)], state);
+    }
+    return true;
+}
+
+bool LatticeTracker::trackTurn(PhaseSpace& state) const {
+    for (const Element& element : m_elements) {
+        if (!trackElement(element, computeMap(element, state.delta), state)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LatticeTracker::trackTurn(PhaseSpace& state, const std::vector<ElementMap>& maps) const {
+    for (const Element& element : m_elements) {
+        if (!trackElement(element, maps[element.map], state)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t LatticeTracker::track(PhaseSpace& state, size_t turns, std::vector<PhaseSpace>* history) const {
+    if (history) {
+        history->reserve(history->size() + turns);
+    }
+
+    std::vector<ElementMap> maps;
+    maps.reserve(m_mapElements.size());
+    for (size_t element : m_mapElements) {
+        maps.push_back(computeMap(m_elements[element], state.delta));
+    }
+
+    for (size_t turn = 0; turn < turns; ++turn) {
+        if (!trackTurn(state, maps)) {
+            return turn;
+        }
+        if (history) {
+            history->push_back(state);
+        }
+    }
+    return turns;
+}
+
+} // namespace pas::accelerator
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "accelerator/Accelerator.hpp"
+#include "physics/Constants.hpp"
+
+#include <vector>
+
+namespace pas::accelerator {
+
+struct TransferMatrix;
+
+/**
+ * @brief Transverse phase-space coordinates relative to the reference orbit.
+ */
+struct PhaseSpace {
+    double x = 0.0;      // Horizontal offset [m]
+    double px = 0.0;     // Horizontal angle dx/ds [rad]
+    double y = 0.0;      // Vertical offset [m]
+    double py = 0.0;     // Vertical angle dy/ds [rad]
+    double delta = 0.0;  // Relative momentum deviation dp/p0
+};
+
+/**
+ * @brief Fast turn-by-turn tracker using linear element maps.
+ *
+ * Tracks in the curvilinear frame of the lattice instead of integrating the
+ * Lorentz force, which makes thousands of turns cheap enough for tune,
+ * chromaticity and aperture studies. Quadrupoles, sector dipoles and
+ * solenoids use thick linear maps with chromatic focusing k/(1 + delta);
+ * every other component is a drift. The longitudinal position is not
+ * evolved, so the momentum offset is constant and track() evaluates each
+ * element map once per call, and only once for all occurrences of a
+ * component shared by several places of the lattice.
+ *
+ * Magnets with an Enge fringe get linear edge maps around the hard-edge
+ * body: the first-order soft-edge correction for quadrupoles and the FINT
+ * vertical edge focusing for dipoles. The solenoid map is the hard-edge map
+ * of the effective length, which includes the focusing of its end fields.
+ *
+ * Sextupoles, multipoles and magnets with errors are tracked as thin-lens
+ * kicks: the element is cut into slices, each a drift or linear map with a
+ * kick in its middle. A kick applies the difference between the real field
+ * (offset, rolled, with all multipoles) and the field of the linear map,
+ * integrated over the slice.
+ *
+ * The element list is copied at construction, so a tracker can be used from
+ * other threads while the accelerator is modified.
+ */
+class LatticeTracker {
+public:
+    /**
+     * @brief Build a tracker for a lattice.
+     * @param accelerator Lattice to track through.
+     * @param referenceMomentum Reference momentum p0 [kg*m/s].
+     * @param charge Particle charge [C].
+     * @param multipoleSlices Thin-lens kicks per nonlinear element.
+     */
+    LatticeTracker(const Accelerator& accelerator, double referenceMomentum,
+                   double charge = physics::constants::e, size_t multipoleSlices = 1);
+
+    /**
+     * @brief Track one turn (or one pass for linear lattices).
+     * @return False if the particle left the aperture.
+     */
+    bool trackTurn(PhaseSpace& state) const;
+
+    /**
+     * @brief Track several turns, optionally recording the state after each.
+     * @param history If non-null, receives the state at the end of every turn.
+     * @return Number of turns completed before the particle was lost.
+     */
+    size_t track(PhaseSpace& state, size_t turns, std::vector<PhaseSpace>* history = nullptr) const;
+
+    size_t getElementCount() const { return m_elements.size(); }
+
+    /**
+     * @brief Number of distinct element maps; occurrences of a shared component share one.
+     */
+    size_t getUniqueMapCount() const { return m_mapElements.size(); }
+    double getLength() const { return m_length; }
+    double getReferenceMomentum() const { return m_referenceMomentum; }
+
+    /**
+     * @brief Linear matrix of one component at the reference momentum.
+     *
+     * Built from the maps trackTurn() applies with one slice per element.
+     * Kicks are linearised about the reference orbit: the gradient they add
+     * (feed-down of offset sextupoles and multipoles, gradient errors) is
+     * kept, their dipole and skew terms are not. The solenoid keeps its
+     * focusing and edge lenses but not its rotation, so the result is
+     * uncoupled.
+     * @param component Component at its current settings.
+     * @param referenceMomentum Reference momentum p0 [kg*m/s].
+     * @param charge Particle charge [C].
+     */
+    static TransferMatrix linearMatrix(const Component& component, double referenceMomentum,
+                                       double charge = physics::constants::e);
+
+private:
+    enum class ElementKind {
+        Drift,
+        Quadrupole,
+        SectorBend,
+        Solenoid
+    };
+
+    struct Element {
+        ElementKind kind = ElementKind::Drift;
+        double length = 0.0;
+        double k1 = 0.0;     // Normalized gradient [m^-2]
+        double h = 0.0;      // Curvature 1/rho [m^-1]
+        double ks = 0.0;     // Solenoid strength qB/(2 p0) [m^-1]
+        int kick = -1;       // Kick applied after the element, index into m_kicks
+        size_t map = 0;      // Map shared with other occurrences of the component
+        Aperture aperture;
+
+        // Fringe edges; slices of a magnet keep only the outer ones
+        bool entranceFringe = false;
+        bool exitFringe = false;
+        physics::EngeFunction::Integrals fringe;
+        double fringeGap = 0.0;  // m
+    };
+
+    /**
+     * @brief Thin kick integrating the nonlinear and error fields of one slice.
+     */
+    struct MultipoleKick {
+        physics::MultipoleExpansion actual;   // Magnet frame, with errors
+        physics::MultipoleExpansion ideal;    // Field contained in the linear map
+        double offsetX = 0.0;
+        double offsetY = 0.0;
+        double cosRoll = 1.0;
+        double sinRoll = 0.0;
+        double strength = 0.0;                // q L_slice / p0 [1/T]
+    };
+
+    /**
+     * @brief Element map evaluated for one momentum offset.
+     *
+     * x1 = mx[0] x + mx[1] px + ox[0], px1 = mx[2] x + mx[3] px + ox[1],
+     * and likewise for y without the offset, followed by a rotation of the
+     * transverse plane by (rc, rs) = (cos, sin) of the solenoid angle.
+     */
+    struct ElementMap {
+        double mx[4];
+        double my[4];
+        double ox[2];
+        double rc = 1.0;
+        double rs = 0.0;
+    };
+
+    static Element describeElement(const Component& component, double length, double strength,
+                                   double referenceMomentum, double charge);
+    static MultipoleKick makeKick(const Magnet& magnet, bool linear, double strength);
+
+    /**
+     * @brief Field of a kick at (x, y) beyond the field of the linear map [T].
+     */
+    static glm::dvec2 kickField(const MultipoleKick& kick, double x, double y);
+
+    static ElementMap computeMap(const Element& element, double delta);
+    static void applyMap(const ElementMap& map, PhaseSpace& state);
+    static void applyKick(const MultipoleKick& kick, PhaseSpace& state);
+    bool trackElement(const Element& element, const ElementMap& map, PhaseSpace& state) const;
+    bool trackTurn(PhaseSpace& state, const std::vector<ElementMap>& maps) const;
+
+    std::vector<Element> m_elements;
+    std::vector<MultipoleKick> m_kicks;
+    std::vector<size_t> m_mapElements;  // First element using each shared map
+    double m_length = 0.0;
+    double m_referenceMomentum;
+};
+
+} // namespace pas::accelerator
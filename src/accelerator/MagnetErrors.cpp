@@ -0,0 +1,189 @@
+#include "accelerator/MagnetErrors.hpp"
+#include "accelerator/Accelerator.hpp"
+#include "utils/Csv.hpp"
+#include "utils/Logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace pas::accelerator {
+
+namespace {
+
+// Multipole errors are given in units of 1e-4 of the main field
+constexpr double UNIT = 1e-4;
+
+/**
+ * @brief Gaussian sample truncated at |value| <= cut * rms.
+ */
+double truncatedGaussian(std::mt19937_64& random, double rms, double cut) {
+    if (rms == 0.0) {
+        return 0.0;
+    }
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    double value = gauss(random);
+    while (cut > 0.0 && std::abs(value) > cut) {
+        value = gauss(random);
+    }
+    return value * rms;
+}
+
+/**
+ * @brief Systematic plus random coefficients, one per order.
+ */
+std::vector<double> drawCoefficients(std::mt19937_64& random, const std::vector<double>& systematic,
+                                     const std::vector<double>& rms, double cut) {
+    std::vector<double> values(std::max(systematic.size(), rms.size()), 0.0);
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i < systematic.size()) {
+            values[i] += systematic[i];
+        }
+        if (i < rms.size()) {
+            values[i] += truncatedGaussian(random, rms[i], cut);
+        }
+    }
+    return values;
+}
+
+bool isMagnet(ComponentType type) {
+    return type == ComponentType::Dipole || type == ComponentType::Quadrupole ||
+           type == ComponentType::Sextupole || type == ComponentType::Multipole;
+}
+
+} // namespace
+
+// MagnetErrors implementation
+
+bool MagnetErrors::isZero() const {
+    auto zero = [](double value) { return value == 0.0; };
+    return std::all_of(normal.begin(), normal.end(), zero) &&
+           std::all_of(skew.begin(), skew.end(), zero) &&
+           offsetX == 0.0 && offsetY == 0.0 && roll == 0.0;
+}
+
+physics::MultipoleExpansion MagnetErrors::expand(int mainOrder, double mainStrength) const {
+    physics::MultipoleExpansion expansion;
+    expansion.setNormal(mainOrder, mainStrength);
+    addTo(expansion, mainOrder, mainStrength);
+    return expansion;
+}
+
+void MagnetErrors::addTo(physics::MultipoleExpansion& expansion, int mainOrder,
+                         double mainStrength) const {
+    // Main field at the reference radius, scaled back to each order
+    const double mainAtRadius = mainStrength * std::pow(referenceRadius, mainOrder - 1);
+    const size_t orders = std::max(normal.size(), skew.size());
+    for (size_t i = 0; i < orders; ++i) {
+        const int n = static_cast<int>(i) + 1;
+        const double scale = UNIT * mainAtRadius / std::pow(referenceRadius, n - 1);
+        const double b = i < normal.size() ? normal[i] : 0.0;
+        const double a = i < skew.size() ? skew[i] : 0.0;
+        if (b != 0.0 || a != 0.0) {
+            expansion.add(n, b * scale, a * scale);
+        }
+    }
+}
+
+// MagnetErrorModel implementation
+
+MagnetErrors MagnetErrorModel::generate(std::mt19937_64& random) const {
+    MagnetErrors errors;
+    errors.referenceRadius = referenceRadius;
+    errors.normal = drawCoefficients(random, systematicNormal, randomNormal, truncation);
+    errors.skew = drawCoefficients(random, systematicSkew, randomSkew, truncation);
+    errors.offsetX = truncatedGaussian(random, offsetRms, truncation);
+    errors.offsetY = truncatedGaussian(random, offsetRms, truncation);
+    errors.roll = truncatedGaussian(random, rollRms, truncation);
+    return errors;
+}
+
+// MagnetErrorTable implementation
+
+void MagnetErrorTable::addFamily(ComponentType type, const MagnetErrorModel& model,
+                                 const std::string& namePrefix) {
+    if (!isMagnet(type)) {
+        PAS_WARN("MagnetErrorTable: {} is not a magnet type", componentTypeToString(type));
+        return;
+    }
+    m_families.push_back({type, model, namePrefix});
+}
+
+void MagnetErrorTable::generate(const Accelerator& lattice, uint64_t seed) {
+    m_entries.clear();
+
+    const auto& components = lattice.getComponents();
+    for (size_t index = 0; index < components.size(); ++index) {
+        const auto& component = components[index];
+        auto family = std::find_if(m_families.begin(), m_families.end(), [&](const Family& f) {
+            return f.type == component->getType() &&
+                   component->getName().compare(0, f.namePrefix.size(), f.namePrefix) == 0;
+        });
+        if (family == m_families.end()) {
+            continue;
+        }
+
+        std::seed_seq sequence{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+                               static_cast<uint32_t>(index)};
+        std::mt19937_64 random(sequence);
+        m_entries.push_back({index, component->getName(), family->model.generate(random)});
+    }
+}
+
+void MagnetErrorTable::apply(Accelerator& lattice) const {
+    std::vector<const Entry*> matched;
+    std::vector<size_t> indices;
+    matched.reserve(m_entries.size());
+    indices.reserve(m_entries.size());
+    for (const Entry& entry : m_entries) {
+        auto magnet = std::dynamic_pointer_cast<Magnet>(lattice.getComponent(entry.componentIndex));
+        if (!magnet || magnet->getName() != entry.name) {
+            PAS_WARN("MagnetErrorTable: Component {} does not match magnet {}",
+                     entry.componentIndex, entry.name);
+            continue;
+        }
+        matched.push_back(&entry);
+        indices.push_back(entry.componentIndex);
+    }
+
+    // Errors belong to each place, not to other places or a Beamline template
+    lattice.makeUnique(indices);
+    for (const Entry* entry : matched) {
+        std::static_pointer_cast<Magnet>(lattice.getComponent(entry->componentIndex))->setErrors(entry->errors);
+    }
+}
+
+bool MagnetErrorTable::exportCSV(const std::string& filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        PAS_ERROR("MagnetErrorTable: Could not create file: {}", filepath);
+        return false;
+    }
+
+    size_t orders = 0;
+    for (const Entry& entry : m_entries) {
+        orders = std::max({orders, entry.errors.normal.size(), entry.errors.skew.size()});
+    }
+
+    file << "index,name,offset_x,offset_y,roll,reference_radius";
+    for (size_t n = 1; n <= orders; ++n) {
+        file << ",b" << n << ",a" << n;
+    }
+    file << "\n";
+
+    for (const Entry& entry : m_entries) {
+        const MagnetErrors& errors = entry.errors;
+        file << entry.componentIndex << ',' << utils::quoteCsvField(entry.name) << ',' << errors.offsetX << ','
+             << errors.offsetY << ',' << errors.roll << ',' << errors.referenceRadius;
+        for (size_t i = 0; i < orders; ++i) {
+            file << ',' << (i < errors.normal.size() ? errors.normal[i] : 0.0)
+                 << ',' << (i < errors.skew.size() ? errors.skew[i] : 0.0);
+        }
+        file << "\n";
+    }
+
+    PAS_INFO("MagnetErrorTable: Exported {} magnets to {}", m_entries.size(), filepath);
+    return true;
+}
+
+} // namespace pas::accelerator
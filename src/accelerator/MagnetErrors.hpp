@@ -0,0 +1,144 @@
+#pragma once
+
+#include "physics/EMField.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace pas::accelerator {
+
+class Accelerator;
+enum class ComponentType;
+
+/**
+ * @brief Field and alignment errors of one magnet.
+ *
+ * Multipole errors follow the magnet measurement convention: they are
+ * normalised to the main field at the reference radius and given in units
+ * of 1e-4,
+ *
+ * By + i*Bx = B_main(R_ref) * 1e-4 * sum_n (b_n + i*a_n) * ((x + i*y) / R_ref)^(n-1)
+ *
+ * with n = 1 the dipole, n = 2 the quadrupole, n = 3 the sextupole term.
+ */
+struct MagnetErrors {
+    std::vector<double> normal;     // b_n [units], index n - 1
+    std::vector<double> skew;       // a_n [units], index n - 1
+    double referenceRadius = 0.01;  // m
+    double offsetX = 0.0;           // Transverse offset of the magnet center [m]
+    double offsetY = 0.0;           // m
+    double roll = 0.0;              // Rotation about the beam axis [rad]
+
+    /**
+     * @brief Check if the magnet is perfect.
+     */
+    bool isZero() const;
+
+    /**
+     * @brief Absolute field expansion of a magnet with these errors.
+     * @param mainOrder Order of the main field (1 dipole, 2 quadrupole, ...).
+     * @param mainStrength Main field coefficient [T/m^(mainOrder-1)].
+     */
+    physics::MultipoleExpansion expand(int mainOrder, double mainStrength) const;
+
+    /**
+     * @brief Add the error multipoles to an existing expansion.
+     */
+    void addTo(physics::MultipoleExpansion& expansion, int mainOrder, double mainStrength) const;
+};
+
+/**
+ * @brief Statistical error model of a magnet family.
+ *
+ * Random errors are Gaussian with the given rms, truncated at a number of
+ * standard deviations; systematic errors are added to every magnet.
+ */
+struct MagnetErrorModel {
+    std::vector<double> systematicNormal;   // b_n [units], index n - 1
+    std::vector<double> systematicSkew;     // a_n [units]
+    std::vector<double> randomNormal;       // rms of b_n [units]
+    std::vector<double> randomSkew;         // rms of a_n [units]
+    double referenceRadius = 0.01;          // m
+    double offsetRms = 0.0;                 // Per plane [m]
+    double rollRms = 0.0;                   // rad
+    double truncation = 3.0;                // Gaussian cut [sigma]; 0 for none
+
+    /**
+     * @brief Draw the errors of one magnet.
+     */
+    MagnetErrors generate(std::mt19937_64& random) const;
+};
+
+/**
+ * @brief Error tables for the magnets of a lattice.
+ *
+ * Magnets are assigned to families by type and optional name prefix; the
+ * first matching family is used. Every magnet draws from its own random
+ * stream seeded from the table seed and its component index, so the errors
+ * of one magnet do not depend on which other families are defined.
+ */
+class MagnetErrorTable {
+public:
+    /**
+     * @brief Errors drawn for one magnet.
+     */
+    struct Entry {
+        size_t componentIndex = 0;
+        std::string name;
+        MagnetErrors errors;
+    };
+
+    /**
+     * @brief Add a magnet family.
+     * @param type Dipole, Quadrupole, Sextupole or Multipole.
+     * @param model Error distribution of the family.
+     * @param namePrefix Only magnets whose name starts with this prefix; empty for all.
+     */
+    void addFamily(ComponentType type, const MagnetErrorModel& model,
+                   const std::string& namePrefix = "");
+
+    size_t getFamilyCount() const { return m_families.size(); }
+
+    /**
+     * @brief Draw errors for every magnet that belongs to a family.
+     *
+     * Replaces previously generated entries.
+     */
+    void generate(const Accelerator& lattice, uint64_t seed);
+
+    /**
+     * @brief Set the generated errors on the magnets of a lattice.
+     *
+     * The lattice must have the layout the table was generated for. Magnets
+     * are modified in place; clone the lattice first to keep the original.
+     * A magnet shared with another place or a Beamline template is replaced
+     * by a private copy first (see Accelerator::makeUnique()).
+     */
+    void apply(Accelerator& lattice) const;
+
+    /**
+     * @brief Remove all generated entries.
+     */
+    void clear() { m_entries.clear(); }
+
+    const std::vector<Entry>& getEntries() const { return m_entries; }
+
+    /**
+     * @brief Export the generated errors as CSV.
+     */
+    bool exportCSV(const std::string& filepath) const;
+
+private:
+    struct Family {
+        ComponentType type;
+        MagnetErrorModel model;
+        std::string namePrefix;
+    };
+
+    std::vector<Family> m_families;
+    std::vector<Entry> m_entries;
+};
+
+} // namespace pas::accelerator
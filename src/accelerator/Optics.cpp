@@ -0,0 +1,189 @@
+#include "accelerator/Optics.hpp"
+#include "accelerator/LatticeTracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pas::accelerator {
+
+namespace {
+
+// Negative per-element phase steps smaller than this are rounding noise
+constexpr double PHASE_TOLERANCE = 1e-12;
+
+constexpr double TWO_PI = 2.0 * physics::constants::pi;
+
+/**
+ * @brief Propagate Twiss parameters with the 2x2 matrix [[a, b], [c, d]].
+ * @param previousMu Phase advance at the previous point, used to unwrap.
+ */
+TwissParameters propagateTwiss(double a, double b, double c, double d,
+                               const TwissParameters& start, double previousMu) {
+    const double gamma0 = start.gamma();
+
+    TwissParameters twiss;
+    twiss.beta = a * a * start.beta - 2.0 * a * b * start.alpha + b * b * gamma0;
+    twiss.alpha = -a * c * start.beta + (a * d + b * c) * start.alpha - b * d * gamma0;
+
+    // Phase advance modulo 2 pi; unwrapped assuming no element advances by 2 pi
+    double phase = std::atan2(b, a * start.beta - b * start.alpha);
+    double step = std::remainder(phase - (previousMu - start.mu), TWO_PI);
+    if (step < 0.0) {
+        step = step > -PHASE_TOLERANCE ? 0.0 : step + TWO_PI;
+    }
+    twiss.mu = previousMu + step;
+    return twiss;
+}
+
+/**
+ * @brief Periodic Twiss parameters of the one-turn 2x2 matrix [[a, b], [., d]].
+ * @return False if the motion is unstable.
+ */
+bool periodicTwiss(double a, double b, double d, TwissParameters& twiss) {
+    double cosMu = 0.5 * (a + d);
+    if (!(std::abs(cosMu) < 1.0)) {
+        return false;
+    }
+    double sinMu = std::copysign(std::sqrt(1.0 - cosMu * cosMu), b);
+    twiss.beta = b / sinMu;
+    twiss.alpha = (a - d) / (2.0 * sinMu);
+    twiss.mu = 0.0;
+    return true;
+}
+
+} // namespace
+
+TransferMatrix operator*(const TransferMatrix& b, const TransferMatrix& a) {
+    TransferMatrix result;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            result.x[i][j] = b.x[i][0] * a.x[0][j] + b.x[i][1] * a.x[1][j] + b.x[i][2] * a.x[2][j];
+        }
+    }
+    for (int i = 0; i < 2; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            result.y[i][j] = b.y[i][0] * a.y[0][j] + b.y[i][1] * a.y[1][j];
+        }
+    }
+    return result;
+}
+
+Optics::Optics(std::shared_ptr<const Accelerator> accelerator, double referenceMomentum,
+               double charge)
+    : m_accelerator(std::move(accelerator))
+    , m_referenceMomentum(referenceMomentum)
+    , m_charge(charge) {}
+
+void Optics::setInitialOptics(const OpticsPoint& initial) {
+    m_initial = initial;
+    m_pointsDirty = 0;
+}
+
+void Optics::invalidate(size_t index) {
+    if (index < m_elements.size()) {
+        m_elements[index].component = nullptr;
+    }
+}
+
+bool Optics::compute() {
+    const auto& components = m_accelerator->getComponents();
+    const size_t count = components.size();
+
+    // Find changed elements and rebuild only their matrices
+    size_t firstDirty = count;
+    if (m_elements.size() != count) {
+        firstDirty = std::min(m_elements.size(), count);
+        m_elements.resize(count);
+        m_prefix.resize(count);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const Component& component = *components[i];
+        CachedElement& cached = m_elements[i];
+        if (cached.component == &component && cached.version == component.getVersion() &&
+            cached.length == component.getLength()) {
+            continue;
+        }
+        cached.component = &component;
+        cached.version = component.getVersion();
+        cached.length = component.getLength();
+        cached.matrix = LatticeTracker::linearMatrix(component, m_referenceMomentum, m_charge);
+        firstDirty = std::min(firstDirty, i);
+    }
+
+    // Prefix products downstream of the first change
+    for (size_t i = firstDirty; i < count; ++i) {
+        m_prefix[i] = i == 0 ? m_elements[i].matrix : m_elements[i].matrix * m_prefix[i - 1];
+    }
+    m_recomputed = count - firstDirty;
+    m_pointsDirty = std::min({m_pointsDirty, firstDirty, m_points.size()});
+
+    if (m_accelerator->isClosed()) {
+        // A periodic solution depends on every element
+        m_valid = computePeriodicStart();
+        if (!m_valid) {
+            m_points.clear();
+            m_pointsDirty = 0;
+            return false;
+        }
+        m_pointsDirty = 0;
+    } else {
+        m_start = m_initial;
+        m_valid = true;
+    }
+
+    computePoints(m_pointsDirty);
+    m_pointsDirty = count;
+    return true;
+}
+
+bool Optics::computePeriodicStart() {
+    if (m_elements.empty()) {
+        return false;
+    }
+
+    const TransferMatrix& m = m_prefix.back();
+    OpticsPoint start;
+    if (!periodicTwiss(m.x[0][0], m.x[0][1], m.x[1][1], start.x) ||
+        !periodicTwiss(m.y[0][0], m.y[0][1], m.y[1][1], start.y)) {
+        return false;
+    }
+
+    // Closed dispersion orbit: (I - M) D = m13
+    double a = m.x[0][0], b = m.x[0][1], c = m.x[1][0], d = m.x[1][1];
+    double determinant = 2.0 - a - d;
+    start.dispersion = ((1.0 - d) * m.x[0][2] + b * m.x[1][2]) / determinant;
+    start.dispersionPrime = (c * m.x[0][2] + (1.0 - a) * m.x[1][2]) / determinant;
+
+    m_start = start;
+    return true;
+}
+
+void Optics::computePoints(size_t first) {
+    m_points.resize(m_elements.size());
+
+    for (size_t i = first; i < m_elements.size(); ++i) {
+        const TransferMatrix& m = m_prefix[i];
+        const OpticsPoint& previous = i == 0 ? m_start : m_points[i - 1];
+
+        OpticsPoint& point = m_points[i];
+        point.s = previous.s + m_elements[i].length;
+        point.x = propagateTwiss(m.x[0][0], m.x[0][1], m.x[1][0], m.x[1][1], m_start.x, previous.x.mu);
+        point.y = propagateTwiss(m.y[0][0], m.y[0][1], m.y[1][0], m.y[1][1], m_start.y, previous.y.mu);
+        point.dispersion = m.x[0][0] * m_start.dispersion + m.x[0][1] * m_start.dispersionPrime + m.x[0][2];
+        point.dispersionPrime = m.x[1][0] * m_start.dispersion + m.x[1][1] * m_start.dispersionPrime + m.x[1][2];
+    }
+}
+
+double Optics::getTuneX() const {
+    return m_points.empty() ? 0.0 : (m_points.back().x.mu - m_start.x.mu) / TWO_PI;
+}
+
+double Optics::getTuneY() const {
+    return m_points.empty() ? 0.0 : (m_points.back().y.mu - m_start.y.mu) / TWO_PI;
+}
+
+TransferMatrix Optics::getOneTurnMatrix() const {
+    return m_prefix.empty() ? TransferMatrix{} : m_prefix.back();
+}
+
+} // namespace pas::accelerator
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "accelerator/Accelerator.hpp"
+#include "physics/Constants.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace pas::accelerator {
+
+/**
+ * @brief Linear transfer matrix of a lattice segment.
+ *
+ * The horizontal block acts on (x, x', delta) so that its third column
+ * carries the dispersion generated by bends; the vertical block acts on
+ * (y, y').
+ */
+struct TransferMatrix {
+    double x[3][3] = {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}};
+    double y[2][2] = {{1.0, 0.0}, {0.0, 1.0}};
+};
+
+/**
+ * @brief Compose two transfer matrices: first a, then b (returns b * a).
+ */
+TransferMatrix operator*(const TransferMatrix& b, const TransferMatrix& a);
+
+/**
+ * @brief Twiss parameters of one plane.
+ */
+struct TwissParameters {
+    double beta = 1.0;   // Beta function [m]
+    double alpha = 0.0;  // -beta'/2
+    double mu = 0.0;     // Phase advance from the lattice start [rad]
+
+    double gamma() const { return (1.0 + alpha * alpha) / beta; }
+};
+
+/**
+ * @brief Optical functions at one position.
+ */
+struct OpticsPoint {
+    double s = 0.0;                 // Longitudinal position [m]
+    TwissParameters x;
+    TwissParameters y;
+    double dispersion = 0.0;        // Horizontal dispersion D [m]
+    double dispersionPrime = 0.0;   // dD/ds
+};
+
+/**
+ * @brief Twiss parameters, dispersion and phase advance of a lattice.
+ *
+ * Each element contributes the matrix LatticeTracker::linearMatrix() builds
+ * from the tracker's own maps at the reference momentum: thick quadrupoles,
+ * sector bends and solenoids with their fringe edges, plus the gradient that
+ * sextupole feed-down and magnet errors add. The tunes therefore follow the
+ * tracked lattice. Coupling (skew terms, solenoid rotation) and the closed
+ * orbit of dipole errors are not modelled.
+ *
+ * Element matrices and their prefix products (start -> exit of element i)
+ * are cached. compute() compares every element against the cached component
+ * version and only rebuilds the prefix products downstream of the first
+ * changed element, so retuning one magnet costs a matrix product per
+ * downstream element instead of a full rebuild.
+ *
+ * Circular lattices use the periodic solution of the one-turn matrix; linear
+ * lattices propagate the initial optics set with setInitialOptics(). Optical
+ * functions are evaluated from the prefix products and need no further matrix
+ * products.
+ */
+class Optics {
+public:
+    /**
+     * @brief Create an optics calculator for a lattice.
+     * @param accelerator Lattice to analyse; read again on every compute().
+     * @param referenceMomentum Reference momentum p0 [kg*m/s].
+     * @param charge Particle charge [C].
+     */
+    Optics(std::shared_ptr<const Accelerator> accelerator, double referenceMomentum,
+           double charge = physics::constants::e);
+
+    /**
+     * @brief Set the optics at the lattice start used for linear lattices.
+     */
+    void setInitialOptics(const OpticsPoint& initial);
+    const OpticsPoint& getInitialOptics() const { return m_initial; }
+
+    /**
+     * @brief Bring the optics up to date with the lattice.
+     * @return False if a circular lattice has no stable periodic solution.
+     */
+    bool compute();
+
+    /**
+     * @brief Force element index (and everything downstream) to be rebuilt.
+     */
+    void invalidate(size_t index);
+
+    /**
+     * @brief Check if the last compute() found valid optics.
+     */
+    bool isValid() const { return m_valid; }
+
+    /**
+     * @brief Optics at the exit of each element (empty if not valid).
+     */
+    const std::vector<OpticsPoint>& getPoints() const { return m_points; }
+
+    /**
+     * @brief Optics at the start of the lattice.
+     */
+    const OpticsPoint& getStart() const { return m_start; }
+
+    /**
+     * @brief Betatron tunes (total phase advance / 2 pi).
+     */
+    double getTuneX() const;
+    double getTuneY() const;
+
+    size_t getElementCount() const { return m_elements.size(); }
+    const TransferMatrix& getElementMatrix(size_t index) const { return m_elements[index].matrix; }
+
+    /**
+     * @brief Transfer matrix from the lattice start to the exit of an element.
+     */
+    const TransferMatrix& getCumulativeMatrix(size_t index) const { return m_prefix[index]; }
+
+    /**
+     * @brief Transfer matrix of the whole lattice (identity if empty).
+     */
+    TransferMatrix getOneTurnMatrix() const;
+
+    /**
+     * @brief Number of prefix products rebuilt by the last compute().
+     */
+    size_t getRecomputedCount() const { return m_recomputed; }
+
+private:
+    struct CachedElement {
+        const Component* component = nullptr;
+        uint64_t version = 0;   // Built at this version; unique across components
+        double length = 0.0;
+        TransferMatrix matrix;
+    };
+
+    bool computePeriodicStart();
+    void computePoints(size_t first);
+
+    std::shared_ptr<const Accelerator> m_accelerator;
+    double m_referenceMomentum;
+    double m_charge;
+
+    std::vector<CachedElement> m_elements;
+    std::vector<TransferMatrix> m_prefix;
+    size_t m_recomputed = 0;
+    size_t m_pointsDirty = 0;   // First point that needs re-evaluation
+
+    OpticsPoint m_initial;
+    OpticsPoint m_start;
+    std::vector<OpticsPoint> m_points;
+    bool m_valid = false;
+};
+
+} // namespace pas::accelerator
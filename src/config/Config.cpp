@@ -1,8 +1,12 @@
 #include "config/Config.hpp"
+#include "config/LatticeCache.hpp"
+#include "config/LatticeImport.hpp"
 #include "utils/Logger.hpp"
 #include "physics/Constants.hpp"
 
+#include <filesystem>
 #include <fstream>
+#include <map>
 
 namespace pas::config {
 
@@ -12,6 +16,8 @@ void to_json(nlohmann::json& j, const Config::SimulationConfig& c) {
         {"timeStep", c.timeStep},
         {"timeScale", c.timeScale},
         {"integratorType", c.integratorType},
+        {"coordinateMode", c.coordinateMode},
+        {"precision", c.precision},
         {"particleCount", c.particleCount},
         {"beamEnergy", c.beamEnergy}
     };
@@ -21,6 +27,8 @@ void from_json(const nlohmann::json& j, Config::SimulationConfig& c) {
     if (j.contains("timeStep")) j.at("timeStep").get_to(c.timeStep);
     if (j.contains("timeScale")) j.at("timeScale").get_to(c.timeScale);
     if (j.contains("integratorType")) j.at("integratorType").get_to(c.integratorType);
+    if (j.contains("coordinateMode")) j.at("coordinateMode").get_to(c.coordinateMode);
+    if (j.contains("precision")) j.at("precision").get_to(c.precision);
     if (j.contains("particleCount")) j.at("particleCount").get_to(c.particleCount);
     if (j.contains("beamEnergy")) j.at("beamEnergy").get_to(c.beamEnergy);
 }
@@ -124,10 +132,20 @@ void Config::applyToEngine(physics::PhysicsEngine& engine) const {
     engine.setTimeStep(m_simulation.timeStep);
     engine.setTimeScale(m_simulation.timeScale);
     engine.setIntegrator(static_cast<physics::IntegratorFactory::Type>(m_simulation.integratorType));
+    engine.setCoordinateMode(static_cast<physics::CoordinateMode>(m_simulation.coordinateMode));
+    engine.setPrecision(static_cast<physics::Precision>(m_simulation.precision));
 }
 
 std::shared_ptr<accelerator::Accelerator>
 Config::loadAccelerator(const std::string& filepath) {
+    const std::string extension = std::filesystem::path(filepath).extension().string();
+    if (extension == ".madx" || extension == ".seq") {
+        return importMadx(filepath);
+    }
+    if (extension == ".tfs") {
+        return importTfs(filepath);
+    }
+
     try {
         std::ifstream file(filepath);
         if (!file.is_open()) {
@@ -148,6 +166,24 @@ Config::loadAccelerator(const std::string& filepath) {
             }
         }
 
+        // B rho [T m] of the reference particle; dipoles bend the survey with it
+        acc->setReferenceRigidity(j.value("referenceRigidity", 0.0));
+
+        // Parse ramp waveforms shared by magnets: "ramps": {"name": {"times", "values", "interpolation"}}
+        std::map<std::string, std::shared_ptr<const physics::Waveform>> ramps;
+        if (j.contains("ramps") && j["ramps"].is_object()) {
+            for (const auto& item : j["ramps"].items()) {
+                const auto& ramp = item.value();
+                auto interpolation = ramp.value("interpolation", std::string("linear")) == "spline"
+                                     ? physics::Waveform::Interpolation::CubicSpline
+                                     : physics::Waveform::Interpolation::Linear;
+                ramps[item.key()] = std::make_shared<physics::Waveform>(
+                    ramp.value("times", std::vector<double>{}),
+                    ramp.value("values", std::vector<double>{}),
+                    interpolation);
+            }
+        }
+
         // Parse components
         if (j.contains("components") && j["components"].is_array()) {
             for (const auto& comp : j["components"]) {
@@ -160,17 +196,68 @@ Config::loadAccelerator(const std::string& filepath) {
                 ap.radiusX = aperture;
                 ap.radiusY = aperture;
 
+                // Optional Enge fringe with the default coefficients
+                auto applyFringe = [&comp](auto& element) {
+                    if (comp.contains("fringeGap")) {
+                        physics::EngeFunction enge;
+                        enge.gap = comp["fringeGap"];
+                        element.setFringe(enge);
+                    }
+                };
+
+                // Optional ramp by name
+                auto applyRamp = [&comp, &ramps, &name](accelerator::Magnet& magnet) {
+                    if (comp.contains("ramp")) {
+                        auto ramp = ramps.find(comp["ramp"].get<std::string>());
+                        if (ramp != ramps.end()) {
+                            magnet.setRamp(ramp->second);
+                        } else {
+                            PAS_WARN("Config: Unknown ramp for {}", name);
+                        }
+                    }
+                };
+
                 if (type == "drift" || type == "beampipe") {
                     auto pipe = std::make_shared<accelerator::BeamPipe>(name, length, ap);
                     acc->addComponent(pipe);
                 } else if (type == "dipole") {
                     double field = comp.value("field", 1.0);
                     auto dipole = std::make_shared<accelerator::Dipole>(name, length, field, ap);
+                    applyFringe(*dipole);
+                    applyRamp(*dipole);
                     acc->addComponent(dipole);
                 } else if (type == "quadrupole") {
                     double gradient = comp.value("gradient", 10.0);
                     auto quad = std::make_shared<accelerator::Quadrupole>(name, length, gradient, ap);
+                    applyFringe(*quad);
+                    applyRamp(*quad);
                     acc->addComponent(quad);
+                } else if (type == "sextupole") {
+                    double strength = comp.value("strength", 0.0);
+                    auto sext = std::make_shared<accelerator::Sextupole>(name, length, strength, ap);
+                    applyFringe(*sext);
+                    applyRamp(*sext);
+                    acc->addComponent(sext);
+                } else if (type == "multipole") {
+                    // Coefficients b_n, a_n [T/m^(n-1)] listed from the dipole term
+                    auto normal = comp.value("normal", std::vector<double>{});
+                    auto skew = comp.value("skew", std::vector<double>{});
+                    physics::MultipoleExpansion multipoles;
+                    for (size_t i = 0; i < normal.size(); ++i) {
+                        multipoles.setNormal(static_cast<int>(i) + 1, normal[i]);
+                    }
+                    for (size_t i = 0; i < skew.size(); ++i) {
+                        multipoles.setSkew(static_cast<int>(i) + 1, skew[i]);
+                    }
+                    auto multipole = std::make_shared<accelerator::Multipole>(name, length, multipoles, ap);
+                    applyFringe(*multipole);
+                    applyRamp(*multipole);
+                    acc->addComponent(multipole);
+                } else if (type == "solenoid") {
+                    double field = comp.value("field", 1.0);
+                    auto solenoid = std::make_shared<accelerator::Solenoid>(name, length, field, ap);
+                    applyFringe(*solenoid);
+                    acc->addComponent(solenoid);
                 } else if (type == "rfcavity") {
                     double voltage = comp.value("voltage", 1e6);
                     double frequency = comp.value("frequency", 500e6);
@@ -178,6 +265,10 @@ Config::loadAccelerator(const std::string& filepath) {
                     auto rf = std::make_shared<accelerator::RFCavity>(
                         name, length, voltage, frequency, phase, ap);
                     acc->addComponent(rf);
+                } else if (type == "monitor") {
+                    size_t capacity = comp.value("capacity", size_t{1024});
+                    auto bpm = std::make_shared<accelerator::BeamPositionMonitor>(name, capacity, ap);
+                    acc->addComponent(bpm);
                 }
             }
         }
@@ -193,6 +284,11 @@ Config::loadAccelerator(const std::string& filepath) {
     }
 }
 
+std::shared_ptr<accelerator::Accelerator>
+Config::loadAcceleratorCached(const std::string& filepath) {
+    return LatticeCache::loadOrBuild(filepath, &Config::loadAccelerator);
+}
+
 bool Config::saveAccelerator(const accelerator::Accelerator& accelerator,
                               const std::string& filepath) {
     try {
@@ -201,14 +297,22 @@ bool Config::saveAccelerator(const accelerator::Accelerator& accelerator,
         j["latticeType"] = accelerator.getLatticeType() == accelerator::LatticeType::Circular
                           ? "circular" : "linear";
         j["totalLength"] = accelerator.getTotalLength();
+        j["referenceRigidity"] = accelerator.getReferenceRigidity();
+
+        // Ramps are named by first use
+        std::map<const physics::Waveform*, std::string> rampNames;
+        nlohmann::json ramps = nlohmann::json::object();
 
         nlohmann::json components = nlohmann::json::array();
-        for (const auto& comp : accelerator.getComponents()) {
+        const auto& lattice = accelerator.getComponents();
+        const auto& sStarts = accelerator.getCompiledLattice().getSStarts();
+        for (size_t index = 0; index < lattice.size(); ++index) {
+            const auto& comp = lattice[index];
             nlohmann::json c;
             c["name"] = comp->getName();
             c["length"] = comp->getLength();
             c["aperture"] = comp->getAperture().radiusX;
-            c["sPosition"] = comp->getSPosition();
+            c["sPosition"] = sStarts[index];
 
             switch (comp->getType()) {
                 case accelerator::ComponentType::BeamPipe:
@@ -226,6 +330,33 @@ bool Config::saveAccelerator(const accelerator::Accelerator& accelerator,
                         c["gradient"] = q->getGradient();
                     }
                     break;
+                case accelerator::ComponentType::Sextupole:
+                    c["type"] = "sextupole";
+                    if (auto sext = std::dynamic_pointer_cast<accelerator::Sextupole>(comp)) {
+                        c["strength"] = sext->getStrength();
+                    }
+                    break;
+                case accelerator::ComponentType::Multipole:
+                    c["type"] = "multipole";
+                    if (auto m = std::dynamic_pointer_cast<accelerator::Multipole>(comp)) {
+                        const auto& multipoles = m->getCoefficients();
+                        std::vector<double> normal;
+                        std::vector<double> skew;
+                        for (int n = 1; n <= multipoles.getOrder(); ++n) {
+                            normal.push_back(multipoles.getNormal(n));
+                            skew.push_back(multipoles.getSkew(n));
+                        }
+                        c["normal"] = normal;
+                        c["skew"] = skew;
+                    }
+                    break;
+                case accelerator::ComponentType::Solenoid:
+                    c["type"] = "solenoid";
+                    if (auto sol = std::dynamic_pointer_cast<accelerator::Solenoid>(comp)) {
+                        c["field"] = sol->getField();
+                        c["fringeGap"] = sol->getFringe().gap;
+                    }
+                    break;
                 case accelerator::ComponentType::RFCavity:
                     c["type"] = "rfcavity";
                     if (auto rf = std::dynamic_pointer_cast<accelerator::RFCavity>(comp)) {
@@ -234,14 +365,41 @@ bool Config::saveAccelerator(const accelerator::Accelerator& accelerator,
                         c["phase"] = rf->getPhase();
                     }
                     break;
+                case accelerator::ComponentType::Monitor:
+                    c["type"] = "monitor";
+                    if (auto bpm = std::dynamic_pointer_cast<accelerator::BeamPositionMonitor>(comp)) {
+                        c["capacity"] = bpm->getCapacity();
+                    }
+                    break;
                 default:
                     c["type"] = "unknown";
                     break;
             }
 
+            if (auto magnet = std::dynamic_pointer_cast<accelerator::Magnet>(comp)) {
+                if (magnet->getFringe()) {
+                    c["fringeGap"] = magnet->getFringe()->gap;
+                }
+                if (const auto& ramp = magnet->getRamp()) {
+                    auto [it, inserted] = rampNames.try_emplace(
+                        ramp.get(), "ramp" + std::to_string(rampNames.size()));
+                    if (inserted) {
+                        ramps[it->second] = {
+                            {"times", ramp->getTimes()},
+                            {"values", ramp->getValues()},
+                            {"interpolation", physics::interpolationToString(ramp->getInterpolation())}
+                        };
+                    }
+                    c["ramp"] = it->second;
+                }
+            }
+
             components.push_back(c);
         }
         j["components"] = components;
+        if (!ramps.empty()) {
+            j["ramps"] = ramps;
+        }
 
         std::ofstream file(filepath);
         if (!file.is_open()) {
@@ -20,6 +20,8 @@ public:
         double timeStep = 1e-11;
         double timeScale = 1e6;
         int integratorType = 2;  // Boris
+        int coordinateMode = 0;  // Global; 1 = relative to the reference orbit
+        int precision = 0;       // Double; 1 = float, 2 = mixed (Boris and RK4, with a lattice)
         size_t particleCount = 1000;
         double beamEnergy = 1e9;  // eV
     };
@@ -79,10 +81,22 @@ public:
 
     /**
      * @brief Load accelerator lattice from JSON file.
+     *
+     * .madx, .seq and .tfs files are imported with importMadx() and importTfs().
      */
     static std::shared_ptr<accelerator::Accelerator>
     loadAccelerator(const std::string& filepath);
 
+    /**
+     * @brief Load accelerator lattice through its binary cache.
+     *
+     * The cache sits next to the source (filepath + ".pascache") and is
+     * rebuilt with loadAccelerator() when the source changes.
+     * @see LatticeCache
+     */
+    static std::shared_ptr<accelerator::Accelerator>
+    loadAcceleratorCached(const std::string& filepath);
+
     /**
      * @brief Save accelerator lattice to JSON file.
      */
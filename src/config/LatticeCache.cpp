@@ -0,0 +1,443 @@
+#include "config/LatticeCache.hpp"
+#include "accelerator/BeamPositionMonitor.hpp"
+#include "utils/Hash.hpp"
+#include "utils/Logger.hpp"
+#include "utils/MappedFile.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+namespace pas::config {
+
+namespace {
+
+using namespace accelerator;
+
+constexpr char LATTICE_MAGIC[8] = {'P', 'A', 'S', 'L', 'A', 'T', '0', '1'};
+
+constexpr uint32_t HAS_FRINGE = 1u << 0;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t latticeType;
+    uint64_t sourceHash;
+    uint64_t elementCount;
+    uint64_t componentCount;
+    uint64_t coefficientCount;
+    uint64_t nameBytes;
+    double referenceRigidity;
+};
+
+struct ComponentRecord {
+    uint32_t type;            // ComponentType
+    uint32_t flags;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t apertureShape;   // ApertureShape
+    uint32_t multipoleOrder;  // Multipole coefficients, normal then skew
+    uint32_t normalCount;     // Error coefficients, after the multipole ones
+    uint32_t skewCount;
+    uint64_t coefficientOffset;
+    double length;
+    double apertureX;
+    double apertureY;
+    double parameters[3];     // Main strength; RF voltage, frequency, phase; monitor capacity
+    double position[3];
+    double rotation[4];       // w, x, y, z
+    double offsetX;
+    double offsetY;
+    double roll;
+    double referenceRadius;
+    double fringe[7];         // Enge coefficients, then gap
+};
+
+static_assert(sizeof(Header) == 64, "Lattice cache header layout changed");
+static_assert(sizeof(ComponentRecord) == 232, "Lattice cache record layout changed");
+
+size_t alignedElementBytes(size_t elementCount) {
+    return (elementCount * sizeof(uint32_t) + 7) & ~size_t(7);
+}
+
+/**
+ * @brief Byte offsets of the sections of a cache file.
+ */
+struct Layout {
+    size_t components;
+    size_t elements;
+    size_t coefficients;
+    size_t names;
+    size_t total;
+
+    Layout(uint64_t elementCount, uint64_t componentCount, uint64_t coefficientCount,
+           uint64_t nameBytes) {
+        components = sizeof(Header);
+        elements = components + componentCount * sizeof(ComponentRecord);
+        coefficients = elements + alignedElementBytes(elementCount);
+        names = coefficients + coefficientCount * sizeof(double);
+        total = names + nameBytes;
+    }
+};
+
+void storeFringe(ComponentRecord& record, const physics::EngeFunction& fringe) {
+    record.flags |= HAS_FRINGE;
+    std::copy(fringe.coefficients.begin(), fringe.coefficients.end(), record.fringe);
+    record.fringe[6] = fringe.gap;
+}
+
+physics::EngeFunction loadFringe(const ComponentRecord& record) {
+    physics::EngeFunction fringe;
+    std::copy(record.fringe, record.fringe + 6, fringe.coefficients.begin());
+    fringe.gap = record.fringe[6];
+    return fringe;
+}
+
+/**
+ * @brief Fill a record from a component; coefficients go to the shared pool.
+ */
+void storeComponent(const Component& component, ComponentRecord& record,
+                    std::vector<double>& coefficients, std::string& names) {
+    record = ComponentRecord{};
+    record.type = static_cast<uint32_t>(component.getType());
+    record.nameOffset = static_cast<uint32_t>(names.size());
+    record.nameLength = static_cast<uint32_t>(component.getName().size());
+    names += component.getName();
+
+    record.length = component.getLength();
+    record.apertureShape = static_cast<uint32_t>(component.getAperture().shape);
+    record.apertureX = component.getAperture().radiusX;
+    record.apertureY = component.getAperture().radiusY;
+
+    const glm::dvec3& position = component.getPosition();
+    const glm::dquat& rotation = component.getRotation();
+    record.position[0] = position.x;
+    record.position[1] = position.y;
+    record.position[2] = position.z;
+    record.rotation[0] = rotation.w;
+    record.rotation[1] = rotation.x;
+    record.rotation[2] = rotation.y;
+    record.rotation[3] = rotation.z;
+    record.coefficientOffset = coefficients.size();
+
+    switch (component.getType()) {
+        case ComponentType::Dipole:
+            record.parameters[0] = static_cast<const Dipole&>(component).getField();
+            break;
+        case ComponentType::Quadrupole:
+            record.parameters[0] = static_cast<const Quadrupole&>(component).getGradient();
+            break;
+        case ComponentType::Sextupole:
+            record.parameters[0] = static_cast<const Sextupole&>(component).getStrength();
+            break;
+        case ComponentType::Multipole: {
+            const auto& expansion = static_cast<const Multipole&>(component).getCoefficients();
+            record.multipoleOrder = static_cast<uint32_t>(expansion.getOrder());
+            for (int n = 1; n <= expansion.getOrder(); ++n) {
+                coefficients.push_back(expansion.getNormal(n));
+            }
+            for (int n = 1; n <= expansion.getOrder(); ++n) {
+                coefficients.push_back(expansion.getSkew(n));
+            }
+            break;
+        }
+        case ComponentType::Solenoid: {
+            const auto& solenoid = static_cast<const Solenoid&>(component);
+            record.parameters[0] = solenoid.getField();
+            storeFringe(record, solenoid.getFringe());
+            break;
+        }
+        case ComponentType::RFCavity: {
+            const auto& cavity = static_cast<const RFCavity&>(component);
+            record.parameters[0] = cavity.getVoltage();
+            record.parameters[1] = cavity.getFrequency();
+            record.parameters[2] = cavity.getPhase();
+            break;
+        }
+        case ComponentType::Monitor:
+            record.parameters[0] = static_cast<double>(
+                static_cast<const BeamPositionMonitor&>(component).getCapacity());
+            break;
+        default:
+            break;
+    }
+
+    if (const auto* magnet = dynamic_cast<const Magnet*>(&component)) {
+        const MagnetErrors& errors = magnet->getErrors();
+        record.normalCount = static_cast<uint32_t>(errors.normal.size());
+        record.skewCount = static_cast<uint32_t>(errors.skew.size());
+        coefficients.insert(coefficients.end(), errors.normal.begin(), errors.normal.end());
+        coefficients.insert(coefficients.end(), errors.skew.begin(), errors.skew.end());
+        record.offsetX = errors.offsetX;
+        record.offsetY = errors.offsetY;
+        record.roll = errors.roll;
+        record.referenceRadius = errors.referenceRadius;
+        if (magnet->getFringe()) {
+            storeFringe(record, *magnet->getFringe());
+        }
+    }
+}
+
+/**
+ * @brief Build a component from a record.
+ * @return nullptr if the record references data outside the file.
+ */
+std::shared_ptr<Component> loadComponent(const ComponentRecord& record, const double* coefficients,
+                                         uint64_t coefficientCount, std::string_view names) {
+    const uint64_t used = uint64_t(record.multipoleOrder) * 2 + record.normalCount + record.skewCount;
+    if (uint64_t(record.nameOffset) + record.nameLength > names.size() ||
+        record.coefficientOffset > coefficientCount || used > coefficientCount - record.coefficientOffset ||
+        record.apertureShape > static_cast<uint32_t>(ApertureShape::Rectangular)) {
+        return nullptr;
+    }
+
+    const std::string name(names.substr(record.nameOffset, record.nameLength));
+    Aperture aperture;
+    aperture.shape = static_cast<ApertureShape>(record.apertureShape);
+    aperture.radiusX = record.apertureX;
+    aperture.radiusY = record.apertureY;
+    const double* pool = coefficients + record.coefficientOffset;
+
+    std::shared_ptr<Component> component;
+    switch (static_cast<ComponentType>(record.type)) {
+        case ComponentType::BeamPipe:
+            component = std::make_shared<BeamPipe>(name, record.length, aperture);
+            break;
+        case ComponentType::Dipole:
+            component = std::make_shared<Dipole>(name, record.length, record.parameters[0], aperture);
+            break;
+        case ComponentType::Quadrupole:
+            component = std::make_shared<Quadrupole>(name, record.length, record.parameters[0], aperture);
+            break;
+        case ComponentType::Sextupole:
+            component = std::make_shared<Sextupole>(name, record.length, record.parameters[0], aperture);
+            break;
+        case ComponentType::Multipole: {
+            physics::MultipoleExpansion expansion;
+            const int order = static_cast<int>(record.multipoleOrder);
+            for (int n = 1; n <= order; ++n) {
+                expansion.setNormal(n, pool[n - 1]);
+                expansion.setSkew(n, pool[order + n - 1]);
+            }
+            pool += 2 * order;
+            component = std::make_shared<Multipole>(name, record.length, std::move(expansion), aperture);
+            break;
+        }
+        case ComponentType::Solenoid: {
+            auto solenoid = std::make_shared<Solenoid>(name, record.length, record.parameters[0], aperture);
+            solenoid->setFringe(loadFringe(record));
+            component = solenoid;
+            break;
+        }
+        case ComponentType::RFCavity:
+            component = std::make_shared<RFCavity>(name, record.length, record.parameters[0],
+                                                   record.parameters[1], record.parameters[2], aperture);
+            break;
+        case ComponentType::Detector:
+            component = std::make_shared<Detector>(name, aperture);
+            break;
+        case ComponentType::Monitor:
+            component = std::make_shared<BeamPositionMonitor>(
+                name, static_cast<size_t>(record.parameters[0]), aperture);
+            break;
+        default:
+            return nullptr;
+    }
+
+    if (auto magnet = std::dynamic_pointer_cast<Magnet>(component)) {
+        MagnetErrors errors;
+        errors.normal.assign(pool, pool + record.normalCount);
+        errors.skew.assign(pool + record.normalCount, pool + record.normalCount + record.skewCount);
+        errors.offsetX = record.offsetX;
+        errors.offsetY = record.offsetY;
+        errors.roll = record.roll;
+        errors.referenceRadius = record.referenceRadius;
+        if (!errors.isZero()) {
+            magnet->setErrors(errors);
+        }
+        if (record.flags & HAS_FRINGE) {
+            magnet->setFringe(loadFringe(record));
+        }
+    }
+
+    component->setPosition(glm::dvec3(record.position[0], record.position[1], record.position[2]));
+    component->setRotation(glm::dquat(record.rotation[0], record.rotation[1], record.rotation[2],
+                                      record.rotation[3]));
+    return component;
+}
+
+} // namespace
+
+uint64_t LatticeCache::hashSource(std::string_view content) {
+    return utils::fnv1a(content);
+}
+
+bool LatticeCache::isCacheable(const Accelerator& lattice) {
+    for (const auto& component : lattice.getComponents()) {
+        if (component->getType() == ComponentType::Custom) {
+            return false;
+        }
+        const auto* magnet = dynamic_cast<const Magnet*>(component.get());
+        if (magnet && magnet->getRamp()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LatticeCache::save(const Accelerator& lattice, const std::string& cachePath, uint64_t sourceHash) {
+    if (!isCacheable(lattice)) {
+        PAS_WARN("LatticeCache: Lattice has ramped or custom components and is not cached");
+        return false;
+    }
+
+    // Unique components in order of first occurrence
+    const auto& components = lattice.getComponents();
+    std::unordered_map<const Component*, uint32_t> unique;
+    std::vector<uint32_t> elements;
+    std::vector<ComponentRecord> records;
+    std::vector<double> coefficients;
+    std::string names;
+    elements.reserve(components.size());
+    for (const auto& component : components) {
+        auto [it, inserted] = unique.try_emplace(component.get(), static_cast<uint32_t>(records.size()));
+        if (inserted) {
+            storeComponent(*component, records.emplace_back(), coefficients, names);
+        }
+        elements.push_back(it->second);
+    }
+
+    const Layout layout(elements.size(), records.size(), coefficients.size(), names.size());
+    const std::string tempPath = cachePath + ".tmp";
+    {
+        utils::MappedFile file;
+        if (!file.create(tempPath, layout.total)) {
+            return false;
+        }
+        std::byte* base = file.data();
+        Header header{};
+        std::memcpy(header.magic, LATTICE_MAGIC, sizeof(LATTICE_MAGIC));
+        header.version = FORMAT_VERSION;
+        header.latticeType = static_cast<uint32_t>(lattice.getLatticeType());
+        header.sourceHash = sourceHash;
+        header.elementCount = elements.size();
+        header.componentCount = records.size();
+        header.coefficientCount = coefficients.size();
+        header.nameBytes = names.size();
+        header.referenceRigidity = lattice.getReferenceRigidity();
+        std::memcpy(base, &header, sizeof(header));
+        std::memcpy(base + layout.components, records.data(), records.size() * sizeof(ComponentRecord));
+        std::memcpy(base + layout.elements, elements.data(), elements.size() * sizeof(uint32_t));
+        std::memcpy(base + layout.coefficients, coefficients.data(), coefficients.size() * sizeof(double));
+        std::memcpy(base + layout.names, names.data(), names.size());
+        file.flush();
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, cachePath, error);
+    if (error) {
+        PAS_ERROR("LatticeCache: Could not write {}: {}", cachePath, error.message());
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    PAS_DEBUG("LatticeCache: Wrote {} elements ({} unique) to {}", elements.size(), records.size(),
+              cachePath);
+    return true;
+}
+
+std::shared_ptr<Accelerator> LatticeCache::load(const std::string& cachePath, uint64_t sourceHash) {
+    std::error_code error;
+    if (!std::filesystem::exists(cachePath, error)) {
+        return nullptr;
+    }
+    utils::MappedFile file;
+    if (!file.openReadOnly(cachePath)) {
+        return nullptr;
+    }
+
+    Header header;
+    if (file.size() < sizeof(Header)) {
+        PAS_WARN("LatticeCache: {} is not a lattice cache", cachePath);
+        return nullptr;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, LATTICE_MAGIC, sizeof(LATTICE_MAGIC)) != 0 ||
+        header.version != FORMAT_VERSION) {
+        PAS_INFO("LatticeCache: {} has another format version; rebuilding", cachePath);
+        return nullptr;
+    }
+    if (header.sourceHash != sourceHash) {
+        PAS_INFO("LatticeCache: Source changed since {} was written; rebuilding", cachePath);
+        return nullptr;
+    }
+
+    // Counts are checked against the file size before any section is read
+    const uint64_t limit = file.size();
+    if (header.elementCount > limit || header.componentCount > limit / sizeof(ComponentRecord) ||
+        header.coefficientCount > limit / sizeof(double) || header.nameBytes > limit ||
+        Layout(header.elementCount, header.componentCount, header.coefficientCount,
+               header.nameBytes).total != limit) {
+        PAS_WARN("LatticeCache: {} is truncated or corrupt", cachePath);
+        return nullptr;
+    }
+    const Layout layout(header.elementCount, header.componentCount, header.coefficientCount,
+                        header.nameBytes);
+
+    const std::byte* base = file.data();
+    const auto* records = reinterpret_cast<const ComponentRecord*>(base + layout.components);
+    const auto* elements = reinterpret_cast<const uint32_t*>(base + layout.elements);
+    const auto* coefficients = reinterpret_cast<const double*>(base + layout.coefficients);
+    const std::string_view names(reinterpret_cast<const char*>(base + layout.names), header.nameBytes);
+
+    std::vector<std::shared_ptr<Component>> components(header.componentCount);
+    for (size_t i = 0; i < components.size(); ++i) {
+        components[i] = loadComponent(records[i], coefficients, header.coefficientCount, names);
+        if (!components[i]) {
+            PAS_WARN("LatticeCache: {} has an invalid component record", cachePath);
+            return nullptr;
+        }
+    }
+
+    auto lattice = std::make_shared<Accelerator>();
+    for (uint64_t i = 0; i < header.elementCount; ++i) {
+        if (elements[i] >= components.size()) {
+            PAS_WARN("LatticeCache: {} has an invalid element", cachePath);
+            return nullptr;
+        }
+        lattice->addComponent(components[elements[i]]);
+    }
+    lattice->setLatticeType(static_cast<LatticeType>(header.latticeType));
+    lattice->setReferenceRigidity(header.referenceRigidity);
+    lattice->computeLattice();
+    return lattice;
+}
+
+std::shared_ptr<Accelerator> LatticeCache::loadOrBuild(const std::string& sourcePath, const Loader& loader,
+                                                       const std::string& cachePath) {
+    uint64_t hash = 0;
+    {
+        utils::MappedFile source;
+        if (!source.openReadOnly(sourcePath)) {
+            return nullptr;
+        }
+        hash = hashSource(source.view());
+    }
+
+    const std::string path = cachePath.empty() ? sourcePath + ".pascache" : cachePath;
+    if (auto lattice = load(path, hash)) {
+        PAS_INFO("LatticeCache: Loaded {} from {}", sourcePath, path);
+        return lattice;
+    }
+
+    auto lattice = loader(sourcePath);
+    if (lattice) {
+        save(*lattice, path, hash);
+    }
+    return lattice;
+}
+
+} // namespace pas::config
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "accelerator/Accelerator.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace pas::config {
+
+/**
+ * @brief Binary cache of a lattice built from a source file.
+ *
+ * A lattice loaded from JSON or MAD-X is written once to a flat binary file
+ * keyed by a hash of the source text; later starts map the cache and build
+ * the components straight from its records instead of parsing the source
+ * again. Components shared by several places are stored once and stay
+ * shared. The layout is plain and versioned:
+ *
+ *   Header        64 bytes (magic "PASLAT01", version, source hash, counts,
+ *                 reference rigidity)
+ *   Components    componentCount x 232-byte records
+ *   Elements      elementCount x uint32 component index, padded to 8 bytes
+ *   Coefficients  coefficientCount doubles (multipole and error coefficients)
+ *   Names         nameBytes of concatenated component names
+ *
+ * s-positions, the survey and the compiled lattice are rebuilt by
+ * computeLattice() in a single pass over the elements; transfer maps depend
+ * on the momentum and are built by LatticeTracker as before.
+ */
+class LatticeCache {
+public:
+    static constexpr uint32_t FORMAT_VERSION = 2;
+
+    using Loader = std::function<std::shared_ptr<accelerator::Accelerator>(const std::string&)>;
+
+    /**
+     * @brief 64-bit FNV-1a hash of source text.
+     */
+    static uint64_t hashSource(std::string_view content);
+
+    /**
+     * @brief Check that every component can be stored.
+     *
+     * Magnets driven by ramp waveforms and custom components cannot.
+     */
+    static bool isCacheable(const accelerator::Accelerator& lattice);
+
+    /**
+     * @brief Write a lattice to a cache file.
+     *
+     * The file is written under a temporary name and renamed into place, so
+     * a concurrent reader sees either the old or the new cache.
+     * @return False if the lattice cannot be cached or the file not written.
+     */
+    static bool save(const accelerator::Accelerator& lattice, const std::string& cachePath,
+                     uint64_t sourceHash);
+
+    /**
+     * @brief Load a lattice from a cache file.
+     * @return nullptr if the file is missing, invalid, of another format
+     *         version or built from a different source.
+     */
+    static std::shared_ptr<accelerator::Accelerator> load(const std::string& cachePath,
+                                                          uint64_t sourceHash);
+
+    /**
+     * @brief Load a lattice through its cache, building and caching it on a miss.
+     * @param sourcePath Lattice source file, hashed to validate the cache.
+     * @param loader Builds the lattice from the source on a miss.
+     * @param cachePath Cache file; sourcePath + ".pascache" if empty.
+     */
+    static std::shared_ptr<accelerator::Accelerator> loadOrBuild(const std::string& sourcePath,
+                                                                 const Loader& loader,
+                                                                 const std::string& cachePath = "");
+};
+
+} // namespace pas::config
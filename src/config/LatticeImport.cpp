@@ -0,0 +1,1302 @@
+#include "config/LatticeImport.hpp"
+#include "accelerator/BeamPositionMonitor.hpp"
+#include "physics/Constants.hpp"
+#include "utils/Hash.hpp"
+#include "utils/Logger.hpp"
+#include "utils/MappedFile.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace pas::config {
+
+namespace {
+
+using accelerator::Aperture;
+using accelerator::ApertureShape;
+using accelerator::Component;
+
+// Positions closer than this are treated as equal when placing elements [m]
+constexpr double POSITION_TOLERANCE = 1e-9;
+
+// Deferred expressions nested deeper than this are taken to be circular
+constexpr int MAX_EVALUATION_DEPTH = 64;
+
+// Names are case-insensitive, as in MAD-X
+
+char toLower(char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(),
+                      [](char x, char y) { return toLower(x) == toLower(y); });
+}
+
+struct NameHash {
+    size_t operator()(std::string_view name) const {
+        // FNV-1a over the lower-case name
+        uint64_t hash = utils::FNV_OFFSET_BASIS;
+        for (char c : name) {
+            hash = utils::fnv1aStep(hash, static_cast<unsigned char>(toLower(c)));
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+struct NameEqual {
+    bool operator()(std::string_view a, std::string_view b) const { return iequals(a, b); }
+};
+
+// Keys are views into the source text, which outlives the maps
+template <typename T>
+using NameMap = std::unordered_map<std::string_view, T, NameHash, NameEqual>;
+
+bool parseNumber(std::string_view text, double& value) {
+    const char* end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    return ec == std::errc() && ptr == end;
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+std::string_view unquote(std::string_view text) {
+    text = trim(text);
+    if (text.size() >= 2 && (text.front() == '"' || text.front() == '\'') && text.back() == text.front()) {
+        return text.substr(1, text.size() - 2);
+    }
+    return text;
+}
+
+// Tokenizer
+
+enum class TokenType { End, Name, Number, String, Symbol };
+
+struct Token {
+    TokenType type = TokenType::End;
+    std::string_view text;  // View into the source; strings without quotes
+
+    bool is(std::string_view symbol) const { return type == TokenType::Symbol && text == symbol; }
+};
+
+bool isNameStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+bool isNameChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == '$';
+}
+
+bool isDigit(char c) {
+    return std::isdigit(static_cast<unsigned char>(c)) != 0;
+}
+
+/**
+ * @brief Tokenizer over MAD-X text; tokens are views into the source.
+ */
+class Lexer {
+public:
+    explicit Lexer(std::string_view source) : m_source(source) {}
+
+    Token next() {
+        skipSpaceAndComments();
+        if (m_pos >= m_source.size()) {
+            return {TokenType::End, m_source.substr(m_source.size())};
+        }
+
+        const size_t start = m_pos;
+        const char c = m_source[m_pos];
+        if (isNameStart(c)) {
+            while (m_pos < m_source.size() && isNameChar(m_source[m_pos])) {
+                ++m_pos;
+            }
+            return {TokenType::Name, m_source.substr(start, m_pos - start)};
+        }
+        if (isDigit(c) || (c == '.' && isDigit(at(m_pos + 1)))) {
+            while (isDigit(at(m_pos)) || at(m_pos) == '.') {
+                ++m_pos;
+            }
+            if (at(m_pos) == 'e' || at(m_pos) == 'E' || at(m_pos) == 'd' || at(m_pos) == 'D') {
+                size_t exponent = m_pos + 1;
+                if (at(exponent) == '+' || at(exponent) == '-') {
+                    ++exponent;
+                }
+                if (isDigit(at(exponent))) {
+                    m_pos = exponent;
+                    while (isDigit(at(m_pos))) {
+                        ++m_pos;
+                    }
+                }
+            }
+            return {TokenType::Number, m_source.substr(start, m_pos - start)};
+        }
+        if (c == '"' || c == '\'') {
+            const size_t close = m_source.find(c, start + 1);
+            m_pos = close == std::string_view::npos ? m_source.size() : close + 1;
+            const size_t end = close == std::string_view::npos ? m_source.size() : close;
+            return {TokenType::String, m_source.substr(start + 1, end - start - 1)};
+        }
+        if ((c == ':' && at(m_pos + 1) == '=') || (c == '-' && at(m_pos + 1) == '>')) {
+            m_pos += 2;
+            return {TokenType::Symbol, m_source.substr(start, 2)};
+        }
+        ++m_pos;
+        return {TokenType::Symbol, m_source.substr(start, 1)};
+    }
+
+    Token peek() {
+        const size_t saved = m_pos;
+        Token token = next();
+        m_pos = saved;
+        return token;
+    }
+
+private:
+    char at(size_t pos) const { return pos < m_source.size() ? m_source[pos] : '\0'; }
+
+    void skipSpaceAndComments() {
+        while (m_pos < m_source.size()) {
+            const char c = m_source[m_pos];
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                ++m_pos;
+            } else if (c == '!' || (c == '/' && at(m_pos + 1) == '/')) {
+                const size_t eol = m_source.find('\n', m_pos);
+                m_pos = eol == std::string_view::npos ? m_source.size() : eol + 1;
+            } else if (c == '/' && at(m_pos + 1) == '*') {
+                const size_t close = m_source.find("*/", m_pos + 2);
+                m_pos = close == std::string_view::npos ? m_source.size() : close + 2;
+            } else {
+                break;
+            }
+        }
+    }
+
+    std::string_view m_source;
+    size_t m_pos = 0;
+};
+
+// Element parameters shared by both formats
+
+enum class ElementClass { Drift, Bend, Quadrupole, Sextupole, Solenoid, RFCavity, Marker, Monitor, Other };
+
+ElementClass classify(std::string_view keyword) {
+    static const NameMap<ElementClass> classes = {
+        {"drift", ElementClass::Drift},           {"sbend", ElementClass::Bend},
+        {"rbend", ElementClass::Bend},            {"quadrupole", ElementClass::Quadrupole},
+        {"sextupole", ElementClass::Sextupole},   {"solenoid", ElementClass::Solenoid},
+        {"rfcavity", ElementClass::RFCavity},     {"marker", ElementClass::Marker},
+        {"monitor", ElementClass::Monitor},       {"hmonitor", ElementClass::Monitor},
+        {"vmonitor", ElementClass::Monitor},      {"instrument", ElementClass::Drift},
+    };
+    auto it = classes.find(keyword);
+    return it != classes.end() ? it->second : ElementClass::Other;
+}
+
+/**
+ * @brief Reference particle of the imported lattice.
+ */
+struct Beam {
+    double momentum = 0.0;  // p0 [kg*m/s]
+    double charge = physics::constants::e;
+    double mass = physics::constants::m_p;
+
+    double rigidity() const { return momentum / charge; }
+    double beta() const {
+        const double mc = mass * physics::constants::c;
+        return momentum / std::sqrt(momentum * momentum + mc * mc);
+    }
+};
+
+/**
+ * @brief MAD-X element attributes in MAD-X units.
+ */
+struct ElementParameters {
+    double length = 0.0;     // Arc length [m]
+    double angle = 0.0;      // rad
+    double k1 = 0.0;         // m^-2
+    double k2 = 0.0;         // m^-3
+    double ks = 0.0;         // rad/m
+    double voltage = 0.0;    // MV
+    double frequency = 0.0;  // MHz
+    double lag = 0.0;        // 2*pi
+    Aperture aperture;
+};
+
+Aperture makeAperture(std::string_view type, double a, double b) {
+    Aperture aperture;
+    if (iequals(type, "rectangle")) {
+        aperture.shape = ApertureShape::Rectangular;
+    } else if (iequals(type, "ellipse")) {
+        aperture.shape = ApertureShape::Elliptical;
+    } else if (iequals(type, "circle")) {
+        aperture.shape = ApertureShape::Circular;
+        b = a;
+    } else {
+        return aperture;
+    }
+    if (a > 0.0) {
+        aperture.radiusX = a;
+        aperture.radiusY = b > 0.0 ? b : a;
+    }
+    return aperture;
+}
+
+/**
+ * @brief Collects the warnings of one import so each kind is logged once.
+ */
+struct ImportReport {
+    std::set<std::string> unsupportedClasses;
+    size_t thinElements = 0;
+
+    void log(std::string_view format) const {
+        if (!unsupportedClasses.empty()) {
+            std::string classes;
+            for (const auto& name : unsupportedClasses) {
+                classes += classes.empty() ? name : ", " + name;
+            }
+            PAS_WARN("{}: Unsupported element classes imported as drifts: {}", format, classes);
+        }
+        if (thinElements > 0) {
+            PAS_WARN("{}: {} thin magnets and cavities imported as markers", format, thinElements);
+        }
+    }
+};
+
+std::shared_ptr<Component> makeComponent(ElementClass kind, std::string_view keyword,
+                                         const std::string& name, const ElementParameters& p,
+                                         const Beam& beam, double circumference, double harmon,
+                                         const LatticeImportOptions& options, ImportReport& report) {
+    using namespace accelerator;
+    const double brho = beam.rigidity();
+    const double length = p.length;
+
+    const bool thick = length > 0.0;
+    switch (kind) {
+        case ElementClass::Bend:
+        case ElementClass::Quadrupole:
+        case ElementClass::Sextupole:
+        case ElementClass::Solenoid:
+        case ElementClass::RFCavity:
+            if (!thick) {
+                ++report.thinElements;
+                return std::make_shared<BeamPipe>(name, 0.0, p.aperture);
+            }
+            break;
+        default:
+            break;
+    }
+
+    switch (kind) {
+        case ElementClass::Bend:
+            return std::make_shared<Dipole>(name, length, p.angle / length * brho, p.aperture);
+        case ElementClass::Quadrupole:
+            return std::make_shared<Quadrupole>(name, length, p.k1 * brho, p.aperture);
+        case ElementClass::Sextupole:
+            return std::make_shared<Sextupole>(name, length, p.k2 * brho, p.aperture);
+        case ElementClass::Solenoid:
+            return std::make_shared<Solenoid>(name, length, p.ks * brho, p.aperture);
+        case ElementClass::RFCavity: {
+            double frequency = p.frequency * 1e6;
+            if (frequency <= 0.0 && harmon > 0.0 && circumference > 0.0) {
+                frequency = harmon * beam.beta() * physics::constants::c / circumference;
+            }
+            return std::make_shared<RFCavity>(name, length, p.voltage * 1e6, frequency,
+                                              p.lag * 2.0 * physics::constants::pi, p.aperture);
+        }
+        case ElementClass::Monitor:
+            return std::make_shared<BeamPositionMonitor>(name, options.monitorCapacity, p.aperture);
+        case ElementClass::Marker:
+            return std::make_shared<BeamPipe>(name, 0.0, p.aperture);
+        case ElementClass::Other:
+            report.unsupportedClasses.insert(std::string(keyword));
+            [[fallthrough]];
+        case ElementClass::Drift:
+            break;
+    }
+    return std::make_shared<BeamPipe>(name, length, p.aperture);
+}
+
+// Lattice assembly
+
+/**
+ * @brief Builds a lattice from elements placed in order of their start.
+ *
+ * Gaps are filled with drifts shared between gaps of equal length.
+ */
+class LatticeBuilder {
+public:
+    LatticeBuilder() : m_lattice(std::make_shared<accelerator::Accelerator>()) {}
+
+    /**
+     * @brief Append a component entering at start, occupying length in the file.
+     */
+    void place(std::shared_ptr<Component> component, double start, double length) {
+        const double gap = start - m_position;
+        if (gap > POSITION_TOLERANCE) {
+            addDrift(gap);
+        } else if (gap < -POSITION_TOLERANCE) {
+            ++m_overlaps;
+            m_largestOverlap = std::max(m_largestOverlap, -gap);
+        }
+        const double entrance = std::max(start, m_position);
+        const double componentLength = component->getLength();
+        m_lattice->addComponent(std::move(component));
+        m_position = entrance + componentLength;
+
+        // Monitors are shorter than their slot
+        if (length - componentLength > POSITION_TOLERANCE) {
+            addDrift(length - componentLength);
+        }
+    }
+
+    /**
+     * @brief Fill the tail with a drift and survey the lattice for the beam rigidity.
+     */
+    std::shared_ptr<accelerator::Accelerator> finish(double totalLength, double rigidity,
+                                                     std::string_view format) {
+        if (totalLength - m_position > POSITION_TOLERANCE) {
+            addDrift(totalLength - m_position);
+        }
+        if (m_overlaps > 0) {
+            PAS_WARN("{}: {} overlapping elements moved downstream (largest overlap {} m)",
+                     format, m_overlaps, m_largestOverlap);
+        }
+        m_lattice->setReferenceRigidity(rigidity);
+        m_lattice->computeLattice();
+        return m_lattice;
+    }
+
+private:
+    void addDrift(double length) {
+        // Share drifts between gaps equal to the nearest nanometre
+        const auto key = static_cast<int64_t>(std::llround(length / POSITION_TOLERANCE));
+        auto& drift = m_drifts[key];
+        if (!drift) {
+            drift = std::make_shared<accelerator::BeamPipe>("DRIFT_" + std::to_string(m_drifts.size() - 1),
+                                                            length);
+        }
+        m_lattice->addComponent(drift);
+        m_position += length;
+    }
+
+    std::shared_ptr<accelerator::Accelerator> m_lattice;
+    std::unordered_map<int64_t, std::shared_ptr<accelerator::BeamPipe>> m_drifts;
+    double m_position = 0.0;
+    size_t m_overlaps = 0;
+    double m_largestOverlap = 0.0;
+};
+
+// MAD-X
+
+struct Attribute {
+    std::string_view name;
+    std::string_view text;  // Expression, string value or {a, b} list contents
+};
+
+struct Definition {
+    std::string_view name;
+    std::string_view keyword;  // Root class
+    ElementClass kind = ElementClass::Other;
+    const Definition* parent = nullptr;
+    std::vector<Attribute> attributes;
+    std::shared_ptr<Component> component;  // Built on first placement, shared after
+
+    const Attribute* find(std::string_view attribute) const {
+        // Later settings override earlier ones and the parent's
+        for (auto it = attributes.rbegin(); it != attributes.rend(); ++it) {
+            if (iequals(it->name, attribute)) {
+                return &*it;
+            }
+        }
+        return parent ? parent->find(attribute) : nullptr;
+    }
+};
+
+struct Variable {
+    std::string_view text;
+    double value = 0.0;
+    bool deferred = false;
+    bool evaluating = false;
+};
+
+struct Entry {
+    Definition* element = nullptr;
+    std::string_view at;
+    std::string_view from;
+};
+
+struct Sequence {
+    std::string_view name;
+    std::vector<Attribute> attributes;
+    std::vector<Entry> entries;
+};
+
+class MadxReader;
+
+/**
+ * @brief Recursive-descent evaluator for MAD-X expressions.
+ */
+class ExpressionParser {
+public:
+    ExpressionParser(MadxReader& reader, std::string_view text, int depth)
+        : m_reader(reader), m_lexer(text), m_text(text), m_depth(depth) {
+        advance();
+    }
+
+    double parse();
+
+private:
+    void advance() { m_token = m_lexer.next(); }
+    double sum();
+    double product();
+    double unary();
+    double power();
+    double primary();
+    double call(std::string_view function);
+
+    MadxReader& m_reader;
+    Lexer m_lexer;
+    std::string_view m_text;
+    int m_depth;
+    Token m_token;
+    bool m_failed = false;
+};
+
+/**
+ * @brief Single-pass reader of MAD-X statements.
+ */
+class MadxReader {
+public:
+    explicit MadxReader(std::string_view source) : m_lexer(source) {}
+
+    void read() {
+        while (statement()) {
+        }
+    }
+
+    std::shared_ptr<accelerator::Accelerator> build(const LatticeImportOptions& options);
+
+    double evaluate(std::string_view expression, int depth = 0) {
+        if (trim(expression).empty()) {
+            return 0.0;
+        }
+        return ExpressionParser(*this, expression, depth).parse();
+    }
+
+    double variable(std::string_view name, int depth) {
+        auto it = m_variables.find(name);
+        if (it == m_variables.end()) {
+            warnOnce(m_undefined, name, "Undefined variable taken as 0");
+            return 0.0;
+        }
+        Variable& var = it->second;
+        if (!var.deferred) {
+            return var.value;
+        }
+        if (var.evaluating || depth > MAX_EVALUATION_DEPTH) {
+            warnOnce(m_circular, name, "Circular definition taken as 0");
+            return 0.0;
+        }
+        var.evaluating = true;
+        const double value = evaluate(var.text, depth + 1);
+        var.evaluating = false;
+        return value;
+    }
+
+    double attribute(std::string_view element, std::string_view name, int depth) {
+        auto it = m_definitions.find(element);
+        if (it == m_definitions.end()) {
+            warnOnce(m_undefined, element, "Undefined element taken as 0");
+            return 0.0;
+        }
+        return attribute(*it->second, name, 0.0, depth);
+    }
+
+    double attribute(const Definition& definition, std::string_view name, double fallback,
+                     int depth = 0) {
+        const Attribute* attr = definition.find(name);
+        if (!attr) {
+            return fallback;
+        }
+        if (depth > MAX_EVALUATION_DEPTH) {
+            warnOnce(m_circular, definition.name, "Circular definition taken as 0");
+            return 0.0;
+        }
+        return evaluate(attr->text, depth + 1);
+    }
+
+private:
+    static const Attribute* find(const std::vector<Attribute>& attributes, std::string_view name) {
+        for (auto it = attributes.rbegin(); it != attributes.rend(); ++it) {
+            if (iequals(it->name, name)) {
+                return &*it;
+            }
+        }
+        return nullptr;
+    }
+
+    void warnOnce(std::set<std::string>& seen, std::string_view name, std::string_view message) {
+        std::string key(name);
+        std::transform(key.begin(), key.end(), key.begin(), toLower);
+        if (seen.insert(key).second) {
+            PAS_WARN("MADX: {}: {}", message, key);
+        }
+    }
+
+    void skipStatement() {
+        for (Token token = m_lexer.next(); token.type != TokenType::End && !token.is(";");
+             token = m_lexer.next()) {
+        }
+    }
+
+    /**
+     * @brief Tokens up to the next top-level comma or semicolon, as one view.
+     */
+    std::string_view expression() {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        int nesting = 0;
+        while (true) {
+            Token token = m_lexer.peek();
+            if (token.type == TokenType::End ||
+                (nesting == 0 && (token.is(",") || token.is(";") || token.is("}")))) {
+                break;
+            }
+            m_lexer.next();
+            if (token.is("(") || token.is("{")) {
+                ++nesting;
+            } else if (token.is(")") || token.is("}")) {
+                --nesting;
+            }
+            // Strings keep their quotes in the view; unquote() strips them
+            const char* tokenBegin = token.text.data();
+            const char* tokenEnd = token.text.data() + token.text.size();
+            if (token.type == TokenType::String) {
+                --tokenBegin;
+                ++tokenEnd;
+            }
+            begin = begin ? begin : tokenBegin;
+            end = tokenEnd;
+        }
+        return begin ? std::string_view(begin, static_cast<size_t>(end - begin)) : std::string_view();
+    }
+
+    /**
+     * @brief Read ", name = value, ..." up to the semicolon.
+     *
+     * at and from go to the entry when one is given.
+     */
+    void readAttributes(std::vector<Attribute>& attributes, Entry* entry = nullptr) {
+        while (true) {
+            Token token = m_lexer.next();
+            if (token.type == TokenType::End || token.is(";")) {
+                return;
+            }
+            if (token.type != TokenType::Name) {
+                continue;
+            }
+            Attribute attr{token.text, "1"};  // Bare flags are true
+            Token op = m_lexer.peek();
+            if (op.is("=") || op.is(":=")) {
+                m_lexer.next();
+                if (m_lexer.peek().is("{")) {
+                    m_lexer.next();
+                    attr.text = expressionList();
+                } else {
+                    attr.text = expression();
+                }
+            }
+            if (entry && iequals(attr.name, "at")) {
+                entry->at = attr.text;
+            } else if (entry && iequals(attr.name, "from")) {
+                entry->from = attr.text;
+            } else {
+                attributes.push_back(attr);
+            }
+        }
+    }
+
+    /**
+     * @brief Contents of a {a, b, ...} list, after the opening brace.
+     */
+    std::string_view expressionList() {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        while (true) {
+            Token token = m_lexer.next();
+            if (token.type == TokenType::End || token.is("}")) {
+                break;
+            }
+            begin = begin ? begin : token.text.data();
+            end = token.text.data() + token.text.size();
+        }
+        return begin ? std::string_view(begin, static_cast<size_t>(end - begin)) : std::string_view();
+    }
+
+    Definition* findDefinition(std::string_view name) {
+        auto it = m_definitions.find(name);
+        return it != m_definitions.end() ? it->second : nullptr;
+    }
+
+    bool statement() {
+        Token first = m_lexer.next();
+        if (first.type == TokenType::End) {
+            return false;
+        }
+        if (first.is(";")) {
+            return true;
+        }
+        if (first.type != TokenType::Name) {
+            skipStatement();
+            return true;
+        }
+
+        // Type prefixes of variable declarations
+        while ((iequals(first.text, "const") || iequals(first.text, "real") ||
+                iequals(first.text, "int") || iequals(first.text, "shared")) &&
+               m_lexer.peek().type == TokenType::Name) {
+            first = m_lexer.next();
+        }
+
+        Token second = m_lexer.peek();
+        if (second.is("=") || second.is(":=")) {
+            m_lexer.next();
+            assign(first.text, expression(), second.is(":="));
+            skipStatement();
+            return true;
+        }
+        if (second.is("->")) {
+            m_lexer.next();
+            Token name = m_lexer.next();
+            Token op = m_lexer.next();
+            Definition* definition = findDefinition(first.text);
+            if (name.type == TokenType::Name && (op.is("=") || op.is(":=")) && definition) {
+                definition->attributes.push_back({name.text, expression()});
+            } else if (!definition) {
+                warnOnce(m_undefined, first.text, "Attribute set on undefined element");
+            }
+            skipStatement();
+            return true;
+        }
+        if (second.is(":")) {
+            m_lexer.next();
+            Token keyword = m_lexer.next();
+            define(first.text, keyword.text);
+            return true;
+        }
+        return command(first.text);
+    }
+
+    void assign(std::string_view name, std::string_view text, bool deferred) {
+        // Evaluate first: x = x + 1 reads the old value
+        const double value = deferred ? 0.0 : evaluate(text);
+        Variable& var = m_variables[name];
+        var.deferred = deferred;
+        var.text = text;
+        var.value = value;
+    }
+
+    void define(std::string_view name, std::string_view keyword) {
+        if (iequals(keyword, "sequence")) {
+            m_sequences.push_back({name, {}, {}});
+            readAttributes(m_sequences.back().attributes);
+            m_current = &m_sequences.back();
+            return;
+        }
+        if (iequals(keyword, "line")) {
+            PAS_WARN("MADX: LINE {} is not supported; use sequences", name);
+            skipStatement();
+            return;
+        }
+
+        Definition& definition = m_storage.emplace_back();
+        definition.name = name;
+        if (const Definition* parent = findDefinition(keyword)) {
+            definition.parent = parent;
+            definition.keyword = parent->keyword;
+            definition.kind = parent->kind;
+        } else {
+            definition.keyword = keyword;
+            definition.kind = classify(keyword);
+        }
+
+        Entry entry{&definition, {}, {}};
+        readAttributes(definition.attributes, m_current ? &entry : nullptr);
+        m_definitions.insert_or_assign(name, &definition);
+        if (m_current) {
+            m_current->entries.push_back(entry);
+        }
+    }
+
+    bool command(std::string_view name) {
+        if (iequals(name, "endsequence")) {
+            m_current = nullptr;
+            skipStatement();
+        } else if (iequals(name, "beam")) {
+            readAttributes(m_beam);
+        } else if (iequals(name, "use")) {
+            std::vector<Attribute> attributes;
+            readAttributes(attributes);
+            const Attribute* used = find(attributes, "sequence");
+            used = used ? used : find(attributes, "period");
+            if (used) {
+                m_used = trim(used->text);
+            }
+        } else if (iequals(name, "return") || iequals(name, "stop") || iequals(name, "exit") ||
+                   iequals(name, "quit")) {
+            return false;
+        } else if (Definition* element = m_current ? findDefinition(name) : nullptr) {
+            // Another place of an element defined earlier
+            Entry entry{element, {}, {}};
+            std::vector<Attribute> ignored;
+            readAttributes(ignored, &entry);
+            m_current->entries.push_back(entry);
+        } else {
+            if (iequals(name, "call")) {
+                PAS_WARN("MADX: CALL is not followed; import the called files into one");
+            }
+            skipStatement();
+        }
+        return true;
+    }
+
+    Sequence* selectSequence(const std::string& requested) {
+        std::string_view name = !requested.empty() ? std::string_view(requested) : m_used;
+        if (name.empty()) {
+            return m_sequences.empty() ? nullptr : &m_sequences.back();
+        }
+        for (Sequence& sequence : m_sequences) {
+            if (iequals(sequence.name, name)) {
+                return &sequence;
+            }
+        }
+        return nullptr;
+    }
+
+    Beam makeBeam(const LatticeImportOptions& options);
+    ElementParameters parameters(const Definition& definition);
+
+    Lexer m_lexer;
+    std::deque<Definition> m_storage;
+    NameMap<Definition*> m_definitions;
+    NameMap<Variable> m_variables;
+    std::deque<Sequence> m_sequences;
+    Sequence* m_current = nullptr;
+    std::vector<Attribute> m_beam;
+    std::string_view m_used;
+    std::set<std::string> m_undefined;
+    std::set<std::string> m_circular;
+
+    friend class ExpressionParser;
+};
+
+double ExpressionParser::parse() {
+    const double value = sum();
+    if (m_token.type != TokenType::End || m_failed) {
+        PAS_WARN("MADX: Could not evaluate '{}'", m_text);
+    }
+    return value;
+}
+
+double ExpressionParser::sum() {
+    double value = product();
+    while (m_token.is("+") || m_token.is("-")) {
+        const bool add = m_token.is("+");
+        advance();
+        const double rhs = product();
+        value = add ? value + rhs : value - rhs;
+    }
+    return value;
+}
+
+double ExpressionParser::product() {
+    double value = unary();
+    while (m_token.is("*") || m_token.is("/")) {
+        const bool multiply = m_token.is("*");
+        advance();
+        const double rhs = unary();
+        value = multiply ? value * rhs : value / rhs;
+    }
+    return value;
+}
+
+double ExpressionParser::unary() {
+    if (m_token.is("-")) {
+        advance();
+        return -unary();
+    }
+    if (m_token.is("+")) {
+        advance();
+        return unary();
+    }
+    return power();
+}
+
+double ExpressionParser::power() {
+    const double base = primary();
+    if (m_token.is("^")) {
+        advance();
+        return std::pow(base, unary());  // Right-associative
+    }
+    return base;
+}
+
+double ExpressionParser::primary() {
+    const Token token = m_token;
+    if (token.type == TokenType::Number) {
+        advance();
+        double value = 0.0;
+        bool parsed = false;
+        if (token.text.find_first_of("dD") != std::string_view::npos) {
+            // Fortran exponent, as in 1.5d-3
+            std::string text(token.text);
+            std::replace_if(text.begin(), text.end(), [](char c) { return c == 'd' || c == 'D'; }, 'e');
+            parsed = parseNumber(text, value);
+        } else {
+            parsed = parseNumber(token.text, value);
+        }
+        if (!parsed) {
+            m_failed = true;
+        }
+        return value;
+    }
+    if (token.is("(")) {
+        advance();
+        const double value = sum();
+        if (m_token.is(")")) {
+            advance();
+        } else {
+            m_failed = true;
+        }
+        return value;
+    }
+    if (token.type != TokenType::Name) {
+        m_failed = true;
+        advance();
+        return 0.0;
+    }
+
+    advance();
+    if (m_token.is("(")) {
+        return call(token.text);
+    }
+    if (m_token.is("->")) {
+        advance();
+        const Token attribute = m_token;
+        advance();
+        return m_reader.attribute(token.text, attribute.text, m_depth + 1);
+    }
+
+    static const NameMap<double> constants = {
+        {"pi", physics::constants::pi},
+        {"twopi", 2.0 * physics::constants::pi},
+        {"degrad", 180.0 / physics::constants::pi},
+        {"raddeg", physics::constants::pi / 180.0},
+        {"e", std::exp(1.0)},
+        {"clight", physics::constants::c},
+        {"qelect", physics::constants::e},
+        {"pmass", physics::constants::m_p * physics::constants::c2 / physics::constants::energy::GeV},
+        {"emass", physics::constants::m_e * physics::constants::c2 / physics::constants::energy::GeV},
+        {"true", 1.0},
+        {"false", 0.0},
+    };
+    if (auto it = constants.find(token.text); it != constants.end() &&
+                                              m_reader.m_variables.find(token.text) ==
+                                                  m_reader.m_variables.end()) {
+        return it->second;
+    }
+    return m_reader.variable(token.text, m_depth + 1);
+}
+
+double ExpressionParser::call(std::string_view function) {
+    advance();  // (
+    const double argument = sum();
+    if (m_token.is(")")) {
+        advance();
+    } else {
+        m_failed = true;
+    }
+
+    static const NameMap<double (*)(double)> functions = {
+        {"sqrt", [](double x) { return std::sqrt(x); }},
+        {"exp", [](double x) { return std::exp(x); }},
+        {"log", [](double x) { return std::log(x); }},
+        {"log10", [](double x) { return std::log10(x); }},
+        {"sin", [](double x) { return std::sin(x); }},
+        {"cos", [](double x) { return std::cos(x); }},
+        {"tan", [](double x) { return std::tan(x); }},
+        {"asin", [](double x) { return std::asin(x); }},
+        {"acos", [](double x) { return std::acos(x); }},
+        {"atan", [](double x) { return std::atan(x); }},
+        {"sinh", [](double x) { return std::sinh(x); }},
+        {"cosh", [](double x) { return std::cosh(x); }},
+        {"tanh", [](double x) { return std::tanh(x); }},
+        {"abs", [](double x) { return std::abs(x); }},
+        {"floor", [](double x) { return std::floor(x); }},
+        {"ceil", [](double x) { return std::ceil(x); }},
+        {"round", [](double x) { return std::round(x); }},
+    };
+    auto it = functions.find(function);
+    if (it == functions.end()) {
+        m_reader.warnOnce(m_reader.m_undefined, function, "Unknown function taken as 0");
+        return 0.0;
+    }
+    return it->second(argument);
+}
+
+Beam MadxReader::makeBeam(const LatticeImportOptions& options) {
+    using namespace physics::constants;
+    Definition beam;
+    beam.attributes = m_beam;
+
+    Beam result;
+    double chargeNumber = 1.0;
+    if (const Attribute* particle = beam.find("particle")) {
+        const std::string_view type = unquote(particle->text);
+        if (iequals(type, "electron")) {
+            result.mass = m_e;
+            chargeNumber = -1.0;
+        } else if (iequals(type, "positron")) {
+            result.mass = m_e;
+        } else if (!iequals(type, "proton")) {
+            result.mass = attribute(beam, "mass", m_p * c2 / energy::GeV) * energy::GeV / c2;
+        }
+    }
+    chargeNumber = attribute(beam, "charge", chargeNumber);
+    result.charge = chargeNumber * e;
+
+    const double restEnergy = result.mass * c2 / energy::GeV;  // GeV
+    double pc = attribute(beam, "pc", 0.0);                    // GeV
+    if (pc <= 0.0) {
+        const double energyGeV = attribute(beam, "energy", 0.0);
+        const double gamma = attribute(beam, "gamma", 0.0);
+        if (energyGeV > restEnergy) {
+            pc = std::sqrt(energyGeV * energyGeV - restEnergy * restEnergy);
+        } else if (gamma > 1.0) {
+            pc = restEnergy * std::sqrt(gamma * gamma - 1.0);
+        }
+    }
+    result.momentum = pc * energy::GeV / c;
+
+    if (options.referenceMomentum > 0.0) {
+        result.momentum = options.referenceMomentum;
+    } else if (result.momentum <= 0.0) {
+        PAS_WARN("MADX: No beam momentum given; using pc = 1 GeV/c");
+        result.momentum = energy::GeV / c;
+    }
+    return result;
+}
+
+ElementParameters MadxReader::parameters(const Definition& definition) {
+    ElementParameters p;
+    p.length = attribute(definition, "l", 0.0);
+    p.angle = attribute(definition, "angle", 0.0);
+    p.k1 = attribute(definition, "k1", 0.0);
+    p.k2 = attribute(definition, "k2", 0.0);
+    p.ks = attribute(definition, "ks", 0.0);
+    p.voltage = attribute(definition, "volt", 0.0);
+    p.frequency = attribute(definition, "freq", 0.0);
+    p.lag = attribute(definition, "lag", 0.0);
+
+    // RBEND lengths are chords
+    if (iequals(definition.keyword, "rbend") && std::abs(p.angle) > 0.0) {
+        const double half = 0.5 * p.angle;
+        p.length *= half / std::sin(half);
+    }
+
+    if (const Attribute* type = definition.find("apertype")) {
+        const Attribute* values = definition.find("aperture");
+        double a = 0.0;
+        double b = 0.0;
+        if (values) {
+            std::string_view list = values->text;
+            const size_t comma = list.find(',');
+            a = evaluate(list.substr(0, comma));
+            b = comma == std::string_view::npos ? a : evaluate(list.substr(comma + 1));
+        }
+        p.aperture = makeAperture(unquote(type->text), a, b);
+    }
+    return p;
+}
+
+std::shared_ptr<accelerator::Accelerator> MadxReader::build(const LatticeImportOptions& options) {
+    Sequence* sequence = selectSequence(options.sequence);
+    if (!sequence) {
+        PAS_ERROR("MADX: Sequence {} not found",
+                  options.sequence.empty() ? std::string(m_used) : options.sequence);
+        return nullptr;
+    }
+
+    const Beam beam = makeBeam(options);
+    const Attribute* lengthAttribute = find(sequence->attributes, "l");
+    const double sequenceLength = lengthAttribute ? evaluate(lengthAttribute->text) : 0.0;
+
+    // Position of at= within an element: centre by default
+    double refer = 0.5;
+    if (const Attribute* attr = find(sequence->attributes, "refer")) {
+        const std::string_view value = unquote(attr->text);
+        refer = iequals(value, "entry") ? 0.0 : iequals(value, "exit") ? 1.0 : 0.5;
+    }
+
+    struct Placement {
+        Definition* element;
+        double start;
+        double length;
+    };
+    std::vector<Placement> placements;
+    placements.reserve(sequence->entries.size());
+    NameMap<double> positions;  // at of each placed element, for from=
+
+    for (const Entry& entry : sequence->entries) {
+        Definition& definition = *entry.element;
+        ElementParameters p = parameters(definition);
+        double at = evaluate(entry.at);
+        if (!entry.from.empty()) {
+            const std::string_view from = unquote(entry.from);
+            if (iequals(from, "#s")) {
+            } else if (iequals(from, "#e")) {
+                at += sequenceLength;
+            } else if (auto it = positions.find(from); it != positions.end()) {
+                at += it->second;
+            } else {
+                warnOnce(m_undefined, from, "Position relative to unplaced element");
+            }
+        }
+        positions.insert_or_assign(definition.name, at);
+        placements.push_back({&definition, at - refer * p.length, p.length});
+    }
+    std::stable_sort(placements.begin(), placements.end(),
+                     [](const Placement& a, const Placement& b) { return a.start < b.start; });
+
+    ImportReport report;
+    LatticeBuilder builder;
+    for (const Placement& placement : placements) {
+        Definition& definition = *placement.element;
+        if (!definition.component) {
+            const double harmon = attribute(definition, "harmon", 0.0);
+            definition.component = makeComponent(definition.kind, definition.keyword,
+                                                  std::string(definition.name), parameters(definition),
+                                                  beam, sequenceLength, harmon, options, report);
+        }
+        // Each place of a monitor records its own crossings, as in Accelerator::addLine
+        const auto& component = definition.component;
+        builder.place(component->observesCrossings() ? component->clone() : component, placement.start,
+                      placement.length);
+    }
+    report.log("MADX");
+    return builder.finish(sequenceLength, beam.rigidity(), "MADX");
+}
+
+// TFS
+
+/**
+ * @brief Split a TFS line into whitespace-separated fields, keeping quoted strings whole.
+ */
+void splitFields(std::string_view line, std::vector<std::string_view>& fields) {
+    fields.clear();
+    size_t pos = 0;
+    while (pos < line.size()) {
+        while (pos < line.size() && std::isspace(static_cast<unsigned char>(line[pos]))) {
+            ++pos;
+        }
+        if (pos >= line.size()) {
+            break;
+        }
+        size_t end = pos;
+        if (line[pos] == '"') {
+            end = line.find('"', pos + 1);
+            end = end == std::string_view::npos ? line.size() : end + 1;
+        } else {
+            while (end < line.size() && !std::isspace(static_cast<unsigned char>(line[end]))) {
+                ++end;
+            }
+        }
+        fields.push_back(unquote(line.substr(pos, end - pos)));
+        pos = end;
+    }
+}
+
+} // namespace
+
+std::shared_ptr<accelerator::Accelerator>
+importMadx(const std::string& filepath, const LatticeImportOptions& options) {
+    utils::MappedFile file;
+    if (!file.openReadOnly(filepath)) {
+        PAS_WARN("MADX: Could not open {}", filepath);
+        return nullptr;
+    }
+    auto lattice = parseMadx(file.view(), options);
+    if (lattice) {
+        PAS_INFO("MADX: Imported {} elements from {}", lattice->getComponentCount(), filepath);
+    }
+    return lattice;
+}
+
+std::shared_ptr<accelerator::Accelerator>
+parseMadx(std::string_view source, const LatticeImportOptions& options) {
+    MadxReader reader(source);
+    reader.read();
+    return reader.build(options);
+}
+
+std::shared_ptr<accelerator::Accelerator>
+importTfs(const std::string& filepath, const LatticeImportOptions& options) {
+    utils::MappedFile file;
+    if (!file.openReadOnly(filepath)) {
+        PAS_WARN("TFS: Could not open {}", filepath);
+        return nullptr;
+    }
+    auto lattice = parseTfs(file.view(), options);
+    if (lattice) {
+        PAS_INFO("TFS: Imported {} elements from {}", lattice->getComponentCount(), filepath);
+    }
+    return lattice;
+}
+
+std::shared_ptr<accelerator::Accelerator>
+parseTfs(std::string_view source, const LatticeImportOptions& options) {
+    using namespace physics::constants;
+
+    NameMap<std::string_view> header;
+    NameMap<size_t> columns;
+    std::vector<std::string_view> fields;
+    fields.reserve(64);
+
+    struct Row {
+        std::string name;
+        std::string_view keyword;
+        ElementParameters parameters;
+        double start = 0.0;
+        double harmon = 0.0;
+    };
+    std::vector<Row> rows;
+    double end = 0.0;
+
+    auto column = [&](std::string_view name) -> const std::string_view* {
+        auto it = columns.find(name);
+        return it != columns.end() && it->second < fields.size() ? &fields[it->second] : nullptr;
+    };
+    auto number = [&](std::string_view name, double fallback) {
+        double value = fallback;
+        if (const std::string_view* field = column(name)) {
+            parseNumber(*field, value);
+        }
+        return value;
+    };
+
+    size_t pos = 0;
+    while (pos < source.size()) {
+        size_t eol = source.find('\n', pos);
+        eol = eol == std::string_view::npos ? source.size() : eol;
+        const std::string_view line = trim(source.substr(pos, eol - pos));
+        pos = eol + 1;
+        if (line.empty() || line.front() == '$') {
+            continue;
+        }
+        if (line.front() == '@') {
+            // @ NAME %format value
+            splitFields(line.substr(1), fields);
+            if (fields.size() >= 3) {
+                header.insert_or_assign(fields[0], fields[2]);
+            }
+            continue;
+        }
+        if (line.front() == '*') {
+            splitFields(line.substr(1), fields);
+            columns.clear();
+            for (size_t i = 0; i < fields.size(); ++i) {
+                columns.emplace(fields[i], i);
+            }
+            continue;
+        }
+        if (columns.count("name") == 0 || columns.count("l") == 0 || columns.count("s") == 0) {
+            PAS_ERROR("TFS: Table has no NAME, S and L columns");
+            return nullptr;
+        }
+
+        splitFields(line, fields);
+        Row row;
+        row.keyword = column("keyword") ? *column("keyword") : std::string_view();
+        row.name = std::string(*column("name"));
+        ElementParameters& p = row.parameters;
+        p.length = number("l", 0.0);
+        const double exit = number("s", 0.0);
+        row.start = exit - p.length;
+        end = std::max(end, exit);
+
+        // Integrated strengths per unit length
+        const double inverseLength = p.length > 0.0 ? 1.0 / p.length : 0.0;
+        p.angle = number("angle", 0.0);
+        p.k1 = number("k1l", 0.0) * inverseLength;
+        p.k2 = number("k2l", 0.0) * inverseLength;
+        p.ks = number("ksi", 0.0) * inverseLength;
+        p.voltage = number("volt", 0.0);
+        p.frequency = number("freq", 0.0);
+        p.lag = number("lag", 0.0);
+        row.harmon = number("harmon", 0.0);
+        if (const std::string_view* type = column("apertype")) {
+            p.aperture = makeAperture(*type, number("aper_1", 0.0), number("aper_2", 0.0));
+        }
+        rows.push_back(std::move(row));
+    }
+    if (columns.empty()) {
+        PAS_ERROR("TFS: Table has no column header");
+        return nullptr;
+    }
+
+    Beam beam;
+    double headerValue = 0.0;
+    if (auto it = header.find("mass"); it != header.end() && parseNumber(it->second, headerValue)) {
+        beam.mass = headerValue * energy::GeV / c2;
+    }
+    if (auto it = header.find("charge"); it != header.end() && parseNumber(it->second, headerValue)) {
+        beam.charge = headerValue * e;
+    }
+    if (options.referenceMomentum > 0.0) {
+        beam.momentum = options.referenceMomentum;
+    } else if (auto it = header.find("pc"); it != header.end() && parseNumber(it->second, headerValue)) {
+        beam.momentum = headerValue * energy::GeV / c;
+    } else {
+        PAS_WARN("TFS: No PC in the header; using pc = 1 GeV/c");
+        beam.momentum = energy::GeV / c;
+    }
+
+    double length = end;
+    if (auto it = header.find("length"); it != header.end()) {
+        parseNumber(it->second, length);
+    }
+
+    ImportReport report;
+    LatticeBuilder builder;
+    for (const Row& row : rows) {
+        ElementClass kind = row.keyword.empty()
+            ? (row.parameters.angle != 0.0 ? ElementClass::Bend : ElementClass::Drift)
+            : classify(row.keyword);
+        if (kind == ElementClass::Drift) {
+            continue;  // Gaps become shared drifts
+        }
+        auto component = makeComponent(kind, row.keyword, row.name, row.parameters, beam, length,
+                                       row.harmon, options, report);
+        builder.place(std::move(component), row.start, row.parameters.length);
+    }
+    report.log("TFS");
+    return builder.finish(length, beam.rigidity(), "TFS");
+}
+
+} // namespace pas::config
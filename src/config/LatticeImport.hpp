@@ -0,0 +1,75 @@
+#pragma once
+
+#include "accelerator/Accelerator.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace pas::config {
+
+/**
+ * @brief Options for importing MAD-X and TFS lattices.
+ */
+struct LatticeImportOptions {
+    double referenceMomentum = 0.0;  // p0 [kg*m/s]; 0 to take it from the file's beam
+    std::string sequence;            // MAD-X sequence; empty for the used or last one
+    size_t monitorCapacity = 1024;   // Turns kept per imported monitor
+};
+
+/**
+ * @brief Import a MAD-X sequence file.
+ *
+ * The file is memory-mapped and read in a single pass; names, attribute
+ * expressions and sequence entries are kept as views into the mapping
+ * until the lattice is built. Supported element classes are drift,
+ * sbend, rbend, quadrupole, sextupole, solenoid, rfcavity, marker and
+ * monitor (including hmonitor and vmonitor); other classes become drifts
+ * of their length.
+ *
+ * Variables, element inheritance, deferred expressions (:=) and
+ * name->attribute references are supported. Element attributes and
+ * deferred variables are evaluated after the whole file is read, so
+ * strengths may be set after the sequence as in the usual sequence/optics
+ * file split. Thin magnets (l = 0) are imported as markers. Normalised
+ * strengths are converted with the rigidity of the BEAM command, or of the
+ * reference momentum in the options. Gaps between elements become drifts,
+ * shared between gaps of equal length, and an element placed several times
+ * by name is shared between its places.
+ *
+ * The lattice is returned linear with s-positions computed; call
+ * closeRing() for a ring.
+ * @return nullptr if the file cannot be read or has no sequence.
+ */
+std::shared_ptr<accelerator::Accelerator>
+importMadx(const std::string& filepath, const LatticeImportOptions& options = {});
+
+/**
+ * @brief Import MAD-X sequence text.
+ * @see importMadx()
+ */
+std::shared_ptr<accelerator::Accelerator>
+parseMadx(std::string_view source, const LatticeImportOptions& options = {});
+
+/**
+ * @brief Import a MAD-X TFS table (TWISS or SURVEY output).
+ *
+ * Each row becomes an element placed by its S (element exit) and L
+ * columns; strengths come from the ANGLE, K1L, K2L, KSI, VOLT, FREQ and
+ * LAG columns where present, and apertures from APERTYPE, APER_1 and
+ * APER_2. Survey tables carry no strengths, so their magnets other than
+ * bends are imported with zero strength. The reference momentum is taken
+ * from the PC and CHARGE header parameters unless set in the options.
+ * @return nullptr if the file cannot be read or has no NAME and L columns.
+ */
+std::shared_ptr<accelerator::Accelerator>
+importTfs(const std::string& filepath, const LatticeImportOptions& options = {});
+
+/**
+ * @brief Import TFS table text.
+ * @see importTfs()
+ */
+std::shared_ptr<accelerator::Accelerator>
+parseTfs(std::string_view source, const LatticeImportOptions& options = {});
+
+} // namespace pas::config
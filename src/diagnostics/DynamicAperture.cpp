@@ -0,0 +1,225 @@
+#include "diagnostics/DynamicAperture.hpp"
+#include "physics/Constants.hpp"
+#include "utils/Logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+namespace pas::diagnostics {
+
+namespace {
+
+// Turns between checks for particles made irrelevant by an inner loss
+constexpr size_t DROP_CHECK_INTERVAL = 64;
+
+struct ScanParticle {
+    accelerator::PhaseSpace state;
+    size_t ray;     // Global ray index (delta-major)
+    size_t step;    // Grid step along the ray, 1-based
+};
+
+void atomicMin(std::atomic<size_t>& target, size_t value) {
+    size_t current = target.load(std::memory_order_relaxed);
+    while (value < current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+// DynamicApertureContour implementation
+
+double DynamicApertureContour::getArea() const {
+    double area = 0.0;
+    for (size_t i = 1; i < points.size(); ++i) {
+        const auto& a = points[i - 1];
+        const auto& b = points[i];
+        area += 0.5 * a.amplitude * b.amplitude * std::sin(b.angle - a.angle);
+    }
+    return area;
+}
+
+double DynamicApertureContour::getMinimumAmplitude() const {
+    double minimum = std::numeric_limits<double>::infinity();
+    for (const auto& point : points) {
+        minimum = std::min(minimum, point.amplitude);
+    }
+    return points.empty() ? 0.0 : minimum;
+}
+
+// DynamicApertureResult implementation
+
+bool DynamicApertureResult::exportCSV(const std::string& filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        PAS_ERROR("DynamicAperture: Could not create file: {}", filepath);
+        return false;
+    }
+
+    file << "# Dynamic aperture (" << particlesLaunched << " particles, "
+         << particlesDropped << " dropped, " << turnsTracked << " particle-turns)\n";
+    file << "delta,angle,amplitude,x,y,bounded\n";
+    for (const auto& contour : contours) {
+        for (const auto& point : contour.points) {
+            file << contour.delta << ',' << point.angle << ',' << point.amplitude << ','
+                 << point.x << ',' << point.y << ',' << (point.bounded ? 1 : 0) << '\n';
+        }
+    }
+
+    PAS_INFO("DynamicAperture: Exported {} contours to {}", contours.size(), filepath);
+    return true;
+}
+
+// DynamicApertureScan implementation
+
+DynamicApertureScan::DynamicApertureScan(accelerator::LatticeTracker tracker)
+    : m_tracker(std::move(tracker)) {}
+
+bool DynamicApertureScan::isStable(double x, double y, double delta, size_t turns) const {
+    accelerator::PhaseSpace state;
+    state.x = x;
+    state.y = y;
+    state.delta = delta;
+    return m_tracker.track(state, turns) == turns;
+}
+
+DynamicApertureResult DynamicApertureScan::run(const DynamicApertureConfig& config) const {
+    DynamicApertureResult result;
+    const size_t rayCount = std::max<size_t>(config.rays, 1);
+    const size_t gridSteps = std::max<size_t>(config.gridSteps, 1);
+    const size_t blockSize = std::max<size_t>(config.blockSize, 1);
+    const size_t totalRays = config.deltas.size() * rayCount;
+    const double stepSize = config.maxAmplitude / static_cast<double>(gridSteps);
+
+    std::vector<double> angles(rayCount, 0.0);
+    for (size_t r = 1; r < rayCount; ++r) {
+        angles[r] = 0.5 * physics::constants::pi * static_cast<double>(r) / static_cast<double>(rayCount - 1);
+    }
+
+    // Step index of the first loss on each ray; gridSteps + 1 means none yet
+    std::vector<std::atomic<size_t>> firstLost(totalRays);
+    for (auto& lost : firstLost) {
+        lost.store(gridSteps + 1, std::memory_order_relaxed);
+    }
+
+    // Coarse grid, ordered by amplitude so inner losses are found first
+    std::vector<ScanParticle> grid;
+    grid.reserve(totalRays * gridSteps);
+    for (size_t step = 1; step <= gridSteps; ++step) {
+        double amplitude = stepSize * static_cast<double>(step);
+        for (size_t ray = 0; ray < totalRays; ++ray) {
+            ScanParticle particle;
+            particle.ray = ray;
+            particle.step = step;
+            particle.state.x = amplitude * std::cos(angles[ray % rayCount]);
+            particle.state.y = amplitude * std::sin(angles[ray % rayCount]);
+            particle.state.delta = config.deltas[ray / rayCount];
+            grid.push_back(particle);
+        }
+    }
+
+    std::atomic<size_t> dropped{0};
+    std::atomic<uint64_t> turnsTracked{0};
+    const auto blockCount = static_cast<ptrdiff_t>((grid.size() + blockSize - 1) / blockSize);
+
+#ifdef PAS_ENABLE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (ptrdiff_t b = 0; b < blockCount; ++b) {
+        const size_t begin = static_cast<size_t>(b) * blockSize;
+        const size_t end = std::min(begin + blockSize, grid.size());
+        std::vector<ScanParticle> active(grid.begin() + static_cast<ptrdiff_t>(begin),
+                                         grid.begin() + static_cast<ptrdiff_t>(end));
+        size_t blockDropped = 0;
+        uint64_t blockTurns = 0;
+
+        for (size_t turn = 0; turn < config.turns && !active.empty(); turn += DROP_CHECK_INTERVAL) {
+            auto irrelevant = std::remove_if(active.begin(), active.end(), [&](const ScanParticle& p) {
+                return p.step > firstLost[p.ray].load(std::memory_order_relaxed);
+            });
+            blockDropped += static_cast<size_t>(active.end() - irrelevant);
+            active.erase(irrelevant, active.end());
+
+            const size_t chunk = std::min(DROP_CHECK_INTERVAL, config.turns - turn);
+            for (size_t i = 0; i < active.size();) {
+                size_t survived = m_tracker.track(active[i].state, chunk);
+                blockTurns += survived;
+                if (survived == chunk) {
+                    ++i;
+                    continue;
+                }
+                atomicMin(firstLost[active[i].ray], active[i].step);
+                active[i] = active.back();
+                active.pop_back();
+            }
+        }
+
+        dropped.fetch_add(blockDropped, std::memory_order_relaxed);
+        turnsTracked.fetch_add(blockTurns, std::memory_order_relaxed);
+    }
+
+    // Refine each bounded ray between its last stable and first lost amplitude
+    std::vector<DynamicAperturePoint> boundary(totalRays);
+    std::vector<size_t> refinementTurns(totalRays, 0);
+    const auto rays = static_cast<ptrdiff_t>(totalRays);
+
+#ifdef PAS_ENABLE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (ptrdiff_t r = 0; r < rays; ++r) {
+        const size_t ray = static_cast<size_t>(r);
+        const double angle = angles[ray % rayCount];
+        const double delta = config.deltas[ray / rayCount];
+        const size_t lost = firstLost[ray].load(std::memory_order_relaxed);
+
+        DynamicAperturePoint& point = boundary[ray];
+        point.angle = angle;
+
+        if (lost > gridSteps) {
+            point.amplitude = config.maxAmplitude;
+        } else {
+            double stable = stepSize * static_cast<double>(lost - 1);
+            double unstable = stepSize * static_cast<double>(lost);
+            for (size_t i = 0; i < config.bisections; ++i) {
+                double mid = 0.5 * (stable + unstable);
+                accelerator::PhaseSpace state;
+                state.x = mid * std::cos(angle);
+                state.y = mid * std::sin(angle);
+                state.delta = delta;
+                size_t survived = m_tracker.track(state, config.turns);
+                refinementTurns[ray] += survived;
+                (survived == config.turns ? stable : unstable) = mid;
+            }
+            point.amplitude = stable;
+            point.bounded = true;
+        }
+        point.x = point.amplitude * std::cos(angle);
+        point.y = point.amplitude * std::sin(angle);
+    }
+
+    result.contours.resize(config.deltas.size());
+    for (size_t d = 0; d < config.deltas.size(); ++d) {
+        result.contours[d].delta = config.deltas[d];
+        result.contours[d].points.assign(boundary.begin() + static_cast<ptrdiff_t>(d * rayCount),
+                                         boundary.begin() + static_cast<ptrdiff_t>((d + 1) * rayCount));
+    }
+
+    result.particlesLaunched = grid.size();
+    result.particlesDropped = dropped.load();
+    result.turnsTracked = turnsTracked.load();
+    for (size_t ray = 0; ray < totalRays; ++ray) {
+        if (firstLost[ray].load() <= gridSteps) {
+            result.particlesLaunched += config.bisections;
+        }
+        result.turnsTracked += refinementTurns[ray];
+    }
+
+    PAS_INFO("DynamicAperture: {} particles, {} dropped early, {} particle-turns",
+             result.particlesLaunched, result.particlesDropped, result.turnsTracked);
+    return result;
+}
+
+} // namespace pas::diagnostics
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "accelerator/LatticeTracker.hpp"
+
+#include <string>
+#include <vector>
+
+namespace pas::diagnostics {
+
+/**
+ * @brief Settings for a dynamic aperture scan.
+ *
+ * Initial conditions are launched along rays x = A cos(theta), y = A sin(theta)
+ * in the first quadrant, at zero angle, for each momentum offset.
+ */
+struct DynamicApertureConfig {
+    size_t turns = 1000;                // Turns a particle must survive
+    size_t rays = 11;                   // Rays from theta = 0 to pi/2
+    size_t gridSteps = 20;              // Coarse amplitude steps per ray
+    double maxAmplitude = 0.05;         // Largest launched amplitude [m]
+    size_t bisections = 8;              // Refinement steps near the boundary
+    std::vector<double> deltas = {0.0}; // Momentum offsets dp/p
+    size_t blockSize = 32;              // Particles tracked together per task
+};
+
+/**
+ * @brief Stability boundary along one ray.
+ */
+struct DynamicAperturePoint {
+    double angle = 0.0;         // Ray angle [rad]
+    double amplitude = 0.0;     // Largest stable amplitude [m]
+    double x = 0.0;             // Boundary point [m]
+    double y = 0.0;
+    bool bounded = false;       // False if nothing was lost up to maxAmplitude
+};
+
+/**
+ * @brief DA contour for one momentum offset.
+ */
+struct DynamicApertureContour {
+    double delta = 0.0;
+    std::vector<DynamicAperturePoint> points;   // Ordered by angle
+
+    /**
+     * @brief Area enclosed by the contour and the axes [m^2].
+     */
+    double getArea() const;
+
+    /**
+     * @brief Smallest boundary amplitude over all rays [m].
+     */
+    double getMinimumAmplitude() const;
+};
+
+/**
+ * @brief Result of a dynamic aperture scan.
+ */
+struct DynamicApertureResult {
+    std::vector<DynamicApertureContour> contours;   // One per momentum offset
+    size_t particlesLaunched = 0;
+    size_t particlesDropped = 0;    // Skipped because an inner particle was lost
+    uint64_t turnsTracked = 0;      // Particle-turns actually computed
+
+    /**
+     * @brief Export the contours as CSV (delta, angle, amplitude, x, y, bounded).
+     */
+    bool exportCSV(const std::string& filepath) const;
+};
+
+/**
+ * @brief Dynamic aperture scan with early termination and ray bisection.
+ *
+ * A coarse amplitude grid is tracked first. Particles are processed in blocks
+ * ordered from small to large amplitude and scheduled dynamically across
+ * threads, so cheap blocks (early losses) free threads for long-lived ones.
+ * Lost particles leave their block immediately, and particles beyond the
+ * first loss on their ray are dropped since they cannot move the boundary.
+ * Each ray's boundary is then refined by bisection between its last stable
+ * and first unstable grid amplitudes.
+ */
+class DynamicApertureScan {
+public:
+    explicit DynamicApertureScan(accelerator::LatticeTracker tracker);
+
+    /**
+     * @brief Run the scan.
+     */
+    DynamicApertureResult run(const DynamicApertureConfig& config) const;
+
+    /**
+     * @brief Check whether a single initial condition survives.
+     */
+    bool isStable(double x, double y, double delta, size_t turns) const;
+
+private:
+    accelerator::LatticeTracker m_tracker;
+};
+
+} // namespace pas::diagnostics
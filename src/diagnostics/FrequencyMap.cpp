@@ -0,0 +1,134 @@
+#include "diagnostics/FrequencyMap.hpp"
+#include "utils/Logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace pas::diagnostics {
+
+namespace {
+
+/**
+ * @brief Per-plane coordinate series of one particle, reused across particles.
+ */
+struct TurnBuffer {
+    std::vector<double> x, px, y, py;
+
+    void resize(size_t turns) {
+        x.resize(turns);
+        px.resize(turns);
+        y.resize(turns);
+        py.resize(turns);
+    }
+};
+
+/**
+ * @brief Wrapped tune difference in [-0.5, 0.5].
+ */
+double tuneDifference(double a, double b) {
+    double d = a - b;
+    return d - std::round(d);
+}
+
+} // namespace
+
+bool FrequencyMapResult::exportCSV(const std::string& filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        PAS_ERROR("FrequencyMap: Could not create file: {}", filepath);
+        return false;
+    }
+
+    file << "# Frequency map (" << gridX << " x " << gridY << ", " << lostCount << " lost)\n";
+    file << "x,y,qx,qy,diffusion,valid\n";
+    for (const auto& point : points) {
+        file << point.x << ',' << point.y << ',' << point.tuneX << ',' << point.tuneY << ','
+             << point.diffusion << ',' << (point.valid ? 1 : 0) << '\n';
+    }
+
+    PAS_INFO("FrequencyMap: Exported {} points to {}", points.size(), filepath);
+    return true;
+}
+
+FrequencyMap::FrequencyMap(accelerator::LatticeTracker tracker)
+    : m_tracker(std::move(tracker)) {}
+
+FrequencyMapResult FrequencyMap::run(const FrequencyMapConfig& config) const {
+    FrequencyMapResult result;
+    result.gridX = std::max<size_t>(config.gridX, 1);
+    result.gridY = std::max<size_t>(config.gridY, 1);
+    result.points.resize(result.gridX * result.gridY);
+
+    const size_t half = config.turns / 2;
+    const auto count = static_cast<ptrdiff_t>(result.points.size());
+    const double gridX = static_cast<double>(result.gridX);
+    const double gridY = static_cast<double>(result.gridY);
+    size_t lost = 0;
+
+#ifdef PAS_ENABLE_OPENMP
+    #pragma omp parallel reduction(+:lost)
+#endif
+    {
+        std::vector<accelerator::PhaseSpace> history;
+        TurnBuffer buffer;
+        buffer.resize(2 * half);
+
+        // Views of the buffer, which keeps its storage for the whole loop
+        const std::span<const double> x(buffer.x), px(buffer.px), y(buffer.y), py(buffer.py);
+
+#ifdef PAS_ENABLE_OPENMP
+        #pragma omp for schedule(dynamic, 16)
+#endif
+        for (ptrdiff_t i = 0; i < count; ++i) {
+            const size_t index = static_cast<size_t>(i);
+            FrequencyMapPoint& point = result.points[index];
+            const size_t column = index % result.gridX;
+            const size_t row = index / result.gridX;
+            point.x = config.maxX * static_cast<double>(column + 1) / gridX;
+            point.y = config.maxY * static_cast<double>(row + 1) / gridY;
+
+            accelerator::PhaseSpace state;
+            state.x = point.x;
+            state.y = point.y;
+            state.delta = config.delta;
+
+            history.clear();
+            if (m_tracker.track(state, 2 * half, &history) < 2 * half) {
+                ++lost;
+                continue;
+            }
+            for (size_t turn = 0; turn < 2 * half; ++turn) {
+                buffer.x[turn] = history[turn].x;
+                buffer.px[turn] = history[turn].px;
+                buffer.y[turn] = history[turn].y;
+                buffer.py[turn] = history[turn].py;
+            }
+
+            auto qx1 = TuneAnalyzer::computeTune(x.first(half), px.first(half), config.method);
+            auto qy1 = TuneAnalyzer::computeTune(y.first(half), py.first(half), config.method);
+            auto qx2 = TuneAnalyzer::computeTune(x.last(half), px.last(half), config.method);
+            auto qy2 = TuneAnalyzer::computeTune(y.last(half), py.last(half), config.method);
+            if (!qx1 || !qy1 || !qx2 || !qy2) {
+                continue;
+            }
+
+            double dx = tuneDifference(*qx2, *qx1);
+            double dy = tuneDifference(*qy2, *qy1);
+            double change = std::sqrt(dx * dx + dy * dy);
+
+            point.tuneX = *qx1;
+            point.tuneY = *qy1;
+            point.diffusion = change > 0.0 ? std::max(std::log10(change), MIN_DIFFUSION)
+                                           : MIN_DIFFUSION;
+            point.valid = true;
+        }
+    }
+
+    result.lostCount = lost;
+    PAS_INFO("FrequencyMap: {} particles x {} turns, {} lost",
+             result.points.size(), 2 * half, result.lostCount);
+    return result;
+}
+
+} // namespace pas::diagnostics
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "diagnostics/TuneAnalyzer.hpp"
+#include "accelerator/LatticeTracker.hpp"
+
+#include <string>
+#include <vector>
+
+namespace pas::diagnostics {
+
+/**
+ * @brief Settings for a frequency map analysis.
+ *
+ * Particles start on a regular (x, y) grid at zero angle.
+ */
+struct FrequencyMapConfig {
+    size_t turns = 2048;        // Split into two halves for the diffusion estimate
+    size_t gridX = 50;          // Grid points in x (from maxX / gridX to maxX)
+    size_t gridY = 50;          // Grid points in y
+    double maxX = 0.01;         // Largest initial x [m]
+    double maxY = 0.01;         // Largest initial y [m]
+    double delta = 0.0;         // Momentum offset dp/p
+    TuneMethod method = TuneMethod::NAFF;
+};
+
+/**
+ * @brief Frequency map entry for one initial condition.
+ */
+struct FrequencyMapPoint {
+    double x = 0.0;             // Initial position [m]
+    double y = 0.0;
+    double tuneX = 0.0;         // Tunes over the first half of the run
+    double tuneY = 0.0;
+    double diffusion = 0.0;     // log10 of the tune change between halves
+    bool valid = false;         // False if lost or no tune was found
+};
+
+/**
+ * @brief Result of a frequency map analysis.
+ */
+struct FrequencyMapResult {
+    std::vector<FrequencyMapPoint> points;  // Row-major, x fastest
+    size_t gridX = 0;
+    size_t gridY = 0;
+    size_t lostCount = 0;
+
+    /**
+     * @brief Export as CSV (x, y, qx, qy, diffusion, valid).
+     */
+    bool exportCSV(const std::string& filepath) const;
+};
+
+/**
+ * @brief Frequency map analysis (FMA).
+ *
+ * Tracks each initial condition with the linear-map tracker, measures the
+ * tunes over the first and second half of the run with NAFF, and reports the
+ * diffusion index d = log10(|Q2 - Q1|). Particles are independent, so
+ * tracking and frequency analysis run in one parallel loop with a reused
+ * per-thread turn buffer.
+ */
+class FrequencyMap {
+public:
+    explicit FrequencyMap(accelerator::LatticeTracker tracker);
+
+    /**
+     * @brief Run the analysis.
+     */
+    FrequencyMapResult run(const FrequencyMapConfig& config) const;
+
+    /**
+     * @brief Diffusion index reported when both halves give identical tunes.
+     */
+    static constexpr double MIN_DIFFUSION = -20.0;
+
+private:
+    accelerator::LatticeTracker m_tracker;
+};
+
+} // namespace pas::diagnostics
@@ -0,0 +1,181 @@
+#include "diagnostics/LossMap.hpp"
+#include "physics/PhysicsEngine.hpp"
+#include "utils/Csv.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace pas::diagnostics {
+
+LossMap::LossMap(size_t numBins)
+    : m_sHistogram(std::max<size_t>(numBins, 1), 0) {
+}
+
+LossMap::~LossMap() {
+    disconnect();
+}
+
+void LossMap::configure(const accelerator::Accelerator& accelerator) {
+    m_length = accelerator.getTotalLength();
+    m_binWidth = m_length / static_cast<double>(m_sHistogram.size());
+    m_circular = accelerator.isClosed();
+
+    const auto& components = accelerator.getComponents();
+    const auto& sStarts = accelerator.getCompiledLattice().getSStarts();
+    m_componentNames.clear();
+    m_componentS.clear();
+    m_componentNames.reserve(components.size());
+    m_componentS.reserve(components.size());
+    for (size_t i = 0; i < components.size(); ++i) {
+        m_componentNames.push_back(components[i]->getName());
+        m_componentS.push_back(sStarts[i]);
+    }
+
+    m_componentLosses.assign(components.size(), 0);
+    clear();
+}
+
+void LossMap::connect(physics::PhysicsEngine& engine) {
+    disconnect();
+
+    if (auto accelerator = engine.getAccelerator()) {
+        configure(*accelerator);
+    }
+
+    m_subscription = engine.subscribeLossesScoped([this](std::span<const physics::LossEvent> batch) {
+        accumulate(batch);
+    });
+}
+
+void LossMap::disconnect() {
+    m_subscription.reset();
+}
+
+size_t LossMap::findBin(const physics::LossEvent& event) const {
+    double s = event.sPosition;
+    if (m_circular && m_length > 0.0) {
+        s = std::fmod(s, m_length);
+        if (s < 0.0) s += m_length;
+    }
+
+    if (m_binWidth <= 0.0 || s < 0.0 || s >= m_length) {
+        return UNASSIGNED;
+    }
+    return std::min(static_cast<size_t>(s / m_binWidth), m_sHistogram.size() - 1);
+}
+
+void LossMap::binEvent(const physics::LossEvent& event, ThreadHistogram& histogram) const {
+    if (event.componentIndex < histogram.components.size() &&
+        histogram.components[event.componentIndex]++ == 0) {
+        histogram.touchedComponents.push_back(event.componentIndex);
+    }
+
+    size_t bin = findBin(event);
+    if (bin == UNASSIGNED) {
+        histogram.unassigned++;
+    } else if (histogram.sBins[bin]++ == 0) {
+        histogram.touchedBins.push_back(bin);
+    }
+}
+
+void LossMap::accumulate(std::span<const physics::LossEvent> batch) {
+    if (batch.empty()) {
+        return;
+    }
+    m_totalLosses += batch.size();
+
+    // Small batches go straight into the totals
+    if (batch.size() < PARALLEL_THRESHOLD) {
+        for (const auto& event : batch) {
+            if (event.componentIndex < m_componentLosses.size()) {
+                m_componentLosses[event.componentIndex]++;
+            }
+            size_t bin = findBin(event);
+            if (bin == UNASSIGNED) {
+                m_unassignedLosses++;
+            } else {
+                m_sHistogram[bin]++;
+            }
+        }
+        return;
+    }
+
+    int threadCount = utils::getMaxThreads();
+    if (m_threadHistograms.size() < static_cast<size_t>(threadCount)) {
+        m_threadHistograms.resize(static_cast<size_t>(threadCount));
+    }
+    for (int t = 0; t < threadCount; ++t) {
+        // Only resized after configure() changes the binning
+        auto& histogram = m_threadHistograms[static_cast<size_t>(t)];
+        if (histogram.sBins.size() != m_sHistogram.size()) {
+            histogram.sBins.assign(m_sHistogram.size(), 0);
+        }
+        if (histogram.components.size() != m_componentLosses.size()) {
+            histogram.components.assign(m_componentLosses.size(), 0);
+        }
+    }
+
+    const auto count = static_cast<ptrdiff_t>(batch.size());
+#ifdef PAS_ENABLE_OPENMP
+    #pragma omp parallel for schedule(static) num_threads(threadCount)
+#endif
+    for (ptrdiff_t i = 0; i < count; ++i) {
+        auto& histogram = m_threadHistograms[static_cast<size_t>(utils::getThreadIndex())];
+        binEvent(batch[static_cast<size_t>(i)], histogram);
+    }
+
+    // Merge the touched entries of each thread and reset them for the next batch
+    for (int t = 0; t < threadCount; ++t) {
+        auto& histogram = m_threadHistograms[static_cast<size_t>(t)];
+        for (size_t b : histogram.touchedBins) {
+            m_sHistogram[b] += histogram.sBins[b];
+            histogram.sBins[b] = 0;
+        }
+        for (size_t c : histogram.touchedComponents) {
+            m_componentLosses[c] += histogram.components[c];
+            histogram.components[c] = 0;
+        }
+        m_unassignedLosses += histogram.unassigned;
+        histogram.touchedBins.clear();
+        histogram.touchedComponents.clear();
+        histogram.unassigned = 0;
+    }
+}
+
+void LossMap::clear() {
+    std::fill(m_sHistogram.begin(), m_sHistogram.end(), 0);
+    std::fill(m_componentLosses.begin(), m_componentLosses.end(), 0);
+    m_totalLosses = 0;
+    m_unassignedLosses = 0;
+}
+
+bool LossMap::exportCSV(const std::string& filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        PAS_ERROR("LossMap: Could not create file: {}", filepath);
+        return false;
+    }
+
+    file << "# s-binned losses (total " << m_totalLosses
+         << ", unassigned " << m_unassignedLosses << ")\n";
+    file << "s_start,s_end,losses\n";
+    for (size_t b = 0; b < m_sHistogram.size(); ++b) {
+        double start = static_cast<double>(b) * m_binWidth;
+        file << start << ',' << start + m_binWidth << ',' << m_sHistogram[b] << '\n';
+    }
+
+    file << "\n# Losses per component\n";
+    file << "index,name,s,losses\n";
+    for (size_t c = 0; c < m_componentLosses.size(); ++c) {
+        file << c << ',' << utils::quoteCsvField(m_componentNames[c]) << ','
+             << m_componentS[c] << ',' << m_componentLosses[c] << '\n';
+    }
+
+    PAS_INFO("LossMap: Exported {} losses to {}", m_totalLosses, filepath);
+    return true;
+}
+
+} // namespace pas::diagnostics
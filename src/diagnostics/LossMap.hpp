@@ -0,0 +1,158 @@
+#pragma once
+
+#include "physics/LossEvents.hpp"
+#include "accelerator/Accelerator.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace pas::physics {
+class PhysicsEngine;
+}
+
+namespace pas::diagnostics {
+
+/**
+ * @brief Beam loss map: loss counts binned by s-position and by component.
+ *
+ * Consumes batches of loss events (see physics::LossEventBuffer). Small batches
+ * are binned straight into the totals. Large batches are binned in parallel
+ * into per-thread histograms, and only the entries they touched are merged at
+ * the end of each batch, so recording millions of losses stays cheap.
+ */
+class LossMap {
+public:
+    /**
+     * @brief Construct an empty loss map.
+     * @param numBins Number of s-bins spanning the lattice length.
+     */
+    explicit LossMap(size_t numBins = 200);
+    ~LossMap();
+
+    // Non-copyable (holds an engine subscription)
+    LossMap(const LossMap&) = delete;
+    LossMap& operator=(const LossMap&) = delete;
+
+    /**
+     * @brief Configure binning from a lattice and clear all counts.
+     *
+     * Call after Accelerator::computeLattice().
+     */
+    void configure(const accelerator::Accelerator& accelerator);
+
+    /**
+     * @brief Subscribe to an engine's loss batches.
+     *
+     * Configures from the engine's accelerator (if any). The subscription is
+     * removed by disconnect() or on destruction; either is safe after the
+     * engine has been destroyed.
+     */
+    void connect(physics::PhysicsEngine& engine);
+
+    /**
+     * @brief Remove the engine subscription, if the engine still exists.
+     */
+    void disconnect();
+
+    /**
+     * @brief Bin a batch of loss events.
+     */
+    void accumulate(std::span<const physics::LossEvent> batch);
+
+    /**
+     * @brief Reset all counts (keeps the binning).
+     */
+    void clear();
+
+    // Binning
+
+    size_t getBinCount() const { return m_sHistogram.size(); }
+    double getBinWidth() const { return m_binWidth; }
+    double getLength() const { return m_length; }
+
+    /**
+     * @brief Get the s-position at the center of a bin.
+     */
+    double getBinCenter(size_t bin) const { return (static_cast<double>(bin) + 0.5) * m_binWidth; }
+
+    // Results
+
+    /**
+     * @brief Loss counts per s-bin.
+     */
+    const std::vector<uint64_t>& getSHistogram() const { return m_sHistogram; }
+
+    /**
+     * @brief Loss counts per component, indexed like Accelerator::getComponents().
+     */
+    const std::vector<uint64_t>& getComponentLosses() const { return m_componentLosses; }
+
+    /**
+     * @brief Get the name of a component recorded at configure time.
+     */
+    const std::string& getComponentName(size_t index) const { return m_componentNames[index]; }
+
+    /**
+     * @brief Total number of losses recorded.
+     */
+    uint64_t getTotalLosses() const { return m_totalLosses; }
+
+    /**
+     * @brief Losses outside the lattice (not assigned to any s-bin or component).
+     */
+    uint64_t getUnassignedLosses() const { return m_unassignedLosses; }
+
+    /**
+     * @brief Export the loss map to CSV.
+     *
+     * Writes an s-binned section followed by a per-component section.
+     */
+    bool exportCSV(const std::string& filepath) const;
+
+private:
+    static constexpr size_t PARALLEL_THRESHOLD = 4096;
+
+    static constexpr size_t UNASSIGNED = static_cast<size_t>(-1);
+
+    /**
+     * @brief Per-thread counts for large batches.
+     *
+     * Kept zeroed between batches; the touched lists name the entries to
+     * merge and reset, so a batch costs nothing for bins it never hits.
+     */
+    struct alignas(64) ThreadHistogram {
+        std::vector<uint64_t> sBins;
+        std::vector<uint64_t> components;
+        std::vector<size_t> touchedBins;
+        std::vector<size_t> touchedComponents;
+        uint64_t unassigned = 0;
+    };
+
+    /**
+     * @brief Get the s-bin of an event, or UNASSIGNED if it lies outside the lattice.
+     */
+    size_t findBin(const physics::LossEvent& event) const;
+
+    /**
+     * @brief Bin a single event into the given thread histogram.
+     */
+    void binEvent(const physics::LossEvent& event, ThreadHistogram& histogram) const;
+
+    std::vector<uint64_t> m_sHistogram;
+    std::vector<uint64_t> m_componentLosses;
+    std::vector<std::string> m_componentNames;
+    std::vector<double> m_componentS;
+    std::vector<ThreadHistogram> m_threadHistograms;
+
+    double m_length = 0.0;
+    double m_binWidth = 0.0;
+    bool m_circular = false;
+    uint64_t m_totalLosses = 0;
+    uint64_t m_unassignedLosses = 0;
+
+    physics::LossEventBuffer::Subscription m_subscription;  // Safe to drop after the engine
+};
+
+} // namespace pas::diagnostics
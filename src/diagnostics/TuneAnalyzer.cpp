@@ -0,0 +1,412 @@
+#include "diagnostics/TuneAnalyzer.hpp"
+#include "physics/Constants.hpp"
+#include "utils/Logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <limits>
+
+namespace pas::diagnostics {
+
+namespace {
+
+using Complex = std::complex<double>;
+
+constexpr double TWO_PI = 2.0 * physics::constants::pi;
+constexpr size_t ZERO_PADDING = 4;
+constexpr int NAFF_ITERATIONS = 64;
+constexpr double FLAT_TOLERANCE = 1e-12;
+
+/**
+ * @brief In-place iterative radix-2 FFT (size must be a power of two).
+ */
+void fft(std::vector<Complex>& data) {
+    const size_t n = data.size();
+
+    // Bit-reversal permutation
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const Complex step = std::polar(1.0, -TWO_PI / static_cast<double>(len));
+        for (size_t start = 0; start < n; start += len) {
+            Complex w(1.0, 0.0);
+            for (size_t k = 0; k < len / 2; ++k) {
+                Complex even = data[start + k];
+                Complex odd = data[start + k + len / 2] * w;
+                data[start + k] = even + odd;
+                data[start + k + len / 2] = even - odd;
+                w *= step;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Periodic Hann window.
+ */
+std::vector<double> hannWindow(size_t n) {
+    std::vector<double> window(n);
+    for (size_t i = 0; i < n; ++i) {
+        window[i] = 0.5 * (1.0 - std::cos(TWO_PI * static_cast<double>(i) / static_cast<double>(n)));
+    }
+    return window;
+}
+
+/**
+ * @brief Magnitude of the windowed Fourier integral at a frequency.
+ */
+double fourierAmplitude(const std::vector<Complex>& windowed, double frequency) {
+    Complex sum(0.0, 0.0);
+    const Complex step = std::polar(1.0, -TWO_PI * frequency);
+    Complex phase(1.0, 0.0);
+    for (const Complex& value : windowed) {
+        sum += value * phase;
+        phase *= step;
+    }
+    return std::abs(sum);
+}
+
+/**
+ * @brief Estimate the dominant frequency of a complex signal, in cycles per turn.
+ * @param realSignal Search only [0, 0.5] since the spectrum is symmetric.
+ */
+std::optional<double> dominantFrequency(std::vector<Complex> signal, bool realSignal,
+                                        TuneMethod method) {
+    const size_t n = signal.size();
+    if (n < TuneAnalyzer::MIN_TURNS) {
+        return std::nullopt;
+    }
+
+    for (const Complex& value : signal) {
+        if (!std::isfinite(value.real()) || !std::isfinite(value.imag())) {
+            return std::nullopt;
+        }
+    }
+
+    Complex mean(0.0, 0.0);
+    for (const Complex& value : signal) {
+        mean += value;
+    }
+    mean /= static_cast<double>(n);
+
+    // No oscillation above rounding noise
+    double deviation = 0.0;
+    for (const Complex& value : signal) {
+        deviation = std::max(deviation, std::abs(value - mean));
+    }
+    if (!(deviation > FLAT_TOLERANCE * std::abs(mean))) {
+        return std::nullopt;
+    }
+
+    const std::vector<double> window = hannWindow(n);
+    for (size_t i = 0; i < n; ++i) {
+        signal[i] = (signal[i] - mean) * window[i];
+    }
+
+    size_t m = 1;
+    while (m < n * ZERO_PADDING) {
+        m <<= 1;
+    }
+    std::vector<Complex> spectrum(m, Complex(0.0, 0.0));
+    std::copy(signal.begin(), signal.end(), spectrum.begin());
+    fft(spectrum);
+
+    // Skip the DC bin; the mean has been removed
+    const size_t last = realSignal ? m / 2 : m - 1;
+    size_t peak = 1;
+    double peakMagnitude = 0.0;
+    for (size_t k = 1; k <= last; ++k) {
+        double magnitude = std::abs(spectrum[k]);
+        if (magnitude > peakMagnitude) {
+            peakMagnitude = magnitude;
+            peak = k;
+        }
+    }
+    if (!(peakMagnitude > std::numeric_limits<double>::min())) {
+        return std::nullopt;
+    }
+
+    // Parabolic interpolation on the log magnitude (exact for a Gaussian peak)
+    double offset = 0.0;
+    const double a = std::abs(spectrum[(peak + m - 1) % m]);
+    const double c = std::abs(spectrum[(peak + 1) % m]);
+    if (a > 0.0 && c > 0.0) {
+        double la = std::log(a);
+        double lb = std::log(peakMagnitude);
+        double lc = std::log(c);
+        double denominator = la - 2.0 * lb + lc;
+        if (denominator < 0.0) {
+            offset = 0.5 * (la - lc) / denominator;
+        }
+    }
+    double frequency = (static_cast<double>(peak) + offset) / static_cast<double>(m);
+
+    if (method == TuneMethod::NAFF) {
+        // Golden-section search within the main lobe around the FFT estimate
+        const double invPhi = (std::sqrt(5.0) - 1.0) / 2.0;
+        double lo = frequency - 2.0 / static_cast<double>(m);
+        double hi = frequency + 2.0 / static_cast<double>(m);
+        double x1 = hi - invPhi * (hi - lo);
+        double x2 = lo + invPhi * (hi - lo);
+        double f1 = fourierAmplitude(signal, x1);
+        double f2 = fourierAmplitude(signal, x2);
+        for (int i = 0; i < NAFF_ITERATIONS; ++i) {
+            if (f1 < f2) {
+                lo = x1;
+                x1 = x2;
+                f1 = f2;
+                x2 = lo + invPhi * (hi - lo);
+                f2 = fourierAmplitude(signal, x2);
+            } else {
+                hi = x2;
+                x2 = x1;
+                f2 = f1;
+                x1 = hi - invPhi * (hi - lo);
+                f1 = fourierAmplitude(signal, x1);
+            }
+        }
+        frequency = 0.5 * (lo + hi);
+    }
+
+    frequency -= std::floor(frequency);
+    if (realSignal && frequency > 0.5) {
+        frequency = 1.0 - frequency;
+    }
+    return frequency;
+}
+
+/**
+ * @brief Track a test particle and return its (x, px, y, py) series.
+ * @return False if the particle was lost.
+ */
+bool trackSeries(const accelerator::LatticeTracker& tracker, double delta, size_t turns,
+                 double amplitude, std::vector<double> (&series)[4]) {
+    accelerator::PhaseSpace state;
+    state.x = amplitude;
+    state.y = amplitude;
+    state.delta = delta;
+
+    std::vector<accelerator::PhaseSpace> history;
+    if (tracker.track(state, turns, &history) < turns) {
+        return false;
+    }
+
+    for (auto& s : series) {
+        s.resize(turns);
+    }
+    for (size_t i = 0; i < turns; ++i) {
+        series[0][i] = history[i].x;
+        series[1][i] = history[i].px;
+        series[2][i] = history[i].y;
+        series[3][i] = history[i].py;
+    }
+    return true;
+}
+
+/**
+ * @brief Least-squares slope of y(x), ignoring NaN entries.
+ */
+std::optional<double> fitSlope(const std::vector<double>& x, std::vector<double> y) {
+    // Unwrap tunes that crossed an integer relative to the first valid point
+    auto reference = std::find_if(y.begin(), y.end(), [](double v) { return std::isfinite(v); });
+    if (reference == y.end()) {
+        return std::nullopt;
+    }
+    const double ref = *reference;
+    for (double& v : y) {
+        if (std::isfinite(v)) {
+            v -= std::round(v - ref);
+        }
+    }
+
+    double n = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        if (!std::isfinite(y[i])) continue;
+        n += 1.0;
+        sx += x[i];
+        sy += y[i];
+        sxx += x[i] * x[i];
+        sxy += x[i] * y[i];
+    }
+
+    double denominator = n * sxx - sx * sx;
+    if (n < 2.0 || std::abs(denominator) < std::numeric_limits<double>::epsilon()) {
+        return std::nullopt;
+    }
+    return (n * sxy - sx * sy) / denominator;
+}
+
+} // namespace
+
+TuneAnalyzer::TuneAnalyzer(TuneMethod method)
+    : m_method(method) {}
+
+TuneAnalyzer::~TuneAnalyzer() {
+    wait();
+}
+
+std::optional<double> TuneAnalyzer::computeTune(std::span<const double> position, TuneMethod method) {
+    std::vector<Complex> signal(position.begin(), position.end());
+    return dominantFrequency(std::move(signal), true, method);
+}
+
+std::optional<double> TuneAnalyzer::computeTune(std::span<const double> position,
+                                                std::span<const double> angle,
+                                                TuneMethod method) {
+    const size_t n = std::min(position.size(), angle.size());
+
+    // Scale the angle so both components have comparable amplitude
+    double meanX = 0.0, meanP = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        meanX += position[i];
+        meanP += angle[i];
+    }
+    meanX /= static_cast<double>(std::max<size_t>(n, 1));
+    meanP /= static_cast<double>(std::max<size_t>(n, 1));
+
+    double sumXX = 0.0, sumPP = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sumXX += (position[i] - meanX) * (position[i] - meanX);
+        sumPP += (angle[i] - meanP) * (angle[i] - meanP);
+    }
+    if (!(sumPP > 0.0) || !(sumXX > 0.0)) {
+        return computeTune(position.first(n), method);
+    }
+    const double scale = std::sqrt(sumXX / sumPP);
+
+    std::vector<Complex> signal(n);
+    for (size_t i = 0; i < n; ++i) {
+        signal[i] = Complex(position[i], -scale * angle[i]);
+    }
+    return dominantFrequency(std::move(signal), false, method);
+}
+
+ChromaticityResult TuneAnalyzer::measureChromaticity(const accelerator::LatticeTracker& tracker,
+                                                     std::span<const double> deltas,
+                                                     size_t turns, double amplitude,
+                                                     TuneMethod method) {
+    ChromaticityResult result;
+    result.deltas.assign(deltas.begin(), deltas.end());
+    result.tunesX.assign(deltas.size(), std::numeric_limits<double>::quiet_NaN());
+    result.tunesY.assign(deltas.size(), std::numeric_limits<double>::quiet_NaN());
+
+    const auto count = static_cast<ptrdiff_t>(deltas.size());
+
+    // Each offset is independent; dynamic scheduling since lost particles finish early
+#ifdef PAS_ENABLE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (ptrdiff_t i = 0; i < count; ++i) {
+        const size_t index = static_cast<size_t>(i);
+        std::vector<double> series[4];
+        if (!trackSeries(tracker, deltas[index], turns, amplitude, series)) {
+            continue;
+        }
+        if (auto qx = computeTune(series[0], series[1], method)) {
+            result.tunesX[index] = *qx;
+        }
+        if (auto qy = computeTune(series[2], series[3], method)) {
+            result.tunesY[index] = *qy;
+        }
+    }
+
+    auto xiX = fitSlope(result.deltas, result.tunesX);
+    auto xiY = fitSlope(result.deltas, result.tunesY);
+    result.valid = xiX.has_value() && xiY.has_value();
+    result.chromaticityX = xiX.value_or(0.0);
+    result.chromaticityY = xiY.value_or(0.0);
+    return result;
+}
+
+bool TuneAnalyzer::analyzeMonitor(const accelerator::BeamPositionMonitor& monitor) {
+    if (isBusy()) {
+        return false;
+    }
+
+    auto x = monitor.getCentroidSeries(accelerator::TransversePlane::Horizontal);
+    auto y = monitor.getCentroidSeries(accelerator::TransversePlane::Vertical);
+    std::string source = monitor.getName();
+    TuneMethod method = m_method;
+
+    m_pending = std::async(std::launch::async,
+        [x = std::move(x), y = std::move(y), source = std::move(source), method]() {
+            TuneMeasurement measurement;
+            measurement.source = source;
+            measurement.turns = x.size();
+            measurement.tuneX = computeTune(x, method);
+            measurement.tuneY = computeTune(y, method);
+            return measurement;
+        });
+    return true;
+}
+
+bool TuneAnalyzer::analyzeTracking(const accelerator::LatticeTracker& tracker,
+                                   std::vector<double> deltas, size_t turns, double amplitude) {
+    if (isBusy()) {
+        return false;
+    }
+
+    TuneMethod method = m_method;
+    m_pending = std::async(std::launch::async,
+        [tracker, deltas = std::move(deltas), turns, amplitude, method]() {
+            TuneMeasurement measurement;
+            measurement.source = "Tracking";
+            measurement.turns = turns;
+
+            if (!deltas.empty()) {
+                measurement.chromaticity = measureChromaticity(tracker, deltas, turns, amplitude, method);
+            }
+
+            // Reuse the on-momentum offset of the scan rather than tracking it again
+            auto onMomentum = std::find(deltas.begin(), deltas.end(), 0.0);
+            if (onMomentum != deltas.end()) {
+                const auto index = static_cast<size_t>(onMomentum - deltas.begin());
+                const double qx = measurement.chromaticity->tunesX[index];
+                const double qy = measurement.chromaticity->tunesY[index];
+                if (!std::isnan(qx)) measurement.tuneX = qx;
+                if (!std::isnan(qy)) measurement.tuneY = qy;
+                return measurement;
+            }
+
+            std::vector<double> series[4];
+            if (trackSeries(tracker, 0.0, turns, amplitude, series)) {
+                measurement.tuneX = computeTune(series[0], series[1], method);
+                measurement.tuneY = computeTune(series[2], series[3], method);
+            }
+            return measurement;
+        });
+    return true;
+}
+
+bool TuneAnalyzer::poll() {
+    if (!isBusy() ||
+        m_pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return false;
+    }
+
+    m_latest = m_pending.get();
+    if (!m_latest->tuneX || !m_latest->tuneY) {
+        PAS_WARN("TuneAnalyzer: No tune found in {} ({} turns)", m_latest->source, m_latest->turns);
+    }
+    return true;
+}
+
+void TuneAnalyzer::wait() {
+    if (isBusy()) {
+        m_pending.wait();
+        poll();
+    }
+}
+
+} // namespace pas::diagnostics
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "accelerator/BeamPositionMonitor.hpp"
+#include "accelerator/LatticeTracker.hpp"
+
+#include <future>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace pas::diagnostics {
+
+/**
+ * @brief Frequency estimation method for tune measurement.
+ */
+enum class TuneMethod {
+    FFT,    // Hann-windowed FFT with interpolated peak
+    NAFF    // FFT estimate refined by maximizing the windowed Fourier integral
+};
+
+/**
+ * @brief Linear chromaticity fit from tunes at several momentum offsets.
+ */
+struct ChromaticityResult {
+    std::vector<double> deltas;     // Momentum offsets tracked
+    std::vector<double> tunesX;     // NaN where the particle was lost
+    std::vector<double> tunesY;
+    double chromaticityX = 0.0;     // dQx/d(delta)
+    double chromaticityY = 0.0;     // dQy/d(delta)
+    bool valid = false;
+};
+
+/**
+ * @brief Result of a tune measurement.
+ */
+struct TuneMeasurement {
+    std::string source;             // What was analyzed
+    size_t turns = 0;               // Turns used
+    std::optional<double> tuneX;    // Fractional tunes
+    std::optional<double> tuneY;
+    std::optional<ChromaticityResult> chromaticity;
+};
+
+/**
+ * @brief Betatron tune and chromaticity analysis from turn-by-turn data.
+ *
+ * The static functions are the numerical core. The instance methods run an
+ * analysis on a background thread so tracking and rendering are not stalled;
+ * call poll() once per frame to pick up finished results.
+ */
+class TuneAnalyzer {
+public:
+    explicit TuneAnalyzer(TuneMethod method = TuneMethod::NAFF);
+    ~TuneAnalyzer();
+
+    // Non-copyable
+    TuneAnalyzer(const TuneAnalyzer&) = delete;
+    TuneAnalyzer& operator=(const TuneAnalyzer&) = delete;
+
+    void setMethod(TuneMethod method) { m_method = method; }
+    TuneMethod getMethod() const { return m_method; }
+
+    /**
+     * @brief Analyze the centroid series of a beam position monitor.
+     *
+     * The series are copied before returning. Tunes from position-only data
+     * are folded into [0, 0.5].
+     * @return False if an analysis is already running.
+     */
+    bool analyzeMonitor(const accelerator::BeamPositionMonitor& monitor);
+
+    /**
+     * @brief Track a test particle at several momentum offsets and measure
+     *        the tunes and chromaticity.
+     *
+     * The tracker is copied into the task. Tunes are in [0, 1).
+     * @param deltas Momentum offsets; if delta = 0 is among them, its tune is
+     *               reported as the on-momentum tune instead of tracking it
+     *               a second time.
+     * @return False if an analysis is already running.
+     */
+    bool analyzeTracking(const accelerator::LatticeTracker& tracker,
+                         std::vector<double> deltas, size_t turns = 1024,
+                         double amplitude = 1e-4);
+
+    /**
+     * @brief Check whether an analysis is running.
+     */
+    bool isBusy() const { return m_pending.valid(); }
+
+    /**
+     * @brief Collect a finished analysis.
+     * @return True if a new result became available.
+     */
+    bool poll();
+
+    /**
+     * @brief Block until the running analysis (if any) finishes.
+     */
+    void wait();
+
+    /**
+     * @brief Get the most recent finished result.
+     */
+    const std::optional<TuneMeasurement>& getLatest() const { return m_latest; }
+
+    // Numerical core
+
+    /**
+     * @brief Fractional tune of a real signal, folded into [0, 0.5].
+     * @return std::nullopt if the signal is too short or has no oscillation.
+     */
+    static std::optional<double> computeTune(std::span<const double> position,
+                                             TuneMethod method = TuneMethod::NAFF);
+
+    /**
+     * @brief Fractional tune in [0, 1) from position and angle.
+     *
+     * Phase-space rotation is always clockwise, so the complex signal
+     * x - i*s*px resolves tunes above the half integer.
+     */
+    static std::optional<double> computeTune(std::span<const double> position,
+                                             std::span<const double> angle,
+                                             TuneMethod method = TuneMethod::NAFF);
+
+    /**
+     * @brief Track at each momentum offset (in parallel) and fit dQ/d(delta).
+     */
+    static ChromaticityResult measureChromaticity(const accelerator::LatticeTracker& tracker,
+                                                  std::span<const double> deltas,
+                                                  size_t turns = 1024, double amplitude = 1e-4,
+                                                  TuneMethod method = TuneMethod::NAFF);
+
+    static constexpr size_t MIN_TURNS = 16;
+
+private:
+    TuneMethod m_method;
+    std::future<TuneMeasurement> m_pending;
+    std::optional<TuneMeasurement> m_latest;
+};
+
+} // namespace pas::diagnostics
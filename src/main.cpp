@@ -3,9 +3,16 @@
 #include "physics/Constants.hpp"
 #include "physics/PhysicsEngine.hpp"
 #include "accelerator/Accelerator.hpp"
+#include "config/Config.hpp"
+#include "diagnostics/LossMap.hpp"
+#include "diagnostics/TuneAnalyzer.hpp"
+#include "diagnostics/DynamicAperture.hpp"
+#include "diagnostics/FrequencyMap.hpp"
 #include "core/Window.hpp"
 #include "rendering/Renderer.hpp"
 #include "rendering/Camera.hpp"
+#include "ui/LossMapPanel.hpp"
+#include "ui/TunePanel.hpp"
 
 #include <glad/glad.h>
 #define GLFW_INCLUDE_NONE
@@ -15,8 +22,11 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
+#include <charconv>
+#include <cstring>
 #include <memory>
 #include <iostream>
+#include <string>
 
 using namespace pas;
 
@@ -52,10 +62,202 @@ std::shared_ptr<accelerator::Accelerator> createDemoAccelerator() {
     return acc;
 }
 
-int main() {
+/**
+ * @brief Load a lattice file through its binary cache, or the demo lattice if none is given.
+ */
+std::shared_ptr<accelerator::Accelerator> loadLattice(const std::string& latticePath) {
+    if (latticePath.empty()) {
+        return createDemoAccelerator();
+    }
+    auto acc = config::Config::loadAcceleratorCached(latticePath);
+    if (!acc) {
+        PAS_ERROR("Could not load lattice {}; using the demo lattice", latticePath);
+        return createDemoAccelerator();
+    }
+    return acc;
+}
+
+/**
+ * @brief Reference momentum of the default 1 GeV proton beam.
+ */
+double defaultReferenceMomentum() {
+    using namespace physics::constants;
+    return relativistic::momentumFromGamma(
+        relativistic::gammaFromKineticEnergy(1.0 * energy::GeV, m_p), m_p);
+}
+
+/**
+ * @brief Run the simulation headless for a fixed number of steps.
+ */
+int runBatch(uint64_t steps, const std::string& lossMapPath, const std::string& latticePath) {
+    physics::PhysicsEngine physicsEngine;
+    physicsEngine.setTimeStep(1e-10);
+    physicsEngine.setAccelerator(loadLattice(latticePath));
+
+    diagnostics::LossMap lossMap;
+    lossMap.connect(physicsEngine);
+
+    physicsEngine.start();
+    physicsEngine.initializeDefaultBeam();
+
+    utils::Timer timer;
+    for (uint64_t i = 0; i < steps; ++i) {
+        physicsEngine.step();
+    }
+
+    PAS_INFO("Batch run: {} steps in {:.3f} s, {} particles lost",
+             steps, timer.elapsedSeconds(), lossMap.getTotalLosses());
+
+    if (!lossMapPath.empty() && !lossMap.exportCSV(lossMapPath)) {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Scan the dynamic aperture and export the contour.
+ */
+int runDynamicAperture(const std::string& outputPath, size_t turns, const std::string& latticePath) {
+    auto accelerator = loadLattice(latticePath);
+    diagnostics::DynamicApertureScan scan(
+        accelerator::LatticeTracker(*accelerator, defaultReferenceMomentum()));
+
+    diagnostics::DynamicApertureConfig config;
+    config.turns = turns;
+    config.deltas = {-1e-3, 0.0, 1e-3};
+
+    utils::Timer timer;
+    auto result = scan.run(config);
+    PAS_INFO("Dynamic aperture scan: {} turns in {:.3f} s", turns, timer.elapsedSeconds());
+    for (const auto& contour : result.contours) {
+        PAS_INFO("  dp/p = {:+.1e}: min amplitude {:.3f} mm, area {:.3f} mm^2",
+                 contour.delta, contour.getMinimumAmplitude() * 1e3, contour.getArea() * 1e6);
+    }
+
+    return result.exportCSV(outputPath) ? 0 : 1;
+}
+
+/**
+ * @brief Compute the frequency map and export it.
+ */
+int runFrequencyMap(const std::string& outputPath, size_t turns, const std::string& latticePath) {
+    auto accelerator = loadLattice(latticePath);
+    diagnostics::FrequencyMap fma(
+        accelerator::LatticeTracker(*accelerator, defaultReferenceMomentum()));
+
+    diagnostics::FrequencyMapConfig config;
+    config.turns = turns;
+
+    utils::Timer timer;
+    auto result = fma.run(config);
+    PAS_INFO("Frequency map: {} particles x {} turns in {:.3f} s, {} lost",
+             result.points.size(), turns, timer.elapsedSeconds(), result.lostCount);
+
+    return result.exportCSV(outputPath) ? 0 : 1;
+}
+
+/**
+ * @brief Parse a positive count from a command-line argument.
+ * @return False if the argument is not a whole number above zero.
+ */
+bool parseCount(const char* text, uint64_t& value) {
+    const char* end = text + std::strlen(text);
+    auto [ptr, ec] = std::from_chars(text, end, value);
+    return ec == std::errc() && ptr == end && ptr != text && value > 0;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--lattice <file>] [--loss-map <file>] [--turns <n>]"
+                 " [--batch <steps> | --dynamic-aperture <file> | --frequency-map <file>]\n";
+}
+
+/**
+ * @brief Report an invalid command line and print the usage.
+ * @return Exit code for main().
+ */
+int rejectCommandLine(const char* program, const std::string& message) {
+    PAS_ERROR("{}", message);
+    printUsage(program);
+    utils::Logger::shutdown();
+    return 1;
+}
+
+int main(int argc, char** argv) {
     // Initialize logging
     utils::Logger::init("PAS", utils::Logger::Level::Debug);
 
+    // Command line: --batch <steps> runs headless, --loss-map <file> exports losses,
+    // --dynamic-aperture <file> scans the DA and --frequency-map <file> runs FMA for --turns <n> turns,
+    // --lattice <file> loads a JSON or MAD-X lattice instead of the demo lattice
+    uint64_t batchSteps = 0;
+    std::string lossMapPath;
+    std::string dynamicAperturePath;
+    std::string frequencyMapPath;
+    uint64_t scanTurns = 1000;
+    std::string latticePath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--batch" && i + 1 < argc) {
+            if (!parseCount(argv[++i], batchSteps)) {
+                return rejectCommandLine(argv[0],
+                                         fmt::format("Invalid step count for --batch: '{}'", argv[i]));
+            }
+        } else if (arg == "--loss-map" && i + 1 < argc) {
+            lossMapPath = argv[++i];
+        } else if (arg == "--dynamic-aperture" && i + 1 < argc) {
+            dynamicAperturePath = argv[++i];
+        } else if (arg == "--frequency-map" && i + 1 < argc) {
+            frequencyMapPath = argv[++i];
+        } else if (arg == "--turns" && i + 1 < argc) {
+            if (!parseCount(argv[++i], scanTurns)) {
+                return rejectCommandLine(argv[0],
+                                         fmt::format("Invalid turn count for --turns: '{}'", argv[i]));
+            }
+        } else if (arg == "--lattice" && i + 1 < argc) {
+            latticePath = argv[++i];
+        } else {
+            // Unknown options and options missing their value
+            return rejectCommandLine(argv[0], fmt::format("Unrecognized argument: '{}'", arg));
+        }
+    }
+
+    // Each run mode exits when done, so a second one would never run
+    const int runModes = static_cast<int>(batchSteps > 0) +
+                         static_cast<int>(!dynamicAperturePath.empty()) +
+                         static_cast<int>(!frequencyMapPath.empty());
+    if (runModes > 1) {
+        return rejectCommandLine(argv[0],
+                                 "--batch, --dynamic-aperture and --frequency-map are mutually exclusive");
+    }
+
+    // The scans track with the lattice tracker, which records no losses
+    if (!lossMapPath.empty() && (!dynamicAperturePath.empty() || !frequencyMapPath.empty())) {
+        return rejectCommandLine(argv[0],
+                                 "--loss-map cannot be combined with --dynamic-aperture or --frequency-map");
+    }
+
+    if (!dynamicAperturePath.empty()) {
+        int result = runDynamicAperture(dynamicAperturePath, static_cast<size_t>(scanTurns), latticePath);
+        utils::Logger::shutdown();
+        return result;
+    }
+    if (!frequencyMapPath.empty()) {
+        int result = runFrequencyMap(frequencyMapPath, static_cast<size_t>(scanTurns), latticePath);
+        utils::Logger::shutdown();
+        return result;
+    }
+    if (batchSteps > 0) {
+        int result = runBatch(batchSteps, lossMapPath, latticePath);
+        utils::Logger::shutdown();
+        return result;
+    }
+
+    if (!lossMapPath.empty()) {
+        PAS_WARN("--loss-map without --batch: losses are exported to {} when the window closes",
+                 lossMapPath);
+    }
+
     PAS_INFO("==============================================");
     PAS_INFO("  Particle Accelerator Simulation v1.0.0");
     PAS_INFO("==============================================");
@@ -91,12 +293,22 @@ int main() {
     physicsEngine.setMaxStepsPerFrame(10000);  // Cap steps to keep UI responsive
 
     // Create and set accelerator
-    auto accelerator = createDemoAccelerator();
+    auto accelerator = loadLattice(latticePath);
     physicsEngine.setAccelerator(accelerator);
 
     // Initialize beam
     physicsEngine.initializeDefaultBeam();
 
+    // Loss diagnostics
+    diagnostics::LossMap lossMap;
+    lossMap.connect(physicsEngine);
+    ui::LossMapPanel lossMapPanel(lossMap);
+
+    // Tune diagnostics
+    diagnostics::TuneAnalyzer tuneAnalyzer;
+    ui::TunePanel tunePanel(tuneAnalyzer);
+    tunePanel.setAccelerator(accelerator, defaultReferenceMomentum());
+
     // Create renderer
     rendering::Renderer renderer;
     if (!renderer.initialize(window.getWidth(), window.getHeight())) {
@@ -192,6 +404,7 @@ int main() {
         if (glfwGetKey(window.getHandle(), GLFW_KEY_R) == GLFW_PRESS) {
             physicsEngine.reset();
             physicsEngine.initializeDefaultBeam();
+            lossMap.clear();
         }
 
         // Update physics
@@ -233,6 +446,7 @@ int main() {
             if (ImGui::Button("Reset")) {
                 physicsEngine.reset();
                 physicsEngine.initializeDefaultBeam();
+                lossMap.clear();
             }
 
             ImGui::Spacing();
@@ -275,6 +489,14 @@ int main() {
             ImGui::End();
         }
 
+        // Loss map panel
+        lossMapPanel.update();
+        lossMapPanel.draw();
+
+        // Tune panel
+        tunePanel.update();
+        tunePanel.draw();
+
         // Demo window
         if (showDemoWindow) {
             ImGui::ShowDemoWindow(&showDemoWindow);
@@ -307,6 +529,11 @@ int main() {
 
     PAS_INFO("Shutting down...");
 
+    int exitCode = 0;
+    if (!lossMapPath.empty() && !lossMap.exportCSV(lossMapPath)) {
+        exitCode = 1;
+    }
+
     // Cleanup
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -314,5 +541,5 @@ int main() {
 
     utils::Logger::shutdown();
 
-    return 0;
+    return exitCode;
 }
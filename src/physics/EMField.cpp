@@ -2,6 +2,7 @@
 #include "physics/Constants.hpp"
 #include <algorithm>
 #include <cmath>
+#include <type_traits>
 
 namespace pas::physics {
 
@@ -20,6 +21,18 @@ void EMFieldManager::removeSource(const std::shared_ptr<FieldSource>& source) {
     }
 }
 
+void EMFieldManager::replaceSource(const std::shared_ptr<FieldSource>& oldSource,
+                                   std::shared_ptr<FieldSource> newSource) {
+    auto it = oldSource ? std::find(m_sources.begin(), m_sources.end(), oldSource) : m_sources.end();
+    if (it == m_sources.end()) {
+        addSource(std::move(newSource));
+    } else if (newSource) {
+        *it = std::move(newSource);
+    } else {
+        m_sources.erase(it);
+    }
+}
+
 void EMFieldManager::clear() {
     m_sources.clear();
 }
@@ -28,12 +41,30 @@ FieldValue EMFieldManager::evaluate(const glm::dvec3& position, double time) con
     FieldValue total;
     for (const auto& source : m_sources) {
         if (source && source->isEnabled() && source->isInside(position)) {
-            total += source->evaluate(position, time);
+            total += source->evaluate(position, time) * source->getScale();
+        }
+    }
+    return total;
+}
+
+FloatFieldValue EMFieldManager::evaluateFloat(const glm::vec3& position, double time) const {
+    const glm::dvec3 point(position);
+    FloatFieldValue total;
+    for (const auto& source : m_sources) {
+        if (source && source->isEnabled() && source->isInside(point)) {
+            total += source->evaluateFloat(position, time) * static_cast<float>(source->getScale());
         }
     }
     return total;
 }
 
+// FieldSource implementation
+
+FloatFieldValue FieldSource::evaluateFloat(const glm::vec3& position, double time) const {
+    const FieldValue field = evaluate(glm::dvec3(position), time);
+    return FloatFieldValue(glm::vec3(field.E), glm::vec3(field.B));
+}
+
 // UniformBField implementation
 
 UniformBField::UniformBField(const glm::dvec3& field, const BoundingBox& bounds)
@@ -41,11 +72,79 @@ UniformBField::UniformBField(const glm::dvec3& field, const BoundingBox& bounds)
     , m_bounds(bounds) {
 }
 
-FieldValue UniformBField::evaluate(const glm::dvec3& position, double /*time*/) const {
-    if (!m_bounds.isInfinite() && !m_bounds.contains(position)) {
+FieldValue UniformBField::evaluate(const glm::dvec3& position, double time) const {
+    return evaluateAt(position, time);
+}
+
+FloatFieldValue UniformBField::evaluateFloat(const glm::vec3& position, double time) const {
+    return evaluateAt(position, time);
+}
+
+template <typename Real>
+BasicFieldValue<Real> UniformBField::evaluateAt(const glm::vec<3, Real>& position, double /*time*/) const {
+    if (!m_bounds.isInfinite() && !m_bounds.contains(glm::dvec3(position))) {
+        return BasicFieldValue<Real>();
+    }
+    return BasicFieldValue<Real>(glm::vec<3, Real>(Real(0)), glm::vec<3, Real>(m_field));
+}
+
+// BoundingBox implementation
+
+BoundingBox BoundingBox::placed(const glm::dvec3& origin, const glm::dquat& rotation) const {
+    if (isInfinite()) {
+        return BoundingBox();
+    }
+
+    // Box around the placed corners
+    BoundingBox bounds(glm::dvec3(std::numeric_limits<double>::infinity()),
+                       glm::dvec3(-std::numeric_limits<double>::infinity()));
+    for (int corner = 0; corner < 8; ++corner) {
+        const glm::dvec3 point((corner & 1) ? max.x : min.x,
+                               (corner & 2) ? max.y : min.y,
+                               (corner & 4) ? max.z : min.z);
+        const glm::dvec3 moved = origin + rotation * point;
+        bounds.min = glm::min(bounds.min, moved);
+        bounds.max = glm::max(bounds.max, moved);
+    }
+    return bounds;
+}
+
+// PlacedField implementation
+
+PlacedField::PlacedField(std::shared_ptr<FieldSource> source,
+                         const glm::dvec3& origin,
+                         const glm::dquat& rotation)
+    : m_source(std::move(source)) {
+    setPlacement(origin, rotation);
+}
+
+FieldValue PlacedField::evaluate(const glm::dvec3& position, double time) const {
+    const glm::dvec3 local = m_inverseRotation * (position - m_origin);
+    if (!m_source->isEnabled() || !m_source->isInside(local)) {
         return FieldValue();
     }
-    return FieldValue(glm::dvec3(0.0), m_field);
+    const FieldValue field = m_source->evaluate(local, time);
+    return FieldValue(m_rotation * field.E, m_rotation * field.B);
+}
+
+FloatFieldValue PlacedField::evaluateFloat(const glm::vec3& position, double time) const {
+    const glm::vec3 local = m_inverseRotationFloat * (position - m_originFloat);
+    if (!m_source->isEnabled() || !m_source->isInside(glm::dvec3(local))) {
+        return FloatFieldValue();
+    }
+    const FloatFieldValue field = m_source->evaluateFloat(local, time);
+    return FloatFieldValue(m_rotationFloat * field.E, m_rotationFloat * field.B);
+}
+
+void PlacedField::setPlacement(const glm::dvec3& origin, const glm::dquat& rotation) {
+    m_origin = origin;
+    m_rotation = rotation;
+    m_inverseRotation = glm::inverse(rotation);
+    m_originFloat = glm::vec3(origin);
+    m_rotationFloat = glm::quat(rotation);
+    m_inverseRotationFloat = glm::quat(m_inverseRotation);
+
+    m_bounds = m_source->getBoundingBox().placed(origin, rotation);
 }
 
 // QuadrupoleField implementation
@@ -66,25 +165,352 @@ QuadrupoleField::QuadrupoleField(double gradient,
     );
 }
 
-FieldValue QuadrupoleField::evaluate(const glm::dvec3& position, double /*time*/) const {
+FieldValue QuadrupoleField::evaluate(const glm::dvec3& position, double time) const {
+    return evaluateAt(position, time);
+}
+
+FloatFieldValue QuadrupoleField::evaluateFloat(const glm::vec3& position, double time) const {
+    return evaluateAt(position, time);
+}
+
+template <typename Real>
+BasicFieldValue<Real> QuadrupoleField::evaluateAt(const glm::vec<3, Real>& position, double /*time*/) const {
     // Check if inside aperture and length
-    if (!m_bounds.contains(position)) {
-        return FieldValue();
+    if (!m_bounds.contains(glm::dvec3(position))) {
+        return BasicFieldValue<Real>();
     }
 
     // Local coordinates relative to center
-    double x = position.x - m_center.x;
-    double y = position.y - m_center.y;
+    const Real x = position.x - static_cast<Real>(m_center.x);
+    const Real y = position.y - static_cast<Real>(m_center.y);
 
     // Check radial aperture
-    double r = std::sqrt(x * x + y * y);
-    if (r > m_aperture) {
-        return FieldValue();
+    const Real aperture = static_cast<Real>(m_aperture);
+    if (x * x + y * y > aperture * aperture) {
+        return BasicFieldValue<Real>();
     }
 
     // Quadrupole field: Bx = G * y, By = G * x
-    glm::dvec3 B(m_gradient * y, m_gradient * x, 0.0);
-    return FieldValue(glm::dvec3(0.0), B);
+    const Real gradient = static_cast<Real>(m_gradient);
+    return BasicFieldValue<Real>(glm::vec<3, Real>(Real(0)),
+                                 glm::vec<3, Real>(gradient * y, gradient * x, Real(0)));
+}
+
+// MultipoleExpansion implementation
+
+void MultipoleExpansion::resize(int n) {
+    if (n > getOrder()) {
+        m_coefficients.resize(static_cast<size_t>(n));
+    }
+}
+
+void MultipoleExpansion::setNormal(int n, double value) {
+    if (n < 1) {
+        return;
+    }
+    resize(n);
+    m_coefficients[static_cast<size_t>(n - 1)].normal = value;
+}
+
+void MultipoleExpansion::setSkew(int n, double value) {
+    if (n < 1) {
+        return;
+    }
+    resize(n);
+    m_coefficients[static_cast<size_t>(n - 1)].skew = value;
+}
+
+void MultipoleExpansion::add(int n, double normal, double skew) {
+    if (n < 1) {
+        return;
+    }
+    resize(n);
+    m_coefficients[static_cast<size_t>(n - 1)].normal += normal;
+    m_coefficients[static_cast<size_t>(n - 1)].skew += skew;
+}
+
+double MultipoleExpansion::getNormal(int n) const {
+    return n >= 1 && n <= getOrder() ? m_coefficients[static_cast<size_t>(n - 1)].normal : 0.0;
+}
+
+double MultipoleExpansion::getSkew(int n) const {
+    return n >= 1 && n <= getOrder() ? m_coefficients[static_cast<size_t>(n - 1)].skew : 0.0;
+}
+
+void MultipoleExpansion::evaluate(std::span<const double> x, std::span<const double> y,
+                                  std::span<double> bx, std::span<double> by) const {
+    const size_t count = std::min({x.size(), y.size(), bx.size(), by.size()});
+    const Coefficient* coefficients = m_coefficients.data();
+    const int order = getOrder();
+
+#ifdef PAS_ENABLE_OPENMP
+    #pragma omp simd
+#endif
+    for (size_t i = 0; i < count; ++i) {
+        double re = 0.0;
+        double im = 0.0;
+        for (int n = order - 1; n >= 0; --n) {
+            const double r = re * x[i] - im * y[i] + coefficients[n].normal;
+            im = re * y[i] + im * x[i] + coefficients[n].skew;
+            re = r;
+        }
+        bx[i] = im;
+        by[i] = re;
+    }
+}
+
+// EngeFunction implementation
+
+namespace {
+
+// Points per side of an edge for the fringe integrals
+constexpr int ENGE_INTEGRATION_STEPS = 2000;
+
+/**
+ * @brief Simpson rule on [a, b] with an even number of steps.
+ */
+template <typename Function>
+double simpson(Function f, double a, double b, int steps) {
+    const double h = (b - a) / steps;
+    double sum = f(a) + f(b);
+    for (int i = 1; i < steps; ++i) {
+        sum += (i % 2 == 1 ? 4.0 : 2.0) * f(a + i * h);
+    }
+    return sum * h / 3.0;
+}
+
+template <typename Real>
+Real engeValue(const EngeFunction& enge, Real d) {
+    // exp() of larger exponents overflows Real; the field is zero there
+    constexpr Real MAX_EXPONENT = std::is_same_v<Real, float> ? Real(80) : Real(700);
+
+    const Real t = d / static_cast<Real>(enge.gap);
+    Real P = 0;
+    for (auto it = enge.coefficients.rbegin(); it != enge.coefficients.rend(); ++it) {
+        P = P * t + static_cast<Real>(*it);
+    }
+    if (P > MAX_EXPONENT) {
+        return 0;
+    }
+    return Real(1) / (Real(1) + std::exp(P));
+}
+
+template <typename Real>
+Real engeDerivative(const EngeFunction& enge, Real d) {
+    const Real gap = static_cast<Real>(enge.gap);
+    const Real t = d / gap;
+    Real dP = 0;
+    for (size_t i = enge.coefficients.size() - 1; i >= 1; --i) {
+        dP = dP * t + static_cast<Real>(static_cast<double>(i) * enge.coefficients[i]);
+    }
+    const Real F = engeValue(enge, d);
+    return -F * (Real(1) - F) * dP / gap;
+}
+
+} // namespace
+
+double EngeFunction::value(double d) const {
+    return engeValue(*this, d);
+}
+
+float EngeFunction::value(float d) const {
+    return engeValue(*this, d);
+}
+
+double EngeFunction::derivative(double d) const {
+    return engeDerivative(*this, d);
+}
+
+float EngeFunction::derivative(float d) const {
+    return engeDerivative(*this, d);
+}
+
+double EngeFunction::extent() const {
+    constexpr double TOLERANCE = 1e-6;
+    constexpr double MAX_GAPS = 20.0;
+    const double step = gap / 100.0;
+    double d = 0.0;
+    while (d < MAX_GAPS * gap && (value(d) > TOLERANCE || 1.0 - value(-d) > TOLERANCE)) {
+        d += step;
+    }
+    return d;
+}
+
+EngeFunction::Integrals EngeFunction::integrals() const {
+    // d = -s is the distance outside the boundary; split at the hard edge
+    const double D = extent();
+    auto outside = [this](double power) {
+        return [this, power](double d) { return std::pow(d, power) * value(d); };
+    };
+    auto inside = [this](double power) {
+        return [this, power](double d) { return std::pow(d, power) * (value(d) - 1.0); };
+    };
+
+    Integrals result;
+    result.first = -(simpson(inside(1.0), -D, 0.0, ENGE_INTEGRATION_STEPS) +
+                     simpson(outside(1.0), 0.0, D, ENGE_INTEGRATION_STEPS));
+    result.second = simpson(inside(2.0), -D, 0.0, ENGE_INTEGRATION_STEPS) +
+                    simpson(outside(2.0), 0.0, D, ENGE_INTEGRATION_STEPS);
+    result.fint = simpson([this](double d) { double F = value(d); return F * (1.0 - F); },
+                          -D, D, 2 * ENGE_INTEGRATION_STEPS) / gap;
+    return result;
+}
+
+// FringeProfile implementation
+
+FringeProfile::FringeProfile(const EngeFunction& enge, double length)
+    : m_enge(enge)
+    , m_halfLength(length / 2.0)
+    , m_extent(length / 2.0 + enge.extent()) {
+}
+
+// MultipoleField implementation
+
+MultipoleField::MultipoleField(MultipoleExpansion multipoles,
+                               const glm::dvec3& center,
+                               double length,
+                               double aperture,
+                               double roll,
+                               const std::optional<EngeFunction>& fringe)
+    : m_multipoles(std::move(multipoles))
+    , m_center(center)
+    , m_length(length)
+    , m_aperture(aperture)
+    , m_roll(roll)
+    , m_cosRoll(std::cos(roll))
+    , m_sinRoll(std::sin(roll)) {
+    if (fringe) {
+        m_fringe.emplace(*fringe, length);
+    }
+    double halfLength = m_fringe ? m_fringe->getExtent() : length / 2.0;
+    m_bounds = BoundingBox(
+        glm::dvec3(center.x - aperture, center.y - aperture, center.z - halfLength),
+        glm::dvec3(center.x + aperture, center.y + aperture, center.z + halfLength)
+    );
+}
+
+FieldValue MultipoleField::evaluate(const glm::dvec3& position, double time) const {
+    return evaluateAt(position, time);
+}
+
+FloatFieldValue MultipoleField::evaluateFloat(const glm::vec3& position, double time) const {
+    return evaluateAt(position, time);
+}
+
+template <typename Real>
+BasicFieldValue<Real> MultipoleField::evaluateAt(const glm::vec<3, Real>& position, double /*time*/) const {
+    if (!m_bounds.contains(glm::dvec3(position))) {
+        return BasicFieldValue<Real>();
+    }
+
+    const Real x = position.x - static_cast<Real>(m_center.x);
+    const Real y = position.y - static_cast<Real>(m_center.y);
+    const Real aperture = static_cast<Real>(m_aperture);
+    if (x * x + y * y > aperture * aperture) {
+        return BasicFieldValue<Real>();
+    }
+
+    // Rotate into the magnet frame, evaluate, rotate the field back
+    const Real cosRoll = static_cast<Real>(m_cosRoll);
+    const Real sinRoll = static_cast<Real>(m_sinRoll);
+    const Real u = cosRoll * x + sinRoll * y;
+    const Real v = -sinRoll * x + cosRoll * y;
+    const glm::vec<3, Real> local = m_multipoles.evaluate(u, v);
+    glm::vec<3, Real> B(cosRoll * local.x - sinRoll * local.y,
+                        sinRoll * local.x + cosRoll * local.y,
+                        Real(0));
+    if (m_fringe) {
+        const Real z = position.z - static_cast<Real>(m_center.z);
+        B *= m_fringe->value(z);
+        B.z = m_fringe->derivative(z) * m_multipoles.potential(u, v);
+    }
+    return BasicFieldValue<Real>(glm::vec<3, Real>(Real(0)), B);
+}
+
+void MultipoleField::evaluateBatch(std::span<const glm::dvec3> positions,
+                                   std::span<glm::dvec3> fields) const {
+    constexpr size_t BLOCK = 64;
+    double u[BLOCK];
+    double v[BLOCK];
+    double bu[BLOCK];
+    double bv[BLOCK];
+
+    const size_t count = std::min(positions.size(), fields.size());
+    const double apertureSq = m_aperture * m_aperture;
+    for (size_t start = 0; start < count; start += BLOCK) {
+        const size_t n = std::min(BLOCK, count - start);
+        for (size_t i = 0; i < n; ++i) {
+            const double x = positions[start + i].x - m_center.x;
+            const double y = positions[start + i].y - m_center.y;
+            u[i] = m_cosRoll * x + m_sinRoll * y;
+            v[i] = -m_sinRoll * x + m_cosRoll * y;
+        }
+
+        m_multipoles.evaluate({u, n}, {v, n}, {bu, n}, {bv, n});
+
+        for (size_t i = 0; i < n; ++i) {
+            const glm::dvec3& position = positions[start + i];
+            if (!m_bounds.contains(position) || u[i] * u[i] + v[i] * v[i] > apertureSq) {
+                fields[start + i] = glm::dvec3(0.0);
+                continue;
+            }
+            fields[start + i] = glm::dvec3(m_cosRoll * bu[i] - m_sinRoll * bv[i],
+                                           m_sinRoll * bu[i] + m_cosRoll * bv[i],
+                                           0.0);
+            if (m_fringe) {
+                const double z = position.z - m_center.z;
+                fields[start + i] *= m_fringe->value(z);
+                fields[start + i].z = m_fringe->derivative(z) * m_multipoles.potential(u[i], v[i]);
+            }
+        }
+    }
+}
+
+// SolenoidField implementation
+
+SolenoidField::SolenoidField(double field,
+                             const glm::dvec3& center,
+                             double length,
+                             double aperture,
+                             const EngeFunction& fringe)
+    : m_field(field)
+    , m_center(center)
+    , m_aperture(aperture)
+    , m_profile(fringe, length) {
+    double halfLength = m_profile.getExtent();
+    m_bounds = BoundingBox(
+        glm::dvec3(center.x - aperture, center.y - aperture, center.z - halfLength),
+        glm::dvec3(center.x + aperture, center.y + aperture, center.z + halfLength)
+    );
+}
+
+FieldValue SolenoidField::evaluate(const glm::dvec3& position, double time) const {
+    return evaluateAt(position, time);
+}
+
+FloatFieldValue SolenoidField::evaluateFloat(const glm::vec3& position, double time) const {
+    return evaluateAt(position, time);
+}
+
+template <typename Real>
+BasicFieldValue<Real> SolenoidField::evaluateAt(const glm::vec<3, Real>& position, double /*time*/) const {
+    if (!m_bounds.contains(glm::dvec3(position))) {
+        return BasicFieldValue<Real>();
+    }
+
+    const Real x = position.x - static_cast<Real>(m_center.x);
+    const Real y = position.y - static_cast<Real>(m_center.y);
+    const Real aperture = static_cast<Real>(m_aperture);
+    if (x * x + y * y > aperture * aperture) {
+        return BasicFieldValue<Real>();
+    }
+
+    // Paraxial expansion, div B = 0 to first order in r
+    const Real z = position.z - static_cast<Real>(m_center.z);
+    const Real field = static_cast<Real>(m_field);
+    const Real radial = Real(-0.5) * field * m_profile.derivative(z);
+    return BasicFieldValue<Real>(glm::vec<3, Real>(Real(0)),
+                                 glm::vec<3, Real>(radial * x, radial * y, field * m_profile.value(z)));
 }
 
 // RFField implementation
@@ -111,21 +537,30 @@ RFField::RFField(double voltage,
 }
 
 FieldValue RFField::evaluate(const glm::dvec3& position, double time) const {
-    if (!m_bounds.contains(position)) {
-        return FieldValue();
+    return evaluateAt(position, time);
+}
+
+FloatFieldValue RFField::evaluateFloat(const glm::vec3& position, double time) const {
+    return evaluateAt(position, time);
+}
+
+template <typename Real>
+BasicFieldValue<Real> RFField::evaluateAt(const glm::vec<3, Real>& position, double time) const {
+    if (!m_bounds.contains(glm::dvec3(position))) {
+        return BasicFieldValue<Real>();
     }
 
     // Check radial aperture
-    double x = position.x - m_center.x;
-    double y = position.y - m_center.y;
-    double r = std::sqrt(x * x + y * y);
-    if (r > m_aperture) {
-        return FieldValue();
+    const Real x = position.x - static_cast<Real>(m_center.x);
+    const Real y = position.y - static_cast<Real>(m_center.y);
+    const Real aperture = static_cast<Real>(m_aperture);
+    if (x * x + y * y > aperture * aperture) {
+        return BasicFieldValue<Real>();
     }
 
-    // E_z = (V/L) * cos(omega * t + phi)
-    double Ez = (m_voltage / m_length) * std::cos(m_omega * time + m_phase);
-    return FieldValue(glm::dvec3(0.0, 0.0, Ez), glm::dvec3(0.0));
+    // E_z = (V/L) * cos(omega * t + phi), in double: omega * t grows without bound
+    const Real Ez = static_cast<Real>((m_voltage / m_length) * std::cos(m_omega * time + m_phase));
+    return BasicFieldValue<Real>(glm::vec<3, Real>(Real(0), Real(0), Ez), glm::vec<3, Real>(Real(0)));
 }
 
 void RFField::setFrequency(double frequency) {
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <array>
 #include <memory>
+#include <optional>
+#include <span>
 #include <vector>
 #include <limits>
 
@@ -10,28 +14,34 @@ namespace pas::physics {
 /**
  * @brief Represents an electromagnetic field value at a point.
  */
-struct FieldValue {
-    glm::dvec3 E{0.0};  // Electric field (V/m)
-    glm::dvec3 B{0.0};  // Magnetic field (Tesla)
+template <typename Real>
+struct BasicFieldValue {
+    using Vec = glm::vec<3, Real>;
 
-    FieldValue() = default;
-    FieldValue(const glm::dvec3& e, const glm::dvec3& b) : E(e), B(b) {}
+    Vec E{0.0};  // Electric field (V/m)
+    Vec B{0.0};  // Magnetic field (Tesla)
 
-    FieldValue& operator+=(const FieldValue& other) {
+    BasicFieldValue() = default;
+    BasicFieldValue(const Vec& e, const Vec& b) : E(e), B(b) {}
+
+    BasicFieldValue& operator+=(const BasicFieldValue& other) {
         E += other.E;
         B += other.B;
         return *this;
     }
 
-    FieldValue operator+(const FieldValue& other) const {
-        return FieldValue(E + other.E, B + other.B);
+    BasicFieldValue operator+(const BasicFieldValue& other) const {
+        return BasicFieldValue(E + other.E, B + other.B);
     }
 
-    FieldValue operator*(double scalar) const {
-        return FieldValue(E * scalar, B * scalar);
+    BasicFieldValue operator*(Real scalar) const {
+        return BasicFieldValue(E * scalar, B * scalar);
     }
 };
 
+using FieldValue = BasicFieldValue<double>;
+using FloatFieldValue = BasicFieldValue<float>;  // For the single-precision pushers
+
 /**
  * @brief Axis-aligned bounding box for spatial queries.
  */
@@ -53,6 +63,17 @@ struct BoundingBox {
         return min.x == -std::numeric_limits<double>::infinity() ||
                max.x == std::numeric_limits<double>::infinity();
     }
+
+    bool intersects(const BoundingBox& other) const {
+        return min.x <= other.max.x && max.x >= other.min.x &&
+               min.y <= other.max.y && max.y >= other.min.y &&
+               min.z <= other.max.z && max.z >= other.min.z;
+    }
+
+    /**
+     * @brief Box around this box moved to origin and rotated; infinite stays infinite.
+     */
+    BoundingBox placed(const glm::dvec3& origin, const glm::dquat& rotation) const;
 };
 
 /**
@@ -73,6 +94,16 @@ public:
      */
     virtual FieldValue evaluate(const glm::dvec3& position, double time) const = 0;
 
+    /**
+     * @brief Evaluate the field in single precision.
+     *
+     * Used by the float pushers, which track positions relative to the
+     * reference orbit, where float resolves them finely. The default rounds
+     * evaluate(); the built-in sources compute in float throughout. Time
+     * stays double, as it grows without bound.
+     */
+    virtual FloatFieldValue evaluateFloat(const glm::vec3& position, double time) const;
+
     /**
      * @brief Get the bounding box of the field region.
      */
@@ -95,8 +126,17 @@ public:
      */
     void setEnabled(bool enabled) { m_enabled = enabled; }
 
+    /**
+     * @brief Strength scale applied by EMFieldManager, e.g. from a magnet ramp.
+     *
+     * Changed between integration steps, so ramps do not rebuild sources.
+     */
+    double getScale() const { return m_scale; }
+    void setScale(double scale) { m_scale = scale; }
+
 protected:
     bool m_enabled = true;
+    double m_scale = 1.0;
 };
 
 /**
@@ -118,6 +158,15 @@ public:
      */
     void removeSource(const std::shared_ptr<FieldSource>& source);
 
+    /**
+     * @brief Swap a source for another in the same slot.
+     *
+     * Adds the replacement if the old source is not registered and removes
+     * the old one if the replacement is null. Call between steps only.
+     */
+    void replaceSource(const std::shared_ptr<FieldSource>& oldSource,
+                       std::shared_ptr<FieldSource> newSource);
+
     /**
      * @brief Clear all field sources.
      */
@@ -136,6 +185,11 @@ public:
      */
     FieldValue evaluate(const glm::dvec3& position, double time) const;
 
+    /**
+     * @brief Evaluate the total field in single precision.
+     */
+    FloatFieldValue evaluateFloat(const glm::vec3& position, double time) const;
+
     /**
      * @brief Get all field sources.
      */
@@ -163,16 +217,62 @@ public:
                            const BoundingBox& bounds = BoundingBox());
 
     FieldValue evaluate(const glm::dvec3& position, double time) const override;
+    FloatFieldValue evaluateFloat(const glm::vec3& position, double time) const override;
     BoundingBox getBoundingBox() const override { return m_bounds; }
 
     const glm::dvec3& getField() const { return m_field; }
     void setField(const glm::dvec3& field) { m_field = field; }
 
 private:
+    template <typename Real>
+    BasicFieldValue<Real> evaluateAt(const glm::vec<3, Real>& position, double time) const;
+
     glm::dvec3 m_field;
     BoundingBox m_bounds;
 };
 
+/**
+ * @brief Field source built around the origin, placed by a rigid transform.
+ *
+ * Positions are moved into the frame of the wrapped source and its E and B
+ * rotated back, so one source serves every place a shared component occurs
+ * at, along straight or curved lattices. The wrapped source's enable flag
+ * applies, but only the placement's own scale does, applied by
+ * EMFieldManager as for any source; PhysicsEngine ramps that one, so
+ * engines sharing a source never write to it.
+ */
+class PlacedField : public FieldSource {
+public:
+    PlacedField(std::shared_ptr<FieldSource> source,
+                const glm::dvec3& origin,
+                const glm::dquat& rotation);
+
+    FieldValue evaluate(const glm::dvec3& position, double time) const override;
+    FloatFieldValue evaluateFloat(const glm::vec3& position, double time) const override;
+    BoundingBox getBoundingBox() const override { return m_bounds; }
+
+    /**
+     * @brief Move the placement; call between steps only.
+     *
+     * Also refreshes the bounding box from the wrapped source.
+     */
+    void setPlacement(const glm::dvec3& origin, const glm::dquat& rotation);
+
+    const std::shared_ptr<FieldSource>& getSource() const { return m_source; }
+    const glm::dvec3& getOrigin() const { return m_origin; }
+    const glm::dquat& getRotation() const { return m_rotation; }
+
+private:
+    std::shared_ptr<FieldSource> m_source;
+    glm::dvec3 m_origin;
+    glm::dquat m_rotation;
+    glm::dquat m_inverseRotation;
+    glm::vec3 m_originFloat;  // Rounded placement for evaluateFloat()
+    glm::quat m_rotationFloat;
+    glm::quat m_inverseRotationFloat;
+    BoundingBox m_bounds;
+};
+
 /**
  * @brief Quadrupole magnetic field for focusing/defocusing.
  *
@@ -194,6 +294,7 @@ public:
                     double aperture = 0.1);
 
     FieldValue evaluate(const glm::dvec3& position, double time) const override;
+    FloatFieldValue evaluateFloat(const glm::vec3& position, double time) const override;
     BoundingBox getBoundingBox() const override { return m_bounds; }
 
     double getGradient() const { return m_gradient; }
@@ -202,6 +303,9 @@ public:
     double getAperture() const { return m_aperture; }
 
 private:
+    template <typename Real>
+    BasicFieldValue<Real> evaluateAt(const glm::vec<3, Real>& position, double time) const;
+
     double m_gradient;    // T/m
     glm::dvec3 m_center;
     double m_length;
@@ -209,6 +313,277 @@ private:
     BoundingBox m_bounds;
 };
 
+/**
+ * @brief Enge function for the longitudinal fall-off of a magnet field.
+ *
+ * F(d) = 1 / (1 + exp(c0 + c1*t + ... + c5*t^5)),  t = d / gap
+ *
+ * where d is the distance outside the effective field boundary. The default
+ * coefficients are the common dipole fit, whose boundary keeps the integrated
+ * field of the equivalent hard edge.
+ */
+struct EngeFunction {
+    std::array<double, 6> coefficients{0.478959, 1.911289, -1.185953, 1.630554, -1.082657, 0.318111};
+    double gap = 0.1;   // Full gap or bore diameter [m]
+
+    /**
+     * @brief Relative field at a distance outside the boundary.
+     */
+    double value(double d) const;
+    float value(float d) const;
+
+    /**
+     * @brief dF/dd.
+     */
+    double derivative(double d) const;
+    float derivative(float d) const;
+
+    /**
+     * @brief Distance beyond which the field is below 1e-6 on either side.
+     */
+    double extent() const;
+
+    /**
+     * @brief Integrals of one edge used by the linear fringe maps.
+     *
+     * With s along the beam from the boundary (inside s > 0) and the hard
+     * edge theta(s): first = int s (F - theta) ds, second = int s^2 (F - theta) ds,
+     * and fint = int F (1 - F) ds / gap (MAD-X FINT).
+     */
+    struct Integrals {
+        double first = 0.0;     // m^2
+        double second = 0.0;    // m^3
+        double fint = 0.0;
+    };
+    Integrals integrals() const;
+};
+
+/**
+ * @brief Longitudinal profile of a magnet with Enge fringes at both ends.
+ *
+ * z is measured from the magnet center; the effective (hard-edge) length is
+ * kept, so the field integral matches the hard-edge model.
+ */
+class FringeProfile {
+public:
+    FringeProfile(const EngeFunction& enge, double length);
+
+    template <typename Real>
+    Real value(Real z) const {
+        const Real half = static_cast<Real>(m_halfLength);
+        return m_enge.value(z - half) * m_enge.value(-z - half);
+    }
+
+    template <typename Real>
+    Real derivative(Real z) const {
+        const Real half = static_cast<Real>(m_halfLength);
+        return m_enge.derivative(z - half) * m_enge.value(-z - half) -
+               m_enge.value(z - half) * m_enge.derivative(-z - half);
+    }
+
+    /**
+     * @brief Half-length of the region with non-negligible field.
+     */
+    double getExtent() const { return m_extent; }
+
+    const EngeFunction& getEnge() const { return m_enge; }
+
+private:
+    EngeFunction m_enge;
+    double m_halfLength;
+    double m_extent;
+};
+
+/**
+ * @brief Two-dimensional magnetic multipole expansion.
+ *
+ * By + i*Bx = sum_n (b_n + i*a_n) * (x + i*y)^(n-1)
+ *
+ * with absolute coefficients in T/m^(n-1): n = 1 is the dipole, n = 2 the
+ * quadrupole, n = 3 the sextupole and so on. Evaluation uses Horner's scheme
+ * in hand-written complex arithmetic, one complex multiply-add per order.
+ */
+class MultipoleExpansion {
+public:
+    /**
+     * @brief Set the normal coefficient b_n (n >= 1).
+     */
+    void setNormal(int n, double value);
+
+    /**
+     * @brief Set the skew coefficient a_n (n >= 1).
+     */
+    void setSkew(int n, double value);
+
+    /**
+     * @brief Add to both coefficients of order n.
+     */
+    void add(int n, double normal, double skew);
+
+    double getNormal(int n) const;
+    double getSkew(int n) const;
+
+    /**
+     * @brief Highest order held (0 if empty).
+     */
+    int getOrder() const { return static_cast<int>(m_coefficients.size()); }
+
+    /**
+     * @brief Evaluate the transverse field at a point, in double or float.
+     * @return (Bx, By, 0) in Tesla.
+     */
+    template <typename Real>
+    glm::vec<3, Real> evaluate(Real x, Real y) const {
+        Real re = 0;
+        Real im = 0;
+        for (auto it = m_coefficients.rbegin(); it != m_coefficients.rend(); ++it) {
+            const Real r = re * x - im * y + static_cast<Real>(it->normal);
+            im = re * y + im * x + static_cast<Real>(it->skew);
+            re = r;
+        }
+        return glm::vec<3, Real>(im, re, Real(0));
+    }
+
+    /**
+     * @brief Scalar potential psi with (Bx, By) = grad psi.
+     *
+     * psi = Im[sum_n (b_n + i*a_n) (x + i*y)^n / n]. A longitudinal profile
+     * p(s) multiplying the field adds Bz = p'(s) * psi to first order.
+     */
+    template <typename Real>
+    Real potential(Real x, Real y) const {
+        Real re = 0;
+        Real im = 0;
+        for (int n = getOrder(); n >= 1; --n) {
+            const Coefficient& c = m_coefficients[static_cast<size_t>(n - 1)];
+            const Real r = re * x - im * y + static_cast<Real>(c.normal / n);
+            im = re * y + im * x + static_cast<Real>(c.skew / n);
+            re = r;
+        }
+        return re * y + im * x;
+    }
+
+    /**
+     * @brief Evaluate the field at many points given as separate coordinate arrays.
+     *
+     * The loop over points is vectorised, running Horner's recursion for
+     * several points per instruction.
+     */
+    void evaluate(std::span<const double> x, std::span<const double> y,
+                  std::span<double> bx, std::span<double> by) const;
+
+private:
+    struct Coefficient {
+        double normal = 0.0;
+        double skew = 0.0;
+    };
+
+    void resize(int n);
+
+    std::vector<Coefficient> m_coefficients;  // Index n - 1
+};
+
+/**
+ * @brief Magnet field given by a multipole expansion.
+ *
+ * The expansion is evaluated in the magnet frame, which may be offset
+ * transversely from the beam axis and rolled about it. Without a fringe the
+ * field has hard edges; with one, every multipole follows the Enge profile
+ * and the first-order longitudinal field keeps it curl-free.
+ */
+class MultipoleField : public FieldSource {
+public:
+    /**
+     * @brief Create a multipole field.
+     * @param multipoles Field expansion in the magnet frame.
+     * @param center Center of the magnet, including any offset.
+     * @param length Effective length along z-axis.
+     * @param aperture Radius of the aperture around the center.
+     * @param roll Rotation of the magnet about z [rad].
+     * @param fringe Enge fall-off at both ends; hard edges if empty.
+     */
+    MultipoleField(MultipoleExpansion multipoles,
+                   const glm::dvec3& center = glm::dvec3(0.0),
+                   double length = 1.0,
+                   double aperture = 0.1,
+                   double roll = 0.0,
+                   const std::optional<EngeFunction>& fringe = std::nullopt);
+
+    FieldValue evaluate(const glm::dvec3& position, double time) const override;
+    FloatFieldValue evaluateFloat(const glm::vec3& position, double time) const override;
+    BoundingBox getBoundingBox() const override { return m_bounds; }
+
+    /**
+     * @brief Evaluate the magnetic field at many points.
+     *
+     * Points are processed in blocks converted to coordinate arrays for the
+     * vectorised expansion. Points outside the field region get zero field.
+     */
+    void evaluateBatch(std::span<const glm::dvec3> positions, std::span<glm::dvec3> fields) const;
+
+    const MultipoleExpansion& getMultipoles() const { return m_multipoles; }
+    void setMultipoles(MultipoleExpansion multipoles) { m_multipoles = std::move(multipoles); }
+    double getRoll() const { return m_roll; }
+    const std::optional<FringeProfile>& getFringe() const { return m_fringe; }
+
+private:
+    template <typename Real>
+    BasicFieldValue<Real> evaluateAt(const glm::vec<3, Real>& position, double time) const;
+
+    MultipoleExpansion m_multipoles;
+    std::optional<FringeProfile> m_fringe;
+    glm::dvec3 m_center;
+    double m_length;
+    double m_aperture;
+    double m_roll;
+    double m_cosRoll;
+    double m_sinRoll;
+    BoundingBox m_bounds;
+};
+
+/**
+ * @brief Solenoid field with Enge fringes.
+ *
+ * Paraxial expansion of the on-axis field B0 * p(z):
+ * Bz = B0 p(z), Bx = -x/2 B0 p'(z), By = -y/2 B0 p'(z).
+ * The radial fringe field provides the solenoid's focusing, so there is no
+ * hard-edge variant.
+ */
+class SolenoidField : public FieldSource {
+public:
+    /**
+     * @brief Create a solenoid field.
+     * @param field Central field B0 in Tesla.
+     * @param center Center position of the solenoid.
+     * @param length Effective length along z-axis.
+     * @param aperture Bore radius.
+     * @param fringe Enge fall-off at both ends.
+     */
+    SolenoidField(double field,
+                  const glm::dvec3& center,
+                  double length,
+                  double aperture,
+                  const EngeFunction& fringe);
+
+    FieldValue evaluate(const glm::dvec3& position, double time) const override;
+    FloatFieldValue evaluateFloat(const glm::vec3& position, double time) const override;
+    BoundingBox getBoundingBox() const override { return m_bounds; }
+
+    double getField() const { return m_field; }
+    void setField(double field) { m_field = field; }
+    const FringeProfile& getProfile() const { return m_profile; }
+
+private:
+    template <typename Real>
+    BasicFieldValue<Real> evaluateAt(const glm::vec<3, Real>& position, double time) const;
+
+    double m_field;       // T
+    glm::dvec3 m_center;
+    double m_aperture;
+    FringeProfile m_profile;
+    BoundingBox m_bounds;
+};
+
 /**
  * @brief RF cavity oscillating electric field for acceleration.
  *
@@ -233,6 +608,7 @@ public:
             double aperture = 0.1);
 
     FieldValue evaluate(const glm::dvec3& position, double time) const override;
+    FloatFieldValue evaluateFloat(const glm::vec3& position, double time) const override;
     BoundingBox getBoundingBox() const override { return m_bounds; }
 
     double getVoltage() const { return m_voltage; }
@@ -245,6 +621,9 @@ public:
     void setPhase(double phase) { m_phase = phase; }
 
 private:
+    template <typename Real>
+    BasicFieldValue<Real> evaluateAt(const glm::vec<3, Real>& position, double time) const;
+
     double m_voltage;     // V
     double m_frequency;   // Hz
     double m_omega;       // Angular frequency (rad/s)
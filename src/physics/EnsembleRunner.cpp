@@ -0,0 +1,286 @@
+#include "physics/EnsembleRunner.hpp"
+#include "physics/PhysicsEngine.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Parallel.hpp"
+#include "utils/Random.hpp"
+#include "utils/ThreadPool.hpp"
+#include "utils/Timer.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <mutex>
+
+namespace pas::physics {
+
+namespace {
+
+// Steps between checks for a fully lost beam
+constexpr uint64_t LOSS_CHECK_INTERVAL = 64;
+
+void writeHeader(std::ostream& out) {
+    out << "index,steps,surviving,lost,survival,emittance_x,emittance_y,mean_energy,wall_time\n";
+}
+
+void writeRow(std::ostream& out, const VariantResult& result) {
+    out << result.index << ',' << result.steps << ',' << result.survivingParticles << ','
+        << result.lostParticles << ',' << result.survival << ',' << result.emittanceX << ','
+        << result.emittanceY << ',' << result.meanEnergy << ',' << result.wallTime << '\n';
+}
+
+} // namespace
+
+// VariantBuilder implementation
+
+VariantBuilder::VariantBuilder(const accelerator::Accelerator& base, size_t index, uint64_t seed)
+    : m_lattice(std::make_shared<accelerator::Accelerator>(base))
+    , m_owned(base.getComponentCount(), false)
+    , m_index(index)
+    , m_random(utils::streamSeed(seed, index)) {}
+
+std::shared_ptr<accelerator::Component> VariantBuilder::modify(size_t componentIndex) {
+    if (componentIndex >= m_owned.size()) {
+        return nullptr;
+    }
+    if (!m_owned[componentIndex]) {
+        m_lattice->replaceComponent(componentIndex, m_lattice->getComponent(componentIndex)->clone());
+        m_owned[componentIndex] = true;
+    }
+    return m_lattice->getComponent(componentIndex);
+}
+
+std::shared_ptr<accelerator::Accelerator> VariantBuilder::build() {
+    // Recording components collect per-run data, and an engine publishing a
+    // component whose source is not current builds or updates it in place;
+    // neither can be shared
+    for (size_t i = 0; i < m_owned.size(); ++i) {
+        const auto& component = m_lattice->getComponent(i);
+        if (!m_owned[i] && (component->observesCrossings() || !component->isFieldSourceCurrent())) {
+            modify(i);
+        }
+    }
+    return m_lattice;
+}
+
+// EnsembleResult implementation
+
+bool EnsembleResult::exportCSV(const std::string& filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        PAS_ERROR("EnsembleResult: Could not create file: {}", filepath);
+        return false;
+    }
+
+    writeHeader(file);
+    for (const auto& variant : variants) {
+        writeRow(file, variant);
+    }
+
+    PAS_INFO("EnsembleResult: Exported {} variants to {}", variants.size(), filepath);
+    return true;
+}
+
+// EnsembleRunner implementation
+
+EnsembleRunner::EnsembleRunner(std::shared_ptr<const accelerator::Accelerator> base, BeamParameters beam)
+    : m_base(std::move(base))
+    , m_beam(beam) {}
+
+EnsembleResult EnsembleRunner::run(const EnsembleConfig& config, const VariantSetup& setup,
+                                   const ResultCallback& onResult) const {
+    EnsembleResult result;
+    if (!m_base || config.variants == 0) {
+        return result;
+    }
+
+    utils::Timer timer;
+
+    // Field sources are built lazily; build them once here so that variants
+    // sharing a component only read it
+    for (const auto& component : m_base->getComponents()) {
+        component->getFieldSource();
+    }
+
+    // Every variant starts from the same beam
+    ParticleSystem beam;
+    if (!beam.generateBeam(m_beam)) {
+        PAS_ERROR("EnsembleRunner: Could not generate the beam");
+        return result;
+    }
+
+    std::ofstream output;
+    if (!config.outputPath.empty()) {
+        output.open(config.outputPath);
+        if (output.is_open()) {
+            writeHeader(output);
+            output.flush();
+        } else {
+            PAS_ERROR("EnsembleRunner: Could not create file: {}", config.outputPath);
+        }
+    }
+
+    const size_t threads = std::min(config.threads == 0
+                                        ? static_cast<size_t>(std::max(utils::getMaxThreads(), 1))
+                                        : config.threads,
+                                    config.variants);
+    PAS_INFO("EnsembleRunner: Running {} variants on {} threads", config.variants, threads);
+
+    result.variants.reserve(config.variants);
+    std::mutex resultMutex;
+    {
+        // One OpenMP thread per task: the pool already occupies every core
+        utils::ThreadPool pool(threads, 1);
+        std::vector<std::future<void>> pending;
+        pending.reserve(config.variants);
+
+        for (size_t index = 0; index < config.variants; ++index) {
+            pending.push_back(pool.submit([&, index]() {
+                VariantResult variant = runVariant(config, setup, index, beam);
+
+                std::lock_guard<std::mutex> lock(resultMutex);
+                if (output.is_open()) {
+                    writeRow(output, variant);
+                    output.flush();
+                }
+                if (onResult) {
+                    onResult(variant);
+                }
+                result.variants.push_back(variant);
+            }));
+        }
+        for (auto& future : pending) {
+            future.get();
+        }
+    }
+
+    std::sort(result.variants.begin(), result.variants.end(),
+              [](const VariantResult& a, const VariantResult& b) { return a.index < b.index; });
+
+    result.minSurvival = std::numeric_limits<double>::max();
+    result.maxSurvival = 0.0;
+    for (const auto& variant : result.variants) {
+        result.meanSurvival += variant.survival;
+        result.meanEmittanceX += variant.emittanceX;
+        result.meanEmittanceY += variant.emittanceY;
+        result.minSurvival = std::min(result.minSurvival, variant.survival);
+        result.maxSurvival = std::max(result.maxSurvival, variant.survival);
+    }
+    const double count = static_cast<double>(result.variants.size());
+    result.meanSurvival /= count;
+    result.meanEmittanceX /= count;
+    result.meanEmittanceY /= count;
+    result.wallTime = timer.elapsedSeconds();
+
+    PAS_INFO("EnsembleRunner: {} variants in {:.2f} s, survival {:.4f} (min {:.4f}, max {:.4f})",
+             result.variants.size(), result.wallTime, result.meanSurvival,
+             result.minSurvival, result.maxSurvival);
+    return result;
+}
+
+VariantResult EnsembleRunner::runVariant(const EnsembleConfig& config, const VariantSetup& setup,
+                                         size_t index, const ParticleSystem& beam) const {
+    utils::Timer timer;
+
+    VariantBuilder builder(*m_base, index, config.seed);
+    if (setup) {
+        setup(builder);
+    }
+
+    PhysicsEngine engine;
+    engine.setAccelerator(builder.build());
+    engine.setTimeStep(config.timeStep);
+
+    ParticleSystem& particles = engine.getParticleSystem();
+    particles.getParticles() = beam.getParticles();
+    particles.updateSpeciesBlocks();
+    particles.setReferenceMomentum(beam.getReferenceMomentum());
+
+    VariantResult result;
+    result.index = index;
+    for (; result.steps < config.steps; ++result.steps) {
+        if (result.steps % LOSS_CHECK_INTERVAL == 0 && particles.getActiveParticleCount() == 0) {
+            break;
+        }
+        engine.step();
+    }
+
+    BeamStatistics stats = particles.computeStatistics();
+    result.survivingParticles = stats.activeParticles;
+    result.lostParticles = stats.totalParticles - stats.activeParticles;
+    result.survival = stats.totalParticles > 0
+        ? static_cast<double>(stats.activeParticles) / static_cast<double>(stats.totalParticles)
+        : 0.0;
+    result.emittanceX = stats.emittanceX;
+    result.emittanceY = stats.emittanceY;
+    result.meanEnergy = stats.meanEnergy;
+    result.wallTime = timer.elapsedSeconds();
+    return result;
+}
+
+VariantSetup EnsembleRunner::gradientErrors(double relativeRms) {
+    return [relativeRms](VariantBuilder& builder) {
+        std::normal_distribution<double> error(0.0, relativeRms);
+        const auto& lattice = builder.getLattice();
+        for (size_t i = 0; i < lattice.getComponentCount(); ++i) {
+            if (lattice.getComponent(i)->getType() != accelerator::ComponentType::Quadrupole) {
+                continue;
+            }
+            auto quad = builder.modify<accelerator::Quadrupole>(i);
+            quad->setGradient(quad->getGradient() * (1.0 + error(builder.getRandom())));
+        }
+    };
+}
+
+VariantSetup EnsembleRunner::misalignments(double rms) {
+    return [rms](VariantBuilder& builder) {
+        std::normal_distribution<double> offset(0.0, rms);
+        const auto& lattice = builder.getLattice();
+        for (size_t i = 0; i < lattice.getComponentCount(); ++i) {
+            auto type = lattice.getComponent(i)->getType();
+            if (type != accelerator::ComponentType::Quadrupole &&
+                type != accelerator::ComponentType::Dipole) {
+                continue;
+            }
+            auto component = builder.modify(i);
+            glm::dvec3 position = component->getPosition();
+            position.x += offset(builder.getRandom());
+            position.y += offset(builder.getRandom());
+            component->setPosition(position);
+        }
+    };
+}
+
+VariantSetup EnsembleRunner::magnetErrors(accelerator::MagnetErrorTable table) {
+    return [table = std::move(table)](VariantBuilder& builder) {
+        accelerator::MagnetErrorTable variant = table;
+        variant.generate(builder.getLattice(), builder.getRandom()());
+        for (const auto& entry : variant.getEntries()) {
+            builder.modify<accelerator::Magnet>(entry.componentIndex)->setErrors(entry.errors);
+        }
+    };
+}
+
+VariantSetup EnsembleRunner::rfPhaseScan(double first, double step) {
+    return [first, step](VariantBuilder& builder) {
+        const double phase = first + static_cast<double>(builder.getIndex()) * step;
+        const auto& lattice = builder.getLattice();
+        for (size_t i = 0; i < lattice.getComponentCount(); ++i) {
+            if (lattice.getComponent(i)->getType() == accelerator::ComponentType::RFCavity) {
+                builder.modify<accelerator::RFCavity>(i)->setPhase(phase);
+            }
+        }
+    };
+}
+
+VariantSetup EnsembleRunner::combine(std::vector<VariantSetup> setups) {
+    return [setups = std::move(setups)](VariantBuilder& builder) {
+        for (const auto& setup : setups) {
+            if (setup) {
+                setup(builder);
+            }
+        }
+    };
+}
+
+} // namespace pas::physics
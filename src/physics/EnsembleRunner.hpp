@@ -0,0 +1,190 @@
+#pragma once
+
+#include "physics/ParticleSystem.hpp"
+#include "accelerator/Accelerator.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace pas::physics {
+
+/**
+ * @brief Lattice of one ensemble member under construction.
+ *
+ * Starts as a copy of the base lattice that shares every component with it.
+ * modify() swaps in a private clone on first use, so a variant only copies
+ * the magnets it changes. build() additionally clones components that record
+ * data (detectors, monitors) or whose field source is not current, so
+ * concurrent variants never write to a shared component. Ramps scale each
+ * engine's own placements and leave shared sources alone.
+ */
+class VariantBuilder {
+public:
+    VariantBuilder(const accelerator::Accelerator& base, size_t index, uint64_t seed);
+
+    /**
+     * @brief Index of the variant within the ensemble.
+     */
+    size_t getIndex() const { return m_index; }
+
+    /**
+     * @brief Random stream of this variant, seeded from the ensemble seed and index.
+     */
+    std::mt19937_64& getRandom() { return m_random; }
+
+    /**
+     * @brief Variant lattice; components not modified are shared with the base.
+     */
+    const accelerator::Accelerator& getLattice() const { return *m_lattice; }
+
+    /**
+     * @brief Get a private, modifiable copy of a component.
+     * @return nullptr if the index is out of range.
+     */
+    std::shared_ptr<accelerator::Component> modify(size_t componentIndex);
+
+    /**
+     * @brief Typed variant of modify(); nullptr if the component has another type.
+     */
+    template <typename T>
+    std::shared_ptr<T> modify(size_t componentIndex) {
+        return std::dynamic_pointer_cast<T>(modify(componentIndex));
+    }
+
+    /**
+     * @brief Check if a component was copied for this variant.
+     */
+    bool isModified(size_t componentIndex) const { return m_owned[componentIndex]; }
+
+    /**
+     * @brief Finish the variant lattice.
+     */
+    std::shared_ptr<accelerator::Accelerator> build();
+
+private:
+    std::shared_ptr<accelerator::Accelerator> m_lattice;
+    std::vector<bool> m_owned;
+    size_t m_index;
+    std::mt19937_64 m_random;
+};
+
+/**
+ * @brief Applies the errors or settings of one variant.
+ *
+ * Called concurrently for different variants; it must only touch its builder.
+ */
+using VariantSetup = std::function<void(VariantBuilder& builder)>;
+
+/**
+ * @brief Settings of an ensemble run.
+ */
+struct EnsembleConfig {
+    size_t variants = 1;
+    uint64_t steps = 1000;          // Integration steps per variant
+    double timeStep = 1e-11;        // s
+    uint64_t seed = 1;              // Base seed of the per-variant error streams
+    size_t threads = 0;             // Concurrent variants; 0 uses all available threads
+    std::string outputPath;         // CSV appended as variants finish; empty for none
+};
+
+/**
+ * @brief Outcome of one ensemble member.
+ */
+struct VariantResult {
+    size_t index = 0;
+    uint64_t steps = 0;             // Steps tracked (fewer if the beam was lost)
+    size_t survivingParticles = 0;
+    size_t lostParticles = 0;
+    double survival = 0.0;          // Surviving fraction
+    double emittanceX = 0.0;        // Geometric rms emittance at the end [m rad]
+    double emittanceY = 0.0;
+    double meanEnergy = 0.0;        // J
+    double wallTime = 0.0;          // s
+};
+
+/**
+ * @brief Aggregated outcome of an ensemble run.
+ */
+struct EnsembleResult {
+    std::vector<VariantResult> variants;    // Sorted by index
+    double meanSurvival = 0.0;
+    double minSurvival = 0.0;
+    double maxSurvival = 0.0;
+    double meanEmittanceX = 0.0;
+    double meanEmittanceY = 0.0;
+    double wallTime = 0.0;                  // s
+
+    /**
+     * @brief Export all variants as CSV.
+     */
+    bool exportCSV(const std::string& filepath) const;
+};
+
+/**
+ * @brief Runs many lattice variants with the same beam on a thread pool.
+ *
+ * The beam is generated once and copied into a private PhysicsEngine per
+ * variant. Variants run concurrently, one per pool worker, with OpenMP
+ * limited to one thread inside each so the machine is saturated without
+ * oversubscription. Finished variants are streamed to the result callback
+ * and the CSV output as they complete.
+ */
+class EnsembleRunner {
+public:
+    /**
+     * @brief Called once per finished variant, never concurrently.
+     */
+    using ResultCallback = std::function<void(const VariantResult&)>;
+
+    EnsembleRunner(std::shared_ptr<const accelerator::Accelerator> base, BeamParameters beam);
+
+    /**
+     * @brief Run all variants.
+     * @param setup Applied to each variant before tracking; may be empty.
+     * @param onResult Optional callback for streaming results.
+     */
+    EnsembleResult run(const EnsembleConfig& config, const VariantSetup& setup,
+                       const ResultCallback& onResult = {}) const;
+
+    // Common sweeps
+
+    /**
+     * @brief Gaussian relative gradient errors on every quadrupole.
+     */
+    static VariantSetup gradientErrors(double relativeRms);
+
+    /**
+     * @brief Gaussian transverse offsets of every dipole and quadrupole [m].
+     */
+    static VariantSetup misalignments(double rms);
+
+    /**
+     * @brief Multipole and alignment errors drawn from the table's families.
+     *
+     * Each variant generates its own table from its random stream.
+     */
+    static VariantSetup magnetErrors(accelerator::MagnetErrorTable table);
+
+    /**
+     * @brief RF phase scan: every cavity gets first + index * step [rad].
+     */
+    static VariantSetup rfPhaseScan(double first, double step);
+
+    /**
+     * @brief Apply several setups in order.
+     */
+    static VariantSetup combine(std::vector<VariantSetup> setups);
+
+private:
+    VariantResult runVariant(const EnsembleConfig& config, const VariantSetup& setup,
+                             size_t index, const ParticleSystem& beam) const;
+
+    std::shared_ptr<const accelerator::Accelerator> m_base;
+    BeamParameters m_beam;
+};
+
+} // namespace pas::physics
@@ -2,6 +2,7 @@
 #include "physics/Constants.hpp"
 #include <cmath>
 #include <algorithm>
+#include <type_traits>
 
 namespace pas::physics {
 
@@ -10,6 +11,7 @@ using namespace constants;
 // EulerIntegrator implementation
 
 void EulerIntegrator::step(Particle& particle,
+                           const Species& species,
                            const EMFieldManager& fieldManager,
                            double time,
                            double dt) {
@@ -25,8 +27,7 @@ void EulerIntegrator::step(Particle& particle,
     glm::dvec3 vel = particle.getVelocity();
 
     // Lorentz force: F = q(E + v x B)
-    double q = particle.getCharge();
-    glm::dvec3 force = q * (field.E + glm::cross(vel, field.B));
+    glm::dvec3 force = species.charge * (field.E + glm::cross(vel, field.B));
 
     // Update momentum: dp = F * dt
     glm::dvec3 newMom = mom + force * dt;
@@ -41,6 +42,7 @@ void EulerIntegrator::step(Particle& particle,
 // VelocityVerletIntegrator implementation
 
 void VelocityVerletIntegrator::step(Particle& particle,
+                                    const Species& species,
                                     const EMFieldManager& fieldManager,
                                     double time,
                                     double dt) {
@@ -48,16 +50,14 @@ void VelocityVerletIntegrator::step(Particle& particle,
 
     glm::dvec3 pos = particle.getPosition();
     glm::dvec3 mom = particle.getMomentum();
-    double q = particle.getCharge();
-    double m = particle.getMass();
 
     // Evaluate field at current position
     FieldValue field = fieldManager.evaluate(pos, time);
 
     // Calculate current velocity and acceleration
     glm::dvec3 vel = particle.getVelocity();
-    glm::dvec3 force = q * (field.E + glm::cross(vel, field.B));
-    glm::dvec3 acc = force / (particle.getGamma() * m);
+    glm::dvec3 force = species.charge * (field.E + glm::cross(vel, field.B));
+    glm::dvec3 acc = force / (particle.getGamma() * species.mass);
 
     // Half-step position update: x' = x + v*dt/2 + a*dt^2/4
     glm::dvec3 halfPos = pos + vel * (dt * 0.5);
@@ -77,6 +77,7 @@ void VelocityVerletIntegrator::step(Particle& particle,
 // BorisIntegrator implementation
 
 void BorisIntegrator::step(Particle& particle,
+                           const Species& species,
                            const EMFieldManager& fieldManager,
                            double time,
                            double dt) {
@@ -84,8 +85,8 @@ void BorisIntegrator::step(Particle& particle,
 
     glm::dvec3 pos = particle.getPosition();
     glm::dvec3 mom = particle.getMomentum();
-    double q = particle.getCharge();
-    double m = particle.getMass();
+    const double q = species.charge;
+    const double m = species.mass;
 
     // Evaluate field at current position
     FieldValue field = fieldManager.evaluate(pos, time);
@@ -94,11 +95,11 @@ void BorisIntegrator::step(Particle& particle,
     glm::dvec3 momMinus = mom + q * field.E * (dt * 0.5);
 
     // Calculate gamma for magnetic rotation
-    double pMag = glm::length(momMinus);
-    double gamma = std::sqrt(1.0 + (pMag / (m * c)) * (pMag / (m * c)));
+    double pOverMc = glm::length(momMinus) / species.massTimesC;
+    double gamma = std::sqrt(1.0 + pOverMc * pOverMc);
 
     // Boris rotation vectors
-    glm::dvec3 t = (q * field.B * dt) / (2.0 * gamma * m);
+    glm::dvec3 t = field.B * (species.chargeOverMass * dt / (2.0 * gamma));
     double tMag2 = glm::dot(t, t);
     glm::dvec3 s = (2.0 * t) / (1.0 + tMag2);
 
@@ -125,32 +126,30 @@ void BorisIntegrator::step(Particle& particle,
 // RK4Integrator implementation
 
 RK4Integrator::State RK4Integrator::evaluateDerivative(
-    const Particle& particle,
+    const Species& species,
     const glm::dvec3& position,
     const glm::dvec3& momentum,
     const EMFieldManager& fieldManager,
     double time) const {
 
-    double m = particle.getMass();
-    double q = particle.getCharge();
-
     // Calculate gamma from momentum
-    double pMag = glm::length(momentum);
-    double gamma = std::sqrt(1.0 + (pMag / (m * c)) * (pMag / (m * c)));
+    double pOverMc = glm::length(momentum) / species.massTimesC;
+    double gamma = std::sqrt(1.0 + pOverMc * pOverMc);
 
     // Velocity from momentum
-    glm::dvec3 vel = momentum / (gamma * m);
+    glm::dvec3 vel = momentum / (gamma * species.mass);
 
     // Evaluate field
     FieldValue field = fieldManager.evaluate(position, time);
 
     // Lorentz force
-    glm::dvec3 force = q * (field.E + glm::cross(vel, field.B));
+    glm::dvec3 force = species.charge * (field.E + glm::cross(vel, field.B));
 
     return State{vel, force};
 }
 
 void RK4Integrator::step(Particle& particle,
+                         const Species& species,
                          const EMFieldManager& fieldManager,
                          double time,
                          double dt) {
@@ -160,22 +159,22 @@ void RK4Integrator::step(Particle& particle,
     glm::dvec3 mom = particle.getMomentum();
 
     // k1
-    State k1 = evaluateDerivative(particle, pos, mom, fieldManager, time);
+    State k1 = evaluateDerivative(species, pos, mom, fieldManager, time);
 
     // k2
     glm::dvec3 pos2 = pos + k1.position * (dt * 0.5);
     glm::dvec3 mom2 = mom + k1.momentum * (dt * 0.5);
-    State k2 = evaluateDerivative(particle, pos2, mom2, fieldManager, time + dt * 0.5);
+    State k2 = evaluateDerivative(species, pos2, mom2, fieldManager, time + dt * 0.5);
 
     // k3
     glm::dvec3 pos3 = pos + k2.position * (dt * 0.5);
     glm::dvec3 mom3 = mom + k2.momentum * (dt * 0.5);
-    State k3 = evaluateDerivative(particle, pos3, mom3, fieldManager, time + dt * 0.5);
+    State k3 = evaluateDerivative(species, pos3, mom3, fieldManager, time + dt * 0.5);
 
     // k4
     glm::dvec3 pos4 = pos + k3.position * dt;
     glm::dvec3 mom4 = mom + k3.momentum * dt;
-    State k4 = evaluateDerivative(particle, pos4, mom4, fieldManager, time + dt);
+    State k4 = evaluateDerivative(species, pos4, mom4, fieldManager, time + dt);
 
     // Combine
     glm::dvec3 newPos = pos + (k1.position + 2.0 * k2.position + 2.0 * k3.position + k4.position) * (dt / 6.0);
@@ -185,6 +184,122 @@ void RK4Integrator::step(Particle& particle,
     particle.setMomentum(newMom);
 }
 
+// BorisPusher and RK4Pusher implementation
+
+namespace {
+
+template <typename Real>
+BasicFieldValue<Real> evaluateField(const EMFieldManager& fieldManager,
+                                    const glm::vec<3, Real>& position,
+                                    double time) {
+    if constexpr (std::is_same_v<Real, float>) {
+        return fieldManager.evaluateFloat(position, time);
+    } else {
+        return fieldManager.evaluate(position, time);
+    }
+}
+
+} // namespace
+
+template <typename Policy>
+void BorisPusher<Policy>::step(State& position,
+                               State& momentum,
+                               const Species& species,
+                               const EMFieldManager& fieldManager,
+                               double time,
+                               double dt) {
+    using Real = typename Policy::Real;
+    using Vec = typename Policy::Vec;
+
+    // Species constants, folded in double before rounding
+    const Real electric = static_cast<Real>(species.charge * dt * 0.5 / species.massTimesC);
+    const Real magnetic = static_cast<Real>(species.chargeOverMass * dt * 0.5);
+    const Real distance = static_cast<Real>(c * dt);
+
+    // Evaluate field at current position
+    const BasicFieldValue<Real> field = evaluateField(fieldManager, Vec(position), time);
+    const Vec u0(momentum);
+
+    // Half-step electric push
+    const Vec uMinus = u0 + field.E * electric;
+
+    // Boris rotation (t = q B dt / (2 gamma m))
+    const Real gamma = std::sqrt(Real(1) + glm::dot(uMinus, uMinus));
+    const Vec t = field.B * (magnetic / gamma);
+    const Vec s = t * (Real(2) / (Real(1) + glm::dot(t, t)));
+    const Vec uPrime = uMinus + glm::cross(uMinus, t);
+    const Vec uPlus = uMinus + glm::cross(uPrime, s);
+
+    // Second half-step electric push
+    const Vec uNew = uPlus + field.E * electric;
+
+    // Position update using the new velocity
+    const Real gammaNew = std::sqrt(Real(1) + glm::dot(uNew, uNew));
+    const Vec dx = uNew * (distance / gammaNew);
+
+    // Increments are added in the accumulator type
+    momentum += State(uNew - u0);
+    position += State(dx);
+}
+
+template <typename Policy>
+void RK4Pusher<Policy>::step(State& position,
+                             State& momentum,
+                             const Species& species,
+                             const EMFieldManager& fieldManager,
+                             double time,
+                             double dt) {
+    using Real = typename Policy::Real;
+    using Accumulator = typename Policy::Accumulator;
+    using Vec = typename Policy::Vec;
+
+    // Changes over a full step: dx = beta c dt, du = q dt / (m c) E + q dt / m (beta x B)
+    const Real electric = static_cast<Real>(species.charge * dt / species.massTimesC);
+    const Real magnetic = static_cast<Real>(species.chargeOverMass * dt);
+    const Real distance = static_cast<Real>(c * dt);
+
+    struct Derivative {
+        State position;
+        State momentum;
+    };
+    auto evaluate = [&](const State& x, const State& w, double t) {
+        const BasicFieldValue<Real> field = evaluateField(fieldManager, Vec(x), t);
+        const Vec uw(w);
+        const Vec beta = uw / std::sqrt(Real(1) + glm::dot(uw, uw));
+        const Vec du = field.E * electric + glm::cross(beta, field.B) * magnetic;
+        return Derivative{State(beta * distance), State(du)};
+    };
+
+    const Accumulator half(0.5);
+    const State pos = position;
+    const State u = momentum;
+
+    // k1
+    Derivative k1 = evaluate(pos, u, time);
+
+    // k2
+    Derivative k2 = evaluate(pos + k1.position * half, u + k1.momentum * half, time + dt * 0.5);
+
+    // k3
+    Derivative k3 = evaluate(pos + k2.position * half, u + k2.momentum * half, time + dt * 0.5);
+
+    // k4
+    Derivative k4 = evaluate(pos + k3.position, u + k3.momentum, time + dt);
+
+    // Combine
+    const Accumulator two(2.0);
+    const Accumulator sixth(1.0 / 6.0);
+    position = pos + (k1.position + k2.position * two + k3.position * two + k4.position) * sixth;
+    momentum = u + (k1.momentum + k2.momentum * two + k3.momentum * two + k4.momentum) * sixth;
+}
+
+template struct BorisPusher<DoublePrecision>;
+template struct BorisPusher<FloatPrecision>;
+template struct BorisPusher<MixedPrecision>;
+template struct RK4Pusher<DoublePrecision>;
+template struct RK4Pusher<FloatPrecision>;
+template struct RK4Pusher<MixedPrecision>;
+
 // IntegratorFactory implementation
 
 std::unique_ptr<Integrator> IntegratorFactory::create(Type type) {
@@ -7,6 +7,35 @@
 
 namespace pas::physics {
 
+/**
+ * @brief Arithmetic precision of the Boris and RK4 pushers.
+ */
+enum class Precision {
+    Double,  // Reference: all arithmetic and state in double
+    Float,   // Float arithmetic and field evaluation; state kept in float
+    Mixed    // Float arithmetic and field evaluation; state accumulated in double
+};
+
+/**
+ * @brief Precision policy for the templated pushers.
+ *
+ * Real is the type of the per-step arithmetic (field evaluation, Lorentz
+ * force, Boris rotation, RK4 stages); Accumulator the type the position and
+ * momentum are kept in from step to step, to which each step's increment is
+ * added.
+ */
+template <typename RealT, typename AccumulatorT>
+struct PrecisionPolicy {
+    using Real = RealT;
+    using Accumulator = AccumulatorT;
+    using Vec = glm::vec<3, RealT>;
+    using State = glm::vec<3, AccumulatorT>;
+};
+
+using DoublePrecision = PrecisionPolicy<double, double>;
+using FloatPrecision = PrecisionPolicy<float, float>;
+using MixedPrecision = PrecisionPolicy<float, double>;
+
 /**
  * @brief Abstract interface for numerical integrators.
  *
@@ -24,7 +53,22 @@ public:
      * @param time Current simulation time.
      * @param dt Time step in seconds.
      */
+    void step(Particle& particle,
+              const EMFieldManager& fieldManager,
+              double time,
+              double dt) {
+        step(particle, particle.getSpeciesProperties(), fieldManager, time, dt);
+    }
+
+    /**
+     * @brief Advance a particle whose species the caller has already looked up.
+     *
+     * Loops over a block of one species fetch its properties once and pass
+     * them here, so mass, charge, q/m and m*c are loop constants.
+     * @param species Properties of the particle's species.
+     */
     virtual void step(Particle& particle,
+                      const Species& species,
                       const EMFieldManager& fieldManager,
                       double time,
                       double dt) = 0;
@@ -47,7 +91,9 @@ public:
  */
 class EulerIntegrator : public Integrator {
 public:
+    using Integrator::step;
     void step(Particle& particle,
+              const Species& species,
               const EMFieldManager& fieldManager,
               double time,
               double dt) override;
@@ -63,7 +109,9 @@ public:
  */
 class VelocityVerletIntegrator : public Integrator {
 public:
+    using Integrator::step;
     void step(Particle& particle,
+              const Species& species,
               const EMFieldManager& fieldManager,
               double time,
               double dt) override;
@@ -86,7 +134,9 @@ public:
  */
 class BorisIntegrator : public Integrator {
 public:
+    using Integrator::step;
     void step(Particle& particle,
+              const Species& species,
               const EMFieldManager& fieldManager,
               double time,
               double dt) override;
@@ -102,7 +152,9 @@ public:
  */
 class RK4Integrator : public Integrator {
 public:
+    using Integrator::step;
     void step(Particle& particle,
+              const Species& species,
               const EMFieldManager& fieldManager,
               double time,
               double dt) override;
@@ -117,13 +169,66 @@ private:
         glm::dvec3 momentum;
     };
 
-    State evaluateDerivative(const Particle& particle,
+    State evaluateDerivative(const Species& species,
                              const glm::dvec3& position,
                              const glm::dvec3& momentum,
                              const EMFieldManager& fieldManager,
                              double time) const;
 };
 
+/**
+ * @brief Boris pusher with configurable arithmetic precision.
+ *
+ * Same algorithm as BorisIntegrator on bare state vectors, with the momentum
+ * as u = p / (m c) so float arithmetic stays far from its range limits.
+ * Positions must be small, i.e. relative to the reference orbit (see
+ * OrbitCoordinates): float resolves about 0.1 um at 1 m but 0.1 mm at 1 km.
+ * With a float Real the fields come from EMFieldManager::evaluateFloat().
+ */
+template <typename Policy>
+struct BorisPusher {
+    using State = typename Policy::State;
+
+    /**
+     * @brief Advance position [m] and momentum u = p / (m c) by one time step.
+     */
+    static void step(State& position,
+                     State& momentum,
+                     const Species& species,
+                     const EMFieldManager& fieldManager,
+                     double time,
+                     double dt);
+};
+
+/**
+ * @brief 4th order Runge-Kutta pusher with configurable arithmetic precision.
+ *
+ * Same algorithm as RK4Integrator on bare state vectors, with the momentum
+ * as u = p / (m c); stage states and the final weighted sum are formed in
+ * the accumulator type. Positions must be small, as for BorisPusher.
+ */
+template <typename Policy>
+struct RK4Pusher {
+    using State = typename Policy::State;
+
+    /**
+     * @brief Advance position [m] and momentum u = p / (m c) by one time step.
+     */
+    static void step(State& position,
+                     State& momentum,
+                     const Species& species,
+                     const EMFieldManager& fieldManager,
+                     double time,
+                     double dt);
+};
+
+extern template struct BorisPusher<DoublePrecision>;
+extern template struct BorisPusher<FloatPrecision>;
+extern template struct BorisPusher<MixedPrecision>;
+extern template struct RK4Pusher<DoublePrecision>;
+extern template struct RK4Pusher<FloatPrecision>;
+extern template struct RK4Pusher<MixedPrecision>;
+
 /**
  * @brief Factory for creating integrators by name.
  */
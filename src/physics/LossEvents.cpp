@@ -0,0 +1,102 @@
+#include "physics/LossEvents.hpp"
+#include "utils/Parallel.hpp"
+#include <algorithm>
+
+namespace pas::physics {
+
+LossEventBuffer::Subscription::Subscription(Subscription&& other) noexcept
+    : m_subscribers(std::move(other.m_subscribers))
+    , m_id(other.m_id) {
+    other.m_subscribers.reset();
+}
+
+LossEventBuffer::Subscription& LossEventBuffer::Subscription::operator=(Subscription&& other) noexcept {
+    if (this != &other) {
+        reset();
+        m_subscribers = std::move(other.m_subscribers);
+        m_id = other.m_id;
+        other.m_subscribers.reset();
+    }
+    return *this;
+}
+
+void LossEventBuffer::Subscription::reset() {
+    if (auto subscribers = m_subscribers.lock()) {
+        std::erase_if(*subscribers, [this](const auto& entry) { return entry.first == m_id; });
+    }
+    m_subscribers.reset();
+}
+
+LossEventBuffer::LossEventBuffer()
+    : m_subscribers(std::make_shared<Subscribers>()) {
+    prepare(1);
+}
+
+void LossEventBuffer::prepare(int threadCount) {
+    size_t count = static_cast<size_t>(std::max(threadCount, 1));
+    if (m_threadBuffers.size() < count) {
+        m_threadBuffers.resize(count);
+    }
+}
+
+void LossEventBuffer::record(const LossEvent& event) {
+    size_t index = static_cast<size_t>(utils::getThreadIndex());
+    m_threadBuffers[index].events.push_back(event);
+}
+
+size_t LossEventBuffer::drain() {
+    m_batch.clear();
+    for (auto& buffer : m_threadBuffers) {
+        m_batch.insert(m_batch.end(), buffer.events.begin(), buffer.events.end());
+        buffer.events.clear();
+    }
+
+    if (m_batch.empty()) {
+        return 0;
+    }
+
+    std::sort(m_batch.begin(), m_batch.end(),
+              [](const LossEvent& a, const LossEvent& b) { return a.particleId < b.particleId; });
+
+    std::span<const LossEvent> batch(m_batch);
+    for (const auto& [id, callback] : *m_subscribers) {
+        callback(batch);
+    }
+    return m_batch.size();
+}
+
+LossEventBuffer::SubscriptionId LossEventBuffer::subscribe(BatchCallback callback) {
+    SubscriptionId id = m_nextSubscriptionId++;
+    if (callback) {
+        m_subscribers->emplace_back(id, std::move(callback));
+    }
+    return id;
+}
+
+LossEventBuffer::Subscription LossEventBuffer::subscribeScoped(BatchCallback callback) {
+    return Subscription(m_subscribers, subscribe(std::move(callback)));
+}
+
+void LossEventBuffer::unsubscribe(SubscriptionId id) {
+    m_subscribers->erase(
+        std::remove_if(m_subscribers->begin(), m_subscribers->end(),
+                       [id](const auto& entry) { return entry.first == id; }),
+        m_subscribers->end()
+    );
+}
+
+size_t LossEventBuffer::getPendingCount() const {
+    size_t count = 0;
+    for (const auto& buffer : m_threadBuffers) {
+        count += buffer.events.size();
+    }
+    return count;
+}
+
+void LossEventBuffer::clear() {
+    for (auto& buffer : m_threadBuffers) {
+        buffer.events.clear();
+    }
+}
+
+} // namespace pas::physics
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace pas::physics {
+
+/**
+ * @brief Record of a single particle loss.
+ */
+struct LossEvent {
+    static constexpr size_t NoComponent = std::numeric_limits<size_t>::max();
+
+    uint64_t particleId = 0;
+    double time = 0.0;                      // Simulation time of the loss [s]
+    double sPosition = 0.0;                 // Longitudinal position [m]
+    glm::dvec3 position{0.0};               // Global position [m]
+    glm::dvec3 momentum{0.0};               // Momentum at loss [kg*m/s]
+    size_t componentIndex = NoComponent;    // Lattice index, NoComponent if outside
+};
+
+/**
+ * @brief Collects loss events from parallel tracking and publishes them in batches.
+ *
+ * Each thread appends to its own buffer, so recording never locks or contends.
+ * After a step the buffers are drained on the calling thread and every
+ * subscriber receives the merged batch, ordered by particle ID so results do
+ * not depend on thread scheduling.
+ */
+class LossEventBuffer {
+    using Subscribers = std::vector<std::pair<size_t, std::function<void(std::span<const LossEvent>)>>>;
+
+public:
+    using BatchCallback = std::function<void(std::span<const LossEvent>)>;
+    using SubscriptionId = size_t;
+
+    /**
+     * @brief Subscription that removes itself when destroyed or reset.
+     *
+     * Refers to the buffer's subscriber list weakly, so it may outlive the
+     * buffer (and the engine holding it); it is then simply inactive.
+     */
+    class Subscription {
+    public:
+        Subscription() = default;
+        ~Subscription() { reset(); }
+
+        Subscription(Subscription&& other) noexcept;
+        Subscription& operator=(Subscription&& other) noexcept;
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+
+        /**
+         * @brief Remove the subscriber if its buffer still exists.
+         */
+        void reset();
+
+        /**
+         * @brief Check whether the subscriber is still registered.
+         */
+        bool isActive() const { return !m_subscribers.expired(); }
+
+    private:
+        friend class LossEventBuffer;
+        Subscription(std::weak_ptr<Subscribers> subscribers, SubscriptionId id)
+            : m_subscribers(std::move(subscribers)), m_id(id) {}
+
+        std::weak_ptr<Subscribers> m_subscribers;
+        SubscriptionId m_id = 0;
+    };
+
+    LossEventBuffer();
+
+    // Subscriptions refer to this buffer's subscriber list
+    LossEventBuffer(const LossEventBuffer&) = delete;
+    LossEventBuffer& operator=(const LossEventBuffer&) = delete;
+
+    /**
+     * @brief Size the per-thread buffers. Call outside of parallel regions.
+     * @param threadCount Number of threads that may call record().
+     */
+    void prepare(int threadCount);
+
+    /**
+     * @brief Record a loss from the calling thread.
+     */
+    void record(const LossEvent& event);
+
+    /**
+     * @brief Merge per-thread buffers and publish the batch to subscribers.
+     * @return Number of events in the published batch.
+     */
+    size_t drain();
+
+    /**
+     * @brief Subscribe to loss batches.
+     * @return Handle for unsubscribe().
+     */
+    SubscriptionId subscribe(BatchCallback callback);
+
+    /**
+     * @brief Subscribe for as long as the returned token lives.
+     *
+     * For subscribers that may outlive the buffer: the token is safe to
+     * reset or destroy after the buffer is gone.
+     */
+    [[nodiscard]] Subscription subscribeScoped(BatchCallback callback);
+
+    /**
+     * @brief Remove a subscriber.
+     */
+    void unsubscribe(SubscriptionId id);
+
+    /**
+     * @brief Get the number of subscribers.
+     */
+    size_t getSubscriberCount() const { return m_subscribers->size(); }
+
+    /**
+     * @brief Get the number of recorded events not yet drained.
+     */
+    size_t getPendingCount() const;
+
+    /**
+     * @brief Discard pending events without publishing them.
+     */
+    void clear();
+
+private:
+    // Padded to a cache line so neighbouring threads don't false-share
+    struct alignas(64) ThreadBuffer {
+        std::vector<LossEvent> events;
+    };
+
+    std::vector<ThreadBuffer> m_threadBuffers;
+    std::vector<LossEvent> m_batch;
+    std::shared_ptr<Subscribers> m_subscribers;  // Shared weakly with Subscription tokens
+    SubscriptionId m_nextSubscriptionId = 0;
+};
+
+} // namespace pas::physics
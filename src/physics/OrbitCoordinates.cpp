@@ -0,0 +1,167 @@
+#include "physics/OrbitCoordinates.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace pas::physics {
+
+template <typename Real>
+void BasicOrbitCoordinates<Real>::resize(size_t count) {
+    m_entries.resize(count, 0);
+    m_turns.resize(count, 0);
+    m_x.resize(count, Real(0));
+    m_y.resize(count, Real(0));
+    m_z.resize(count, Real(0));
+    m_ux.resize(count, Real(0));
+    m_uy.resize(count, Real(0));
+    m_uz.resize(count, Real(0));
+    m_active.resize(count, 0);
+    m_ids.resize(count, NO_PARTICLE);
+}
+
+template <typename Real>
+void BasicOrbitCoordinates<Real>::sync(const std::vector<Particle>& particles) {
+    const bool unchanged = m_ids.size() == particles.size() &&
+                           std::equal(m_ids.begin(), m_ids.end(), particles.begin(),
+                                      [](uint64_t id, const Particle& p) { return id == p.getId(); });
+    if (unchanged) {
+        return;
+    }
+
+    std::unordered_map<uint64_t, size_t> slots;
+    slots.reserve(m_ids.size());
+    for (size_t i = 0; i < m_ids.size(); ++i) {
+        if (m_ids[i] != NO_PARTICLE) {
+            slots.emplace(m_ids[i], i);
+        }
+    }
+
+    BasicOrbitCoordinates synced;
+    synced.resize(particles.size());
+    for (size_t i = 0; i < particles.size(); ++i) {
+        auto slot = slots.find(particles[i].getId());
+        if (slot == slots.end()) {
+            continue;
+        }
+        const size_t from = slot->second;
+        synced.m_entries[i] = m_entries[from];
+        synced.m_turns[i] = m_turns[from];
+        synced.m_x[i] = m_x[from];
+        synced.m_y[i] = m_y[from];
+        synced.m_z[i] = m_z[from];
+        synced.m_ux[i] = m_ux[from];
+        synced.m_uy[i] = m_uy[from];
+        synced.m_uz[i] = m_uz[from];
+        synced.m_active[i] = m_active[from];
+        synced.m_ids[i] = m_ids[from];
+    }
+    *this = std::move(synced);
+}
+
+template <typename Real>
+void BasicOrbitCoordinates<Real>::assign(const std::vector<Particle>& particles,
+                                         const accelerator::CompiledLattice& lattice, bool closed) {
+    resize(particles.size());
+    std::fill(m_ids.begin(), m_ids.end(), NO_PARTICLE);
+    for (size_t i = 0; i < particles.size(); ++i) {
+        update(i, particles[i], lattice, closed);
+    }
+}
+
+template <typename Real>
+void BasicOrbitCoordinates<Real>::update(size_t index, const Particle& particle,
+                                         const accelerator::CompiledLattice& lattice, bool closed) {
+    m_active[index] = particle.isActive() ? 1 : 0;
+    if (!particle.isActive()) {
+        return;
+    }
+
+    const glm::dvec3& position = particle.getPosition();
+    const bool known = m_ids[index] == particle.getId();
+
+    // New particles start from their z, which is exact for straight lattices
+    size_t cursor = m_entries[index];
+    if (!known) {
+        cursor = lattice.findIndexAtS(position.z).value_or(0);
+        m_turns[index] = 0;
+        m_ids[index] = particle.getId();
+    }
+
+    const accelerator::OrbitPosition orbit = lattice.toOrbit(position, cursor, closed, m_turns[index]);
+    m_entries[index] = static_cast<uint32_t>(orbit.index);
+    // Walking back from the seed of a new particle is no turn; in a straight ring z past the end is
+    m_turns[index] = known ? m_turns[index] + orbit.wraps : std::max(orbit.wraps, 0);
+
+    const glm::dquat rotation = lattice.getReferenceFrame(orbit.index, m_turns[index]).rotation;
+    const glm::dvec3 momentum = glm::inverse(rotation) * particle.getMomentum() /
+                                particle.getSpeciesProperties().massTimesC;
+    setLocal(index, Vec(lattice.toFrame(orbit)), Vec(momentum));
+}
+
+template <typename Real>
+void BasicOrbitCoordinates<Real>::store(size_t index, Particle& particle,
+                                        const accelerator::CompiledLattice& lattice) const {
+    if (!m_active[index]) {
+        return;
+    }
+    const accelerator::Placement frame = lattice.getReferenceFrame(m_entries[index], m_turns[index]);
+    const double massTimesC = particle.getSpeciesProperties().massTimesC;
+    particle.setPosition(frame.toGlobal(glm::dvec3(getLocalPosition(index))));
+    particle.setMomentum(frame.rotation * glm::dvec3(getLocalMomentum(index)) * massTimesC);
+}
+
+template <typename Real>
+void BasicOrbitCoordinates<Real>::transfer(size_t index, const accelerator::CompiledLattice& lattice,
+                                           bool closed) {
+    const size_t last = lattice.size() - 1;
+    size_t entry = m_entries[index];
+    glm::dvec3 position(getLocalPosition(index));
+    glm::dvec3 momentum(getLocalMomentum(index));
+
+    // Walk one way only, so rounding at a shared boundary cannot ping-pong
+    int direction = 0;
+    for (size_t step = 0; step <= 2 * last + 1; ++step) {
+        if (direction >= 0 && (entry < last || closed)) {
+            // Past the exit: at or beyond the next entrance plane
+            const accelerator::Placement& next = lattice.getTransfer(entry);
+            const glm::dvec3 exit = next.rotation * glm::dvec3(0.0, 0.0, 1.0);
+            if (glm::dot(position - next.origin, exit) >= 0.0) {
+                const glm::dquat inverse = glm::inverse(next.rotation);
+                position = inverse * (position - next.origin);
+                momentum = inverse * momentum;
+                direction = 1;
+                if (entry == last) {
+                    entry = 0;
+                    ++m_turns[index];
+                } else {
+                    ++entry;
+                }
+                continue;
+            }
+        }
+        if (direction <= 0 && position.z < 0.0 && (entry > 0 || closed)) {
+            direction = -1;
+            if (entry == 0) {
+                entry = last;
+                --m_turns[index];
+            } else {
+                --entry;
+            }
+            const accelerator::Placement& previous = lattice.getTransfer(entry);
+            position = previous.toGlobal(position);
+            momentum = previous.rotation * momentum;
+            continue;
+        }
+        break;
+    }
+
+    if (direction != 0) {
+        m_entries[index] = static_cast<uint32_t>(entry);
+        setLocal(index, Vec(position), Vec(momentum));
+    }
+}
+
+template class BasicOrbitCoordinates<double>;
+template class BasicOrbitCoordinates<float>;
+
+} // namespace pas::physics
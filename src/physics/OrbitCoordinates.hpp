@@ -0,0 +1,194 @@
+#pragma once
+
+#include "physics/Particle.hpp"
+#include "accelerator/CompiledLattice.hpp"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace pas::physics {
+
+/**
+ * @brief Particle state relative to the reference orbit, pushed by the integrators.
+ *
+ * Entry i holds particle i in the reference frame of the lattice entry it
+ * is in: the position (x, y, z) from the entrance, with z along the orbit
+ * there, and the momentum as u = p / (m c) in the same frame. These stay at
+ * the scale of the beam and the element lengths anywhere in a kilometre-scale
+ * ring, where global positions need every digit of a double to resolve
+ * millimetres. The frames are Cartesian, so the integrators push the state
+ * unchanged with fields placed in the same frame (see PhysicsEngine); after
+ * each push transfer() carries a particle that left its entry into the next
+ * one. The entry index and the turn number place the frame in the ring.
+ *
+ * The arrays are laid out per quantity, so a tracking loop streams through
+ * only what it reads. The global state in the Particle vector is converted
+ * with update() and store() when a run of steps starts and ends, for
+ * rendering, statistics and export.
+ *
+ * Each particle keeps its entry as a cursor, so update() usually transforms
+ * into one frame. Particles are matched by ID: sync() carries every slot
+ * along when the particle vector is compacted or reordered, and only a
+ * particle not seen before is located from scratch.
+ *
+ * Real is the storage type of the position and momentum. In float a
+ * particle takes 41 bytes instead of 65, and positions within an entry
+ * still resolve about 1 um over 10 m; frame changes in update(), store()
+ * and transfer() are done in double.
+ */
+template <typename Real>
+class BasicOrbitCoordinates {
+public:
+    using Vec = glm::vec<3, Real>;
+
+    /**
+     * @brief Resize to a particle count; new slots are located on their next update().
+     */
+    void resize(size_t count);
+
+    /**
+     * @brief Match the slots to the particle vector by ID.
+     *
+     * Particles that moved, e.g. when ParticleSystem::removeInactiveParticles()
+     * compacts the vector, keep their entry and turn count; new ones are
+     * located from scratch on their next update(). Costs one ID comparison
+     * per particle when nothing moved.
+     */
+    void sync(const std::vector<Particle>& particles);
+
+    /**
+     * @brief Locate every particle from scratch.
+     */
+    void assign(const std::vector<Particle>& particles, const accelerator::CompiledLattice& lattice,
+                bool closed);
+
+    /**
+     * @brief Take the global position, momentum and state of particle i.
+     *
+     * Starts from the particle's last entry and turn. Inactive particles are
+     * only marked inactive. Safe to call concurrently for different i.
+     */
+    void update(size_t index, const Particle& particle, const accelerator::CompiledLattice& lattice,
+                bool closed);
+
+    /**
+     * @brief Write the global position and momentum of particle i back.
+     *
+     * Does nothing for slots marked inactive. Safe to call concurrently for
+     * different i.
+     */
+    void store(size_t index, Particle& particle, const accelerator::CompiledLattice& lattice) const;
+
+    /**
+     * @brief Carry particle i into the entry its position is in.
+     *
+     * Moves through the frames of neighbouring entries with
+     * CompiledLattice::getTransfer() while the particle is past the exit or
+     * before the entrance of its entry, wrapping around rings like
+     * CompiledLattice::toOrbit(). Usually a single comparison.
+     */
+    void transfer(size_t index, const accelerator::CompiledLattice& lattice, bool closed);
+
+    size_t size() const { return m_entries.size(); }
+
+    /**
+     * @brief Position of particle i in the reference frame of its entry [m].
+     */
+    Vec getLocalPosition(size_t index) const {
+        return Vec(m_x[index], m_y[index], m_z[index]);
+    }
+
+    /**
+     * @brief Momentum of particle i in the reference frame of its entry, as p / (m c).
+     */
+    Vec getLocalMomentum(size_t index) const {
+        return Vec(m_ux[index], m_uy[index], m_uz[index]);
+    }
+
+    /**
+     * @brief Set the state of particle i in the frame of its current entry.
+     */
+    void setLocal(size_t index, const Vec& position, const Vec& momentum) {
+        m_x[index] = position.x;
+        m_y[index] = position.y;
+        m_z[index] = position.z;
+        m_ux[index] = momentum.x;
+        m_uy[index] = momentum.y;
+        m_uz[index] = momentum.z;
+    }
+
+    bool isActive(size_t index) const { return m_active[index] != 0; }
+    void setActive(size_t index, bool active) { m_active[index] = active ? 1 : 0; }
+
+    /**
+     * @brief Orbit coordinates (x, y, ds) of particle i.
+     */
+    accelerator::OrbitPosition getPosition(size_t index, const accelerator::CompiledLattice& lattice) const {
+        return lattice.fromFrame(m_entries[index], glm::dvec3(getLocalPosition(index)));
+    }
+
+    /**
+     * @brief s-position of particle i within the lattice [m].
+     */
+    double getS(size_t index, const accelerator::CompiledLattice& lattice) const {
+        return lattice.getSStarts()[m_entries[index]] + getPosition(index, lattice).ds;
+    }
+
+    /**
+     * @brief Path length of particle i including completed turns [m].
+     */
+    double getPathLength(size_t index, const accelerator::CompiledLattice& lattice,
+                         double circumference) const {
+        return static_cast<double>(m_turns[index]) * circumference + getS(index, lattice);
+    }
+
+    /**
+     * @brief Global position of particle i, for rendering and export.
+     */
+    glm::dvec3 toGlobal(size_t index, const accelerator::CompiledLattice& lattice) const {
+        return lattice.getReferenceFrame(m_entries[index], m_turns[index])
+            .toGlobal(glm::dvec3(getLocalPosition(index)));
+    }
+
+    /**
+     * @brief Global momentum of particle i, as p / (m c).
+     */
+    glm::dvec3 toGlobalMomentum(size_t index, const accelerator::CompiledLattice& lattice) const {
+        return lattice.getReferenceFrame(m_entries[index], m_turns[index]).rotation *
+               glm::dvec3(getLocalMomentum(index));
+    }
+
+    /**
+     * @brief ID of the particle slot i was located for.
+     */
+    uint64_t getId(size_t index) const { return m_ids[index]; }
+
+    const std::vector<uint32_t>& getEntries() const { return m_entries; }
+    const std::vector<int32_t>& getTurns() const { return m_turns; }
+    const std::vector<Real>& getX() const { return m_x; }
+    const std::vector<Real>& getY() const { return m_y; }
+    const std::vector<Real>& getZ() const { return m_z; }
+
+private:
+    static constexpr uint64_t NO_PARTICLE = ~uint64_t{0};
+
+    std::vector<uint32_t> m_entries;
+    std::vector<int32_t> m_turns;
+    std::vector<Real> m_x;
+    std::vector<Real> m_y;
+    std::vector<Real> m_z;
+    std::vector<Real> m_ux;
+    std::vector<Real> m_uy;
+    std::vector<Real> m_uz;
+    std::vector<uint8_t> m_active;
+    std::vector<uint64_t> m_ids;  // Particle each slot was located for
+};
+
+extern template class BasicOrbitCoordinates<double>;
+extern template class BasicOrbitCoordinates<float>;
+
+using OrbitCoordinates = BasicOrbitCoordinates<double>;
+using FloatOrbitCoordinates = BasicOrbitCoordinates<float>;  // For the float pushers
+
+} // namespace pas::physics
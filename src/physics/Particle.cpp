@@ -5,37 +5,45 @@ namespace pas::physics {
 
 using namespace constants;
 
-uint64_t Particle::s_nextId = 0;
+std::atomic<uint64_t> Particle::s_nextId{0};
 
 Particle::Particle(double mass, double charge,
                    const glm::dvec3& position,
                    const glm::dvec3& momentum)
+    : Particle(SpeciesTable::find(mass, charge), position, momentum) {
+}
+
+Particle::Particle(SpeciesId species,
+                   const glm::dvec3& position,
+                   const glm::dvec3& momentum)
     : m_position(position)
     , m_momentum(momentum)
-    , m_mass(mass)
-    , m_charge(charge)
-    , m_restEnergy(mass * c2)
     , m_gamma(1.0)
     , m_beta(0.0)
-    , m_active(true)
-    , m_id(s_nextId++) {
+    , m_id(s_nextId.fetch_add(1, std::memory_order_relaxed))
+    , m_species(species)
+    , m_active(true) {
     updateDerivedQuantities();
 }
 
+uint64_t Particle::reserveIds(size_t count) {
+    return s_nextId.fetch_add(count, std::memory_order_relaxed);
+}
+
 Particle Particle::electron(const glm::dvec3& position, const glm::dvec3& momentum) {
-    return Particle(m_e, -e, position, momentum);
+    return Particle(SpeciesTable::ELECTRON, position, momentum);
 }
 
 Particle Particle::positron(const glm::dvec3& position, const glm::dvec3& momentum) {
-    return Particle(m_e, e, position, momentum);
+    return Particle(SpeciesTable::POSITRON, position, momentum);
 }
 
 Particle Particle::proton(const glm::dvec3& position, const glm::dvec3& momentum) {
-    return Particle(m_p, e, position, momentum);
+    return Particle(SpeciesTable::PROTON, position, momentum);
 }
 
 Particle Particle::antiproton(const glm::dvec3& position, const glm::dvec3& momentum) {
-    return Particle(m_p, -e, position, momentum);
+    return Particle(SpeciesTable::ANTIPROTON, position, momentum);
 }
 
 void Particle::setMomentum(const glm::dvec3& momentum) {
@@ -64,13 +72,15 @@ double Particle::getMomentumMagnitude() const {
 
 glm::dvec3 Particle::getVelocity() const {
     // v = p / (gamma * m)
-    if (m_gamma > 0.0 && m_mass > 0.0) {
-        return m_momentum / (m_gamma * m_mass);
+    const double mass = getMass();
+    if (m_gamma > 0.0 && mass > 0.0) {
+        return m_momentum / (m_gamma * mass);
     }
     return glm::dvec3(0.0);
 }
 
 void Particle::setVelocity(const glm::dvec3& velocity) {
+    const double mass = getMass();
     double speed = glm::length(velocity);
     if (speed >= c) {
         // Clamp to just below speed of light
@@ -79,11 +89,11 @@ void Particle::setVelocity(const glm::dvec3& velocity) {
         speed = glm::length(clampedVelocity);
         m_beta = speed / c;
         m_gamma = relativistic::gammaFromBeta(m_beta);
-        m_momentum = m_gamma * m_mass * clampedVelocity;
+        m_momentum = m_gamma * mass * clampedVelocity;
     } else if (speed > 0.0) {
         m_beta = speed / c;
         m_gamma = relativistic::gammaFromBeta(m_beta);
-        m_momentum = m_gamma * m_mass * velocity;
+        m_momentum = m_gamma * mass * velocity;
     } else {
         m_beta = 0.0;
         m_gamma = 1.0;
@@ -96,16 +106,17 @@ double Particle::getSpeed() const {
 }
 
 double Particle::getTotalEnergy() const {
-    return m_gamma * m_restEnergy;
+    return m_gamma * getRestEnergy();
 }
 
 double Particle::getKineticEnergy() const {
-    return (m_gamma - 1.0) * m_restEnergy;
+    return (m_gamma - 1.0) * getRestEnergy();
 }
 
 void Particle::setKineticEnergy(double kineticEnergy, const glm::dvec3& direction) {
     // Calculate gamma from kinetic energy
-    m_gamma = 1.0 + kineticEnergy / m_restEnergy;
+    const Species& species = getSpeciesProperties();
+    m_gamma = 1.0 + kineticEnergy / species.restEnergy;
     m_beta = relativistic::betaFromGamma(m_gamma);
 
     // Determine direction
@@ -124,7 +135,7 @@ void Particle::setKineticEnergy(double kineticEnergy, const glm::dvec3& directio
     }
 
     // Calculate momentum magnitude: p = gamma * m * v = gamma * beta * m * c
-    double momentumMag = m_gamma * m_beta * m_mass * c;
+    double momentumMag = m_gamma * m_beta * species.massTimesC;
     m_momentum = dir * momentumMag;
 }
 
@@ -135,9 +146,10 @@ double Particle::getDelta(double referenceMomentum) const {
 
 void Particle::updateDerivedQuantities() {
     double p = getMomentumMagnitude();
-    if (p > 0.0 && m_mass > 0.0) {
+    const Species& species = getSpeciesProperties();
+    if (p > 0.0 && species.mass > 0.0) {
         // gamma = sqrt(1 + (p/(m*c))^2)
-        double pOverMc = p / (m_mass * c);
+        double pOverMc = p / species.massTimesC;
         m_gamma = std::sqrt(1.0 + pOverMc * pOverMc);
         m_beta = relativistic::betaFromGamma(m_gamma);
     } else {
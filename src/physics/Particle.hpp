@@ -2,14 +2,19 @@
 
 #include <glm/glm.hpp>
 #include "physics/Constants.hpp"
+#include "physics/Species.hpp"
+
+#include <atomic>
+#include <cstdint>
 
 namespace pas::physics {
 
 /**
  * @brief Represents a charged particle in 6D phase space.
  *
- * Tracks position (x, y, z), momentum (px, py, pz), and particle properties
- * (mass, charge). Provides relativistic calculations for gamma, beta, and energy.
+ * Tracks position (x, y, z), momentum (px, py, pz), and the particle's
+ * species; mass and charge live in the SpeciesTable. Provides relativistic
+ * calculations for gamma, beta, and energy.
  */
 class Particle {
 public:
@@ -19,11 +24,19 @@ public:
      * @param charge Electric charge in Coulombs.
      * @param position Initial position in meters.
      * @param momentum Initial momentum in kg*m/s.
+     * @throws std::length_error if the species is new and the SpeciesTable is full.
      */
     Particle(double mass, double charge,
              const glm::dvec3& position = glm::dvec3(0.0),
              const glm::dvec3& momentum = glm::dvec3(0.0));
 
+    /**
+     * @brief Construct a particle of a registered species.
+     */
+    explicit Particle(SpeciesId species,
+                      const glm::dvec3& position = glm::dvec3(0.0),
+                      const glm::dvec3& momentum = glm::dvec3(0.0));
+
     // Factory methods for common particle types
 
     /**
@@ -96,10 +109,12 @@ public:
      */
     double getSpeed() const;
 
-    // Particle properties (immutable)
-    double getMass() const { return m_mass; }
-    double getCharge() const { return m_charge; }
-    double getRestEnergy() const { return m_restEnergy; }
+    // Particle properties (immutable, shared by the species)
+    SpeciesId getSpecies() const { return m_species; }
+    const Species& getSpeciesProperties() const { return SpeciesTable::get(m_species); }
+    double getMass() const { return getSpeciesProperties().mass; }
+    double getCharge() const { return getSpeciesProperties().charge; }
+    double getRestEnergy() const { return getSpeciesProperties().restEnergy; }
 
     // Relativistic quantities (derived)
 
@@ -154,30 +169,37 @@ public:
      */
     uint64_t getId() const { return m_id; }
 
+    /**
+     * @brief Assign an ID obtained from reserveIds().
+     */
+    void setId(uint64_t id) { m_id = id; }
+
+    /**
+     * @brief Reserve a contiguous block of unique IDs. Thread-safe.
+     * @return First ID of the block.
+     */
+    static uint64_t reserveIds(size_t count);
+
 private:
     /**
      * @brief Recalculate derived quantities (gamma, beta) from momentum.
      */
     void updateDerivedQuantities();
 
-    static uint64_t s_nextId;
+    static std::atomic<uint64_t> s_nextId;
 
     // Phase space coordinates
     glm::dvec3 m_position;  // meters
     glm::dvec3 m_momentum;  // kg*m/s
 
-    // Particle properties
-    double m_mass;          // kg
-    double m_charge;        // Coulombs
-    double m_restEnergy;    // Joules
-
     // Derived relativistic quantities
     double m_gamma;         // Lorentz factor
     double m_beta;          // v/c
 
     // State
-    bool m_active;
     uint64_t m_id;
+    SpeciesId m_species;    // Index into the SpeciesTable
+    bool m_active;
 };
 
 } // namespace pas::physics
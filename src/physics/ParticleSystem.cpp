@@ -1,14 +1,123 @@
 #include "physics/ParticleSystem.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Random.hpp"
 #include <algorithm>
 #include <cmath>
+#include <random>
 
 namespace pas::physics {
 
 using namespace constants;
 
+namespace {
+
+// Particles per random stream; fixed so results do not depend on the thread count
+constexpr size_t GENERATION_BLOCK = 1024;
+
+// Relative tolerance for zero pivots in the Cholesky factorization
+constexpr double CHOLESKY_TOLERANCE = 1e-12;
+
+using Matrix6 = std::array<double, 36>;
+
+/**
+ * @brief Lower-triangular L with L L^T = sigma.
+ *
+ * Semi-definite matrices are accepted: a zero pivot gives a zero column.
+ * @return False if sigma is not symmetric positive semi-definite.
+ */
+bool choleskyDecompose(const Matrix6& sigma, Matrix6& L) {
+    L.fill(0.0);
+    double scale = 0.0;
+    for (int i = 0; i < 6; ++i) {
+        scale = std::max(scale, std::abs(sigma[i * 6 + i]));
+    }
+    const double tolerance = CHOLESKY_TOLERANCE * scale;
+
+    for (int j = 0; j < 6; ++j) {
+        double pivot = sigma[j * 6 + j];
+        for (int k = 0; k < j; ++k) {
+            pivot -= L[j * 6 + k] * L[j * 6 + k];
+        }
+        if (pivot < -tolerance) {
+            return false;
+        }
+        if (pivot <= tolerance) {
+            // Degenerate direction: the remaining column must vanish too
+            for (int i = j + 1; i < 6; ++i) {
+                double residual = sigma[i * 6 + j];
+                for (int k = 0; k < j; ++k) {
+                    residual -= L[i * 6 + k] * L[j * 6 + k];
+                }
+                if (std::abs(residual) > tolerance) {
+                    return false;
+                }
+            }
+            continue;
+        }
+
+        double diagonal = std::sqrt(pivot);
+        L[j * 6 + j] = diagonal;
+        for (int i = j + 1; i < 6; ++i) {
+            double value = sigma[i * 6 + j];
+            for (int k = 0; k < j; ++k) {
+                value -= L[i * 6 + k] * L[j * 6 + k];
+            }
+            L[i * 6 + j] = value / diagonal;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Random stream for one block of particles.
+ */
+struct UnitSampler {
+    std::mt19937_64 rng;
+    std::normal_distribution<double> normalDist{0.0, 1.0};
+    std::uniform_real_distribution<double> uniformDist{-1.0, 1.0};
+
+    explicit UnitSampler(uint64_t seed) : rng(seed) {}
+
+    /**
+     * @brief Draw six coordinates with zero mean and unit covariance.
+     */
+    void sample(BeamParameters::Distribution distribution, double (&u)[6]) {
+        switch (distribution) {
+            case BeamParameters::Distribution::Gaussian:
+                for (double& value : u) {
+                    value = normalDist(rng);
+                }
+                break;
+
+            case BeamParameters::Distribution::Uniform:
+                for (double& value : u) {
+                    value = uniformDist(rng) * std::sqrt(3.0);
+                }
+                break;
+
+            case BeamParameters::Distribution::Waterbag: {
+                // Uniform in a 6D ball; radius sqrt(8) gives unit variance per coordinate
+                double norm = 0.0;
+                for (double& value : u) {
+                    value = normalDist(rng);
+                    norm += value * value;
+                }
+                double uniform = 0.5 * (uniformDist(rng) + 1.0);
+                double radius = std::sqrt(8.0) * std::pow(uniform, 1.0 / 6.0);
+                double factor = norm > 0.0 ? radius / std::sqrt(norm) : 0.0;
+                for (double& value : u) {
+                    value *= factor;
+                }
+                break;
+            }
+        }
+    }
+};
+
+} // namespace
+
 ParticleSystem::ParticleSystem()
-    : m_referenceMomentum(0.0)
-    , m_rng(42) {
+    : m_referenceMomentum(0.0) {
 }
 
 Particle ParticleSystem::createParticle(BeamParameters::ParticleType type) {
@@ -26,97 +135,129 @@ Particle ParticleSystem::createParticle(BeamParameters::ParticleType type) {
     }
 }
 
-void ParticleSystem::generateBeam(const BeamParameters& params) {
-    clear();
-    m_particles.reserve(params.numParticles);
+std::array<double, 36> ParticleSystem::covarianceMatrix(const BeamParameters& params) {
+    if (params.matching == BeamParameters::Matching::SigmaMatrix) {
+        return params.sigmaMatrix;
+    }
+
+    Matrix6 sigma{};
+    auto at = [&sigma](int i, int j) -> double& { return sigma[i * 6 + j]; };
+
+    if (params.matching == BeamParameters::Matching::Twiss) {
+        double gammaX = (1.0 + params.alphaX * params.alphaX) / params.betaX;
+        double gammaY = (1.0 + params.alphaY * params.alphaY) / params.betaY;
+        at(0, 0) = params.emittanceX * params.betaX;
+        at(0, 1) = at(1, 0) = -params.emittanceX * params.alphaX;
+        at(1, 1) = params.emittanceX * gammaX;
+        at(2, 2) = params.emittanceY * params.betaY;
+        at(2, 3) = at(3, 2) = -params.emittanceY * params.alphaY;
+        at(3, 3) = params.emittanceY * gammaY;
+    } else {
+        at(0, 0) = params.sigmaX * params.sigmaX;
+        at(1, 1) = params.sigmaPx * params.sigmaPx;
+        at(2, 2) = params.sigmaY * params.sigmaY;
+        at(3, 3) = params.sigmaPy * params.sigmaPy;
+    }
+
+    double varDelta = params.sigmaDelta * params.sigmaDelta;
+    at(4, 4) = params.sigmaZ * params.sigmaZ;
+    at(5, 5) = varDelta;
+
+    if (params.matching == BeamParameters::Matching::Twiss) {
+        // x -> x + D delta, x' -> x' + D' delta
+        double D = params.dispersionX;
+        double Dp = params.dispersionPrimeX;
+        at(0, 0) += D * D * varDelta;
+        at(0, 1) += D * Dp * varDelta;
+        at(1, 0) = at(0, 1);
+        at(1, 1) += Dp * Dp * varDelta;
+        at(0, 5) = at(5, 0) = D * varDelta;
+        at(1, 5) = at(5, 1) = Dp * varDelta;
+    }
+    return sigma;
+}
 
-    // Seed RNG
-    m_rng.seed(params.seed);
+bool ParticleSystem::generateBeam(const BeamParameters& params) {
+    clear();
+    return appendBeam(params);
+}
 
-    // Create distributions
-    std::normal_distribution<double> normalDist(0.0, 1.0);
-    std::uniform_real_distribution<double> uniformDist(-1.0, 1.0);
+bool ParticleSystem::appendBeam(const BeamParameters& params) {
+    Matrix6 L;
+    if (!choleskyDecompose(covarianceMatrix(params), L)) {
+        PAS_ERROR("ParticleSystem: Beam covariance matrix is not positive semi-definite");
+        return false;
+    }
 
     // Create a reference particle to get mass
-    Particle refParticle = createParticle(params.particleType);
+    const Particle refParticle = createParticle(params.particleType);
     double mass = refParticle.getMass();
 
     // Calculate reference momentum from kinetic energy
     double gamma = relativistic::gammaFromKineticEnergy(params.kineticEnergy, mass);
     double beta = relativistic::betaFromGamma(gamma);
     double pRef = gamma * beta * mass * c;
-    m_referenceMomentum = pRef;
+    if (m_particles.empty()) {
+        m_referenceMomentum = pRef;
+    }
 
-    // Normalize direction
+    // Beam frame: longitudinal along the direction, transverse x horizontal where possible
     glm::dvec3 dir = glm::normalize(params.direction);
-
-    for (size_t i = 0; i < params.numParticles; ++i) {
-        Particle particle = createParticle(params.particleType);
-
-        // Generate position offset
-        double dx, dy, dz;
-        if (params.distribution == BeamParameters::Distribution::Gaussian) {
-            dx = normalDist(m_rng) * params.sigmaX;
-            dy = normalDist(m_rng) * params.sigmaY;
-            dz = normalDist(m_rng) * params.sigmaZ;
-        } else if (params.distribution == BeamParameters::Distribution::Uniform) {
-            dx = uniformDist(m_rng) * params.sigmaX * std::sqrt(3.0);
-            dy = uniformDist(m_rng) * params.sigmaY * std::sqrt(3.0);
-            dz = uniformDist(m_rng) * params.sigmaZ * std::sqrt(3.0);
-        } else {
-            // Waterbag: uniform in 6D phase space
-            double r = std::cbrt(std::abs(uniformDist(m_rng)));
-            double theta = std::acos(uniformDist(m_rng));
-            double phi = uniformDist(m_rng) * constants::pi;
-            dx = r * std::sin(theta) * std::cos(phi) * params.sigmaX;
-            dy = r * std::sin(theta) * std::sin(phi) * params.sigmaY;
-            dz = r * std::cos(theta) * params.sigmaZ;
-        }
-
-        glm::dvec3 position = params.positionOffset + glm::dvec3(dx, dy, dz);
-        particle.setPosition(position);
-
-        // Generate momentum deviation
-        double dpx, dpy, delta;
-        if (params.distribution == BeamParameters::Distribution::Gaussian) {
-            dpx = normalDist(m_rng) * params.sigmaPx;
-            dpy = normalDist(m_rng) * params.sigmaPy;
-            delta = normalDist(m_rng) * params.sigmaDelta;
-        } else {
-            dpx = uniformDist(m_rng) * params.sigmaPx * std::sqrt(3.0);
-            dpy = uniformDist(m_rng) * params.sigmaPy * std::sqrt(3.0);
-            delta = uniformDist(m_rng) * params.sigmaDelta * std::sqrt(3.0);
-        }
-
-        // Calculate actual momentum
-        double pMag = pRef * (1.0 + delta);
-
-        // Add transverse momentum components
-        // The main momentum is along the direction, with small transverse deviations
-        glm::dvec3 momentum = dir * pMag;
-
-        // Create perpendicular vectors for transverse momentum
-        glm::dvec3 perpX, perpY;
-        if (std::abs(dir.y) < 0.9) {
-            perpX = glm::normalize(glm::cross(dir, glm::dvec3(0, 1, 0)));
-        } else {
-            perpX = glm::normalize(glm::cross(dir, glm::dvec3(1, 0, 0)));
+    glm::dvec3 perpX;
+    if (std::abs(dir.y) < 0.9) {
+        perpX = glm::normalize(glm::cross(glm::dvec3(0, 1, 0), dir));
+    } else {
+        perpX = glm::normalize(glm::cross(glm::dvec3(1, 0, 0), dir));
+    }
+    glm::dvec3 perpY = glm::cross(dir, perpX);
+
+    const size_t first = m_particles.size();
+    m_particles.resize(first + params.numParticles, refParticle);
+    extendSpeciesBlocks(refParticle.getSpecies(), first, m_particles.size());
+    const uint64_t firstId = Particle::reserveIds(params.numParticles);
+    const size_t blocks = (params.numParticles + GENERATION_BLOCK - 1) / GENERATION_BLOCK;
+    const auto blockCount = static_cast<ptrdiff_t>(blocks);
+
+#ifdef PAS_ENABLE_OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (ptrdiff_t b = 0; b < blockCount; ++b) {
+        UnitSampler sampler(utils::streamSeed(params.seed, static_cast<uint64_t>(b)));
+        const size_t begin = static_cast<size_t>(b) * GENERATION_BLOCK;
+        const size_t end = std::min(begin + GENERATION_BLOCK, params.numParticles);
+
+        for (size_t i = begin; i < end; ++i) {
+            double u[6];
+            sampler.sample(params.distribution, u);
+
+            // (x, x', y, y', z, delta) = L u
+            double v[6];
+            for (int row = 0; row < 6; ++row) {
+                v[row] = 0.0;
+                for (int col = 0; col <= row; ++col) {
+                    v[row] += L[row * 6 + col] * u[col];
+                }
+            }
+
+            Particle& particle = m_particles[first + i];
+            particle.setId(firstId + i);
+            particle.setPosition(params.positionOffset + perpX * v[0] + perpY * v[2] + dir * v[4]);
+            particle.setMomentum(dir * (pRef * (1.0 + v[5])) + perpX * (pRef * v[1]) +
+                                 perpY * (pRef * v[3]));
         }
-        perpY = glm::cross(dir, perpX);
-
-        momentum += perpX * (pRef * dpx) + perpY * (pRef * dpy);
-
-        particle.setMomentum(momentum);
-        m_particles.push_back(particle);
     }
+
+    return true;
 }
 
 void ParticleSystem::clear() {
     m_particles.clear();
+    m_speciesBlocks.clear();
 }
 
 void ParticleSystem::addParticle(const Particle& particle) {
     m_particles.push_back(particle);
+    extendSpeciesBlocks(particle.getSpecies(), m_particles.size() - 1, m_particles.size());
 }
 
 void ParticleSystem::removeInactiveParticles() {
@@ -125,6 +266,32 @@ void ParticleSystem::removeInactiveParticles() {
                        [](const Particle& p) { return !p.isActive(); }),
         m_particles.end()
     );
+    updateSpeciesBlocks();
+}
+
+void ParticleSystem::sortBySpecies() {
+    std::stable_sort(m_particles.begin(), m_particles.end(),
+                     [](const Particle& a, const Particle& b) { return a.getSpecies() < b.getSpecies(); });
+    updateSpeciesBlocks();
+}
+
+void ParticleSystem::updateSpeciesBlocks() {
+    m_speciesBlocks.clear();
+    for (size_t i = 0; i < m_particles.size(); ++i) {
+        extendSpeciesBlocks(m_particles[i].getSpecies(), i, i + 1);
+    }
+}
+
+void ParticleSystem::extendSpeciesBlocks(SpeciesId species, size_t begin, size_t end) {
+    if (begin == end) {
+        return;
+    }
+    if (!m_speciesBlocks.empty() && m_speciesBlocks.back().species == species &&
+        m_speciesBlocks.back().end == begin) {
+        m_speciesBlocks.back().end = end;
+    } else {
+        m_speciesBlocks.push_back(SpeciesBlock{species, begin, end});
+    }
 }
 
 size_t ParticleSystem::getActiveParticleCount() const {
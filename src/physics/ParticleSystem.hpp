@@ -1,8 +1,8 @@
 #pragma once
 
 #include "physics/Particle.hpp"
+#include <array>
 #include <vector>
-#include <random>
 #include <cstdint>
 
 namespace pas::physics {
@@ -50,6 +50,27 @@ struct BeamParameters {
     };
     Distribution distribution = Distribution::Gaussian;
 
+    // Phase-space correlations
+    enum class Matching {
+        None,         // Uncorrelated sigmas above
+        Twiss,        // Transverse emittances and Twiss parameters
+        SigmaMatrix   // Full 6D covariance matrix
+    };
+    Matching matching = Matching::None;
+
+    // Matched beam (Matching::Twiss); sigmaZ and sigmaDelta still set the longitudinal plane
+    double emittanceX = 1e-6;       // Geometric rms emittance [m rad]
+    double emittanceY = 1e-6;       // Geometric rms emittance [m rad]
+    double betaX = 10.0;            // m
+    double alphaX = 0.0;
+    double betaY = 10.0;            // m
+    double alphaY = 0.0;
+    double dispersionX = 0.0;       // m
+    double dispersionPrimeX = 0.0;
+
+    // Covariance of (x, x', y, y', z, delta), row-major (Matching::SigmaMatrix)
+    std::array<double, 36> sigmaMatrix{};
+
     // Random seed for reproducibility
     uint64_t seed = 42;
 };
@@ -86,10 +107,21 @@ struct BeamStatistics {
     double normalizedEmittanceY = 0.0;
 };
 
+/**
+ * @brief Contiguous run of particles of one species, [begin, end).
+ */
+struct SpeciesBlock {
+    SpeciesId species = SpeciesTable::PROTON;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
 /**
  * @brief Container for managing a collection of particles.
  *
  * Provides beam generation, statistics computation, and particle management.
+ * Particles are kept in species blocks, so integration loops can look up the
+ * species once per block; mixed beams are appended as further blocks.
  */
 class ParticleSystem {
 public:
@@ -97,9 +129,31 @@ public:
 
     /**
      * @brief Generate a beam with the given parameters.
+     *
+     * Unit-covariance samples of the chosen distribution are transformed with
+     * the Cholesky factor of the 6D covariance matrix, so matched beams keep
+     * their Twiss correlations. Particles are generated in parallel blocks
+     * with one random stream per block; the result depends only on the seed.
+     *
      * @param params Beam parameters.
+     * @return False if the covariance matrix is not positive semi-definite.
+     */
+    bool generateBeam(const BeamParameters& params);
+
+    /**
+     * @brief Generate a beam and append it after the existing particles.
+     *
+     * Used for mixed beams, e.g. an electron cloud around a proton beam.
+     * The reference momentum is set only when the system was empty.
+     *
+     * @return False if the covariance matrix is not positive semi-definite.
+     */
+    bool appendBeam(const BeamParameters& params);
+
+    /**
+     * @brief Covariance matrix of (x, x', y, y', z, delta) described by the parameters.
      */
-    void generateBeam(const BeamParameters& params);
+    static std::array<double, 36> covarianceMatrix(const BeamParameters& params);
 
     /**
      * @brief Clear all particles.
@@ -116,6 +170,21 @@ public:
      */
     void removeInactiveParticles();
 
+    /**
+     * @brief Stable-sort particles by species so each species forms one block.
+     */
+    void sortBySpecies();
+
+    /**
+     * @brief Runs of particles of one species, in particle order.
+     */
+    const std::vector<SpeciesBlock>& getSpeciesBlocks() const { return m_speciesBlocks; }
+
+    /**
+     * @brief Rebuild the species blocks after changing particles through getParticles().
+     */
+    void updateSpeciesBlocks();
+
     /**
      * @brief Get the number of particles.
      */
@@ -178,9 +247,14 @@ private:
      */
     static Particle createParticle(BeamParameters::ParticleType type);
 
+    /**
+     * @brief Extend the blocks with particles [begin, end) of one species.
+     */
+    void extendSpeciesBlocks(SpeciesId species, size_t begin, size_t end);
+
     std::vector<Particle> m_particles;
+    std::vector<SpeciesBlock> m_speciesBlocks;
     double m_referenceMomentum;
-    std::mt19937_64 m_rng;
 };
 
 } // namespace pas::physics
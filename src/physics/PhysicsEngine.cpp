@@ -1,11 +1,22 @@
 #include "physics/PhysicsEngine.hpp"
 #include "utils/Logger.hpp"
+#include "utils/Parallel.hpp"
 
 #include <cmath>
 #include <algorithm>
+#include <limits>
+#include <tuple>
+#include <utility>
 
 namespace pas::physics {
 
+namespace {
+
+// Radius around the orbit within which no particle is lost, whatever the apertures [m]
+constexpr double DEFAULT_APERTURE = 0.1;
+
+} // namespace
+
 PhysicsEngine::PhysicsEngine() {
     // Initialize default integrator
     setIntegrator(IntegratorFactory::Type::Boris);
@@ -15,9 +26,16 @@ void PhysicsEngine::setAccelerator(std::shared_ptr<accelerator::Accelerator> acc
     m_accelerator = std::move(accelerator);
 
     // Update field manager with accelerator's fields
+    m_fieldManager.clear();
+    m_publishedSources.clear();
+    m_frameFields.clear();
+    m_rampCircuits.clear();
+    m_orbitCoordinates.resize(0);
+    m_floatCoordinates.resize(0);
     if (m_accelerator) {
-        m_fieldManager.clear();
-        m_accelerator->populateFieldManager(m_fieldManager);
+        publishFieldSources();
+        buildObservationPlanes();
+        applyRamps(m_currentTime);
         PAS_DEBUG("PhysicsEngine: Set accelerator with {} components", m_accelerator->getComponentCount());
     }
 }
@@ -25,9 +43,35 @@ void PhysicsEngine::setAccelerator(std::shared_ptr<accelerator::Accelerator> acc
 void PhysicsEngine::setIntegrator(IntegratorFactory::Type type) {
     m_integratorType = type;
     m_integrator = IntegratorFactory::create(type);
+    if (m_precision != activePrecision()) {
+        PAS_WARN("PhysicsEngine: {} runs in double precision only", m_integrator->getName());
+    }
     PAS_DEBUG("PhysicsEngine: Set integrator to {}", static_cast<int>(type));
 }
 
+void PhysicsEngine::setPrecision(Precision precision) {
+    m_precision = precision;
+    if (m_precision != activePrecision()) {
+        PAS_WARN("PhysicsEngine: {} runs in double precision only", m_integrator->getName());
+    }
+
+    // Particles are located afresh in the coordinates of the new precision
+    m_orbitCoordinates.resize(0);
+    m_floatCoordinates.resize(0);
+    if (m_accelerator) {
+        publishFieldSources();
+    }
+    PAS_DEBUG("PhysicsEngine: Set precision to {}", static_cast<int>(precision));
+}
+
+void PhysicsEngine::setCoordinateMode(CoordinateMode mode) {
+    m_coordinateMode = mode;
+    if (m_accelerator) {
+        publishFieldSources();
+    }
+    PAS_DEBUG("PhysicsEngine: Set coordinate mode to {}", static_cast<int>(mode));
+}
+
 void PhysicsEngine::start() {
     if (m_state == SimulationState::Stopped) {
         reset();
@@ -65,6 +109,7 @@ void PhysicsEngine::reset() {
 
     // Clear particles
     m_particleSystem.clear();
+    m_lossEvents.clear();
 
     PAS_INFO("PhysicsEngine: Simulation reset");
 }
@@ -82,11 +127,18 @@ void PhysicsEngine::update(double deltaTime) {
 
     // Perform fixed timesteps (capped to prevent UI freeze)
     size_t stepsThisFrame = 0;
+    const bool stepping = m_accumulatedTime >= m_timeStep && m_maxStepsPerFrame > 0 && m_integrator;
+    if (stepping) {
+        beginSteps();
+    }
     while (m_accumulatedTime >= m_timeStep && stepsThisFrame < m_maxStepsPerFrame) {
-        step();
+        advance();
         m_accumulatedTime -= m_timeStep;
         stepsThisFrame++;
     }
+    if (stepping) {
+        endSteps();
+    }
 
     // If we hit the cap, discard excess accumulated time to prevent runaway
     if (stepsThisFrame >= m_maxStepsPerFrame && m_accumulatedTime > m_timeStep) {
@@ -101,21 +153,77 @@ void PhysicsEngine::step() {
     if (!m_integrator) {
         return;
     }
+    beginSteps();
+    advance();
+    endSteps();
+}
+
+void PhysicsEngine::beginSteps() {
+    if (!tracksOrbit()) {
+        m_orbitCoordinates.resize(0);
+        m_floatCoordinates.resize(0);
+        return;
+    }
+
+    // The steps up to endSteps() push the orbit coordinates against this survey
+    publishFieldSources();
+    m_trackedLattice = &m_accelerator->getCompiledLattice();
+    const bool closed = m_accelerator->isClosed();
+    auto& particles = m_particleSystem.getParticles();
+    visitOrbitCoordinates([&](auto& coordinates) {
+        coordinates.sync(particles);
+
+        const auto count = static_cast<ptrdiff_t>(particles.size());
+#ifdef PAS_ENABLE_OPENMP
+        #pragma omp parallel for schedule(static)
+#endif
+        for (ptrdiff_t i = 0; i < count; ++i) {
+            const auto index = static_cast<size_t>(i);
+            coordinates.update(index, particles[index], *m_trackedLattice, closed);
+        }
+    });
+}
+
+void PhysicsEngine::advance() {
+    if (!m_integrator) {
+        return;
+    }
 
     auto& particles = m_particleSystem.getParticles();
+    const bool observing = !m_observationPlanes.empty();
 
-    // Integrate each particle
-    for (auto& particle : particles) {
-        if (!particle.isActive()) {
-            continue;
+    // Blocks go stale if the particle vector was replaced directly
+    const auto& blocks = m_particleSystem.getSpeciesBlocks();
+    if ((blocks.empty() ? 0 : blocks.back().end) != particles.size()) {
+        m_particleSystem.updateSpeciesBlocks();
+    }
+
+    // On the orbit, beginSteps() published the fields the coordinates are relative to
+    if (m_accelerator && !m_trackedLattice) {
+        publishFieldSources();
+    }
+    applyRamps(m_currentTime + 0.5 * m_timeStep);
+
+    for (const auto& plane : m_observationPlanes) {
+        plane.component->prepareCrossings(utils::getMaxThreads());
+    }
+
+    // Integrate each particle, one species block at a time
+    for (const SpeciesBlock& block : m_particleSystem.getSpeciesBlocks()) {
+        if (m_trackedLattice) {
+            stepOnOrbit(block, observing);
+        } else {
+            stepGlobal(block, observing);
         }
+    }
 
-        // Integrate using the integrator
-        m_integrator->step(particle, m_fieldManager, m_currentTime, m_timeStep);
+    for (const auto& plane : m_observationPlanes) {
+        plane.component->commitCrossings();
     }
 
-    // Check for particle losses
+    // Check for particle losses and publish them to subscribers
     checkParticleLosses();
+    m_stats.lostParticleCount += m_lossEvents.drain();
 
     // Update stats
     m_currentTime += m_timeStep;
@@ -124,6 +232,177 @@ void PhysicsEngine::step() {
     m_stepsThisSecond++;
 }
 
+void PhysicsEngine::endSteps() {
+    if (!m_trackedLattice) {
+        return;
+    }
+
+    // Global coordinates for rendering, statistics and export
+    auto& particles = m_particleSystem.getParticles();
+    visitOrbitCoordinates([&](const auto& coordinates) {
+        const auto count = static_cast<ptrdiff_t>(particles.size());
+#ifdef PAS_ENABLE_OPENMP
+        #pragma omp parallel for schedule(static)
+#endif
+        for (ptrdiff_t i = 0; i < count; ++i) {
+            const auto index = static_cast<size_t>(i);
+            coordinates.store(index, particles[index], *m_trackedLattice);
+        }
+    });
+    m_trackedLattice = nullptr;
+}
+
+void PhysicsEngine::stepGlobal(const SpeciesBlock& block, bool observing) {
+    auto& particles = m_particleSystem.getParticles();
+    const Species& species = SpeciesTable::get(block.species);
+    const auto begin = static_cast<ptrdiff_t>(block.begin);
+    const auto end = static_cast<ptrdiff_t>(block.end);
+#ifdef PAS_ENABLE_OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (ptrdiff_t i = begin; i < end; ++i) {
+        Particle& particle = particles[static_cast<size_t>(i)];
+        if (!particle.isActive()) {
+            continue;
+        }
+
+        const glm::dvec3 previousPosition = particle.getPosition();
+        const glm::dvec3 previousMomentum = particle.getMomentum();
+
+        // Integrate using the integrator
+        m_integrator->step(particle, species, m_fieldManager, m_currentTime, m_timeStep);
+
+        if (observing) {
+            const glm::dvec3& position = particle.getPosition();
+            const glm::dvec3& momentum = particle.getMomentum();
+            detectCrossings(particle.getId(), previousPosition.z, position.z, [&](double fraction) {
+                return std::make_pair(previousPosition + (position - previousPosition) * fraction,
+                                      previousMomentum + (momentum - previousMomentum) * fraction);
+            });
+        }
+    }
+}
+
+template <typename Visitor>
+void PhysicsEngine::visitOrbitCoordinates(Visitor visitor) {
+    if (activePrecision() == Precision::Float) {
+        visitor(m_floatCoordinates);
+    } else {
+        visitor(m_orbitCoordinates);
+    }
+}
+
+template <typename Coordinates, typename MakePush>
+void PhysicsEngine::pushOnOrbit(Coordinates& coordinates, const SpeciesBlock& block, bool observing,
+                                MakePush makePush) {
+    using Vec = typename Coordinates::Vec;
+
+    if (block.begin == block.end) {
+        return;
+    }
+
+    const accelerator::CompiledLattice& lattice = *m_trackedLattice;
+    const bool closed = m_accelerator->isClosed();
+    const double circumference = m_accelerator->getCircumference();
+    const Species& species = SpeciesTable::get(block.species);
+    const auto begin = static_cast<ptrdiff_t>(block.begin);
+    const auto end = static_cast<ptrdiff_t>(block.end);
+#ifdef PAS_ENABLE_OPENMP
+    #pragma omp parallel
+#endif
+    {
+        auto push = makePush();
+
+#ifdef PAS_ENABLE_OPENMP
+        #pragma omp for schedule(static)
+#endif
+        for (ptrdiff_t i = begin; i < end; ++i) {
+            const auto index = static_cast<size_t>(i);
+            if (!coordinates.isActive(index)) {
+                continue;
+            }
+
+            const size_t entry = coordinates.getEntries()[index];
+            const int turn = coordinates.getTurns()[index];
+            const double previousPath =
+                observing ? coordinates.getPathLength(index, lattice, circumference) : 0.0;
+
+            // Fields of the entry, placed in its frame
+            Vec position = coordinates.getLocalPosition(index);
+            Vec momentum = coordinates.getLocalMomentum(index);
+            const Vec previousPosition = position;
+            const Vec previousMomentum = momentum;
+            push(position, momentum, m_frameFields[entry]);
+            coordinates.setLocal(index, position, momentum);
+            coordinates.transfer(index, lattice, closed);
+
+            if (observing) {
+                // Global coordinates only for the planes actually crossed
+                const double path = coordinates.getPathLength(index, lattice, circumference);
+                detectCrossings(coordinates.getId(index), previousPath, path, [&](double fraction) {
+                    const accelerator::Placement frame = lattice.getReferenceFrame(entry, turn);
+                    const glm::dvec3 position0 = frame.toGlobal(glm::dvec3(previousPosition));
+                    const glm::dvec3 momentum0 =
+                        frame.rotation * glm::dvec3(previousMomentum) * species.massTimesC;
+                    const glm::dvec3 position1 = coordinates.toGlobal(index, lattice);
+                    const glm::dvec3 momentum1 = coordinates.toGlobalMomentum(index, lattice) *
+                                                 species.massTimesC;
+                    return std::make_pair(position0 + (position1 - position0) * fraction,
+                                          momentum0 + (momentum1 - momentum0) * fraction);
+                });
+            }
+        }
+    }
+}
+
+template <typename Pusher, typename Coordinates>
+void PhysicsEngine::pushOnOrbit(Coordinates& coordinates, const SpeciesBlock& block, bool observing) {
+    const Species& species = SpeciesTable::get(block.species);
+    pushOnOrbit(coordinates, block, observing, [&] {
+        return [&](typename Pusher::State& position, typename Pusher::State& momentum,
+                   const EMFieldManager& fields) {
+            Pusher::step(position, momentum, species, fields, m_currentTime, m_timeStep);
+        };
+    });
+}
+
+void PhysicsEngine::stepOnOrbit(const SpeciesBlock& block, bool observing) {
+    const bool rk4 = m_integratorType == IntegratorFactory::Type::RK4;
+    switch (activePrecision()) {
+        case Precision::Float:
+            if (rk4) {
+                pushOnOrbit<RK4Pusher<FloatPrecision>>(m_floatCoordinates, block, observing);
+            } else {
+                pushOnOrbit<BorisPusher<FloatPrecision>>(m_floatCoordinates, block, observing);
+            }
+            return;
+        case Precision::Mixed:
+            if (rk4) {
+                pushOnOrbit<RK4Pusher<MixedPrecision>>(m_orbitCoordinates, block, observing);
+            } else {
+                pushOnOrbit<BorisPusher<MixedPrecision>>(m_orbitCoordinates, block, observing);
+            }
+            return;
+        case Precision::Double:
+            break;
+    }
+
+    const Species& species = SpeciesTable::get(block.species);
+    pushOnOrbit(m_orbitCoordinates, block, observing, [&] {
+        // Integrators push a Particle; this one carries each particle's orbit coordinates
+        Particle local = m_particleSystem.getParticles()[block.begin];
+        local.setActive(true);
+        return [&species, local, this](glm::dvec3& position, glm::dvec3& momentum,
+                                       const EMFieldManager& fields) mutable {
+            local.setPosition(position);
+            local.setMomentum(momentum * species.massTimesC);
+            m_integrator->step(local, species, fields, m_currentTime, m_timeStep);
+            position = local.getPosition();
+            momentum = local.getMomentum() / species.massTimesC;
+        };
+    });
+}
+
 void PhysicsEngine::updateStats(double frameTime) {
     m_lastStepTime += frameTime;
 
@@ -148,40 +427,380 @@ void PhysicsEngine::checkParticleLosses() {
     }
 
     auto& particles = m_particleSystem.getParticles();
+    // Tracking on the orbit holds the lattice the coordinates were loaded against
+    const bool orbital = m_trackedLattice != nullptr;
+    const accelerator::CompiledLattice& lattice =
+        orbital ? *m_trackedLattice : m_accelerator->getCompiledLattice();
+    if (lattice.empty()) {
+        return;
+    }
+
+    const double lossTime = m_currentTime + m_timeStep;
+    const auto count = static_cast<ptrdiff_t>(particles.size());
+    m_lossEvents.prepare(utils::getMaxThreads());
+
+    // Cursors are only hints, so slots left over from reordered particles do no harm
+    if (!orbital) {
+        m_apertureCursors.resize(particles.size(), 0);
+    }
+
+    // In global coordinates the orbit coordinates are empty and go unused
+    visitOrbitCoordinates([&](auto& coordinates) {
+#ifdef PAS_ENABLE_OPENMP
+        #pragma omp parallel for schedule(static)
+#endif
+        for (ptrdiff_t i = 0; i < count; ++i) {
+            const auto index = static_cast<size_t>(i);
+            Particle& particle = particles[index];
+            LossEvent event;
+
+            if (orbital) {
+                if (!coordinates.isActive(index)) {
+                    continue;
+                }
+
+                // Only the aperture of the entry the particle is in, without transforms
+                const accelerator::OrbitPosition orbit = coordinates.getPosition(index, lattice);
+                if (lattice.isInsideAperture(orbit)) {
+                    continue;
+                }
+                if (std::sqrt(orbit.x * orbit.x + orbit.y * orbit.y) <= DEFAULT_APERTURE) {
+                    continue;
+                }
+
+                // The Particle keeps where it was lost
+                coordinates.store(index, particle, lattice);
+                coordinates.setActive(index, false);
+
+                const bool within = orbit.ds >= 0.0 && orbit.ds <= lattice.getLengths()[orbit.index];
+                event.sPosition = coordinates.getS(index, lattice);
+                event.componentIndex = within ? orbit.index : LossEvent::NoComponent;
+            } else {
+                if (!particle.isActive()) {
+                    continue;
+                }
+
+                // Check the apertures around the particle's s, starting from its last entry
+                const glm::dvec3& pos = particle.getPosition();
+                if (lattice.isInsideApertureAtS(pos, pos.z, m_apertureCursors[index])) {
+                    continue;
+                }
+
+                // Check distance from beam axis as fallback
+                double radialDist = std::sqrt(pos.x * pos.x + pos.y * pos.y);
+                if (radialDist <= DEFAULT_APERTURE) {
+                    continue;
+                }
+
+                event.sPosition = pos.z;
+                event.componentIndex = lattice.findIndexAtS(m_accelerator->wrapS(pos.z),
+                                                             m_apertureCursors[index])
+                                           .value_or(LossEvent::NoComponent);
+            }
+
+            particle.setActive(false);
+
+            event.particleId = particle.getId();
+            event.time = lossTime;
+            event.position = particle.getPosition();
+            event.momentum = particle.getMomentum();
+            m_lossEvents.record(event);
+        }
+    });
+}
+
+bool PhysicsEngine::isCurved() const {
+    if (!m_accelerator || m_accelerator->getCompiledLattice().empty()) {
+        return false;
+    }
+    const auto& angles = m_accelerator->getCompiledLattice().getAngles();
+    return std::any_of(angles.begin(), angles.end(), [](double angle) { return angle != 0.0; });
+}
+
+bool PhysicsEngine::tracksOrbit() const {
+    if (!m_accelerator || m_accelerator->getCompiledLattice().empty()) {
+        return false;
+    }
+    // Bent lattices have no global coordinate to find the entry from, and
+    // float positions must be small
+    return m_coordinateMode == CoordinateMode::ReferenceOrbit || isCurved() ||
+           activePrecision() != Precision::Double;
+}
+
+Precision PhysicsEngine::activePrecision() const {
+    // Euler and Verlet have no reduced-precision pushers
+    const bool pushers =
+        m_integratorType == IntegratorFactory::Type::Boris || m_integratorType == IntegratorFactory::Type::RK4;
+    return pushers ? m_precision : Precision::Double;
+}
+
+void PhysicsEngine::buildObservationPlanes() {
+    m_observationPlanes.clear();
     const auto& components = m_accelerator->getComponents();
+    const auto& sStarts = m_accelerator->getCompiledLattice().getSStarts();
+    for (size_t i = 0; i < components.size(); ++i) {
+        if (components[i]->observesCrossings()) {
+            m_observationPlanes.push_back({sStarts[i], i, components[i].get()});
+        }
+    }
 
-    for (auto& particle : particles) {
-        if (!particle.isActive()) {
+    std::sort(m_observationPlanes.begin(), m_observationPlanes.end(),
+              [](const ObservationPlane& a, const ObservationPlane& b) { return a.s < b.s; });
+}
+
+void PhysicsEngine::publishFieldSources() {
+    const auto& components = m_accelerator->getComponents();
+    const accelerator::CompiledLattice& lattice = m_accelerator->getCompiledLattice();
+    // Frame fields and ramp circuits hold the placed sources; updates in place keep them
+    bool recreated = m_publishedSources.size() != components.size();
+    bool rewired = false;
+
+    // A resurvey moves the placements of unchanged components too
+    const bool moved = lattice.getSurveyVersion() != m_publishedSurvey;
+    m_publishedSurvey = lattice.getSurveyVersion();
+
+    // Components removed from the end of the lattice
+    for (size_t i = components.size(); i < m_publishedSources.size(); ++i) {
+        m_fieldManager.removeSource(m_publishedSources[i].placed);
+    }
+    m_publishedSources.resize(components.size());
+
+    for (size_t i = 0; i < components.size(); ++i) {
+        const auto& component = components[i];
+        PublishedSource& published = m_publishedSources[i];
+        const bool current = published.component == component.get() &&
+                             published.version == component->getVersion();
+        if (current && !moved) {
             continue;
         }
 
-        glm::dvec3 pos = particle.getPosition();
-
-        // Check if particle is inside any component's aperture
-        bool insideAperture = false;
-        for (const auto& comp : components) {
-            if (comp->isInsideAperture(pos)) {
-                insideAperture = true;
-                break;
+        const accelerator::Placement frame = lattice.getCenterFrame(i);
+        if (current) {
+            if (published.placed) {
+                published.placed->setPlacement(frame.origin, frame.rotation);
             }
+            continue;
+        }
+
+        // Updates the source in place unless it had to be recreated
+        auto source = component->getFieldSource();
+        if (source != published.source) {
+            auto placed = source ? std::make_shared<PlacedField>(source, frame.origin, frame.rotation)
+                                 : nullptr;
+            m_fieldManager.replaceSource(published.placed, placed);
+            published.placed = std::move(placed);
+            published.source = std::move(source);
+            recreated = true;
+        } else if (published.placed) {
+            published.placed->setPlacement(frame.origin, frame.rotation);
+        }
+        published.component = component.get();
+        published.version = component->getVersion();
+
+        // A magnet moved to another waveform changes circuit
+        const auto* magnet = dynamic_cast<const accelerator::Magnet*>(component.get());
+        auto ramp = magnet ? magnet->getRamp() : nullptr;
+        if (ramp != published.ramp) {
+            published.ramp = std::move(ramp);
+            rewired = true;
         }
+    }
 
-        // If not in any aperture and we have components, particle may be lost
-        if (!insideAperture && !components.empty()) {
-            // Check distance from beam axis as fallback
-            double radialDist = std::sqrt(pos.x * pos.x + pos.y * pos.y);
-            if (radialDist > 0.1) {  // 10 cm default aperture
-                particle.setActive(false);
-                m_stats.lostParticleCount++;
+    // Tracking on the orbit places the sources again in each entry's frame
+    const bool tracking = tracksOrbit();
+    const bool reframe = tracking ? recreated || moved || m_frameFields.size() != lattice.size()
+                                  : !m_frameFields.empty();
+    if (reframe) {
+        buildFrameFields();
+    }
 
-                if (m_lossCallback) {
-                    m_lossCallback(particle);
-                }
+    if (recreated || rewired || reframe) {
+        buildRampCircuits();
+    }
+}
+
+void PhysicsEngine::buildFrameFields() {
+    // Entries added or removed invalidate every particle's entry
+    const accelerator::CompiledLattice& lattice = m_accelerator->getCompiledLattice();
+    if (m_frameFields.size() != lattice.size()) {
+        m_orbitCoordinates.resize(0);
+        m_floatCoordinates.resize(0);
+    }
+
+    m_frameFields.clear();
+    for (PublishedSource& published : m_publishedSources) {
+        published.framed.clear();
+    }
+    if (!tracksOrbit()) {
+        return;
+    }
+
+    // Each entry gets the sources overlapping the region its particles can
+    // reach, at their placement relative to its frame
+    const size_t count = lattice.size();
+    const bool closed = m_accelerator->isClosed();
+    const double infinity = std::numeric_limits<double>::infinity();
+    std::vector<BoundingBox> regions;
+    regions.reserve(count);
+    double maxReach = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        // Twice the aperture around the orbit; open ends extend to infinity
+        const double reach = 2.0 * std::max({lattice.getApertureX()[i], lattice.getApertureY()[i],
+                                             DEFAULT_APERTURE});
+        const glm::dvec3 exit = lattice.getTransfer(i).origin;
+        regions.emplace_back(
+            glm::dvec3(std::min(0.0, exit.x) - reach, -reach, (i == 0 && !closed) ? -infinity : -reach),
+            glm::dvec3(std::max(0.0, exit.x) + reach, reach,
+                       (i + 1 == count && !closed) ? infinity : std::max(0.0, exit.z) + reach));
+        maxReach = std::max(maxReach, reach);
+    }
+
+    // Only entries within a window in s around each source can overlap it,
+    // so this is linear in the lattice size for sources of bounded extent
+    const std::vector<double>& starts = lattice.getSStarts();
+    const double length = starts.back() + lattice.getLengths().back();
+    std::vector<size_t> visited(count, m_publishedSources.size());
+    m_frameFields.resize(count);
+    for (size_t j = 0; j < m_publishedSources.size(); ++j) {
+        PublishedSource& published = m_publishedSources[j];
+        if (!published.placed) {
+            continue;
+        }
+
+        // Chords of a bent orbit are shorter than its arcs, hence the factor 2
+        const BoundingBox& box = published.source->getBoundingBox();
+        const glm::dvec3 corner = glm::max(glm::abs(box.min), glm::abs(box.max));
+        const double window = 2.0 * (glm::length(corner) + maxReach);
+        const double center = starts[j] + 0.5 * lattice.getLengths()[j];
+
+        auto place = [&](size_t i) {
+            if (visited[i] == j) {
+                return;
+            }
+            visited[i] = j;
+            const accelerator::Placement reference = lattice.getReferenceFrame(i);
+            const glm::dquat inverse = glm::inverse(reference.rotation);
+            const glm::dvec3 origin = inverse * (published.placed->getOrigin() - reference.origin);
+            const glm::dquat rotation = inverse * published.placed->getRotation();
+            if (!box.placed(origin, rotation).intersects(regions[i])) {
+                return;
+            }
+
+            auto placed = std::make_shared<PlacedField>(published.source, origin, rotation);
+            m_frameFields[i].addSource(placed);
+            published.framed.push_back(std::move(placed));
+        };
+
+        // Entries overlapping [s0, s1], from the last one starting at or before s0
+        auto placeRange = [&](double s0, double s1) {
+            auto it = std::upper_bound(starts.begin(), starts.end(), s0);
+            for (size_t i = it == starts.begin() ? 0 : static_cast<size_t>(it - starts.begin()) - 1;
+                 i < count && starts[i] <= s1; ++i) {
+                place(i);
+            }
+        };
+
+        if (!std::isfinite(window) || (closed && 2.0 * window >= length)) {
+            placeRange(-infinity, infinity);
+            continue;
+        }
+        placeRange(center - window, center + window);
+        if (!closed) {
+            // The end regions reach to infinity
+            place(0);
+            place(count - 1);
+        } else {
+            // Around the ends of the ring
+            if (center - window < 0.0) {
+                placeRange(center - window + length, length);
+            }
+            if (center + window > length) {
+                placeRange(0.0, center + window - length);
             }
         }
     }
 }
 
+void PhysicsEngine::buildRampCircuits() {
+    m_rampCircuits.clear();
+    const auto& components = m_accelerator->getComponents();
+    for (size_t i = 0; i < components.size(); ++i) {
+        auto magnet = std::dynamic_pointer_cast<accelerator::Magnet>(components[i]);
+        const auto& placed = m_publishedSources[i].placed;
+        if (!magnet || !magnet->getRamp() || !placed) {
+            continue;
+        }
+
+        // Magnets sharing a waveform form one circuit
+        auto circuit = std::find_if(m_rampCircuits.begin(), m_rampCircuits.end(),
+                                    [&](const RampCircuit& c) { return c.waveform == magnet->getRamp(); });
+        if (circuit == m_rampCircuits.end()) {
+            m_rampCircuits.push_back({magnet->getRamp(), {}});
+            circuit = m_rampCircuits.end() - 1;
+        }
+        circuit->sources.push_back(placed);
+        const auto& framed = m_publishedSources[i].framed;
+        circuit->sources.insert(circuit->sources.end(), framed.begin(), framed.end());
+    }
+}
+
+void PhysicsEngine::applyRamps(double time) {
+    for (const RampCircuit& circuit : m_rampCircuits) {
+        const double scale = circuit.waveform->evaluate(time);
+        for (const auto& source : circuit.sources) {
+            source->setScale(scale);
+        }
+    }
+}
+
+template <typename Interpolate>
+void PhysicsEngine::detectCrossings(uint64_t particleId, double s0, double s1, Interpolate interpolate) const {
+    // s0 and s1 are path lengths along the orbit; global z when tracking in global coordinates
+    // Only forward crossings are recorded
+    if (!(s1 > s0)) {
+        return;
+    }
+
+    // Circular lattices repeat every circumference; each period is one turn
+    const bool closed = m_accelerator->isClosed();
+    const double period = closed ? m_accelerator->getCircumference() : 0.0;
+    const accelerator::CompiledLattice& lattice =
+        m_trackedLattice ? *m_trackedLattice : m_accelerator->getCompiledLattice();
+    int64_t firstTurn = 0;
+    int64_t lastTurn = 0;
+    if (period > 0.0) {
+        firstTurn = static_cast<int64_t>(std::floor(s0 / period));
+        lastTurn = static_cast<int64_t>(std::floor(s1 / period));
+    }
+
+    for (int64_t turn = std::max<int64_t>(firstTurn, 0); turn <= lastTurn; ++turn) {
+        const double offset = static_cast<double>(turn) * period;
+
+        // Planes with s0 < offset + s <= s1
+        auto it = std::upper_bound(m_observationPlanes.begin(), m_observationPlanes.end(), s0 - offset,
+                                   [](double s, const ObservationPlane& plane) { return s < plane.s; });
+
+        for (; it != m_observationPlanes.end() && offset + it->s <= s1; ++it) {
+            // Linear interpolation between the bracketing steps
+            double fraction = (offset + it->s - s0) / (s1 - s0);
+
+            accelerator::PlaneCrossing crossing;
+            crossing.particleId = particleId;
+            crossing.turn = static_cast<uint64_t>(turn);
+            crossing.time = m_currentTime + fraction * m_timeStep;
+            std::tie(crossing.position, crossing.momentum) = interpolate(fraction);
+
+            // Offsets in the plane's frame; starting there, the walk rarely leaves it
+            const accelerator::OrbitPosition orbit =
+                lattice.toOrbit(crossing.position, it->index, closed, static_cast<int>(turn));
+            crossing.x = orbit.x;
+            crossing.y = orbit.y;
+
+            it->component->recordCrossing(crossing);
+        }
+    }
+}
+
 void PhysicsEngine::initializeDefaultBeam() {
     // Create a proton beam
     BeamParameters params;
@@ -3,10 +3,12 @@
 #include "physics/ParticleSystem.hpp"
 #include "physics/Integrator.hpp"
 #include "physics/EMField.hpp"
+#include "physics/LossEvents.hpp"
+#include "physics/OrbitCoordinates.hpp"
+#include "physics/Waveform.hpp"
 #include "accelerator/Accelerator.hpp"
 
 #include <memory>
-#include <functional>
 
 namespace pas::physics {
 
@@ -19,6 +21,14 @@ enum class SimulationState {
     Paused
 };
 
+/**
+ * @brief How particle state is held while tracking.
+ */
+enum class CoordinateMode {
+    Global,         // Absolute global positions, s taken as global z
+    ReferenceOrbit  // Relative to the reference orbit, in the frame of the current entry
+};
+
 /**
  * @brief Statistics from the physics simulation.
  */
@@ -40,8 +50,6 @@ struct SimulationStats {
  */
 class PhysicsEngine {
 public:
-    using LossCallback = std::function<void(const Particle&)>;
-
     PhysicsEngine();
     ~PhysicsEngine() = default;
 
@@ -71,6 +79,54 @@ public:
     void setIntegrator(IntegratorFactory::Type type);
     IntegratorFactory::Type getIntegratorType() const { return m_integratorType; }
 
+    /**
+     * @brief Set the arithmetic precision of the Boris and RK4 integrators.
+     *
+     * Float and Mixed push the orbit coordinates with BorisPusher or
+     * RK4Pusher and evaluate fields in float; Float also keeps them in
+     * FloatOrbitCoordinates. Both need positions relative to the orbit, so
+     * with a lattice they track relative to it in either coordinate mode;
+     * without one, and for Euler and Verlet, the engine tracks in double.
+     */
+    void setPrecision(Precision precision);
+    Precision getPrecision() const { return m_precision; }
+
+    /**
+     * @brief Choose how particle state is held while tracking.
+     *
+     * In ReferenceOrbit mode the integrators push every particle in the
+     * reference frame of the lattice entry it is in (see OrbitCoordinates),
+     * with each entry's fields placed in that frame, and the Particle vector
+     * is brought up to date once per update() or step(). Once the survey
+     * bends the lattice, global z is no path length, so the engine tracks
+     * relative to the orbit in either mode. Without a lattice it tracks in
+     * global coordinates.
+     */
+    void setCoordinateMode(CoordinateMode mode);
+    CoordinateMode getCoordinateMode() const { return m_coordinateMode; }
+
+    /**
+     * @brief Particle state relative to the reference orbit.
+     *
+     * As of the last step; empty while the engine tracks in global coordinates
+     * or in Float precision.
+     */
+    const OrbitCoordinates& getOrbitCoordinates() const { return m_orbitCoordinates; }
+
+    /**
+     * @brief Particle state relative to the reference orbit in Float precision.
+     *
+     * As of the last step; empty unless the engine tracks in Float precision.
+     */
+    const FloatOrbitCoordinates& getFloatOrbitCoordinates() const { return m_floatCoordinates; }
+
+    /**
+     * @brief Field sources of each lattice entry, placed in its frame.
+     *
+     * Empty while the engine tracks in global coordinates.
+     */
+    const std::vector<EMFieldManager>& getFrameFields() const { return m_frameFields; }
+
     /**
      * @brief Set the time step for integration.
      */
@@ -104,12 +160,24 @@ public:
 
     /**
      * @brief Advance simulation by one frame.
+     *
+     * When tracking relative to the orbit, components changed during the
+     * frame are published at the next one, and the Particle vector is
+     * updated once, after the frame's last step.
      * @param deltaTime Real-world time since last update [s]
      */
     void update(double deltaTime);
 
     /**
      * @brief Perform a single integration step.
+     *
+     * Components changed since the last step are published first: their
+     * field sources are updated in place, or swapped in the field manager
+     * if they were recreated, and every field is placed at its surveyed
+     * place in the lattice. Tracking threads therefore see new strengths
+     * at the next step boundary without locks or a rebuild. Magnet ramps
+     * are evaluated once at the middle of the step and held for all
+     * particles.
      */
     void step();
 
@@ -119,9 +187,28 @@ public:
     const SimulationStats& getStats() const { return m_stats; }
 
     /**
-     * @brief Set callback for particle loss events.
+     * @brief Subscribe to batches of particle loss events.
+     *
+     * Losses are buffered per thread during a step and published once the
+     * step completes, so callbacks never run inside the tracking loop.
+     */
+    LossEventBuffer::SubscriptionId subscribeLosses(LossEventBuffer::BatchCallback callback) {
+        return m_lossEvents.subscribe(std::move(callback));
+    }
+
+    /**
+     * @brief Subscribe to loss batches for as long as the returned token lives.
+     *
+     * The token may outlive the engine; it is then inactive.
      */
-    void setLossCallback(LossCallback callback) { m_lossCallback = std::move(callback); }
+    [[nodiscard]] LossEventBuffer::Subscription subscribeLossesScoped(LossEventBuffer::BatchCallback callback) {
+        return m_lossEvents.subscribeScoped(std::move(callback));
+    }
+
+    /**
+     * @brief Remove a loss batch subscriber.
+     */
+    void unsubscribeLosses(LossEventBuffer::SubscriptionId id) { m_lossEvents.unsubscribe(id); }
 
     /**
      * @brief Initialize a default beam.
@@ -129,14 +216,95 @@ public:
     void initializeDefaultBeam();
 
 private:
+    /**
+     * @brief Entrance plane of a component that observes crossings.
+     */
+    struct ObservationPlane {
+        double s;
+        size_t index;  // Lattice entry of the component
+        accelerator::Component* component;
+    };
+
+    /**
+     * @brief Field source published to the field manager for one component.
+     */
+    struct PublishedSource {
+        const accelerator::Component* component = nullptr;
+        uint64_t version = 0;
+        std::shared_ptr<FieldSource> source;       // The component's own source
+        std::shared_ptr<PlacedField> placed;       // Registered at the surveyed place
+        std::shared_ptr<const Waveform> ramp;      // Circuit the placements are in
+        std::vector<std::shared_ptr<PlacedField>> framed;  // Copies in nearby entry frames
+    };
+
+    /**
+     * @brief Placed sources of the magnets driven by one waveform.
+     *
+     * The scale is set on this engine's placements, never on the magnets'
+     * sources, which other engines may share.
+     */
+    struct RampCircuit {
+        std::shared_ptr<const Waveform> waveform;
+        std::vector<std::shared_ptr<PlacedField>> sources;
+    };
+
+    void beginSteps();
+    void advance();
+    void endSteps();
+    void stepGlobal(const SpeciesBlock& block, bool observing);
+    void stepOnOrbit(const SpeciesBlock& block, bool observing);
+    Precision activePrecision() const;
     void updateStats(double frameTime);
     void checkParticleLosses();
+    bool isCurved() const;
+    bool tracksOrbit() const;
+    void buildObservationPlanes();
+    void publishFieldSources();
+    void buildFrameFields();
+    void buildRampCircuits();
+    void applyRamps(double time);
+
+    /**
+     * @brief Record the observation planes a particle passed between path lengths s0 and s1.
+     *
+     * interpolate(fraction) returns the global position and momentum that
+     * far through the step; it is only called for planes actually crossed.
+     */
+    template <typename Interpolate>
+    void detectCrossings(uint64_t particleId, double s0, double s1, Interpolate interpolate) const;
+
+    /**
+     * @brief Call visitor with the orbit coordinates of the active precision.
+     */
+    template <typename Visitor>
+    void visitOrbitCoordinates(Visitor visitor);
+
+    /**
+     * @brief Push a species block of orbit coordinates with the fields of each entry.
+     *
+     * makePush() is called once per thread and returns the functor that
+     * advances one particle's position and momentum u = p / (m c).
+     */
+    template <typename Coordinates, typename MakePush>
+    void pushOnOrbit(Coordinates& coordinates, const SpeciesBlock& block, bool observing, MakePush makePush);
+
+    /**
+     * @brief Push a species block of orbit coordinates with a templated pusher.
+     */
+    template <typename Pusher, typename Coordinates>
+    void pushOnOrbit(Coordinates& coordinates, const SpeciesBlock& block, bool observing);
 
     ParticleSystem m_particleSystem;
     EMFieldManager m_fieldManager;
     std::shared_ptr<accelerator::Accelerator> m_accelerator;
     std::unique_ptr<Integrator> m_integrator;
     IntegratorFactory::Type m_integratorType = IntegratorFactory::Type::Boris;
+    CoordinateMode m_coordinateMode = CoordinateMode::Global;
+    Precision m_precision = Precision::Double;
+    OrbitCoordinates m_orbitCoordinates;
+    FloatOrbitCoordinates m_floatCoordinates;  // Used instead in Float precision
+    const accelerator::CompiledLattice* m_trackedLattice = nullptr;  // Set while tracking on the orbit
+    std::vector<EMFieldManager> m_frameFields;  // Per lattice entry, sources placed in its frame
 
     SimulationState m_state = SimulationState::Stopped;
     double m_timeStep = 1e-11;      // Default: 10 ps
@@ -146,7 +314,12 @@ private:
     size_t m_maxStepsPerFrame = 10000;  // Cap to keep UI responsive
 
     SimulationStats m_stats;
-    LossCallback m_lossCallback;
+    LossEventBuffer m_lossEvents;
+    std::vector<ObservationPlane> m_observationPlanes;  // Sorted by s
+    std::vector<size_t> m_apertureCursors;  // Lattice entry each particle was last checked in
+    std::vector<PublishedSource> m_publishedSources;  // One per component
+    uint64_t m_publishedSurvey = 0;  // Survey version of the placements
+    std::vector<RampCircuit> m_rampCircuits;
 
     // Performance tracking
     double m_lastStepTime = 0.0;
@@ -0,0 +1,53 @@
+#include "physics/Species.hpp"
+#include "utils/Logger.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace pas::physics {
+
+using namespace constants;
+
+// Constant-initialised, so particles created during static initialisation see them
+std::array<Species, SpeciesTable::CAPACITY> SpeciesTable::s_entries = {
+    Species::make(m_e, -e),
+    Species::make(m_e, e),
+    Species::make(m_p, e),
+    Species::make(m_p, -e),
+};
+std::atomic<size_t> SpeciesTable::s_count{4};
+std::mutex SpeciesTable::s_mutex;
+
+SpeciesId SpeciesTable::find(double mass, double charge) {
+    auto lookup = [mass, charge](size_t count) -> size_t {
+        for (size_t i = 0; i < count; ++i) {
+            if (s_entries[i].mass == mass && s_entries[i].charge == charge) {
+                return i;
+            }
+        }
+        return CAPACITY;
+    };
+
+    size_t index = lookup(s_count.load(std::memory_order_acquire));
+    if (index < CAPACITY) {
+        return static_cast<SpeciesId>(index);
+    }
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    const size_t count = s_count.load(std::memory_order_relaxed);
+    index = lookup(count);
+    if (index < CAPACITY) {
+        return static_cast<SpeciesId>(index);
+    }
+    if (count == CAPACITY) {
+        // Any existing entry would give the particle another species' mass and charge
+        PAS_ERROR("SpeciesTable: Table full, cannot register mass {} kg, charge {} C", mass, charge);
+        throw std::length_error("SpeciesTable: all " + std::to_string(CAPACITY) + " species are registered");
+    }
+
+    s_entries[count] = Species::make(mass, charge);
+    s_count.store(count + 1, std::memory_order_release);
+    return static_cast<SpeciesId>(count);
+}
+
+} // namespace pas::physics
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "physics/Constants.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace pas::physics {
+
+/**
+ * @brief Compact index of a particle species in the SpeciesTable.
+ */
+using SpeciesId = uint16_t;
+
+/**
+ * @brief Constant properties shared by every particle of one species.
+ *
+ * Combinations the integrators need every step are stored precomputed.
+ */
+struct Species {
+    double mass = 0.0;            // kg
+    double charge = 0.0;          // Coulombs
+    double chargeOverMass = 0.0;  // C/kg
+    double massTimesC = 0.0;      // kg*m/s
+    double restEnergy = 0.0;      // Joules
+
+    static constexpr Species make(double mass, double charge) {
+        return Species{mass, charge, mass > 0.0 ? charge / mass : 0.0, mass * constants::c,
+                       mass * constants::c2};
+    }
+};
+
+/**
+ * @brief Process-wide table of particle species.
+ *
+ * Particles hold a SpeciesId instead of their own mass and charge. The common
+ * species have fixed IDs; any other (mass, charge) pair is registered on first
+ * use and keeps its ID for the life of the process. Entries never move, so
+ * get() needs no lock; registration is serialised.
+ */
+class SpeciesTable {
+public:
+    static constexpr SpeciesId ELECTRON = 0;
+    static constexpr SpeciesId POSITRON = 1;
+    static constexpr SpeciesId PROTON = 2;
+    static constexpr SpeciesId ANTIPROTON = 3;
+
+    static constexpr size_t CAPACITY = 256;
+
+    /**
+     * @brief ID of the species with this mass and charge, registering it if new.
+     *
+     * Thread-safe.
+     * @throws std::length_error if the species is new and the table is full.
+     */
+    static SpeciesId find(double mass, double charge);
+
+    /**
+     * @brief Properties of a species.
+     */
+    static const Species& get(SpeciesId id) { return s_entries[id]; }
+
+    /**
+     * @brief Number of registered species.
+     */
+    static size_t size() { return s_count.load(std::memory_order_acquire); }
+
+private:
+    static std::array<Species, CAPACITY> s_entries;
+    static std::atomic<size_t> s_count;
+    static std::mutex s_mutex;
+};
+
+} // namespace pas::physics
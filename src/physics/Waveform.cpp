@@ -0,0 +1,78 @@
+#include "physics/Waveform.hpp"
+#include "utils/Logger.hpp"
+
+#include <algorithm>
+
+namespace pas::physics {
+
+Waveform::Waveform(std::vector<double> times, std::vector<double> values,
+                   Interpolation interpolation)
+    : m_interpolation(interpolation) {
+    if (times.empty() || times.size() != values.size()) {
+        PAS_WARN("Waveform: {} times for {} values", times.size(), values.size());
+        return;
+    }
+    if (std::adjacent_find(times.begin(), times.end(),
+                           [](double a, double b) { return !(a < b); }) != times.end()) {
+        PAS_WARN("Waveform: Sample times must be strictly increasing");
+        return;
+    }
+
+    m_times = std::move(times);
+    m_values = std::move(values);
+
+    if (m_interpolation != Interpolation::CubicSpline || m_times.size() < 3) {
+        return;
+    }
+
+    // Natural spline: tridiagonal system for the second derivatives (Thomas algorithm)
+    const size_t n = m_times.size();
+    m_secondDerivatives.assign(n, 0.0);
+    std::vector<double> upper(n, 0.0);
+    for (size_t i = 1; i + 1 < n; ++i) {
+        const double h0 = m_times[i] - m_times[i - 1];
+        const double h1 = m_times[i + 1] - m_times[i];
+        const double rhs = 6.0 * ((m_values[i + 1] - m_values[i]) / h1 -
+                                  (m_values[i] - m_values[i - 1]) / h0);
+        const double pivot = 2.0 * (h0 + h1) - h0 * upper[i - 1];
+        upper[i] = h1 / pivot;
+        m_secondDerivatives[i] = (rhs - h0 * m_secondDerivatives[i - 1]) / pivot;
+    }
+    for (size_t i = n - 2; i > 0; --i) {
+        m_secondDerivatives[i] -= upper[i] * m_secondDerivatives[i + 1];
+    }
+}
+
+double Waveform::evaluate(double time) const {
+    if (m_times.empty()) {
+        return 1.0;
+    }
+    if (time <= m_times.front()) {
+        return m_values.front();
+    }
+    if (time >= m_times.back()) {
+        return m_values.back();
+    }
+
+    const size_t i = static_cast<size_t>(
+        std::upper_bound(m_times.begin(), m_times.end(), time) - m_times.begin()) - 1;
+    const double h = m_times[i + 1] - m_times[i];
+    const double a = (m_times[i + 1] - time) / h;
+    const double b = 1.0 - a;
+    double value = a * m_values[i] + b * m_values[i + 1];
+    if (!m_secondDerivatives.empty()) {
+        value += ((a * a * a - a) * m_secondDerivatives[i] +
+                  (b * b * b - b) * m_secondDerivatives[i + 1]) * h * h / 6.0;
+    }
+    return value;
+}
+
+std::string interpolationToString(Waveform::Interpolation interpolation) {
+    switch (interpolation) {
+        case Waveform::Interpolation::Linear:      return "linear";
+        case Waveform::Interpolation::CubicSpline: return "spline";
+        default:                                   return "linear";
+    }
+}
+
+} // namespace pas::physics
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace pas::physics {
+
+/**
+ * @brief Tabulated function of time, e.g. the relative strength of a magnet ramp.
+ *
+ * Values are interpolated between the table points and held constant
+ * outside the table. Spline coefficients are computed once at construction,
+ * so evaluation is a binary search plus a polynomial.
+ */
+class Waveform {
+public:
+    enum class Interpolation {
+        Linear,
+        CubicSpline     // Natural cubic spline
+    };
+
+    /**
+     * @brief Empty waveform, evaluates to 1.
+     */
+    Waveform() = default;
+
+    /**
+     * @brief Create a waveform from a table.
+     * @param times Strictly increasing sample times [s].
+     * @param values Values at the sample times.
+     * @param interpolation Interpolation between samples.
+     *
+     * An invalid table (size mismatch or times not increasing) is rejected
+     * with a warning and leaves the waveform empty.
+     */
+    Waveform(std::vector<double> times, std::vector<double> values,
+             Interpolation interpolation = Interpolation::Linear);
+
+    /**
+     * @brief Evaluate the waveform at a time.
+     */
+    double evaluate(double time) const;
+
+    bool isEmpty() const { return m_times.empty(); }
+    size_t getPointCount() const { return m_times.size(); }
+    Interpolation getInterpolation() const { return m_interpolation; }
+
+    const std::vector<double>& getTimes() const { return m_times; }
+    const std::vector<double>& getValues() const { return m_values; }
+
+    double getStartTime() const { return m_times.empty() ? 0.0 : m_times.front(); }
+    double getEndTime() const { return m_times.empty() ? 0.0 : m_times.back(); }
+
+private:
+    std::vector<double> m_times;
+    std::vector<double> m_values;
+    std::vector<double> m_secondDerivatives;  // Spline only
+    Interpolation m_interpolation = Interpolation::Linear;
+};
+
+/**
+ * @brief Convert interpolation type to string ("linear", "spline").
+ */
+std::string interpolationToString(Waveform::Interpolation interpolation);
+
+} // namespace pas::physics
@@ -133,34 +133,39 @@ void AcceleratorRenderer::createBaseMeshes() {
 void AcceleratorRenderer::buildGeometry(const accelerator::Accelerator& accelerator) {
     m_instances.clear();
 
+    // Meshes are centred on the surveyed middle of each element, with its alignment
     const auto& components = accelerator.getComponents();
-    for (const auto& component : components) {
-        addComponentGeometry(component);
+    const accelerator::CompiledLattice& lattice = accelerator.getCompiledLattice();
+    for (size_t i = 0; i < components.size(); ++i) {
+        const accelerator::Placement center = lattice.getCenterFrame(i);
+        const glm::dvec3 origin = center.toGlobal(components[i]->getPosition());
+        glm::mat4 frame = glm::translate(glm::mat4(1.0f), glm::vec3(origin));
+        frame = frame * glm::mat4(glm::mat4_cast(center.rotation * components[i]->getRotation()));
+        addComponentGeometry(components[i], frame);
     }
 }
 
-void AcceleratorRenderer::addComponentGeometry(const std::shared_ptr<accelerator::Component>& component) {
-    glm::dvec3 pos = component->getPosition();
-
+void AcceleratorRenderer::addComponentGeometry(const std::shared_ptr<accelerator::Component>& component,
+                                               const glm::mat4& frame) {
     switch (component->getType()) {
         case accelerator::ComponentType::BeamPipe: {
             auto* pipe = static_cast<accelerator::BeamPipe*>(component.get());
-            buildBeamPipeGeometry(*pipe, pos);
+            buildBeamPipeGeometry(*pipe, frame);
             break;
         }
         case accelerator::ComponentType::Dipole: {
             auto* dipole = static_cast<accelerator::Dipole*>(component.get());
-            buildDipoleGeometry(*dipole, pos);
+            buildDipoleGeometry(*dipole, frame);
             break;
         }
         case accelerator::ComponentType::Quadrupole: {
             auto* quad = static_cast<accelerator::Quadrupole*>(component.get());
-            buildQuadrupoleGeometry(*quad, pos);
+            buildQuadrupoleGeometry(*quad, frame);
             break;
         }
         case accelerator::ComponentType::RFCavity: {
             auto* cavity = static_cast<accelerator::RFCavity*>(component.get());
-            buildRFCavityGeometry(*cavity, pos);
+            buildRFCavityGeometry(*cavity, frame);
             break;
         }
         default:
@@ -169,15 +174,13 @@ void AcceleratorRenderer::addComponentGeometry(const std::shared_ptr<accelerator
 }
 
 void AcceleratorRenderer::buildBeamPipeGeometry(const accelerator::BeamPipe& pipe,
-                                                 const glm::dvec3& position) {
+                                                const glm::mat4& frame) {
     ComponentInstance instance;
 
     // Position along beam axis (Z) with length scaling
     float length = static_cast<float>(pipe.getLength());
-    float sPos = static_cast<float>(pipe.getSPosition());
 
-    glm::mat4 transform = glm::mat4(1.0f);
-    transform = glm::translate(transform, glm::vec3(0.0f, 0.0f, sPos + length * 0.5f));
+    glm::mat4 transform = frame;
     transform = glm::rotate(transform, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
     transform = glm::scale(transform, glm::vec3(1.0f, length, 1.0f));
 
@@ -190,14 +193,12 @@ void AcceleratorRenderer::buildBeamPipeGeometry(const accelerator::BeamPipe& pip
 }
 
 void AcceleratorRenderer::buildDipoleGeometry(const accelerator::Dipole& dipole,
-                                               const glm::dvec3& position) {
+                                              const glm::mat4& frame) {
     ComponentInstance instance;
 
     float length = static_cast<float>(dipole.getLength());
-    float sPos = static_cast<float>(dipole.getSPosition());
 
-    glm::mat4 transform = glm::mat4(1.0f);
-    transform = glm::translate(transform, glm::vec3(0.0f, 0.0f, sPos + length * 0.5f));
+    glm::mat4 transform = frame;
     transform = glm::rotate(transform, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
     transform = glm::scale(transform, glm::vec3(0.15f, length, 0.15f));
 
@@ -210,15 +211,13 @@ void AcceleratorRenderer::buildDipoleGeometry(const accelerator::Dipole& dipole,
 }
 
 void AcceleratorRenderer::buildQuadrupoleGeometry(const accelerator::Quadrupole& quad,
-                                                   const glm::dvec3& position) {
+                                                  const glm::mat4& frame) {
     ComponentInstance instance;
 
     float length = static_cast<float>(quad.getLength());
-    float sPos = static_cast<float>(quad.getSPosition());
 
     // Quadrupoles rendered as boxes to distinguish from dipoles
-    glm::mat4 transform = glm::mat4(1.0f);
-    transform = glm::translate(transform, glm::vec3(0.0f, 0.0f, sPos + length * 0.5f));
+    glm::mat4 transform = frame;
     transform = glm::scale(transform, glm::vec3(0.2f, 0.2f, length));
 
     instance.transform = transform;
@@ -237,14 +236,12 @@ void AcceleratorRenderer::buildQuadrupoleGeometry(const accelerator::Quadrupole&
 }
 
 void AcceleratorRenderer::buildRFCavityGeometry(const accelerator::RFCavity& cavity,
-                                                 const glm::dvec3& position) {
+                                                const glm::mat4& frame) {
     ComponentInstance instance;
 
     float length = static_cast<float>(cavity.getLength());
-    float sPos = static_cast<float>(cavity.getSPosition());
 
-    glm::mat4 transform = glm::mat4(1.0f);
-    transform = glm::translate(transform, glm::vec3(0.0f, 0.0f, sPos + length * 0.5f));
+    glm::mat4 transform = frame;
     transform = glm::scale(transform, glm::vec3(0.25f, 0.25f, length));
 
     instance.transform = transform;
@@ -60,11 +60,12 @@ public:
 private:
     void createShaders();
     void createBaseMeshes();
-    void addComponentGeometry(const std::shared_ptr<accelerator::Component>& component);
-    void buildBeamPipeGeometry(const accelerator::BeamPipe& pipe, const glm::dvec3& position);
-    void buildDipoleGeometry(const accelerator::Dipole& dipole, const glm::dvec3& position);
-    void buildQuadrupoleGeometry(const accelerator::Quadrupole& quad, const glm::dvec3& position);
-    void buildRFCavityGeometry(const accelerator::RFCavity& cavity, const glm::dvec3& position);
+    void addComponentGeometry(const std::shared_ptr<accelerator::Component>& component,
+                              const glm::mat4& frame);
+    void buildBeamPipeGeometry(const accelerator::BeamPipe& pipe, const glm::mat4& frame);
+    void buildDipoleGeometry(const accelerator::Dipole& dipole, const glm::mat4& frame);
+    void buildQuadrupoleGeometry(const accelerator::Quadrupole& quad, const glm::mat4& frame);
+    void buildRFCavityGeometry(const accelerator::RFCavity& cavity, const glm::mat4& frame);
 
     struct ComponentInstance {
         glm::mat4 transform;
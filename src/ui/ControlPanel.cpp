@@ -65,6 +65,13 @@ void ControlPanel::draw() {
     }
     ImGui::SetItemTooltip("Numerical integration method");
 
+    // Arithmetic precision of Boris and RK4
+    const char* precisions[] = { "Double", "Float", "Mixed" };
+    if (ImGui::Combo("Precision", &m_precision, precisions, 3)) {
+        m_engine.setPrecision(static_cast<physics::Precision>(m_precision));
+    }
+    ImGui::SetItemTooltip("Float stores and pushes particles in float; Mixed keeps double state");
+
     ImGui::Spacing();
     ImGui::Separator();
     ImGui::Text("Statistics");
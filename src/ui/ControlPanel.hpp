@@ -21,6 +21,7 @@ private:
     physics::PhysicsEngine& m_engine;
     float m_timeScale = 1e6f;
     int m_integratorType = 2;  // Boris
+    int m_precision = 0;       // Double
     bool m_wireframeMode = false;
     bool m_showDemoWindow = false;
 };
@@ -0,0 +1,81 @@
+#include "ui/LossMapPanel.hpp"
+#include <algorithm>
+#include <numeric>
+
+namespace pas::ui {
+
+LossMapPanel::LossMapPanel(const diagnostics::LossMap& lossMap)
+    : UIPanel("Loss Map")
+    , m_lossMap(lossMap) {}
+
+void LossMapPanel::update() {
+    const auto& histogram = m_lossMap.getSHistogram();
+    m_sHistogram.resize(histogram.size());
+    std::transform(histogram.begin(), histogram.end(), m_sHistogram.begin(),
+                   [](uint64_t count) { return static_cast<float>(count); });
+
+    // Rank components by loss count
+    const auto& losses = m_lossMap.getComponentLosses();
+    m_topComponents.resize(losses.size());
+    std::iota(m_topComponents.begin(), m_topComponents.end(), size_t{0});
+    size_t rows = std::min(MAX_TABLE_ROWS, m_topComponents.size());
+    std::partial_sort(m_topComponents.begin(), m_topComponents.begin() + static_cast<ptrdiff_t>(rows),
+                      m_topComponents.end(),
+                      [&losses](size_t a, size_t b) { return losses[a] > losses[b]; });
+    m_topComponents.resize(rows);
+}
+
+void LossMapPanel::draw() {
+    if (!m_visible) return;
+
+    ImGui::SetNextWindowPos(ImVec2(730, 10), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(400, 400), ImGuiCond_FirstUseEver);
+
+    if (!ImGui::Begin(m_title.c_str(), &m_visible)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("Total Losses: %llu", static_cast<unsigned long long>(m_lossMap.getTotalLosses()));
+    ImGui::Text("Outside Lattice: %llu", static_cast<unsigned long long>(m_lossMap.getUnassignedLosses()));
+    ImGui::Text("Bin Width: %.3f m", m_lossMap.getBinWidth());
+
+    if (ImGui::Button("Export CSV")) {
+        m_lossMap.exportCSV(m_exportPath);
+    }
+
+    ImGui::Spacing();
+    drawSHistogram();
+
+    ImGui::Spacing();
+    drawComponentTable();
+
+    ImGui::End();
+}
+
+void LossMapPanel::drawSHistogram() {
+    ImGui::Text("Losses vs s (0 - %.1f m)", m_lossMap.getLength());
+    ImGui::PlotHistogram("##LossHist", m_sHistogram.data(), static_cast<int>(m_sHistogram.size()),
+                         0, nullptr, 0.0f, FLT_MAX, ImVec2(-1, 120));
+}
+
+void LossMapPanel::drawComponentTable() {
+    ImGui::Text("Top Loss Locations");
+    ImGui::Separator();
+
+    const auto& losses = m_lossMap.getComponentLosses();
+    if (ImGui::BeginTable("LossComponents", 2, ImGuiTableFlags_SizingStretchProp)) {
+        for (size_t index : m_topComponents) {
+            if (losses[index] == 0) break;
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", m_lossMap.getComponentName(index).c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(losses[index]));
+        }
+        ImGui::EndTable();
+    }
+}
+
+} // namespace pas::ui
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "ui/UIPanel.hpp"
+#include "diagnostics/LossMap.hpp"
+#include <string>
+#include <vector>
+
+namespace pas::ui {
+
+/**
+ * @brief Panel displaying the beam loss map along the lattice.
+ */
+class LossMapPanel : public UIPanel {
+public:
+    LossMapPanel(const diagnostics::LossMap& lossMap);
+
+    void draw() override;
+
+    /**
+     * @brief Refresh plot data from the loss map (call each frame).
+     */
+    void update();
+
+private:
+    void drawSHistogram();
+    void drawComponentTable();
+
+    const diagnostics::LossMap& m_lossMap;
+
+    std::vector<float> m_sHistogram;
+    std::vector<size_t> m_topComponents;
+    std::string m_exportPath = "loss_map.csv";
+
+    static constexpr size_t MAX_TABLE_ROWS = 20;
+};
+
+} // namespace pas::ui
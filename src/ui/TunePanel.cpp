@@ -0,0 +1,148 @@
+#include "ui/TunePanel.hpp"
+#include <algorithm>
+
+namespace pas::ui {
+
+TunePanel::TunePanel(diagnostics::TuneAnalyzer& analyzer)
+    : UIPanel("Tune")
+    , m_analyzer(analyzer) {}
+
+void TunePanel::setAccelerator(std::shared_ptr<const accelerator::Accelerator> accelerator,
+                               double referenceMomentum) {
+    m_accelerator = std::move(accelerator);
+    m_referenceMomentum = referenceMomentum;
+    m_monitorIndex = 0;
+}
+
+void TunePanel::update() {
+    if (!m_analyzer.poll()) {
+        return;
+    }
+
+    // Cache the tune-vs-offset curves for plotting
+    m_chromaticityX.clear();
+    m_chromaticityY.clear();
+    const auto& latest = m_analyzer.getLatest();
+    if (latest && latest->chromaticity) {
+        for (size_t i = 0; i < latest->chromaticity->deltas.size(); ++i) {
+            m_chromaticityX.push_back(static_cast<float>(latest->chromaticity->tunesX[i]));
+            m_chromaticityY.push_back(static_cast<float>(latest->chromaticity->tunesY[i]));
+        }
+    }
+}
+
+void TunePanel::draw() {
+    if (!m_visible) return;
+
+    ImGui::SetNextWindowPos(ImVec2(320, 520), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(400, 360), ImGuiCond_FirstUseEver);
+
+    if (!ImGui::Begin(m_title.c_str(), &m_visible)) {
+        ImGui::End();
+        return;
+    }
+
+    drawControls();
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    drawResults();
+
+    ImGui::End();
+}
+
+void TunePanel::drawControls() {
+    int method = m_analyzer.getMethod() == diagnostics::TuneMethod::NAFF ? 1 : 0;
+    const char* methods[] = {"FFT", "NAFF"};
+    if (ImGui::Combo("Method", &method, methods, 2)) {
+        m_analyzer.setMethod(method == 1 ? diagnostics::TuneMethod::NAFF : diagnostics::TuneMethod::FFT);
+    }
+
+    const bool busy = m_analyzer.isBusy();
+
+    // Tracking through the linear lattice model
+    ImGui::Text("Tracking");
+    ImGui::InputInt("Turns", &m_turns, 256, 1024);
+    m_turns = std::max(m_turns, static_cast<int>(diagnostics::TuneAnalyzer::MIN_TURNS));
+    ImGui::SliderInt("Offsets", &m_offsetCount, 0, 21);
+    ImGui::SliderFloat("Max dp/p", &m_maxOffset, 1e-5f, 1e-2f, "%.1e", ImGuiSliderFlags_Logarithmic);
+
+    if (ImGui::Button("Measure Tunes & Chromaticity") && !busy && m_accelerator) {
+        startTracking();
+    }
+
+    // Turn-by-turn data from beam position monitors
+    if (m_accelerator) {
+        auto monitors = m_accelerator->getMonitors();
+        if (!monitors.empty()) {
+            ImGui::Spacing();
+            ImGui::Text("Beam Position Monitors");
+
+            m_monitorIndex = std::min(m_monitorIndex, static_cast<int>(monitors.size()) - 1);
+            std::vector<const char*> names;
+            for (const auto& monitor : monitors) {
+                names.push_back(monitor->getName().c_str());
+            }
+            ImGui::Combo("Monitor", &m_monitorIndex, names.data(), static_cast<int>(names.size()));
+
+            const auto& monitor = monitors[static_cast<size_t>(m_monitorIndex)];
+            ImGui::Text("Turns recorded: %llu", static_cast<unsigned long long>(monitor->getTurnCount()));
+            if (ImGui::Button("Analyze Monitor") && !busy) {
+                m_analyzer.analyzeMonitor(*monitor);
+            }
+        }
+    }
+
+    if (busy) {
+        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "Analyzing...");
+    }
+}
+
+void TunePanel::drawResults() {
+    const auto& latest = m_analyzer.getLatest();
+    if (!latest) {
+        ImGui::TextDisabled("No measurement yet");
+        return;
+    }
+
+    ImGui::Text("Source: %s (%zu turns)", latest->source.c_str(), latest->turns);
+    if (latest->tuneX && latest->tuneY) {
+        ImGui::Text("Qx: %.6f", *latest->tuneX);
+        ImGui::Text("Qy: %.6f", *latest->tuneY);
+    } else {
+        ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "No tune found (unstable or lost)");
+    }
+
+    if (latest->chromaticity) {
+        const auto& chroma = *latest->chromaticity;
+        ImGui::Spacing();
+        if (chroma.valid) {
+            ImGui::Text("Chromaticity Qx': %.3f", chroma.chromaticityX);
+            ImGui::Text("Chromaticity Qy': %.3f", chroma.chromaticityY);
+        } else {
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Chromaticity fit failed");
+        }
+
+        if (!m_chromaticityX.empty()) {
+            ImGui::PlotLines("Qx vs dp/p", m_chromaticityX.data(), static_cast<int>(m_chromaticityX.size()),
+                             0, nullptr, FLT_MAX, FLT_MAX, ImVec2(0, 60));
+            ImGui::PlotLines("Qy vs dp/p", m_chromaticityY.data(), static_cast<int>(m_chromaticityY.size()),
+                             0, nullptr, FLT_MAX, FLT_MAX, ImVec2(0, 60));
+        }
+    }
+}
+
+void TunePanel::startTracking() {
+    std::vector<double> deltas;
+    if (m_offsetCount > 1) {
+        for (int i = 0; i < m_offsetCount; ++i) {
+            double fraction = static_cast<double>(i) / static_cast<double>(m_offsetCount - 1);
+            deltas.push_back(static_cast<double>(m_maxOffset) * (2.0 * fraction - 1.0));
+        }
+    }
+
+    accelerator::LatticeTracker tracker(*m_accelerator, m_referenceMomentum);
+    m_analyzer.analyzeTracking(tracker, std::move(deltas), static_cast<size_t>(m_turns));
+}
+
+} // namespace pas::ui
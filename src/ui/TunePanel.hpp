@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ui/UIPanel.hpp"
+#include "diagnostics/TuneAnalyzer.hpp"
+#include "accelerator/Accelerator.hpp"
+#include <memory>
+#include <vector>
+
+namespace pas::ui {
+
+/**
+ * @brief Panel for tune and chromaticity measurements.
+ *
+ * Starts analyses on the TuneAnalyzer's background thread and shows the
+ * latest result; the frame loop never waits for an analysis to finish.
+ */
+class TunePanel : public UIPanel {
+public:
+    TunePanel(diagnostics::TuneAnalyzer& analyzer);
+
+    /**
+     * @brief Set the lattice to measure.
+     * @param referenceMomentum Reference momentum for tracking [kg*m/s].
+     */
+    void setAccelerator(std::shared_ptr<const accelerator::Accelerator> accelerator,
+                        double referenceMomentum);
+
+    void draw() override;
+
+    /**
+     * @brief Collect finished analyses (call each frame).
+     */
+    void update();
+
+private:
+    void drawControls();
+    void drawResults();
+    void startTracking();
+
+    diagnostics::TuneAnalyzer& m_analyzer;
+    std::shared_ptr<const accelerator::Accelerator> m_accelerator;
+    double m_referenceMomentum = 0.0;
+
+    int m_turns = 1024;
+    int m_offsetCount = 9;
+    float m_maxOffset = 1e-3f;
+    int m_monitorIndex = 0;
+
+    std::vector<float> m_chromaticityX;
+    std::vector<float> m_chromaticityY;
+};
+
+} // namespace pas::ui
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace pas::utils {
+
+/**
+ * @brief Append-only buffer stored as a list of fixed-capacity chunks.
+ *
+ * Appending never moves existing elements, so growth costs one allocation per
+ * chunk instead of repeated reallocation and copying. Full chunks can be
+ * handed off (e.g. written to disk) and released individually.
+ *
+ * Not thread-safe: use one buffer per thread.
+ */
+template<typename T, size_t ChunkCapacity = 512>
+class ChunkedBuffer {
+public:
+    static_assert(ChunkCapacity > 0, "ChunkCapacity must be positive");
+
+    /**
+     * @brief Append an element.
+     */
+    void push_back(const T& value) {
+        if (m_chunks.empty() || m_chunks.back()->size() == ChunkCapacity) {
+            auto chunk = std::make_unique<std::vector<T>>();
+            chunk->reserve(ChunkCapacity);
+            m_chunks.push_back(std::move(chunk));
+        }
+        m_chunks.back()->push_back(value);
+        ++m_size;
+    }
+
+    /**
+     * @brief Get the total number of stored elements.
+     */
+    size_t size() const { return m_size; }
+
+    /**
+     * @brief Check if the buffer is empty.
+     */
+    bool empty() const { return m_size == 0; }
+
+    /**
+     * @brief Get the number of allocated chunks.
+     */
+    size_t getChunkCount() const { return m_chunks.size(); }
+
+    /**
+     * @brief Release all elements and chunks.
+     */
+    void clear() {
+        m_chunks.clear();
+        m_size = 0;
+    }
+
+    /**
+     * @brief Visit every chunk in insertion order.
+     * @param visitor Callable taking std::span<const T>.
+     */
+    template<typename Visitor>
+    void forEachChunk(Visitor&& visitor) const {
+        for (const auto& chunk : m_chunks) {
+            visitor(std::span<const T>(*chunk));
+        }
+    }
+
+    /**
+     * @brief Hand off and release all full chunks, keeping the partial tail.
+     * @param visitor Callable taking std::span<const T>.
+     * @return Number of elements released.
+     */
+    template<typename Visitor>
+    size_t drainFullChunks(Visitor&& visitor) {
+        size_t released = 0;
+        size_t fullCount = 0;
+        while (fullCount < m_chunks.size() && m_chunks[fullCount]->size() == ChunkCapacity) {
+            visitor(std::span<const T>(*m_chunks[fullCount]));
+            released += ChunkCapacity;
+            ++fullCount;
+        }
+        m_chunks.erase(m_chunks.begin(), m_chunks.begin() + static_cast<ptrdiff_t>(fullCount));
+        m_size -= released;
+        return released;
+    }
+
+    /**
+     * @brief Append all elements to a vector and release the chunks.
+     */
+    void moveInto(std::vector<T>& out) {
+        out.reserve(out.size() + m_size);
+        for (const auto& chunk : m_chunks) {
+            out.insert(out.end(), chunk->begin(), chunk->end());
+        }
+        clear();
+    }
+
+private:
+    std::vector<std::unique_ptr<std::vector<T>>> m_chunks;
+    size_t m_size = 0;
+};
+
+} // namespace pas::utils
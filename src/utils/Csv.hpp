@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace pas::utils {
+
+/**
+ * @brief Quote a CSV field as RFC 4180 does: in double quotes, with embedded quotes doubled.
+ */
+inline std::string quoteCsvField(std::string_view text) {
+    std::string field = "\"";
+    for (char ch : text) {
+        if (ch == '"') {
+            field += '"';
+        }
+        field += ch;
+    }
+    field += '"';
+    return field;
+}
+
+} // namespace pas::utils
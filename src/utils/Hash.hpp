@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace pas::utils {
+
+// 64-bit FNV-1a parameters
+inline constexpr uint64_t FNV_OFFSET_BASIS = 1469598103934665603ull;
+inline constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+/**
+ * @brief Fold one byte into a running FNV-1a hash.
+ */
+inline uint64_t fnv1aStep(uint64_t hash, unsigned char byte) {
+    return (hash ^ byte) * FNV_PRIME;
+}
+
+/**
+ * @brief 64-bit FNV-1a hash of a byte string.
+ */
+inline uint64_t fnv1a(std::string_view bytes) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (char c : bytes) {
+        hash = fnv1aStep(hash, static_cast<unsigned char>(c));
+    }
+    return hash;
+}
+
+} // namespace pas::utils
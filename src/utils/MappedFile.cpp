@@ -0,0 +1,207 @@
+#include "utils/MappedFile.hpp"
+#include "utils/Logger.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pas::utils {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_writable = std::exchange(other.m_writable, false);
+        m_path = std::move(other.m_path);
+#ifdef _WIN32
+        m_fileHandle = std::exchange(other.m_fileHandle, nullptr);
+        m_mappingHandle = std::exchange(other.m_mappingHandle, nullptr);
+#else
+        m_fd = std::exchange(other.m_fd, -1);
+#endif
+    }
+    return *this;
+}
+
+bool MappedFile::openReadOnly(const std::string& filepath) {
+    return map(filepath, 0, false);
+}
+
+bool MappedFile::create(const std::string& filepath, size_t size) {
+    if (size == 0) {
+        PAS_ERROR("MappedFile: Cannot create empty mapping: {}", filepath);
+        return false;
+    }
+    return map(filepath, size, true);
+}
+
+#ifdef _WIN32
+
+bool MappedFile::map(const std::string& filepath, size_t size, bool writable) {
+    close();
+
+    HANDLE file = CreateFileA(filepath.c_str(),
+                              writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              writable ? CREATE_ALWAYS : OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        PAS_ERROR("MappedFile: Could not open {}", filepath);
+        return false;
+    }
+
+    if (!writable) {
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(file, &fileSize);
+        size = static_cast<size_t>(fileSize.QuadPart);
+    }
+    if (size == 0) {
+        // Empty files cannot be mapped
+        CloseHandle(file);
+        PAS_WARN("MappedFile: {} is empty", filepath);
+        return false;
+    }
+
+    ULARGE_INTEGER mapSize;
+    mapSize.QuadPart = size;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                        mapSize.HighPart, mapSize.LowPart, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        PAS_ERROR("MappedFile: Could not map {}", filepath);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        PAS_ERROR("MappedFile: Could not map view of {}", filepath);
+        return false;
+    }
+
+    m_fileHandle = file;
+    m_mappingHandle = mapping;
+    m_data = static_cast<std::byte*>(view);
+    m_size = size;
+    m_writable = writable;
+    m_path = filepath;
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mappingHandle) {
+        CloseHandle(m_mappingHandle);
+    }
+    if (m_fileHandle) {
+        CloseHandle(m_fileHandle);
+    }
+    m_data = nullptr;
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+    m_size = 0;
+    m_writable = false;
+    m_path.clear();
+}
+
+void MappedFile::flush() {
+    if (m_data && m_writable) {
+        FlushViewOfFile(m_data, m_size);
+    }
+}
+
+#else
+
+bool MappedFile::map(const std::string& filepath, size_t size, bool writable) {
+    close();
+
+    int fd = writable ? ::open(filepath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)
+                      : ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        PAS_ERROR("MappedFile: Could not open {}", filepath);
+        return false;
+    }
+
+    if (writable) {
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            PAS_ERROR("MappedFile: Could not resize {} to {} bytes", filepath, size);
+            return false;
+        }
+    } else {
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            PAS_ERROR("MappedFile: Could not stat {}", filepath);
+            return false;
+        }
+        size = static_cast<size_t>(info.st_size);
+    }
+
+    if (size == 0) {
+        ::close(fd);
+        PAS_WARN("MappedFile: {} is empty", filepath);
+        return false;
+    }
+
+    void* view = ::mmap(nullptr, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                        MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        ::close(fd);
+        PAS_ERROR("MappedFile: Could not map {}", filepath);
+        return false;
+    }
+
+    m_fd = fd;
+    m_data = static_cast<std::byte*>(view);
+    m_size = size;
+    m_writable = writable;
+    m_path = filepath;
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        ::munmap(m_data, m_size);
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    m_data = nullptr;
+    m_fd = -1;
+    m_size = 0;
+    m_writable = false;
+    m_path.clear();
+}
+
+void MappedFile::flush() {
+    if (m_data && m_writable) {
+        ::msync(m_data, m_size, MS_SYNC);
+    }
+}
+
+#endif
+
+} // namespace pas::utils
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace pas::utils {
+
+/**
+ * @brief Memory-mapped file (RAII).
+ *
+ * Maps a whole file into the address space, either read-only or read-write.
+ * Writes through a read-write mapping are visible to other processes that
+ * map the same file, which lets analysis tools follow a running simulation.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    // Move-only
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Map an existing file read-only.
+     * @return True on success.
+     */
+    bool openReadOnly(const std::string& filepath);
+
+    /**
+     * @brief Create (or truncate) a file of the given size and map it read-write.
+     * @return True on success.
+     */
+    bool create(const std::string& filepath, size_t size);
+
+    /**
+     * @brief Unmap and close the file.
+     */
+    void close();
+
+    /**
+     * @brief Flush modified pages to disk.
+     */
+    void flush();
+
+    bool isOpen() const { return m_data != nullptr; }
+    bool isWritable() const { return m_writable; }
+    size_t size() const { return m_size; }
+    const std::string& getPath() const { return m_path; }
+
+    std::byte* data() { return m_data; }
+    const std::byte* data() const { return m_data; }
+
+    /**
+     * @brief View the mapped bytes as text.
+     */
+    std::string_view view() const {
+        return std::string_view(reinterpret_cast<const char*>(m_data), m_size);
+    }
+
+private:
+    bool map(const std::string& filepath, size_t size, bool writable);
+
+    std::byte* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_writable = false;
+    std::string m_path;
+
+#ifdef _WIN32
+    void* m_fileHandle = nullptr;
+    void* m_mappingHandle = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+} // namespace pas::utils
@@ -0,0 +1,49 @@
+#pragma once
+
+#ifdef PAS_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+namespace pas::utils {
+
+/**
+ * @brief Get the maximum number of threads a parallel region may use.
+ *
+ * Returns 1 when the build has no OpenMP support.
+ */
+inline int getMaxThreads() {
+#ifdef PAS_ENABLE_OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/**
+ * @brief Limit the threads of parallel regions started by the calling thread.
+ *
+ * Used by thread pool workers so nested OpenMP loops do not oversubscribe
+ * the machine. No effect when OpenMP is disabled.
+ */
+inline void setMaxThreads(int threads) {
+#ifdef PAS_ENABLE_OPENMP
+    omp_set_num_threads(threads);
+#else
+    (void)threads;
+#endif
+}
+
+/**
+ * @brief Get the index of the calling thread within the current parallel region.
+ *
+ * Returns 0 outside of a parallel region or when OpenMP is disabled.
+ */
+inline int getThreadIndex() {
+#ifdef PAS_ENABLE_OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+} // namespace pas::utils
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+namespace pas::utils {
+
+/**
+ * @brief Independent seed for one of several random streams (SplitMix64 finalizer).
+ *
+ * Streams with different indices are decorrelated even for adjacent base seeds.
+ */
+inline uint64_t streamSeed(uint64_t seed, uint64_t stream) {
+    uint64_t z = seed + 0x9E3779B97F4A7C15ull * (stream + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+} // namespace pas::utils
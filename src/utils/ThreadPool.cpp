@@ -0,0 +1,63 @@
+#include "utils/ThreadPool.hpp"
+#include "utils/Parallel.hpp"
+
+#include <algorithm>
+
+namespace pas::utils {
+
+ThreadPool::ThreadPool(size_t threads, int innerThreads) {
+    if (threads == 0) {
+        threads = static_cast<size_t>(std::max(getMaxThreads(), 1));
+    }
+
+    m_workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        m_workers.emplace_back([this, innerThreads]() { workerLoop(innerThreads); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_tasks.empty() && m_running == 0; });
+}
+
+void ThreadPool::workerLoop(int innerThreads) {
+    setMaxThreads(std::max(innerThreads, 1));
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+            if (m_tasks.empty()) {
+                return;  // Stopping with nothing left to do
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            ++m_running;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_running;
+            if (m_tasks.empty() && m_running == 0) {
+                m_idle.notify_all();
+            }
+        }
+    }
+}
+
+} // namespace pas::utils
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace pas::utils {
+
+/**
+ * @brief Fixed-size pool of worker threads executing queued tasks.
+ *
+ * Each worker limits its own OpenMP parallel regions to innerThreads, so
+ * tasks that call parallel code (e.g. PhysicsEngine::step) share the cores
+ * with the other workers instead of oversubscribing them.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Start the workers.
+     * @param threads Number of workers; 0 uses getMaxThreads().
+     * @param innerThreads OpenMP threads available to each task.
+     */
+    explicit ThreadPool(size_t threads = 0, int innerThreads = 1);
+
+    /**
+     * @brief Finish all queued tasks and join the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queue a task.
+     * @return Future for the task's result; exceptions are rethrown by get().
+     */
+    template <typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<F>> {
+        using Result = std::invoke_result_t<F>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.emplace_back([packaged]() { (*packaged)(); });
+        }
+        m_condition.notify_one();
+        return future;
+    }
+
+    /**
+     * @brief Block until the queue is empty and no task is running.
+     */
+    void wait();
+
+    size_t getThreadCount() const { return m_workers.size(); }
+
+private:
+    void workerLoop(int innerThreads);
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::condition_variable m_idle;
+    size_t m_running = 0;
+    bool m_stopping = false;
+};
+
+} // namespace pas::utils
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "accelerator/Accelerator.hpp"
+
+#include <memory>
+#include <string>
+
+namespace pas::tests {
+
+/**
+ * @brief Build the closed FODO ring shared by the optics and tracking suites.
+ *
+ * Each 10 m cell is QF<i>, a 4.9 m drift, QD<i> and another 4.9 m drift,
+ * with 0.1 m quadrupoles of normalized gradient ±k1. At k1 = 2 the quads
+ * act as nearly thin f = 5 m lenses, giving about 60 degrees per cell.
+ *
+ * @param k1 Normalized quadrupole gradient (1/m²)
+ * @param cells Number of FODO cells
+ * @param brho Reference magnetic rigidity (T·m)
+ * @param aperture Aperture applied to every quadrupole and drift
+ */
+inline std::shared_ptr<accelerator::Accelerator> makeFODORing(
+    double k1, size_t cells, double brho,
+    const accelerator::Aperture& aperture = accelerator::Aperture()) {
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    for (size_t i = 0; i < cells; ++i) {
+        std::string index = std::to_string(i);
+        acc->addComponent(std::make_shared<accelerator::Quadrupole>(
+            "QF" + index, 0.1, k1 * brho, aperture));
+        acc->addComponent(std::make_shared<accelerator::BeamPipe>("DF" + index, 4.9, aperture));
+        acc->addComponent(std::make_shared<accelerator::Quadrupole>(
+            "QD" + index, 0.1, -k1 * brho, aperture));
+        acc->addComponent(std::make_shared<accelerator::BeamPipe>("DD" + index, 4.9, aperture));
+    }
+    acc->closeRing();
+    return acc;
+}
+
+} // namespace pas::tests
@@ -123,6 +123,104 @@ TEST_F(AcceleratorTest, GetComponentAtS) {
     EXPECT_EQ(atS5->getName(), "Pipe3");
 }
 
+TEST_F(AcceleratorTest, GetComponentAtSMatchesLinearScan) {
+    // Large ring with zero-length detectors between the elements
+    for (int i = 0; i < 500; ++i) {
+        accelerator.addComponent(std::make_shared<BeamPipe>("Pipe" + std::to_string(i), 0.5 + 0.01 * (i % 7)));
+        if (i % 3 == 0) {
+            accelerator.addComponent(std::make_shared<Detector>("Det" + std::to_string(i)));
+        }
+    }
+    accelerator.closeRing();
+    const double circumference = accelerator.getCircumference();
+
+    size_t cursor = 0;
+    for (int i = 0; i < 5000; ++i) {
+        const double s = 2.5 * circumference * i / 5000.0 - 0.5 * circumference;
+        const double wrapped = s - circumference * std::floor(s / circumference);
+        std::optional<size_t> expected;
+        for (size_t j = 0; j < accelerator.getComponentCount(); ++j) {
+            if (accelerator.getComponent(j)->containsS(wrapped)) {
+                expected = j;
+                break;
+            }
+        }
+        EXPECT_EQ(accelerator.findComponentIndexAtS(s), expected);
+        EXPECT_EQ(accelerator.findComponentIndexAtS(s, cursor), expected);
+    }
+}
+
+TEST_F(AcceleratorTest, SLookupsFollowEdits) {
+    for (const char* name : {"A", "B", "C"}) {
+        accelerator.addComponent(std::make_shared<BeamPipe>(name, 1.0));
+    }
+    accelerator.computeLattice();
+    EXPECT_DOUBLE_EQ(accelerator.getSPosition(2), 2.0);
+
+    // Same count after clear(), different lengths
+    accelerator.clear();
+    for (const char* name : {"D", "E", "F"}) {
+        accelerator.addComponent(std::make_shared<BeamPipe>(name, 2.0));
+    }
+    EXPECT_DOUBLE_EQ(accelerator.getSPosition(2), 4.0);
+    EXPECT_EQ(accelerator.findComponentIndexAtS(3.0), std::optional<size_t>(1));
+
+    accelerator.replaceComponent(0, std::make_shared<BeamPipe>("G", 4.0));
+    EXPECT_DOUBLE_EQ(accelerator.getSPosition(1), 4.0);
+    size_t cursor = 0;
+    EXPECT_EQ(accelerator.findComponentIndexAtS(3.0, cursor), std::optional<size_t>(0));
+
+    EXPECT_TRUE(std::isnan(accelerator.getSPosition(3)));
+}
+
+TEST_F(AcceleratorTest, SLookupsScanOnlyAfterEdits) {
+    for (int i = 0; i < 100; ++i) {
+        accelerator.addComponent(std::make_shared<Quadrupole>("Q" + std::to_string(i), 1.0, 1.0));
+    }
+    accelerator.computeLattice();
+    const CompiledLattice& compiled = accelerator.getCompiledLattice();
+    const size_t scans = compiled.getRefreshCount();
+
+    // Strength edits leave s alone, so lookups keep using the compiled arrays
+    std::static_pointer_cast<Quadrupole>(accelerator.getComponent(5))->setGradient(2.0);
+    size_t cursor = 0;
+    for (size_t i = 0; i < 100; ++i) {
+        const double s = static_cast<double>(i) + 0.5;
+        EXPECT_DOUBLE_EQ(accelerator.getSPosition(i), static_cast<double>(i));
+        EXPECT_EQ(accelerator.findComponentIndexAtS(s), std::optional<size_t>(i));
+        EXPECT_EQ(accelerator.findComponentIndexAtS(s, cursor), std::optional<size_t>(i));
+    }
+    EXPECT_EQ(compiled.getRefreshCount(), scans);
+
+    // One scan after an edit to the component list, then none again
+    accelerator.addDrift(1.0);
+    EXPECT_EQ(accelerator.findComponentIndexAtS(100.5), std::optional<size_t>(100));
+    EXPECT_DOUBLE_EQ(accelerator.getSPosition(100), 100.0);
+    EXPECT_EQ(compiled.getRefreshCount(), scans + 1);
+}
+
+TEST_F(AcceleratorTest, NameLookupFollowsEdits) {
+    accelerator.addComponent(std::make_shared<BeamPipe>("A", 1.0));
+    accelerator.addComponent(std::make_shared<BeamPipe>("B", 1.0));
+    accelerator.addComponent(std::make_shared<BeamPipe>("B", 2.0));
+
+    // Duplicates resolve to the first component
+    EXPECT_DOUBLE_EQ(accelerator.getComponent("B")->getLength(), 1.0);
+
+    accelerator.insertComponent(0, std::make_shared<BeamPipe>("C", 3.0));
+    EXPECT_EQ(accelerator.getComponent("A"), accelerator.getComponent(1));
+
+    accelerator.removeComponent(2);
+    EXPECT_DOUBLE_EQ(accelerator.getComponent("B")->getLength(), 2.0);
+
+    accelerator.removeComponent("B");
+    EXPECT_EQ(accelerator.getComponent("B"), nullptr);
+    EXPECT_EQ(accelerator.clone()->getComponent("C")->getLength(), 3.0);
+
+    accelerator.clear();
+    EXPECT_EQ(accelerator.getComponent("A"), nullptr);
+}
+
 // FODO cell construction
 
 TEST_F(AcceleratorTest, BuildFODOCell) {
@@ -161,6 +259,12 @@ TEST_F(AcceleratorTest, BuildFODOLattice) {
     // 4 cells * 4 components = 16 components
     EXPECT_EQ(accelerator.getComponentCount(), 16u);
     EXPECT_EQ(accelerator.getQuadrupoleCount(), 8u);
+
+    // Every cell's magnets can be found and tuned on their own
+    auto qf3 = accelerator.getComponent("FODO_3_QF");
+    ASSERT_NE(qf3, nullptr);
+    EXPECT_EQ(qf3, accelerator.getComponent(8));
+    EXPECT_NE(qf3, accelerator.getComponent("FODO_1_QF"));
 }
 
 // Lattice type
@@ -197,6 +301,14 @@ TEST_F(AcceleratorTest, PopulateFieldManager) {
 
     // BeamPipe has no field, Dipole and Quad do
     EXPECT_EQ(manager.getSourceCount(), 2u);
+
+    // Fields sit at the surveyed places of their components
+    accelerator.computeLattice();
+    manager.clear();
+    accelerator.populateFieldManager(manager);
+    EXPECT_DOUBLE_EQ(manager.evaluate(glm::dvec3(0.0, 0.0, 1.5), 0.0).B.y, 1.0);
+    EXPECT_DOUBLE_EQ(manager.evaluate(glm::dvec3(0.0, 0.0, 0.5), 0.0).B.y, 0.0);
+    EXPECT_DOUBLE_EQ(manager.evaluate(glm::dvec3(0.01, 0.0, 2.25), 0.0).B.y, 0.5);
 }
 
 // Component filtering
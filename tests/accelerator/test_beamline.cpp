@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+#include "accelerator/Accelerator.hpp"
+#include "accelerator/Beamline.hpp"
+#include "accelerator/LatticeTracker.hpp"
+#include "accelerator/MagnetErrors.hpp"
+
+namespace pas::accelerator::tests {
+
+class BeamlineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        beamline.defineElement(std::make_shared<Quadrupole>("QF", 0.5, 20.0));
+        beamline.defineElement(std::make_shared<Quadrupole>("QD", 0.5, -20.0));
+        beamline.defineElement(std::make_shared<BeamPipe>("D", 2.0));
+        beamline.defineElement(std::make_shared<Dipole>("B", 3.0, 1.0));
+        beamline.defineElement(std::make_shared<BeamPositionMonitor>("BPM"));
+
+        beamline.defineLine("CELL", {{"QF"}, {"D"}, {"B"}, {"BPM"}, {"QD"}, {"D"}});
+        beamline.defineLine("ARC", {{"CELL", 3}, {"CELL", 2, true}, {"D"}});
+        beamline.defineLine("RING", {{"ARC", 1000}});
+    }
+
+    /**
+     * @brief Fully expanded line, for comparison.
+     */
+    std::vector<Beamline::Occurrence> expanded(const std::string& line) const {
+        std::vector<Beamline::Occurrence> occurrences;
+        beamline.expand(line, [&](const Beamline::Occurrence& o) { occurrences.push_back(o); });
+        return occurrences;
+    }
+
+    Beamline beamline;
+};
+
+TEST_F(BeamlineTest, CountsWithoutExpanding) {
+    EXPECT_EQ(beamline.getUniqueElementCount(), 5u);
+    EXPECT_EQ(beamline.getElementCount("CELL"), 6u);
+    EXPECT_EQ(beamline.getElementCount("ARC"), 31u);
+    EXPECT_EQ(beamline.getElementCount("RING"), 31000u);
+    EXPECT_NEAR(beamline.getLength("CELL"), 8.001, 1e-12);  // The monitor is 1 mm long
+    EXPECT_NEAR(beamline.getLength("RING"), 42005.0, 1e-8);
+
+    // Names are unique across elements and lines; only earlier definitions can be used
+    EXPECT_FALSE(beamline.defineElement(std::make_shared<BeamPipe>("CELL", 1.0)));
+    EXPECT_FALSE(beamline.defineLine("QF", {{"D"}}));
+    EXPECT_FALSE(beamline.defineLine("LOOP", {{"LOOP"}}));
+    EXPECT_EQ(beamline.getElementCount("LOOP"), 0u);
+}
+
+TEST_F(BeamlineTest, ReflectionReversesTheLine) {
+    auto arc = expanded("ARC");
+    ASSERT_EQ(arc.size(), 31u);
+
+    // The reflected cells run D, QD, BPM, B, D, QF
+    const std::vector<std::string> reflected = {"D", "QD", "BPM", "B", "D", "QF"};
+    for (size_t i = 0; i < reflected.size(); ++i) {
+        EXPECT_EQ(arc[18 + i].element->getName(), reflected[i]);
+    }
+    EXPECT_EQ(arc.back().element->getName(), "D");
+    EXPECT_NEAR(arc.back().sStart, 40.005, 1e-12);
+}
+
+TEST_F(BeamlineTest, LookupsMatchExpansion) {
+    auto arc = expanded("ARC");
+    for (const auto& occurrence : arc) {
+        auto byIndex = beamline.getOccurrence("ARC", occurrence.index);
+        ASSERT_TRUE(byIndex);
+        EXPECT_EQ(byIndex->element, occurrence.element);
+        EXPECT_NEAR(byIndex->sStart, occurrence.sStart, 1e-9);
+
+        // Inside every element
+        const double length = occurrence.element->getLength();
+        if (length > 0.0) {
+            for (double fraction : {0.01, 0.5, 0.99}) {
+                auto byS = beamline.findAtS("ARC", occurrence.sStart + fraction * length);
+                ASSERT_TRUE(byS);
+                EXPECT_EQ(byS->index, occurrence.index);
+                EXPECT_NEAR(byS->sStart, occurrence.sStart, 1e-9);
+            }
+        }
+    }
+    EXPECT_FALSE(beamline.findAtS("ARC", 42.1));
+    EXPECT_FALSE(beamline.getOccurrence("ARC", 31));
+
+    // Deep in the ring without expanding it
+    auto far = beamline.findAtS("RING", 999 * 42.005 + 26.2);
+    ASSERT_TRUE(far);
+    EXPECT_EQ(far->index, 999u * 31u + arc[19].index);
+    EXPECT_EQ(far->element->getName(), "QD");
+}
+
+TEST_F(BeamlineTest, CopyOutlivesSource) {
+    auto source = std::make_unique<Beamline>(beamline);
+    Beamline copy = *source;
+    source.reset();
+
+    EXPECT_EQ(copy.getElementCount("RING"), beamline.getElementCount("RING"));
+    auto occurrence = copy.getOccurrence("RING", 15);
+    ASSERT_TRUE(occurrence.has_value());
+    EXPECT_EQ(occurrence->element->getName(), beamline.getOccurrence("RING", 15)->element->getName());
+    auto found = copy.findAtS("RING", 100.0);
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(found->index, beamline.findAtS("RING", 100.0)->index);
+}
+
+TEST_F(BeamlineTest, LatticeSharesTemplates) {
+    Accelerator lattice;
+    ASSERT_TRUE(lattice.addLine(beamline, "ARC"));
+    EXPECT_FALSE(lattice.addLine(beamline, "NONE"));
+    lattice.computeLattice();
+    ASSERT_EQ(lattice.getComponentCount(), 31u);
+
+    // Magnets are shared, monitors record data and are not
+    EXPECT_EQ(lattice.getComponent(0), lattice.getComponent(6));
+    EXPECT_EQ(lattice.getComponent(0), beamline.getElement("QF"));
+    EXPECT_NE(lattice.getComponent(3), lattice.getComponent(9));
+
+    // s-positions are per occurrence
+    auto arc = expanded("ARC");
+    for (size_t i = 0; i < arc.size(); ++i) {
+        EXPECT_NEAR(lattice.getSPosition(i), arc[i].sStart, 1e-9);
+    }
+    EXPECT_EQ(lattice.findComponentIndexAtS(8.1), std::optional<size_t>(6));
+
+    // Still per occurrence after an edit without computeLattice(); the shared
+    // QF itself only remembers the s of its last occurrence
+    lattice.addDrift(1.0);
+    EXPECT_EQ(lattice.findComponentIndexAtS(0.25), std::optional<size_t>(0));
+    EXPECT_EQ(lattice.findComponentIndexAtS(8.1), std::optional<size_t>(6));
+    EXPECT_NEAR(lattice.getSPosition(6), arc[6].sStart, 1e-9);
+    lattice.removeComponent(31);
+
+    // Clones keep the sharing
+    auto copy = lattice.clone();
+    EXPECT_EQ(copy->getComponent(0), copy->getComponent(6));
+    EXPECT_NE(copy->getComponent(0), lattice.getComponent(0));
+
+    // The tracker computes one map per shared piece
+    LatticeTracker tracker(lattice, 1e-18);
+    EXPECT_EQ(tracker.getElementCount(), 31u);
+    EXPECT_EQ(tracker.getUniqueMapCount(), 4u + 5u);  // QF, QD, D, B and the monitor copies
+
+    // Editing one occurrence needs a private copy
+    auto quad = std::dynamic_pointer_cast<Quadrupole>(lattice.makeUnique(6));
+    quad->setGradient(10.0);
+    EXPECT_DOUBLE_EQ(std::dynamic_pointer_cast<Quadrupole>(lattice.getComponent(0))->getGradient(), 20.0);
+    EXPECT_EQ(lattice.makeUnique(6), quad);
+}
+
+TEST_F(BeamlineTest, ErrorTableSplitsSharedMagnets) {
+    Accelerator lattice;
+    lattice.addLine(beamline, "ARC");
+    lattice.computeLattice();
+
+    MagnetErrorModel model;
+    model.offsetRms = 1e-4;
+    MagnetErrorTable table;
+    table.addFamily(ComponentType::Quadrupole, model, "QF");
+    table.generate(lattice, 11);
+    ASSERT_EQ(table.getEntries().size(), 5u);
+    table.apply(lattice);
+
+    // Every occurrence now has its own magnet with its own errors
+    for (size_t i = 0; i < table.getEntries().size(); ++i) {
+        const auto& entry = table.getEntries()[i];
+        auto quad = std::dynamic_pointer_cast<Quadrupole>(lattice.getComponent(entry.componentIndex));
+        EXPECT_DOUBLE_EQ(quad->getErrors().offsetX, entry.errors.offsetX);
+        for (size_t j = 0; j < i; ++j) {
+            EXPECT_NE(lattice.getComponent(table.getEntries()[j].componentIndex), quad);
+        }
+    }
+    EXPECT_EQ(lattice.getComponent(1), beamline.getElement("D"));
+
+    // The last occurrence is split off too: the template keeps no errors
+    EXPECT_FALSE(std::dynamic_pointer_cast<Magnet>(beamline.getElement("QF"))->hasErrors());
+}
+
+TEST_F(BeamlineTest, FODOLatticeSharesCells) {
+    Accelerator lattice;
+    FODOCellParams params;
+    lattice.buildFODOLattice(params, 100, true);
+    lattice.computeLattice();
+
+    EXPECT_EQ(lattice.getComponentCount(), 400u);
+    EXPECT_EQ(lattice.getComponent(0), lattice.getComponent(396));
+    EXPECT_EQ(lattice.getComponent("FODO_QF"), lattice.getComponent(0));
+    EXPECT_NEAR(lattice.getSPosition(396), 99 * params.cellLength, 1e-9);
+}
+
+} // namespace pas::accelerator::tests
@@ -0,0 +1,280 @@
+#include <gtest/gtest.h>
+
+#include "accelerator/BeamPositionMonitor.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+namespace pas::accelerator::tests {
+
+namespace {
+
+PlaneCrossing crossing(uint64_t id, uint64_t turn, double x, double y) {
+    PlaneCrossing c;
+    c.particleId = id;
+    c.turn = turn;
+    c.x = x;
+    c.y = y;
+    return c;
+}
+
+} // namespace
+
+TEST(BeamPositionMonitorTest, Construction) {
+    BeamPositionMonitor bpm("BPM1", 64);
+    EXPECT_EQ(bpm.getType(), ComponentType::Monitor);
+    EXPECT_EQ(componentTypeToString(bpm.getType()), "Monitor");
+    EXPECT_EQ(bpm.getCapacity(), 64u);
+    EXPECT_EQ(bpm.getTurnCount(), 0u);
+    EXPECT_TRUE(bpm.observesCrossings());
+    EXPECT_EQ(bpm.getFieldSource(), nullptr);
+}
+
+TEST(BeamPositionMonitorTest, RecordsCentroidAndMoments) {
+    BeamPositionMonitor bpm("BPM1", 16);
+    bpm.prepareCrossings(1);
+    bpm.recordCrossing(crossing(0, 0, 0.001, 0.002));
+    bpm.recordCrossing(crossing(1, 0, 0.003, -0.002));
+    bpm.commitCrossings();
+
+    // Turn stays open until a later turn is seen
+    EXPECT_EQ(bpm.getTurnCount(), 0u);
+    bpm.flush();
+    ASSERT_EQ(bpm.getTurnCount(), 1u);
+
+    auto turn = bpm.getTurn(0);
+    ASSERT_TRUE(turn.has_value());
+    EXPECT_EQ(turn->count, 2u);
+    EXPECT_NEAR(turn->meanX, 0.002, 1e-15);
+    EXPECT_NEAR(turn->meanY, 0.0, 1e-15);
+    EXPECT_NEAR(turn->sigmaXX, 1e-6, 1e-15);
+    EXPECT_NEAR(turn->sigmaYY, 4e-6, 1e-15);
+    EXPECT_NEAR(turn->sigmaXY, -2e-6, 1e-15);
+}
+
+TEST(BeamPositionMonitorTest, IgnoresParticlesOutsideAperture) {
+    Aperture ap;
+    ap.radiusX = 0.01;
+    ap.radiusY = 0.01;
+    BeamPositionMonitor bpm("BPM1", 16, ap);
+    bpm.recordCrossing(crossing(0, 0, 0.001, 0.0));
+    bpm.recordCrossing(crossing(1, 0, 0.5, 0.0));
+    bpm.commitCrossings();
+    bpm.flush();
+
+    auto turn = bpm.getTurn(0);
+    ASSERT_TRUE(turn.has_value());
+    EXPECT_EQ(turn->count, 1u);
+}
+
+TEST(BeamPositionMonitorTest, RingBufferKeepsLatestTurns) {
+    BeamPositionMonitor bpm("BPM1", 4);
+    for (uint64_t t = 0; t < 10; ++t) {
+        bpm.recordCrossing(crossing(0, t, 0.001 * static_cast<double>(t), 0.0));
+        bpm.commitCrossings();
+    }
+    bpm.flush();
+
+    EXPECT_EQ(bpm.getTurnCount(), 10u);
+    EXPECT_FALSE(bpm.getTurn(5).has_value());
+    ASSERT_TRUE(bpm.getTurn(6).has_value());
+
+    auto series = bpm.getCentroidSeries(TransversePlane::Horizontal);
+    ASSERT_EQ(series.size(), 4u);
+    EXPECT_DOUBLE_EQ(series.front(), 0.006);
+    EXPECT_DOUBLE_EQ(series.back(), 0.009);
+}
+
+TEST(BeamPositionMonitorTest, SkippedTurnsAreEmpty) {
+    BeamPositionMonitor bpm("BPM1", 8);
+    bpm.recordCrossing(crossing(0, 0, 0.001, 0.0));
+    bpm.recordCrossing(crossing(0, 2, 0.003, 0.0));
+    bpm.commitCrossings();
+    bpm.flush();
+
+    EXPECT_EQ(bpm.getTurnCount(), 3u);
+    ASSERT_TRUE(bpm.getTurn(1).has_value());
+    EXPECT_EQ(bpm.getTurn(1)->count, 0u);
+    EXPECT_DOUBLE_EQ(bpm.getTurn(2)->meanX, 0.003);
+}
+
+TEST(BeamPositionMonitorTest, TurnJumpWritesOnlyRetainedTurns) {
+    BeamPositionMonitor bpm("BPM1", 8);
+    bpm.recordCrossing(crossing(0, 0, 0.001, 0.0));
+    bpm.recordCrossing(crossing(0, 1'000'000'000, 0.003, 0.0));
+    bpm.commitCrossings();
+    bpm.flush();
+
+    EXPECT_EQ(bpm.getTurnCount(), 1'000'000'001u);
+    EXPECT_FALSE(bpm.getTurn(0).has_value());
+    ASSERT_TRUE(bpm.getTurn(999'999'994).has_value());
+    EXPECT_EQ(bpm.getTurn(999'999'994)->count, 0u);
+    EXPECT_DOUBLE_EQ(bpm.getTurn(1'000'000'000)->meanX, 0.003);
+}
+
+TEST(BeamPositionMonitorTest, VarianceHoldsForLargeOffsets) {
+    // Micrometre spread ten metres off axis: sum(x^2)/n - mean^2 would cancel to noise
+    BeamPositionMonitor bpm("BPM1", 8, Aperture{ApertureShape::Circular, 100.0, 100.0});
+    for (uint64_t id = 0; id < 1000; ++id) {
+        const double offset = (id % 2 == 0 ? 1e-6 : -1e-6);
+        bpm.recordCrossing(crossing(id, 0, 10.0 + offset, -10.0 + offset));
+        if (id == 500) {
+            bpm.commitCrossings();  // Merges partial moments
+        }
+    }
+    bpm.commitCrossings();
+    bpm.flush();
+
+    auto turn = bpm.getTurn(0);
+    ASSERT_TRUE(turn.has_value());
+    EXPECT_EQ(turn->count, 1000u);
+    EXPECT_NEAR(turn->meanX, 10.0, 1e-12);
+    EXPECT_NEAR(turn->sigmaXX, 1e-12, 1e-16);
+    EXPECT_NEAR(turn->sigmaYY, 1e-12, 1e-16);
+    EXPECT_NEAR(turn->sigmaXY, 1e-12, 1e-16);
+}
+
+TEST(BeamPositionMonitorTest, LateCrossingsFoldIntoCompletedTurn) {
+    BeamPositionMonitor bpm("BPM1", 8);
+    bpm.setTrackedParticles({1});
+    bpm.recordCrossing(crossing(0, 0, 0.001, 0.0));
+    bpm.recordCrossing(crossing(0, 1, 0.002, 0.0));
+    bpm.recordCrossing(crossing(0, 3, 0.004, 0.0));
+    bpm.commitCrossings();
+    ASSERT_EQ(bpm.getTurnCount(), 2u);
+
+    // Particle 1 reaches the plane for turn 0 one step late
+    bpm.recordCrossing(crossing(1, 0, 0.003, 0.002));
+    bpm.commitCrossings();
+    bpm.flush();
+
+    // Later turns keep their data and the count never moves back
+    EXPECT_EQ(bpm.getTurnCount(), 4u);
+    auto turn0 = bpm.getTurn(0);
+    ASSERT_TRUE(turn0.has_value());
+    EXPECT_EQ(turn0->count, 2u);
+    EXPECT_NEAR(turn0->meanX, 0.002, 1e-15);
+    EXPECT_NEAR(turn0->meanY, 0.001, 1e-15);
+    EXPECT_NEAR(turn0->sigmaXX, 1e-6, 1e-15);
+    EXPECT_NEAR(turn0->sigmaXY, 1e-6, 1e-15);
+    EXPECT_DOUBLE_EQ(bpm.getTurn(1)->meanX, 0.002);
+    EXPECT_EQ(bpm.getTurn(2)->count, 0u);
+    EXPECT_DOUBLE_EQ(bpm.getTurn(3)->meanX, 0.004);
+    EXPECT_DOUBLE_EQ(bpm.getBuffer().getParticleCoordinate(0, 0, TransversePlane::Horizontal), 0.003);
+    EXPECT_EQ(bpm.getDroppedCrossings(), 0u);
+}
+
+TEST(BeamPositionMonitorTest, DropsCrossingsOfOverwrittenTurns) {
+    BeamPositionMonitor bpm("BPM1", 4);
+    bpm.setTrackedParticles({1});
+    for (uint64_t t = 0; t < 7; ++t) {
+        bpm.recordCrossing(crossing(0, t, 0.001 * static_cast<double>(t), 0.0));
+        bpm.commitCrossings();
+    }
+    bpm.recordCrossing(crossing(1, 5, 0.015, 0.0));
+    bpm.recordCrossing(crossing(1, 1, 0.02, 0.0));
+    bpm.commitCrossings();
+    bpm.flush();
+
+    // Turn 1 shares its slot with turn 5, which must be left alone
+    EXPECT_EQ(bpm.getDroppedCrossings(), 1u);
+    EXPECT_EQ(bpm.getTurnCount(), 7u);
+    EXPECT_FALSE(bpm.getTurn(1).has_value());
+    ASSERT_TRUE(bpm.getTurn(5).has_value());
+    EXPECT_EQ(bpm.getTurn(5)->count, 2u);
+    EXPECT_NEAR(bpm.getTurn(5)->meanX, 0.01, 1e-15);
+    EXPECT_DOUBLE_EQ(bpm.getBuffer().getParticleCoordinate(5, 0, TransversePlane::Horizontal), 0.015);
+}
+
+TEST(BeamPositionMonitorTest, TracksSelectedParticles) {
+    BeamPositionMonitor bpm("BPM1", 8);
+    bpm.setTrackedParticles({7, 3});
+    ASSERT_EQ(bpm.getTrackedParticles().size(), 2u);
+    EXPECT_EQ(bpm.getTrackedParticles()[0], 3u);
+
+    bpm.recordCrossing(crossing(3, 0, 0.001, 0.002));
+    bpm.recordCrossing(crossing(5, 0, 0.005, 0.005));
+    bpm.recordCrossing(crossing(3, 1, 0.003, 0.004));
+    bpm.commitCrossings();
+    bpm.flush();
+
+    const BPMBuffer& buffer = bpm.getBuffer();
+    auto x = buffer.getParticleSeries(0, TransversePlane::Horizontal);
+    ASSERT_EQ(x.size(), 2u);
+    EXPECT_DOUBLE_EQ(x[0], 0.001);
+    EXPECT_DOUBLE_EQ(x[1], 0.003);
+    EXPECT_DOUBLE_EQ(buffer.getParticleCoordinate(1, 0, TransversePlane::Vertical), 0.004);
+
+    // Particle 7 never crossed
+    EXPECT_TRUE(std::isnan(buffer.getParticleCoordinate(0, 1, TransversePlane::Horizontal)));
+}
+
+TEST(BeamPositionMonitorTest, OpenTurnKeepsRetainedParticleRow) {
+    BeamPositionMonitor bpm("BPM1", 4);
+    bpm.setTrackedParticles({0});
+    for (uint64_t t = 0; t < 5; ++t) {
+        bpm.recordCrossing(crossing(0, t, 0.001 * static_cast<double>(t + 1), 0.0));
+        bpm.commitCrossings();
+    }
+
+    // Turn 4 is open and shares turn 0's slot, which is still retained
+    const BPMBuffer& buffer = bpm.getBuffer();
+    ASSERT_EQ(bpm.getTurnCount(), 4u);
+    EXPECT_DOUBLE_EQ(buffer.getParticleCoordinate(0, 0, TransversePlane::Horizontal), 0.001);
+
+    bpm.flush();
+    EXPECT_TRUE(std::isnan(buffer.getParticleCoordinate(0, 0, TransversePlane::Horizontal)));
+    EXPECT_DOUBLE_EQ(buffer.getParticleCoordinate(4, 0, TransversePlane::Horizontal), 0.005);
+}
+
+TEST(BeamPositionMonitorTest, MappedFileIsReadableWhileRunning) {
+    std::string path = ::testing::TempDir() + "pas_bpm.bin";
+    BeamPositionMonitor bpm("BPM1", 8);
+    bpm.setTrackedParticles({0});
+    ASSERT_TRUE(bpm.mapToFile(path));
+    EXPECT_TRUE(bpm.getBuffer().isMapped());
+
+    for (uint64_t t = 0; t < 3; ++t) {
+        bpm.recordCrossing(crossing(0, t, 0.001 * static_cast<double>(t), 0.0));
+        bpm.commitCrossings();
+    }
+
+    BPMBuffer reader;
+    ASSERT_TRUE(reader.openFile(path));
+    EXPECT_EQ(reader.getCapacity(), 8u);
+    EXPECT_EQ(reader.getTrackedCount(), 1u);
+    EXPECT_EQ(reader.getTurnCount(), 2u);
+
+    bpm.flush();
+    EXPECT_EQ(reader.getTurnCount(), 3u);
+    EXPECT_NEAR(reader.getTurn(2)->meanX, 0.002, 1e-15);
+    EXPECT_NEAR(reader.getParticleCoordinate(1, 0, TransversePlane::Horizontal), 0.001, 1e-15);
+
+    std::remove(path.c_str());
+}
+
+TEST(BeamPositionMonitorTest, ResetDiscardsData) {
+    BeamPositionMonitor bpm("BPM1", 8);
+    bpm.recordCrossing(crossing(0, 0, 0.001, 0.0));
+    bpm.commitCrossings();
+    bpm.flush();
+    ASSERT_EQ(bpm.getTurnCount(), 1u);
+
+    bpm.reset();
+    EXPECT_EQ(bpm.getTurnCount(), 0u);
+    EXPECT_FALSE(bpm.getTurn(0).has_value());
+}
+
+TEST(BPMBufferTest, RejectsInvalidFile) {
+    std::string path = ::testing::TempDir() + "pas_bpm_invalid.bin";
+    utils::MappedFile file;
+    ASSERT_TRUE(file.create(path, 128));
+    file.close();
+
+    BPMBuffer buffer;
+    EXPECT_FALSE(buffer.openFile(path));
+    EXPECT_FALSE(buffer.isValid());
+    std::remove(path.c_str());
+}
+
+} // namespace pas::accelerator::tests
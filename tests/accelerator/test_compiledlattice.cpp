@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+#include "accelerator/Accelerator.hpp"
+#include "accelerator/CompiledLattice.hpp"
+#include "physics/Constants.hpp"
+
+namespace pas::accelerator::tests {
+
+class CompiledLatticeTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Aperture rectangular;
+        rectangular.shape = ApertureShape::Rectangular;
+        rectangular.radiusX = 0.04;
+        rectangular.radiusY = 0.02;
+
+        lattice.addComponent(std::make_shared<Quadrupole>("QF", 0.5, 20.0));
+        lattice.addDrift(1.0);
+        lattice.addComponent(std::make_shared<Dipole>("B1", 2.0, 1.2, rectangular));
+        lattice.addComponent(std::make_shared<Sextupole>("S1", 0.2, 100.0));
+        lattice.addComponent(std::make_shared<RFCavity>("RF", 0.5, 1e6, 500e6));
+        lattice.computeLattice();
+    }
+
+    Accelerator lattice;
+};
+
+TEST_F(CompiledLatticeTest, ArraysMatchComponents) {
+    const CompiledLattice& compiled = lattice.getCompiledLattice();
+    ASSERT_EQ(compiled.size(), lattice.getComponentCount());
+
+    for (size_t i = 0; i < compiled.size(); ++i) {
+        const auto& component = lattice.getComponent(i);
+        EXPECT_EQ(compiled.getTypes()[i], component->getType());
+        EXPECT_DOUBLE_EQ(compiled.getSStarts()[i], component->getSPosition());
+        EXPECT_DOUBLE_EQ(compiled.getLengths()[i], component->getLength());
+        EXPECT_EQ(compiled.getApertureShapes()[i], component->getAperture().shape);
+        EXPECT_DOUBLE_EQ(compiled.getApertureX()[i], component->getAperture().radiusX);
+        EXPECT_DOUBLE_EQ(compiled.getApertureY()[i], component->getAperture().radiusY);
+        EXPECT_EQ(&compiled.getComponent(i), component.get());
+    }
+
+    EXPECT_DOUBLE_EQ(compiled.getStrengths()[0], 20.0);
+    EXPECT_DOUBLE_EQ(compiled.getStrengths()[1], 0.0);
+    EXPECT_DOUBLE_EQ(compiled.getStrengths()[2], 1.2);
+    EXPECT_DOUBLE_EQ(compiled.getStrengths()[3], 50.0);  // B''/2
+    EXPECT_DOUBLE_EQ(compiled.getStrengths()[4], 1e6);
+}
+
+TEST_F(CompiledLatticeTest, ApertureTestMatchesComponents) {
+    auto dipole = lattice.getComponent("B1");
+    dipole->setPosition(glm::dvec3(0.1, -0.05, 3.0));
+    dipole->setRotation(glm::angleAxis(0.3, glm::dvec3(0.0, 1.0, 0.0)));
+    lattice.computeLattice();
+    const CompiledLattice& compiled = lattice.getCompiledLattice();
+
+    std::mt19937_64 random(7);
+    std::uniform_real_distribution<double> transverse(-0.1, 0.1);
+    std::uniform_real_distribution<double> longitudinal(-1.0, 5.0);
+    for (int sample = 0; sample < 2000; ++sample) {
+        const glm::dvec3 pos(transverse(random), transverse(random), longitudinal(random));
+        bool inside = false;
+        for (size_t i = 0; i < compiled.size(); ++i) {
+            // Straight survey: entry i enters at z = s
+            const glm::dvec3 entrance(0.0, 0.0, lattice.getSPosition(i));
+            const bool expected = lattice.getComponent(i)->isInsideAperture(pos - entrance);
+            ASSERT_EQ(compiled.isInsideAperture(i, pos), expected);
+            inside = inside || expected;
+        }
+        EXPECT_EQ(compiled.isInsideAnyAperture(pos), inside);
+    }
+}
+
+TEST_F(CompiledLatticeTest, ApertureTestAtSMatchesFullScan) {
+    // One aperture moved far along s, one slightly, one only across it
+    lattice.getComponent("B1")->setPosition(glm::dvec3(0.1, -0.05, 3.0));
+    lattice.getComponent("B1")->setRotation(glm::angleAxis(0.3, glm::dvec3(0.0, 1.0, 0.0)));
+    lattice.getComponent("S1")->setPosition(glm::dvec3(0.0, 0.0, -0.05));
+    lattice.getComponent("QF")->setPosition(glm::dvec3(0.02, 0.0, 0.0));
+    lattice.addDrift(0.0, "M1");
+    lattice.addDrift(1.5);
+    lattice.computeLattice();
+    const CompiledLattice& compiled = lattice.getCompiledLattice();
+
+    // Particles moving forward in s, each with its own cursor
+    std::mt19937_64 random(11);
+    std::uniform_real_distribution<double> transverse(-0.1, 0.1);
+    std::uniform_real_distribution<double> start(-1.0, 1.0);
+    std::uniform_real_distribution<double> advance(0.0, 0.3);
+    for (int particle = 0; particle < 200; ++particle) {
+        size_t cursor = 0;
+        for (double z = start(random); z < 8.0; z += advance(random)) {
+            const glm::dvec3 pos(transverse(random), transverse(random), z);
+            ASSERT_EQ(compiled.isInsideApertureAtS(pos, z, cursor), compiled.isInsideAnyAperture(pos))
+                << "z = " << z;
+        }
+    }
+}
+
+TEST_F(CompiledLatticeTest, FollowsEditsToTheObjectModel) {
+    auto quad = std::dynamic_pointer_cast<Quadrupole>(lattice.getComponent("QF"));
+    quad->setGradient(-15.0);
+    EXPECT_DOUBLE_EQ(lattice.getCompiledLattice().getStrengths()[0], -15.0);
+
+    // Layout changes rebuild the arrays
+    lattice.addComponent(std::make_shared<Quadrupole>("QD", 0.5, -20.0));
+    EXPECT_EQ(lattice.getCompiledLattice().size(), 6u);
+    lattice.removeComponent("QF");
+    lattice.computeLattice();
+    const CompiledLattice& compiled = lattice.getCompiledLattice();
+    ASSERT_EQ(compiled.size(), 5u);
+    EXPECT_EQ(compiled.getTypes()[0], ComponentType::BeamPipe);
+    EXPECT_DOUBLE_EQ(compiled.getSStarts()[4], 3.7);
+
+    // Clones carry their own arrays
+    auto copy = lattice.clone();
+    EXPECT_EQ(copy->getCompiledLattice().size(), 5u);
+    EXPECT_NE(&copy->getCompiledLattice().getComponent(0), &compiled.getComponent(0));
+}
+
+TEST_F(CompiledLatticeTest, SurveyClosesRingOfBends) {
+    // 16 bends of 2 pi / 16 at B rho = 10 T m, separated by drifts
+    constexpr int bends = 16;
+    constexpr double rigidity = 10.0;
+    constexpr double length = 2.0;
+    const double angle = 2.0 * physics::constants::pi / bends;
+    Accelerator ring;
+    auto bend = std::make_shared<Dipole>("B", length, angle * rigidity / length);
+    for (int i = 0; i < bends; ++i) {
+        ring.addComponent(bend);
+        ring.addDrift(1.5);
+    }
+    ring.setReferenceRigidity(rigidity);
+    ring.closeRing();
+    const CompiledLattice& compiled = ring.getCompiledLattice();
+
+    const Placement& exit = compiled.getExitFrame();
+    EXPECT_NEAR(glm::length(exit.origin), 0.0, 1e-9);
+    const glm::dvec3 direction = exit.rotation * glm::dvec3(0.0, 0.0, 1.0);
+    EXPECT_NEAR(direction.z, 1.0, 1e-12);
+
+    // Positive fields bend towards -x; the second bend is turned by one angle
+    EXPECT_DOUBLE_EQ(compiled.getAngles()[0], angle);
+    EXPECT_LT(compiled.getOrigins()[2].x, 0.0);
+    const glm::dvec3 heading = compiled.getRotations()[2] * glm::dvec3(0.0, 0.0, 1.0);
+    EXPECT_NEAR(heading.x, -std::sin(angle), 1e-12);
+
+    // Aperture follows the arc: the middle of the bend sits off the chord by the sagitta
+    const double rho = length / angle;
+    const Placement center = compiled.getCenterFrame(0);
+    const glm::dvec3 arc = center.toGlobal(glm::dvec3(rho * (1.0 - std::cos(0.5 * angle)), 0.0, 0.0));
+    EXPECT_TRUE(compiled.isInsideAperture(0, arc));
+    EXPECT_TRUE(compiled.isInsideAperture(0, arc + center.rotation * glm::dvec3(0.045, 0.0, 0.0)));
+    EXPECT_FALSE(compiled.isInsideAperture(0, arc + center.rotation * glm::dvec3(0.055, 0.0, 0.0)));
+    EXPECT_FALSE(compiled.isInsideAperture(0, compiled.getOrigins()[1] + glm::dvec3(0.0, 0.0, 0.1)));
+}
+
+TEST_F(CompiledLatticeTest, BendChangeResurveysDownstream) {
+    lattice.addComponent(std::make_shared<Dipole>("B2", 2.0, -0.8));
+    lattice.addDrift(1.0);
+    lattice.setReferenceRigidity(3.0);
+    lattice.computeLattice();
+    const CompiledLattice& compiled = lattice.getCompiledLattice();
+    const std::vector<glm::dvec3> before = compiled.getOrigins();
+    const uint64_t version = compiled.getSurveyVersion();
+
+    // Strength edits elsewhere keep the frames
+    std::dynamic_pointer_cast<Quadrupole>(lattice.getComponent("QF"))->setGradient(5.0);
+    EXPECT_EQ(lattice.getCompiledLattice().getSurveyVersion(), version);
+
+    std::dynamic_pointer_cast<Dipole>(lattice.getComponent("B1"))->setField(0.6);
+    const CompiledLattice& after = lattice.getCompiledLattice();
+    EXPECT_GT(after.getSurveyVersion(), version);
+    for (size_t i = 0; i <= 2; ++i) {
+        EXPECT_EQ(after.getOrigins()[i], before[i]);
+    }
+    EXPECT_NE(after.getOrigins()[3], before[3]);
+
+    // Same frames as a survey from scratch
+    CompiledLattice fresh;
+    fresh.build(lattice.getComponents(), 3.0);
+    for (size_t i = 0; i < fresh.size(); ++i) {
+        EXPECT_NEAR(glm::length(after.getOrigins()[i] - fresh.getOrigins()[i]), 0.0, 1e-12);
+    }
+    EXPECT_NEAR(glm::length(after.getExitFrame().origin - fresh.getExitFrame().origin), 0.0, 1e-12);
+}
+
+TEST_F(CompiledLatticeTest, CursorFollowsParticleThroughLattice) {
+    const CompiledLattice& compiled = lattice.getCompiledLattice();
+
+    size_t cursor = 0;
+    for (double s = -0.5; s < 5.0; s += 0.01) {
+        EXPECT_EQ(compiled.findIndexAtS(s, cursor), compiled.findIndexAtS(s));
+    }
+    EXPECT_EQ(cursor, 4u);
+
+    // Backward jumps fall back to binary search
+    EXPECT_EQ(compiled.findIndexAtS(0.1, cursor), std::optional<size_t>(0));
+    EXPECT_EQ(compiled.findIndexAtS(3.9, cursor), std::optional<size_t>(4));
+    EXPECT_EQ(compiled.findIndexAtS(4.2, cursor), std::nullopt);
+    EXPECT_EQ(cursor, 4u);
+}
+
+} // namespace pas::accelerator::tests
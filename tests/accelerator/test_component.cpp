@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include <cmath>
+#include <cstdio>
+#include <string>
 
 #include "accelerator/Component.hpp"
 #include "physics/Constants.hpp"
@@ -144,6 +146,137 @@ TEST_F(ComponentTest, QuadrupoleFieldSource) {
     EXPECT_NE(field, nullptr);
 }
 
+TEST_F(ComponentTest, VersionsAreUniqueAcrossComponents) {
+    Quadrupole first("Q1", 0.5, 50.0);
+    auto copy = first.clone();
+    EXPECT_NE(copy->getVersion(), first.getVersion());
+
+    // A changed component never reuses a version another one holds
+    Quadrupole second("Q2", 0.5, 50.0);
+    first.setGradient(20.0);
+    EXPECT_NE(first.getVersion(), second.getVersion());
+    EXPECT_NE(first.getVersion(), copy->getVersion());
+}
+
+TEST_F(ComponentTest, StrengthChangeUpdatesFieldSourceInPlace) {
+    Quadrupole quad("Q1", 0.5, 50.0);
+    auto field = quad.getFieldSource();
+    const uint64_t version = quad.getVersion();
+
+    quad.setGradient(20.0);
+    EXPECT_GT(quad.getVersion(), version);
+    EXPECT_EQ(quad.getFieldSource(), field);
+    EXPECT_NEAR(field->evaluate(glm::dvec3(0.01, 0.0, 0.0), 0.0).B.y, 0.2, EPSILON);
+
+    // Errors change the kind of source, so it is recreated
+    MagnetErrors errors;
+    errors.offsetX = 1e-3;
+    quad.setErrors(errors);
+    auto shifted = quad.getFieldSource();
+    EXPECT_NE(shifted, field);
+    quad.setGradient(10.0);
+    EXPECT_EQ(quad.getFieldSource(), shifted);
+    EXPECT_NEAR(shifted->evaluate(glm::dvec3(0.011, 0.0, 0.0), 0.0).B.y, 0.1, EPSILON);
+
+    RFCavity cavity("RF", 0.5, 1e6, 400e6);
+    auto rf = std::dynamic_pointer_cast<physics::RFField>(cavity.getFieldSource());
+    cavity.setVoltage(2e6);
+    cavity.setPhase(0.3);
+    EXPECT_EQ(cavity.getFieldSource(), rf);
+    EXPECT_DOUBLE_EQ(rf->getVoltage(), 2e6);
+    EXPECT_DOUBLE_EQ(rf->getPhase(), 0.3);
+}
+
+// Sextupole and Multipole tests
+
+TEST_F(ComponentTest, SextupoleField) {
+    Sextupole sext("S1", 0.2, 300.0);
+    EXPECT_EQ(sext.getType(), ComponentType::Sextupole);
+    EXPECT_EQ(sext.getTypeName(), "Sextupole");
+
+    auto field = sext.getFieldSource();
+    ASSERT_NE(field, nullptr);
+
+    // By = B''/2 (x^2 - y^2), Bx = B'' x y
+    physics::FieldValue value = field->evaluate(glm::dvec3(0.01, 0.02, 0.0), 0.0);
+    EXPECT_NEAR(value.B.y, 150.0 * (1e-4 - 4e-4), EPSILON);
+    EXPECT_NEAR(value.B.x, 300.0 * 0.01 * 0.02, EPSILON);
+
+    sext.setStrength(-100.0);
+    EXPECT_NEAR(sext.getFieldSource()->evaluate(glm::dvec3(0.01, 0.0, 0.0), 0.0).B.y, -50.0 * 1e-4, EPSILON);
+    EXPECT_NEAR(sext.getK2(1e-18), e * -100.0 / 1e-18, 1e-6);
+
+    auto copy = std::dynamic_pointer_cast<Sextupole>(sext.clone());
+    ASSERT_NE(copy, nullptr);
+    EXPECT_DOUBLE_EQ(copy->getStrength(), -100.0);
+}
+
+TEST_F(ComponentTest, MultipoleComponentCombinesOrders) {
+    physics::MultipoleExpansion coefficients;
+    coefficients.setNormal(2, 10.0);
+    coefficients.setSkew(4, 1000.0);
+    Multipole multipole("M1", 0.1, coefficients);
+
+    EXPECT_EQ(multipole.getType(), ComponentType::Multipole);
+    EXPECT_EQ(multipole.getMainOrder(), 2);
+    EXPECT_DOUBLE_EQ(multipole.getMainStrength(), 10.0);
+
+    // Errors are relative to the main (quadrupole) field at the reference radius
+    MagnetErrors errors;
+    errors.referenceRadius = 0.01;
+    errors.normal = {0.0, 100.0};  // 1 percent gradient error
+    multipole.setErrors(errors);
+    physics::MultipoleExpansion total = multipole.getMultipoles();
+    EXPECT_NEAR(total.getNormal(2), 10.1, EPSILON);
+    EXPECT_DOUBLE_EQ(total.getSkew(4), 1000.0);
+
+    physics::FieldValue value = multipole.getFieldSource()->evaluate(glm::dvec3(0.01, 0.0, 0.0), 0.0);
+    EXPECT_NEAR(value.B.y, 10.1 * 0.01, EPSILON);
+    EXPECT_NEAR(value.B.x, 1000.0 * 1e-6, EPSILON);
+}
+
+TEST_F(ComponentTest, MagnetFringeUsesSmoothField) {
+    Quadrupole quad("Q1", 0.5, 10.0);
+    EXPECT_FALSE(quad.getFringe().has_value());
+
+    physics::EngeFunction enge;
+    enge.gap = 0.1;
+    quad.setFringe(enge);
+    auto field = std::dynamic_pointer_cast<physics::MultipoleField>(quad.getFieldSource());
+    ASSERT_NE(field, nullptr);
+    EXPECT_GT(field->getBoundingBox().max.z, 0.25);
+    EXPECT_GT(field->evaluate(glm::dvec3(0.01, 0.0, 0.26), 0.0).B.y, 0.0);
+
+    auto copy = std::dynamic_pointer_cast<Quadrupole>(quad.clone());
+    ASSERT_TRUE(copy->getFringe().has_value());
+    EXPECT_DOUBLE_EQ(copy->getFringe()->gap, 0.1);
+
+    quad.clearFringe();
+    EXPECT_NE(std::dynamic_pointer_cast<physics::QuadrupoleField>(quad.getFieldSource()), nullptr);
+}
+
+TEST_F(ComponentTest, SolenoidField) {
+    Aperture aperture;
+    aperture.radiusX = 0.04;
+    Solenoid solenoid("SOL1", 1.0, 3.0, aperture);
+    EXPECT_EQ(solenoid.getType(), ComponentType::Solenoid);
+    EXPECT_EQ(solenoid.getTypeName(), "Solenoid");
+    EXPECT_DOUBLE_EQ(solenoid.getFringe().gap, 0.08);
+    EXPECT_NEAR(solenoid.getKs(1e-18), e * 3.0 / 2e-18, 1e-6);
+
+    auto field = std::dynamic_pointer_cast<physics::SolenoidField>(solenoid.getFieldSource());
+    ASSERT_NE(field, nullptr);
+    EXPECT_NEAR(field->evaluate(glm::dvec3(0.0), 0.0).B.z, 3.0, 1e-6);
+
+    solenoid.setField(-1.0);
+    EXPECT_NEAR(solenoid.getFieldSource()->evaluate(glm::dvec3(0.0), 0.0).B.z, -1.0, 1e-6);
+
+    auto copy = std::dynamic_pointer_cast<Solenoid>(solenoid.clone());
+    ASSERT_NE(copy, nullptr);
+    EXPECT_DOUBLE_EQ(copy->getField(), -1.0);
+    EXPECT_DOUBLE_EQ(copy->getFringe().gap, 0.08);
+}
+
 // RFCavity tests
 
 TEST_F(ComponentTest, RFCavityHasCorrectParameters) {
@@ -201,6 +334,66 @@ TEST_F(ComponentTest, DetectorClearsHits) {
     EXPECT_EQ(detector.getHitCount(), 0u);
 }
 
+TEST_F(ComponentTest, DetectorHitsOrderedByTime) {
+    Detector detector("TestDetector");
+
+    detector.recordHit(3.0, glm::dvec3(0.0), glm::dvec3(0.0), 3);
+    detector.recordHit(1.0, glm::dvec3(0.0), glm::dvec3(0.0), 1);
+    detector.recordHit(2.0, glm::dvec3(0.0), glm::dvec3(0.0), 2);
+
+    const auto& hits = detector.getHits();
+    ASSERT_EQ(hits.size(), 3u);
+    EXPECT_EQ(hits[0].particleId, 1u);
+    EXPECT_EQ(hits[2].particleId, 3u);
+}
+
+TEST_F(ComponentTest, DetectorCrossingRespectsAperture) {
+    Aperture aperture;
+    aperture.radiusX = 0.01;
+    Detector detector("TestDetector", aperture);
+    EXPECT_TRUE(detector.observesCrossings());
+
+    PlaneCrossing inside;
+    inside.particleId = 1;
+    inside.x = 0.005;
+    detector.recordCrossing(inside);
+
+    PlaneCrossing outside;
+    outside.particleId = 2;
+    outside.x = 0.02;
+    detector.recordCrossing(outside);
+
+    EXPECT_EQ(detector.getHitCount(), 1u);
+}
+
+TEST_F(ComponentTest, DetectorStreamsHitsToDisk) {
+    Detector detector("TestDetector");
+    std::string path = ::testing::TempDir() + "pas_detector_hits.bin";
+    ASSERT_TRUE(detector.enableHitStreaming(path));
+
+    constexpr size_t count = 2000;
+    for (size_t i = 0; i < count; ++i) {
+        detector.recordHit(static_cast<double>(i), glm::dvec3(0.0, 0.0, 1.0),
+                           glm::dvec3(0.0), i);
+    }
+    detector.commitCrossings();
+
+    // Full chunks leave memory after commit
+    EXPECT_GT(detector.getStreamedHitCount(), 0u);
+    EXPECT_LT(detector.getHitCount(), count);
+
+    detector.disableHitStreaming();
+    EXPECT_EQ(detector.getStreamedHitCount(), count);
+    EXPECT_EQ(detector.getHitCount(), 0u);
+
+    auto hits = Detector::readHitStream(path);
+    ASSERT_EQ(hits.size(), count);
+    EXPECT_DOUBLE_EQ(hits[10].time, 10.0);
+    EXPECT_DOUBLE_EQ(hits[10].position.z, 1.0);
+    EXPECT_EQ(hits[10].particleId, 10u);
+    std::remove(path.c_str());
+}
+
 // Coordinate transformation tests
 
 TEST_F(ComponentTest, LocalGlobalTransform) {
@@ -246,6 +439,7 @@ TEST_F(ComponentTest, ComponentTypeToString) {
     EXPECT_EQ(componentTypeToString(ComponentType::BeamPipe), "BeamPipe");
     EXPECT_EQ(componentTypeToString(ComponentType::Dipole), "Dipole");
     EXPECT_EQ(componentTypeToString(ComponentType::Quadrupole), "Quadrupole");
+    EXPECT_EQ(componentTypeToString(ComponentType::Solenoid), "Solenoid");
     EXPECT_EQ(componentTypeToString(ComponentType::RFCavity), "RFCavity");
     EXPECT_EQ(componentTypeToString(ComponentType::Detector), "Detector");
 }
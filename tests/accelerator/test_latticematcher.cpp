@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+
+#include "accelerator/LatticeMatcher.hpp"
+#include "accelerator/LatticeTracker.hpp"
+#include "physics/Constants.hpp"
+#include "utils/Parallel.hpp"
+
+#include "FODORing.hpp"
+
+#include <cmath>
+#include <vector>
+
+namespace pas::accelerator::tests {
+
+using namespace physics::constants;
+using namespace physics::constants::energy;
+using namespace physics::constants::relativistic;
+using pas::tests::makeFODORing;
+
+class LatticeMatcherTest : public ::testing::Test {
+protected:
+    // 1 GeV kinetic energy proton
+    double p0 = momentumFromGamma(gammaFromKineticEnergy(1.0 * GeV, m_p), m_p);
+    double brho = p0 / e;
+
+    MatchKnob family(const std::string& prefix, size_t cells) {
+        MatchKnob knob;
+        knob.name = prefix;
+        for (size_t i = 0; i < cells; ++i) {
+            knob.components.push_back(prefix + std::to_string(i));
+        }
+        return knob;
+    }
+
+    static MatchConstraint constraint(ConstraintQuantity quantity, double target,
+                                      const std::string& location = "") {
+        MatchConstraint c;
+        c.quantity = quantity;
+        c.target = target;
+        c.location = location;
+        return c;
+    }
+};
+
+TEST_F(LatticeMatcherTest, CloneIsIndependent) {
+    auto acc = makeFODORing(2.0, 2, brho);
+    auto copy = acc->clone();
+    ASSERT_EQ(copy->getComponentCount(), acc->getComponentCount());
+    EXPECT_TRUE(copy->isClosed());
+    EXPECT_DOUBLE_EQ(copy->getTotalLength(), acc->getTotalLength());
+
+    auto quad = std::static_pointer_cast<Quadrupole>(copy->getComponent("QF0"));
+    EXPECT_NE(quad, acc->getComponent("QF0"));
+    EXPECT_DOUBLE_EQ(quad->getSPosition(), acc->getComponent("QF0")->getSPosition());
+    quad->setGradient(0.0);
+    EXPECT_DOUBLE_EQ(std::static_pointer_cast<Quadrupole>(acc->getComponent("QF0"))->getGradient(), 2.0 * brho);
+}
+
+TEST_F(LatticeMatcherTest, MatchesTunesWithFamilies) {
+    auto acc = makeFODORing(2.0, 4, brho);
+    LatticeMatcher matcher(*acc, p0);
+    ASSERT_TRUE(matcher.addKnob(family("QF", 4)));
+    MatchKnob qd = family("QD", 4);
+    ASSERT_TRUE(matcher.addKnob(qd));
+    ASSERT_TRUE(matcher.addConstraint(constraint(ConstraintQuantity::TuneX, 0.75)));
+    ASSERT_TRUE(matcher.addConstraint(constraint(ConstraintQuantity::TuneY, 0.6)));
+
+    MatchResult result = matcher.match();
+    ASSERT_TRUE(result.converged);
+    EXPECT_LT(result.finalCost, result.initialCost);
+    ASSERT_EQ(result.values.size(), 2u);
+    EXPECT_GT(result.values[0], 0.0);
+    EXPECT_LT(result.values[1], 0.0);
+
+    // The source lattice is untouched until apply()
+    EXPECT_DOUBLE_EQ(std::static_pointer_cast<Quadrupole>(acc->getComponent("QF2"))->getGradient(), 2.0 * brho);
+    ASSERT_TRUE(matcher.apply(*acc, result));
+    EXPECT_DOUBLE_EQ(std::static_pointer_cast<Quadrupole>(acc->getComponent("QF2"))->getGradient(), result.values[0]);
+
+    Optics optics(acc, p0);
+    ASSERT_TRUE(optics.compute());
+    EXPECT_NEAR(optics.getTuneX(), 0.75, 1e-7);
+    EXPECT_NEAR(optics.getTuneY(), 0.6, 1e-7);
+}
+
+TEST_F(LatticeMatcherTest, MatchesBetaWithManyKnobs) {
+    // 100 individually powered quadrupoles
+    const size_t cells = 50;
+    auto acc = makeFODORing(0.5, cells, brho);
+    LatticeMatcher matcher(*acc, p0);
+    for (size_t i = 0; i < cells; ++i) {
+        for (const char* prefix : {"QF", "QD"}) {
+            MatchKnob knob;
+            knob.name = prefix + std::to_string(i);
+            knob.components = {knob.name};
+            ASSERT_TRUE(matcher.addKnob(knob));
+        }
+    }
+    EXPECT_EQ(matcher.getKnobCount(), 100u);
+
+    Optics before(acc, p0);
+    ASSERT_TRUE(before.compute());
+    ASSERT_TRUE(matcher.addConstraint(constraint(ConstraintQuantity::TuneX, before.getTuneX() + 0.05)));
+    ASSERT_TRUE(matcher.addConstraint(constraint(ConstraintQuantity::TuneY, before.getTuneY() - 0.05)));
+    ASSERT_TRUE(matcher.addConstraint(constraint(ConstraintQuantity::BetaX, 18.0, "QF10")));
+
+    MatchResult result = matcher.match();
+    ASSERT_TRUE(result.converged);
+    ASSERT_TRUE(matcher.apply(*acc, result));
+
+    Optics after(acc, p0);
+    ASSERT_TRUE(after.compute());
+    EXPECT_NEAR(after.getTuneX(), before.getTuneX() + 0.05, 1e-7);
+    EXPECT_NEAR(after.getTuneY(), before.getTuneY() - 0.05, 1e-7);
+    EXPECT_NEAR(after.getPoints()[40].x.beta, 18.0, 1e-6);
+}
+
+TEST_F(LatticeMatcherTest, RespectsKnobBounds) {
+    auto acc = makeFODORing(2.0, 4, brho);
+    LatticeMatcher matcher(*acc, p0);
+    MatchKnob qf = family("QF", 4);
+    qf.maximum = 2.05 * brho;
+    ASSERT_TRUE(matcher.addKnob(qf));
+    ASSERT_TRUE(matcher.addConstraint(constraint(ConstraintQuantity::TuneX, 0.8)));
+
+    // Target out of reach: stops at the bound without converging
+    MatchResult result = matcher.match();
+    EXPECT_FALSE(result.converged);
+    EXPECT_LE(result.values[0], 2.05 * brho);
+    EXPECT_NEAR(result.values[0], 2.05 * brho, 1e-6 * brho);
+}
+
+TEST_F(LatticeMatcherTest, CustomConstraintWithTracker) {
+    // Point-to-point focusing: a parallel ray crosses the axis at the end
+    Accelerator line;
+    line.addDrift(1.0);
+    line.addComponent(std::make_shared<Quadrupole>("Q", 0.2, 1.0 * brho));
+    line.addDrift(2.0, "End");
+    line.computeLattice();
+
+    LatticeMatcher matcher(line, p0);
+    MatchKnob knob;
+    knob.name = "Q";
+    knob.components = {"Q"};
+    knob.minimum = 0.0;
+    ASSERT_TRUE(matcher.addKnob(knob));
+
+    MatchConstraint focus;
+    focus.quantity = ConstraintQuantity::Custom;
+    focus.target = 0.0;
+    focus.weight = 1e3;
+    const double momentum = p0;
+    focus.evaluate = [momentum](const Accelerator& lattice, const Optics&) {
+        LatticeTracker tracker(lattice, momentum);
+        PhaseSpace state;
+        state.x = 1e-3;
+        tracker.trackTurn(state);
+        return state.x;
+    };
+    ASSERT_TRUE(matcher.addConstraint(focus));
+
+    MatchResult result = matcher.match();
+    ASSERT_TRUE(result.converged);
+
+    // Thin-lens estimate: f = 2 m
+    double k1 = result.values[0] / brho;
+    EXPECT_NEAR(1.0 / (k1 * 0.2), 2.0, 0.1);
+}
+
+TEST_F(LatticeMatcherTest, ProbeRebuildsOnlyDownstreamMatrices) {
+    auto acc = makeFODORing(2.0, 4, brho);
+    LatticeMatcher matcher(*acc, p0);
+
+    // Downstream knob first, so its Jacobian probe follows the start evaluation
+    MatchKnob late;
+    late.name = "QD3";
+    late.components = {"QD3"};
+    ASSERT_TRUE(matcher.addKnob(late));
+    MatchKnob early;
+    early.name = "QF0";
+    early.components = {"QF0"};
+    ASSERT_TRUE(matcher.addKnob(early));
+
+    std::vector<size_t> recomputed;
+    MatchConstraint tune;
+    tune.quantity = ConstraintQuantity::Custom;
+    tune.target = 0.7;
+    tune.evaluate = [&recomputed](const Accelerator&, const Optics& optics) {
+        recomputed.push_back(optics.getRecomputedCount());
+        return optics.getTuneX();
+    };
+    ASSERT_TRUE(matcher.addConstraint(tune));
+
+    // One workspace, so evaluations run in order on the same optics
+    const int threads = utils::getMaxThreads();
+    utils::setMaxThreads(1);
+    MatchSettings settings;
+    settings.maxIterations = 1;
+    matcher.match(settings);
+    utils::setMaxThreads(threads);
+
+    // Start values, then the QD3 probe: only QD3 and the drift after it
+    ASSERT_GE(recomputed.size(), 3u);
+    EXPECT_EQ(recomputed[0], acc->getComponentCount());
+    EXPECT_EQ(recomputed[1], 2u);
+    EXPECT_EQ(recomputed[2], acc->getComponentCount());
+}
+
+TEST_F(LatticeMatcherTest, RejectsInvalidDeclarations) {
+    auto acc = makeFODORing(2.0, 2, brho);
+    LatticeMatcher matcher(*acc, p0);
+
+    MatchKnob missing;
+    missing.name = "X";
+    missing.components = {"QX"};
+    EXPECT_FALSE(matcher.addKnob(missing));
+
+    MatchKnob wrongType;
+    wrongType.name = "QF";
+    wrongType.components = {"QF0"};
+    wrongType.parameter = KnobParameter::DipoleField;
+    EXPECT_FALSE(matcher.addKnob(wrongType));
+
+    EXPECT_FALSE(matcher.addConstraint(constraint(ConstraintQuantity::BetaX, 1.0, "Nowhere")));
+    EXPECT_FALSE(matcher.addConstraint(constraint(ConstraintQuantity::Custom, 1.0)));
+    EXPECT_EQ(matcher.getKnobCount(), 0u);
+    EXPECT_EQ(matcher.getConstraintCount(), 0u);
+
+    // Unstable start: nothing to match from
+    auto unstable = makeFODORing(20.0, 2, brho);
+    LatticeMatcher failing(*unstable, p0);
+    ASSERT_TRUE(failing.addKnob(family("QF", 2)));
+    ASSERT_TRUE(failing.addConstraint(constraint(ConstraintQuantity::TuneX, 0.5)));
+    MatchResult result = failing.match();
+    EXPECT_FALSE(result.converged);
+    EXPECT_EQ(result.iterations, 0u);
+}
+
+} // namespace pas::accelerator::tests
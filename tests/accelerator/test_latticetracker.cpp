@@ -0,0 +1,292 @@
+#include <gtest/gtest.h>
+
+#include "accelerator/LatticeTracker.hpp"
+#include "physics/Constants.hpp"
+
+#include "FODORing.hpp"
+
+#include <cmath>
+
+namespace pas::accelerator::tests {
+
+using namespace physics::constants;
+using namespace physics::constants::energy;
+using namespace physics::constants::relativistic;
+using pas::tests::makeFODORing;
+
+class LatticeTrackerTest : public ::testing::Test {
+protected:
+    // 1 GeV kinetic energy proton
+    double p0 = momentumFromGamma(gammaFromKineticEnergy(1.0 * GeV, m_p), m_p);
+    double brho = p0 / e;
+
+    /**
+     * @brief Integrate the paraxial equations of motion through a field along z.
+     */
+    PhaseSpace integrateField(const physics::FieldSource& field, PhaseSpace state,
+                              double z0, double z1) const {
+        auto derivative = [&](double z, const double (&u)[4], double (&du)[4]) {
+            glm::dvec3 B = field.evaluate(glm::dvec3(u[0], u[2], z), 0.0).B;
+            du[0] = u[1];
+            du[1] = (u[3] * B.z - B.y) / brho;
+            du[2] = u[3];
+            du[3] = (B.x - u[1] * B.z) / brho;
+        };
+
+        const int steps = 20000;
+        const double h = (z1 - z0) / steps;
+        double u[4] = {state.x, state.px, state.y, state.py};
+        for (int i = 0; i < steps; ++i) {
+            const double z = z0 + i * h;
+            double k1[4], k2[4], k3[4], k4[4], t[4];
+            derivative(z, u, k1);
+            for (int j = 0; j < 4; ++j) t[j] = u[j] + 0.5 * h * k1[j];
+            derivative(z + 0.5 * h, t, k2);
+            for (int j = 0; j < 4; ++j) t[j] = u[j] + 0.5 * h * k2[j];
+            derivative(z + 0.5 * h, t, k3);
+            for (int j = 0; j < 4; ++j) t[j] = u[j] + h * k3[j];
+            derivative(z + h, t, k4);
+            for (int j = 0; j < 4; ++j) u[j] += h / 6.0 * (k1[j] + 2.0 * k2[j] + 2.0 * k3[j] + k4[j]);
+        }
+        state.x = u[0];
+        state.px = u[1];
+        state.y = u[2];
+        state.py = u[3];
+        return state;
+    }
+
+    /**
+     * @brief Track through a soft-edge field that spans [-L/2 - D, L/2 + D],
+     * returning to the hard-edge planes with drifts of -D.
+     */
+    PhaseSpace trackSoftEdge(const physics::FieldSource& field, PhaseSpace state,
+                             double length, double D) const {
+        state.x -= D * state.px;
+        state.y -= D * state.py;
+        state = integrateField(field, state, -length / 2.0 - D, length / 2.0 + D);
+        state.x -= D * state.px;
+        state.y -= D * state.py;
+        return state;
+    }
+};
+
+TEST_F(LatticeTrackerTest, DriftMap) {
+    Accelerator acc;
+    acc.addDrift(2.0);
+    acc.computeLattice();
+    LatticeTracker tracker(acc, p0);
+    EXPECT_EQ(tracker.getElementCount(), 1u);
+    EXPECT_DOUBLE_EQ(tracker.getLength(), 2.0);
+
+    PhaseSpace state;
+    state.x = 1e-3;
+    state.px = 1e-4;
+    state.py = -2e-4;
+    ASSERT_TRUE(tracker.trackTurn(state));
+    EXPECT_NEAR(state.x, 1.2e-3, 1e-15);
+    EXPECT_NEAR(state.px, 1e-4, 1e-15);
+    EXPECT_NEAR(state.y, -4e-4, 1e-15);
+}
+
+TEST_F(LatticeTrackerTest, QuadrupoleFocusesOnePlane) {
+    Accelerator acc;
+    acc.addComponent(std::make_shared<Quadrupole>("QF", 0.2, 2.0 * brho));
+    acc.computeLattice();
+    LatticeTracker tracker(acc, p0);
+
+    PhaseSpace state;
+    state.x = 1e-3;
+    state.y = 1e-3;
+    ASSERT_TRUE(tracker.trackTurn(state));
+
+    double phi = std::sqrt(2.0) * 0.2;
+    EXPECT_NEAR(state.x, 1e-3 * std::cos(phi), 1e-15);
+    EXPECT_NEAR(state.px, -1e-3 * std::sqrt(2.0) * std::sin(phi), 1e-15);
+    EXPECT_NEAR(state.y, 1e-3 * std::cosh(phi), 1e-15);
+    EXPECT_GT(state.py, 0.0);
+}
+
+TEST_F(LatticeTrackerTest, OffMomentumFocusesLess) {
+    Accelerator acc;
+    acc.addComponent(std::make_shared<Quadrupole>("QF", 0.2, 2.0 * brho));
+    acc.computeLattice();
+    LatticeTracker tracker(acc, p0);
+
+    PhaseSpace onMomentum;
+    onMomentum.x = 1e-3;
+    PhaseSpace offMomentum = onMomentum;
+    offMomentum.delta = 0.01;
+    tracker.trackTurn(onMomentum);
+    tracker.trackTurn(offMomentum);
+    EXPECT_LT(std::abs(offMomentum.px), std::abs(onMomentum.px));
+}
+
+TEST_F(LatticeTrackerTest, DipoleDispersion) {
+    Accelerator acc;
+    acc.addComponent(std::make_shared<Dipole>("B", 1.0, 1.0));
+    acc.computeLattice();
+    LatticeTracker tracker(acc, p0);
+
+    // Off-momentum particle is displaced toward the dispersive orbit
+    PhaseSpace state;
+    state.delta = 1e-3;
+    ASSERT_TRUE(tracker.trackTurn(state));
+    double h = 1.0 / brho;
+    EXPECT_NEAR(state.x, 1e-3 / h * (1.0 - std::cos(h * 1.0 / std::sqrt(1.001))), 1e-12);
+}
+
+TEST_F(LatticeTrackerTest, SextupoleThinKick) {
+    const double k2 = 10.0;
+    Accelerator acc;
+    acc.addComponent(std::make_shared<Sextupole>("S", 0.2, k2 * brho));
+    acc.computeLattice();
+
+    LatticeTracker thin(acc, p0);
+    EXPECT_EQ(thin.getElementCount(), 2u);
+    EXPECT_DOUBLE_EQ(thin.getLength(), 0.2);
+
+    // Drift 0.1, kick -k2 L / 2 (x^2 - y^2), drift 0.1
+    PhaseSpace state;
+    state.x = 1e-2;
+    ASSERT_TRUE(thin.trackTurn(state));
+    const double kick = -k2 * 0.2 / 2.0 * 1e-4;
+    EXPECT_NEAR(state.px, kick, 1e-15);
+    EXPECT_NEAR(state.x, 1e-2 + 0.1 * kick, 1e-15);
+
+    // More slices converge to the same kick for a short element
+    LatticeTracker sliced(acc, p0, e, 4);
+    EXPECT_EQ(sliced.getElementCount(), 5u);
+    PhaseSpace slicedState;
+    slicedState.x = 1e-2;
+    ASSERT_TRUE(sliced.trackTurn(slicedState));
+    EXPECT_NEAR(slicedState.px, state.px, 1e-3 * std::abs(kick));
+    EXPECT_NEAR(slicedState.x, state.x, 1e-8);
+}
+
+TEST_F(LatticeTrackerTest, SolenoidMatchesFieldIntegration) {
+    const double ks = 1.5;
+    const double length = 0.5;
+    Accelerator acc;
+    auto solenoid = std::make_shared<Solenoid>("SOL", length, 2.0 * ks * brho);
+    acc.addComponent(solenoid);
+    acc.computeLattice();
+    LatticeTracker tracker(acc, p0);
+
+    PhaseSpace initial;
+    initial.x = 1e-3;
+    initial.py = 2e-4;
+    PhaseSpace state = initial;
+    ASSERT_TRUE(tracker.trackTurn(state));
+
+    // Coupled: a horizontal offset turns into vertical motion
+    EXPECT_GT(std::abs(state.y - (initial.y + length * initial.py)), 1e-4);
+
+    physics::SolenoidField field(solenoid->getField(), glm::dvec3(0.0), length, 0.05, solenoid->getFringe());
+    PhaseSpace reference = trackSoftEdge(field, initial, length, solenoid->getFringe().extent());
+    EXPECT_NEAR(state.x, reference.x, 2e-5);
+    EXPECT_NEAR(state.px, reference.px, 2e-5);
+    EXPECT_NEAR(state.y, reference.y, 2e-5);
+    EXPECT_NEAR(state.py, reference.py, 2e-5);
+}
+
+TEST_F(LatticeTrackerTest, QuadrupoleFringeMatchesFieldIntegration) {
+    const double k1 = 8.0;
+    const double length = 0.3;
+    physics::EngeFunction enge;
+    enge.gap = 0.1;
+
+    Accelerator acc;
+    auto quad = std::make_shared<Quadrupole>("Q", length, k1 * brho);
+    acc.addComponent(quad);
+    acc.computeLattice();
+    LatticeTracker hardEdge(acc, p0);
+    quad->setFringe(enge);
+    LatticeTracker softEdge(acc, p0);
+    EXPECT_EQ(softEdge.getElementCount(), 1u);
+
+    PhaseSpace initial;
+    initial.x = 1e-3;
+    initial.px = -1e-3;
+    initial.y = 1e-3;
+    initial.py = 5e-4;
+    PhaseSpace hard = initial;
+    PhaseSpace soft = initial;
+    ASSERT_TRUE(hardEdge.trackTurn(hard));
+    ASSERT_TRUE(softEdge.trackTurn(soft));
+
+    physics::MultipoleExpansion multipoles;
+    multipoles.setNormal(2, k1 * brho);
+    physics::MultipoleField field(multipoles, glm::dvec3(0.0), length, 0.05, 0.0, enge);
+    PhaseSpace reference = trackSoftEdge(field, initial, length, enge.extent());
+
+    // The edge maps recover most of the difference to the hard-edge model
+    const double hardError = std::abs(hard.px - reference.px) + std::abs(hard.py - reference.py);
+    const double softError = std::abs(soft.px - reference.px) + std::abs(soft.py - reference.py);
+    EXPECT_GT(hardError, 1e-6);
+    EXPECT_LT(softError, 0.2 * hardError);
+    EXPECT_NEAR(soft.x, reference.x, 0.2 * std::abs(hard.x - reference.x) + 1e-9);
+}
+
+TEST_F(LatticeTrackerTest, DipoleFringeDefocusesVertically) {
+    const double length = 1.0;
+    physics::EngeFunction enge;
+    enge.gap = 0.05;
+
+    Accelerator acc;
+    auto dipole = std::make_shared<Dipole>("B", length, 1.0);
+    acc.addComponent(dipole);
+    acc.computeLattice();
+    LatticeTracker hardEdge(acc, p0);
+    dipole->setFringe(enge);
+    LatticeTracker softEdge(acc, p0);
+
+    PhaseSpace hard;
+    hard.x = 1e-3;
+    hard.y = 1e-3;
+    PhaseSpace soft = hard;
+    ASSERT_TRUE(hardEdge.trackTurn(hard));
+    ASSERT_TRUE(softEdge.trackTurn(soft));
+    EXPECT_DOUBLE_EQ(soft.x, hard.x);
+    EXPECT_DOUBLE_EQ(soft.px, hard.px);
+
+    // Thin edge lenses of strength h tan(psi) at both ends
+    const double h = 1.0 / brho;
+    const double k = h * std::tan(enge.integrals().fint * enge.gap * h);
+    const double y = 1e-3 * (1.0 + length * k);
+    EXPECT_NEAR(soft.y, y, 1e-15);
+    EXPECT_NEAR(soft.py, k * 1e-3 + k * y, 1e-15);
+    EXPECT_GT(soft.py, hard.py);
+}
+
+TEST_F(LatticeTrackerTest, ApertureLoss) {
+    Accelerator acc;
+    acc.addDrift(1.0);
+    acc.computeLattice();
+    LatticeTracker tracker(acc, p0);
+
+    PhaseSpace state;
+    state.px = 0.1;  // Leaves the 5 cm pipe within the first metre
+    EXPECT_FALSE(tracker.trackTurn(state));
+    state = PhaseSpace{};
+    state.px = 0.1;
+    EXPECT_EQ(tracker.track(state, 10), 0u);
+}
+
+TEST_F(LatticeTrackerTest, StableRingConservesAmplitude) {
+    auto ring = makeFODORing(2.0, 4, brho);
+    LatticeTracker tracker(*ring, p0);
+
+    PhaseSpace state;
+    state.x = 1e-3;
+    std::vector<PhaseSpace> history;
+    ASSERT_EQ(tracker.track(state, 1000, &history), 1000u);
+    ASSERT_EQ(history.size(), 1000u);
+
+    double maxX = 0.0;
+    for (const auto& s : history) {
+        maxX = std::max(maxX, std::abs(s.x));
+    }
+    EXPECT_LT(maxX, 5e-3);
+}
+
+} // namespace pas::accelerator::tests
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "accelerator/Accelerator.hpp"
+#include "accelerator/LatticeTracker.hpp"
+#include "accelerator/MagnetErrors.hpp"
+#include "physics/Constants.hpp"
+
+namespace pas::accelerator::tests {
+
+using namespace physics::constants;
+
+class MagnetErrorsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        lattice.addComponent(std::make_shared<Quadrupole>("QF1", 0.5, 20.0));
+        lattice.addDrift(1.0);
+        lattice.addComponent(std::make_shared<Dipole>("B1", 1.0, 1.2));
+        lattice.addDrift(1.0);
+        lattice.addComponent(std::make_shared<Quadrupole>("QD1", 0.5, -20.0));
+        lattice.addComponent(std::make_shared<Quadrupole>("QF2", 0.5, 20.0));
+        lattice.computeLattice();
+    }
+
+    Accelerator lattice;
+};
+
+TEST_F(MagnetErrorsTest, ExpansionIsRelativeToReferenceRadius) {
+    MagnetErrors errors;
+    errors.referenceRadius = 0.01;
+    errors.normal = {0.0, 0.0, 10.0};  // b3 = 10 units
+
+    physics::MultipoleExpansion expansion = errors.expand(2, 20.0);
+    EXPECT_DOUBLE_EQ(expansion.getNormal(2), 20.0);
+
+    // At the reference radius the sextupole adds 10 units of the main field
+    glm::dvec3 B = expansion.evaluate(0.01, 0.0);
+    EXPECT_NEAR(B.y, 0.2 * (1.0 + 10e-4), 1e-12);
+    EXPECT_NEAR(B.x, 0.0, 1e-12);
+}
+
+TEST_F(MagnetErrorsTest, PerfectMagnetKeepsDedicatedField) {
+    auto quad = std::dynamic_pointer_cast<Quadrupole>(lattice.getComponent("QF1"));
+    EXPECT_FALSE(quad->hasErrors());
+    EXPECT_EQ(std::dynamic_pointer_cast<physics::MultipoleField>(quad->getFieldSource()), nullptr);
+
+    MagnetErrors errors;
+    errors.skew = {0.0, 5.0};
+    quad->setErrors(errors);
+    EXPECT_TRUE(quad->hasErrors());
+    EXPECT_NE(std::dynamic_pointer_cast<physics::MultipoleField>(quad->getFieldSource()), nullptr);
+
+    // Clones carry the errors
+    auto copy = std::dynamic_pointer_cast<Quadrupole>(quad->clone());
+    EXPECT_TRUE(copy->hasErrors());
+    EXPECT_DOUBLE_EQ(copy->getErrors().skew[1], 5.0);
+
+    quad->clearErrors();
+    EXPECT_EQ(std::dynamic_pointer_cast<physics::MultipoleField>(quad->getFieldSource()), nullptr);
+}
+
+TEST_F(MagnetErrorsTest, ModelRespectsTruncationAndSystematics) {
+    MagnetErrorModel model;
+    model.systematicNormal = {0.0, 0.0, 2.0};
+    model.randomNormal = {0.0, 0.0, 1.0};
+    model.offsetRms = 1e-4;
+    model.truncation = 2.0;
+
+    std::mt19937_64 random(3);
+    double sum = 0.0;
+    const int samples = 2000;
+    for (int i = 0; i < samples; ++i) {
+        MagnetErrors errors = model.generate(random);
+        ASSERT_EQ(errors.normal.size(), 3u);
+        EXPECT_LE(std::abs(errors.normal[2] - 2.0), 2.0);
+        EXPECT_LE(std::abs(errors.offsetX), 2e-4);
+        EXPECT_DOUBLE_EQ(errors.roll, 0.0);
+        sum += errors.normal[2];
+    }
+    EXPECT_NEAR(sum / samples, 2.0, 0.1);
+}
+
+TEST_F(MagnetErrorsTest, TableAssignsFamiliesByTypeAndPrefix) {
+    MagnetErrorModel focusing;
+    focusing.randomNormal = {0.0, 0.0, 1.0};
+    MagnetErrorModel dipoles;
+    dipoles.rollRms = 1e-3;
+
+    MagnetErrorTable table;
+    table.addFamily(ComponentType::Quadrupole, focusing, "QF");
+    table.addFamily(ComponentType::Dipole, dipoles);
+    table.addFamily(ComponentType::BeamPipe, focusing);  // Not a magnet, ignored
+    EXPECT_EQ(table.getFamilyCount(), 2u);
+
+    table.generate(lattice, 42);
+    ASSERT_EQ(table.getEntries().size(), 3u);
+    EXPECT_EQ(table.getEntries()[0].name, "QF1");
+    EXPECT_EQ(table.getEntries()[1].name, "B1");
+    EXPECT_EQ(table.getEntries()[2].name, "QF2");
+
+    // Same seed gives the same errors; a magnet's errors do not depend on other families
+    MagnetErrorTable quadsOnly;
+    quadsOnly.addFamily(ComponentType::Quadrupole, focusing, "QF");
+    quadsOnly.generate(lattice, 42);
+    EXPECT_DOUBLE_EQ(quadsOnly.getEntries()[1].errors.normal[2], table.getEntries()[2].errors.normal[2]);
+
+    // Unshared magnets are edited in place, whoever else holds them
+    auto copy = lattice.clone();
+    auto bend = copy->getComponent("B1");
+    table.apply(*copy);
+    EXPECT_EQ(copy->getComponent("B1"), bend);
+    EXPECT_TRUE(std::dynamic_pointer_cast<Dipole>(bend)->hasErrors());
+    EXPECT_FALSE(std::dynamic_pointer_cast<Quadrupole>(copy->getComponent("QD1"))->hasErrors());
+    EXPECT_FALSE(std::dynamic_pointer_cast<Dipole>(lattice.getComponent("B1"))->hasErrors());
+}
+
+TEST_F(MagnetErrorsTest, TrackerKicksOffsetQuadrupole) {
+    const double p0 = 1e-18;
+    Accelerator line;
+    auto quad = std::make_shared<Quadrupole>("Q", 0.2, 20.0);
+    line.addComponent(quad);
+    line.computeLattice();
+
+    LatticeTracker perfect(line, p0);
+    EXPECT_EQ(perfect.getElementCount(), 1u);
+
+    MagnetErrors errors;
+    errors.offsetX = 1e-4;
+    quad->setErrors(errors);
+    LatticeTracker misaligned(line, p0);
+    EXPECT_EQ(misaligned.getElementCount(), 2u);
+    EXPECT_DOUBLE_EQ(misaligned.getLength(), 0.2);
+
+    // A particle on the ideal axis is focused towards the displaced center
+    PhaseSpace state;
+    ASSERT_TRUE(misaligned.trackTurn(state));
+    const double expectedKick = e * 0.2 / p0 * 20.0 * 1e-4;
+    EXPECT_NEAR(state.px, expectedKick, expectedKick * 0.05);
+    EXPECT_GT(state.x, 0.0);
+    EXPECT_DOUBLE_EQ(state.py, 0.0);
+}
+
+TEST_F(MagnetErrorsTest, ExportCSV) {
+    MagnetErrorModel model;
+    model.randomNormal = {0.0, 0.0, 1.0};
+    model.randomSkew = {0.0, 1.0};
+    lattice.addComponent(std::make_shared<Quadrupole>("Q,\"3\"", 0.5, 20.0));
+    MagnetErrorTable table;
+    table.addFamily(ComponentType::Quadrupole, model);
+    table.generate(lattice, 1);
+
+    const std::string path = "test_magnet_errors.csv";
+    ASSERT_TRUE(table.exportCSV(path));
+
+    std::ifstream file(path);
+    std::string header;
+    std::getline(file, header);
+    EXPECT_EQ(header, "index,name,offset_x,offset_y,roll,reference_radius,b1,a1,b2,a2,b3,a3");
+    size_t rows = 0;
+    std::string line;
+    std::string last;
+    while (std::getline(file, line)) {
+        last = line;
+        rows++;
+    }
+    EXPECT_EQ(rows, 4u);
+
+    // Names are quoted, with embedded quotes doubled
+    EXPECT_EQ(last.rfind("6,\"Q,\"\"3\"\"\",", 0), 0u);
+    file.close();
+    std::remove(path.c_str());
+}
+
+} // namespace pas::accelerator::tests
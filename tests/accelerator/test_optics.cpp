@@ -0,0 +1,265 @@
+#include <gtest/gtest.h>
+
+#include "accelerator/Optics.hpp"
+#include "accelerator/LatticeTracker.hpp"
+#include "physics/Constants.hpp"
+
+#include "FODORing.hpp"
+
+#include <array>
+#include <cmath>
+
+namespace pas::accelerator::tests {
+
+using namespace physics::constants;
+using namespace physics::constants::energy;
+using namespace physics::constants::relativistic;
+using pas::tests::makeFODORing;
+
+class OpticsTest : public ::testing::Test {
+protected:
+    // 1 GeV kinetic energy proton
+    double p0 = momentumFromGamma(gammaFromKineticEnergy(1.0 * GeV, m_p), m_p);
+    double brho = p0 / e;
+};
+
+TEST_F(OpticsTest, DriftPropagation) {
+    auto acc = std::make_shared<Accelerator>();
+    acc->addDrift(3.0);
+    acc->computeLattice();
+
+    Optics optics(acc, p0);
+    OpticsPoint initial;
+    initial.x.beta = 2.0;
+    initial.y.beta = 4.0;
+    optics.setInitialOptics(initial);
+    ASSERT_TRUE(optics.compute());
+    ASSERT_EQ(optics.getPoints().size(), 1u);
+
+    // beta(s) = beta0 + s^2 / beta0 for a waist at s = 0
+    const auto& end = optics.getPoints()[0];
+    EXPECT_DOUBLE_EQ(end.s, 3.0);
+    EXPECT_NEAR(end.x.beta, 2.0 + 9.0 / 2.0, 1e-12);
+    EXPECT_NEAR(end.x.alpha, -3.0 / 2.0, 1e-12);
+    EXPECT_NEAR(end.x.mu, std::atan(3.0 / 2.0), 1e-12);
+    EXPECT_NEAR(end.y.beta, 4.0 + 9.0 / 4.0, 1e-12);
+}
+
+TEST_F(OpticsTest, PeriodicFODOSolution) {
+    auto acc = makeFODORing(2.0, 4, brho);
+    Optics optics(acc, p0);
+    ASSERT_TRUE(optics.compute());
+    ASSERT_EQ(optics.getPoints().size(), 16u);
+
+    // Thin-lens estimate: sin(mu/2) = L / (2 f) = 1/2, so Q = 4 * 60 / 360
+    EXPECT_NEAR(optics.getTuneX(), 2.0 / 3.0, 0.01);
+    EXPECT_NEAR(optics.getTuneY(), 2.0 / 3.0, 0.01);
+
+    // Periodic: the optics at the end match the start
+    const auto& start = optics.getStart();
+    const auto& end = optics.getPoints().back();
+    EXPECT_NEAR(end.x.beta, start.x.beta, 1e-9);
+    EXPECT_NEAR(end.x.alpha, start.x.alpha, 1e-9);
+    EXPECT_NEAR(end.y.beta, start.y.beta, 1e-9);
+    EXPECT_DOUBLE_EQ(end.s, 40.0);
+
+    // Horizontal beta peaks at the focusing quads, vertical at the defocusing ones
+    const auto& points = optics.getPoints();
+    EXPECT_GT(points[0].x.beta, points[2].x.beta);
+    EXPECT_LT(points[0].y.beta, points[2].y.beta);
+    EXPECT_NEAR(points[0].x.beta, points[2].y.beta, 1e-6);
+
+    // No bends, no dispersion
+    EXPECT_DOUBLE_EQ(end.dispersion, 0.0);
+}
+
+TEST_F(OpticsTest, OneTurnMatrixMatchesTracker) {
+    auto acc = makeFODORing(2.0, 4, brho);
+    acc->insertComponent(1, std::make_shared<Dipole>("B", 1.0, 0.5));
+    acc->computeLattice();
+
+    Optics optics(acc, p0);
+    ASSERT_TRUE(optics.compute());
+    LatticeTracker tracker(*acc, p0);
+
+    PhaseSpace state;
+    state.x = 1e-3;
+    state.px = -2e-4;
+    state.y = 5e-4;
+    TransferMatrix m = optics.getOneTurnMatrix();
+    double x = m.x[0][0] * state.x + m.x[0][1] * state.px;
+    double px = m.x[1][0] * state.x + m.x[1][1] * state.px;
+    double y = m.y[0][0] * state.y + m.y[0][1] * state.py;
+
+    ASSERT_TRUE(tracker.trackTurn(state));
+    EXPECT_NEAR(state.x, x, 1e-15);
+    EXPECT_NEAR(state.px, px, 1e-15);
+    EXPECT_NEAR(state.y, y, 1e-15);
+
+    // The tracker scales focusing by 1/(1 + delta); the dispersion column is the first-order term
+    PhaseSpace offMomentum;
+    offMomentum.delta = 1e-6;
+    ASSERT_TRUE(tracker.trackTurn(offMomentum));
+    EXPECT_NEAR(offMomentum.x, m.x[0][2] * 1e-6, 1e-5 * std::abs(m.x[0][2]) * 1e-6);
+    EXPECT_NEAR(offMomentum.px, m.x[1][2] * 1e-6, 1e-5 * std::abs(m.x[1][2]) * 1e-6);
+}
+
+TEST_F(OpticsTest, FollowsTrackerWithFringesSolenoidsAndErrors) {
+    auto acc = makeFODORing(2.0, 4, brho);
+    Optics hardEdge(acc, p0);
+    ASSERT_TRUE(hardEdge.compute());
+
+    physics::EngeFunction enge;
+    enge.gap = 0.05;
+    auto bend = std::make_shared<Dipole>("B", 1.0, 0.5);
+    bend->setFringe(enge);
+    acc->insertComponent(1, bend);
+    std::static_pointer_cast<Quadrupole>(acc->getComponent("QF0"))->setFringe(enge);
+
+    // Opposite solenoids: the rotations cancel, the focusing adds up
+    acc->insertComponent(3, std::make_shared<Solenoid>("SOL1", 0.5, 2.0));
+    acc->insertComponent(4, std::make_shared<Solenoid>("SOL2", 0.5, -2.0));
+
+    // Feed-down of an offset sextupole and a 1% gradient error
+    auto sextupole = std::make_shared<Sextupole>("S", 0.2, 20.0 * brho);
+    MagnetErrors offset;
+    offset.offsetX = 2e-3;
+    sextupole->setErrors(offset);
+    acc->insertComponent(6, sextupole);
+    MagnetErrors gradient;
+    gradient.normal = {0.0, 100.0};
+    std::static_pointer_cast<Quadrupole>(acc->getComponent("QD2"))->setErrors(gradient);
+    acc->computeLattice();
+
+    Optics optics(acc, p0);
+    ASSERT_TRUE(optics.compute());
+    LatticeTracker tracker(*acc, p0);
+
+    // One-turn matrix of the tracker by central differences
+    const double step = 1e-7;
+    auto column = [&](PhaseSpace offsetState) {
+        PhaseSpace minus;
+        minus.x = -offsetState.x;
+        minus.px = -offsetState.px;
+        minus.y = -offsetState.y;
+        minus.py = -offsetState.py;
+        EXPECT_TRUE(tracker.trackTurn(offsetState));
+        EXPECT_TRUE(tracker.trackTurn(minus));
+        return std::array<double, 4>{(offsetState.x - minus.x) / (2.0 * step),
+                                     (offsetState.px - minus.px) / (2.0 * step),
+                                     (offsetState.y - minus.y) / (2.0 * step),
+                                     (offsetState.py - minus.py) / (2.0 * step)};
+    };
+    PhaseSpace unit;
+    unit.x = step;
+    auto cx = column(unit);
+    unit = PhaseSpace{};
+    unit.px = step;
+    auto cpx = column(unit);
+    unit = PhaseSpace{};
+    unit.y = step;
+    auto cy = column(unit);
+    unit = PhaseSpace{};
+    unit.py = step;
+    auto cpy = column(unit);
+
+    const TransferMatrix m = optics.getOneTurnMatrix();
+    const double tolerance = 1e-6;
+    EXPECT_NEAR(m.x[0][0], cx[0], tolerance);
+    EXPECT_NEAR(m.x[0][1], cpx[0], tolerance * 10.0);
+    EXPECT_NEAR(m.x[1][0], cx[1], tolerance);
+    EXPECT_NEAR(m.x[1][1], cpx[1], tolerance);
+    EXPECT_NEAR(m.y[0][0], cy[2], tolerance);
+    EXPECT_NEAR(m.y[0][1], cpy[2], tolerance * 10.0);
+    EXPECT_NEAR(m.y[1][0], cy[3], tolerance);
+    EXPECT_NEAR(m.y[1][1], cpy[3], tolerance);
+    EXPECT_NEAR(cx[2], 0.0, tolerance);
+    EXPECT_NEAR(cy[0], 0.0, tolerance);
+
+    // The extra focusing moves the tunes well beyond the tolerance
+    const double cosMuX = 0.5 * (cx[0] + cpx[1]);
+    const double cosMuY = 0.5 * (cy[2] + cpy[3]);
+    EXPECT_NEAR(std::cos(2.0 * pi * optics.getTuneX()), cosMuX, tolerance);
+    EXPECT_NEAR(std::cos(2.0 * pi * optics.getTuneY()), cosMuY, tolerance);
+    EXPECT_GT(std::abs(optics.getTuneX() - hardEdge.getTuneX()), 1e-3);
+    EXPECT_GT(std::abs(optics.getTuneY() - hardEdge.getTuneY()), 1e-3);
+}
+
+TEST_F(OpticsTest, DipoleGeneratesDispersion) {
+    auto acc = std::make_shared<Accelerator>();
+    auto dipole = std::make_shared<Dipole>("B", 2.0, 1.0);
+    acc->addComponent(dipole);
+    acc->computeLattice();
+
+    Optics optics(acc, p0);
+    ASSERT_TRUE(optics.compute());
+
+    // Sector bend from zero dispersion: D = rho (1 - cos theta), D' = sin theta
+    double rho = dipole->getBendingRadius(p0);
+    double theta = 2.0 / rho;
+    const auto& end = optics.getPoints()[0];
+    EXPECT_NEAR(end.dispersion, rho * (1.0 - std::cos(theta)), 1e-12);
+    EXPECT_NEAR(end.dispersionPrime, std::sin(theta), 1e-12);
+}
+
+TEST_F(OpticsTest, ChangingOneMagnetRecomputesDownstreamOnly) {
+    auto acc = makeFODORing(2.0, 4, brho);
+    Optics optics(acc, p0);
+    ASSERT_TRUE(optics.compute());
+    EXPECT_EQ(optics.getRecomputedCount(), 16u);
+
+    // Nothing changed
+    ASSERT_TRUE(optics.compute());
+    EXPECT_EQ(optics.getRecomputedCount(), 0u);
+
+    // Retune the last QD: one prefix product
+    auto lastQD = std::static_pointer_cast<Quadrupole>(acc->getComponent("QD3"));
+    lastQD->setGradient(-2.1 * brho);
+    ASSERT_TRUE(optics.compute());
+    EXPECT_EQ(optics.getRecomputedCount(), 2u);
+
+    // Incremental result equals a fresh computation
+    Optics fresh(acc, p0);
+    ASSERT_TRUE(fresh.compute());
+    EXPECT_DOUBLE_EQ(optics.getTuneX(), fresh.getTuneX());
+    for (size_t i = 0; i < fresh.getPoints().size(); ++i) {
+        EXPECT_DOUBLE_EQ(optics.getPoints()[i].x.beta, fresh.getPoints()[i].x.beta);
+        EXPECT_DOUBLE_EQ(optics.getPoints()[i].y.mu, fresh.getPoints()[i].y.mu);
+    }
+
+    optics.invalidate(4);
+    ASSERT_TRUE(optics.compute());
+    EXPECT_EQ(optics.getRecomputedCount(), 12u);
+}
+
+TEST_F(OpticsTest, LinearLatticeKeepsUpstreamPoints) {
+    auto acc = makeFODORing(2.0, 2, brho);
+    acc->setLatticeType(LatticeType::Linear);
+    Optics optics(acc, p0);
+    OpticsPoint initial;
+    initial.x.beta = 10.0;
+    initial.y.beta = 5.0;
+    optics.setInitialOptics(initial);
+    ASSERT_TRUE(optics.compute());
+    auto before = optics.getPoints();
+
+    std::static_pointer_cast<Quadrupole>(acc->getComponent("QF1"))->setGradient(2.5 * brho);
+    ASSERT_TRUE(optics.compute());
+    EXPECT_EQ(optics.getRecomputedCount(), 4u);
+    EXPECT_DOUBLE_EQ(optics.getPoints()[3].x.beta, before[3].x.beta);
+    EXPECT_NE(optics.getPoints()[4].x.beta, before[4].x.beta);
+}
+
+TEST_F(OpticsTest, UnstableRingHasNoPeriodicSolution) {
+    auto acc = makeFODORing(20.0, 4, brho);
+    Optics optics(acc, p0);
+    EXPECT_FALSE(optics.compute());
+    EXPECT_FALSE(optics.isValid());
+    EXPECT_TRUE(optics.getPoints().empty());
+    EXPECT_DOUBLE_EQ(optics.getTuneX(), 0.0);
+
+    Optics empty(std::make_shared<Accelerator>(), p0);
+    EXPECT_TRUE(empty.compute());
+}
+
+} // namespace pas::accelerator::tests
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "config/LatticeCache.hpp"
+#include "config/LatticeImport.hpp"
+#include "physics/Waveform.hpp"
+
+namespace pas::config::tests {
+
+using namespace accelerator;
+
+class LatticeCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "pas_lattice_cache_test.pascache";
+
+        FODOCellParams params;
+        lattice.buildFODOLattice(params, 10, true);
+
+        auto dipole = std::make_shared<Dipole>("B1", 2.0, 1.2);
+        MagnetErrors errors;
+        errors.normal = {0.0, 1.5, -2.0};
+        errors.skew = {0.5};
+        errors.offsetX = 1e-4;
+        errors.roll = 2e-3;
+        dipole->setErrors(errors);
+        physics::EngeFunction fringe;
+        fringe.gap = 0.07;
+        dipole->setFringe(fringe);
+        dipole->setPosition(glm::dvec3(0.1, 0.0, 2.0));
+        dipole->setRotation(glm::angleAxis(0.05, glm::dvec3(0.0, 1.0, 0.0)));
+        lattice.addComponent(dipole);
+
+        Aperture rectangular;
+        rectangular.shape = ApertureShape::Rectangular;
+        rectangular.radiusX = 0.04;
+        rectangular.radiusY = 0.02;
+        physics::MultipoleExpansion octupole;
+        octupole.setNormal(4, 300.0);
+        octupole.setSkew(2, 0.1);
+        lattice.addComponent(std::make_shared<Multipole>("O1", 0.3, octupole, rectangular));
+        lattice.addComponent(std::make_shared<Sextupole>("S1", 0.2, 80.0));
+        lattice.addComponent(std::make_shared<Solenoid>("SOL", 1.0, 2.5));
+        lattice.addComponent(std::make_shared<RFCavity>("RF", 0.5, 1e6, 500e6, 0.3));
+        lattice.addComponent(std::make_shared<BeamPositionMonitor>("BPM", 256));
+        lattice.closeRing();
+    }
+
+    void TearDown() override { std::remove(path.c_str()); }
+
+    std::string path;
+    Accelerator lattice;
+};
+
+TEST_F(LatticeCacheTest, RoundTripKeepsComponentsAndSharing) {
+    ASSERT_TRUE(LatticeCache::save(lattice, path, 42));
+    auto loaded = LatticeCache::load(path, 42);
+    ASSERT_TRUE(loaded);
+
+    ASSERT_EQ(loaded->getComponentCount(), lattice.getComponentCount());
+    EXPECT_TRUE(loaded->isClosed());
+    EXPECT_DOUBLE_EQ(loaded->getTotalLength(), lattice.getTotalLength());
+    for (size_t i = 0; i < lattice.getComponentCount(); ++i) {
+        const auto& original = lattice.getComponent(i);
+        const auto& copy = loaded->getComponent(i);
+        EXPECT_EQ(copy->getType(), original->getType());
+        EXPECT_EQ(copy->getName(), original->getName());
+        EXPECT_DOUBLE_EQ(copy->getLength(), original->getLength());
+        EXPECT_EQ(copy->getAperture().shape, original->getAperture().shape);
+        EXPECT_DOUBLE_EQ(copy->getAperture().radiusY, original->getAperture().radiusY);
+        EXPECT_DOUBLE_EQ(loaded->getSPosition(i), lattice.getSPosition(i));
+        EXPECT_DOUBLE_EQ(loaded->getCompiledLattice().getStrengths()[i],
+                         lattice.getCompiledLattice().getStrengths()[i]);
+    }
+
+    // Shared cells stay shared
+    EXPECT_EQ(loaded->getComponent(0), loaded->getComponent(4));
+    EXPECT_NE(loaded->getComponent(0), loaded->getComponent(2));
+
+    auto dipole = std::dynamic_pointer_cast<Dipole>(loaded->getComponent("B1"));
+    ASSERT_TRUE(dipole);
+    EXPECT_EQ(dipole->getErrors().normal, (std::vector<double>{0.0, 1.5, -2.0}));
+    EXPECT_EQ(dipole->getErrors().skew, (std::vector<double>{0.5}));
+    EXPECT_DOUBLE_EQ(dipole->getErrors().roll, 2e-3);
+    ASSERT_TRUE(dipole->getFringe());
+    EXPECT_DOUBLE_EQ(dipole->getFringe()->gap, 0.07);
+    EXPECT_DOUBLE_EQ(dipole->getPosition().x, 0.1);
+    EXPECT_DOUBLE_EQ(dipole->getRotation().y, lattice.getComponent("B1")->getRotation().y);
+
+    auto multipole = std::dynamic_pointer_cast<Multipole>(loaded->getComponent("O1"));
+    ASSERT_TRUE(multipole);
+    EXPECT_DOUBLE_EQ(multipole->getCoefficients().getNormal(4), 300.0);
+    EXPECT_DOUBLE_EQ(multipole->getCoefficients().getSkew(2), 0.1);
+
+    auto cavity = std::dynamic_pointer_cast<RFCavity>(loaded->getComponent("RF"));
+    ASSERT_TRUE(cavity);
+    EXPECT_DOUBLE_EQ(cavity->getFrequency(), 500e6);
+    EXPECT_DOUBLE_EQ(cavity->getPhase(), 0.3);
+
+    auto monitor = std::dynamic_pointer_cast<BeamPositionMonitor>(loaded->getComponent("BPM"));
+    ASSERT_TRUE(monitor);
+    EXPECT_EQ(monitor->getCapacity(), 256u);
+}
+
+TEST_F(LatticeCacheTest, RejectsStaleAndCorruptCaches) {
+    EXPECT_FALSE(LatticeCache::load(path, 42));  // Missing
+
+    ASSERT_TRUE(LatticeCache::save(lattice, path, 42));
+    EXPECT_FALSE(LatticeCache::load(path, 43));  // Other source
+
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8);
+    EXPECT_FALSE(LatticeCache::load(path, 42));
+
+    // Ramps are shared objects outside the lattice
+    auto quad = std::dynamic_pointer_cast<Quadrupole>(lattice.makeUnique(0));
+    quad->setRamp(std::make_shared<physics::Waveform>(std::vector<double>{0.0, 1.0},
+                                                      std::vector<double>{1.0, 2.0}));
+    EXPECT_FALSE(LatticeCache::isCacheable(lattice));
+    EXPECT_FALSE(LatticeCache::save(lattice, path, 42));
+}
+
+TEST_F(LatticeCacheTest, LoadOrBuildParsesOnlyOnMiss) {
+    const std::string source = ::testing::TempDir() + "pas_lattice_cache_test.madx";
+    auto write = [&](double k1) {
+        std::ofstream file(source);
+        file << "beam, pc = 1.0;\n"
+             << "q: quadrupole, l = 0.5, k1 = " << k1 << ";\n"
+             << "ring: sequence, l = 4.0;\n q, at = 1.0;\n q, at = 3.0;\nendsequence;\n";
+    };
+
+    int parses = 0;
+    auto loader = [&](const std::string& file) {
+        ++parses;
+        return importMadx(file);
+    };
+
+    write(0.5);
+    auto first = LatticeCache::loadOrBuild(source, loader, path);
+    auto second = LatticeCache::loadOrBuild(source, loader, path);
+    ASSERT_TRUE(first && second);
+    EXPECT_EQ(parses, 1);
+    ASSERT_EQ(second->getComponentCount(), first->getComponentCount());
+    EXPECT_EQ(second->getComponent(1), second->getComponent(3));
+
+    // Editing the source invalidates the cache
+    write(0.25);
+    auto third = LatticeCache::loadOrBuild(source, loader, path);
+    ASSERT_TRUE(third);
+    EXPECT_EQ(parses, 2);
+    EXPECT_NEAR(third->getCompiledLattice().getStrengths()[1],
+                0.5 * first->getCompiledLattice().getStrengths()[1], 1e-12);
+
+    std::remove(source.c_str());
+}
+
+} // namespace pas::config::tests
@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "config/LatticeImport.hpp"
+#include "accelerator/BeamPositionMonitor.hpp"
+#include "physics/Constants.hpp"
+
+namespace pas::config::tests {
+
+using namespace accelerator;
+namespace constants = physics::constants;
+
+// Proton beam at pc = 10 GeV/c
+const double kRigidity = 10.0 * constants::energy::GeV / constants::c / constants::e;
+
+constexpr const char* kCellSequence = R"(
+! FODO cell with strengths set after the sequence
+beam, particle = proton, pc = 10.0;
+lq = 0.5;
+qf: quadrupole, l := lq, k1 := kqf;
+qd: qf, k1 := -kqf;                 // Inherits l from qf
+mb: sbend, l = 2.0, angle = 2*pi/100, apertype = ellipse, aperture = {0.04, 0.02};
+mr: rbend, l = 1.0, angle = 0.1;
+bpm: monitor;
+
+cell: sequence, l = 10.0, refer = entry;
+  qf, at = 0.0;
+  mb, at = 1.0;
+  bpm, at = 3.5;
+  qd, at = 5.0;
+  mb, at = 6.0;
+  m1: marker, at = 2.5, from = mb;
+  mr, at = 8.5;
+endsequence;
+
+/* Optics */
+kqf := 0.25 * scale;
+scale = 2;
+use, sequence = cell;
+)";
+
+TEST(LatticeImportTest, ParsesMadxSequence) {
+    auto lattice = parseMadx(kCellSequence);
+    ASSERT_TRUE(lattice);
+
+    // QF D MB D BPM D QD D MB D M1 MR D
+    ASSERT_EQ(lattice->getComponentCount(), 13u);
+    EXPECT_NEAR(lattice->getTotalLength(), 10.0, 1e-9);
+
+    auto qf = std::dynamic_pointer_cast<Quadrupole>(lattice->getComponent("qf"));
+    auto qd = std::dynamic_pointer_cast<Quadrupole>(lattice->getComponent("qd"));
+    ASSERT_TRUE(qf && qd);
+    EXPECT_NEAR(qf->getLength(), 0.5, 1e-12);
+    EXPECT_NEAR(qd->getLength(), 0.5, 1e-12);
+    EXPECT_NEAR(qf->getGradient(), 0.5 * kRigidity, 1e-9);
+    EXPECT_NEAR(qd->getGradient(), -0.5 * kRigidity, 1e-9);
+
+    auto mb = std::dynamic_pointer_cast<Dipole>(lattice->getComponent("mb"));
+    ASSERT_TRUE(mb);
+    EXPECT_NEAR(mb->getField(), 2.0 * constants::pi / 100.0 / 2.0 * kRigidity, 1e-9);
+    EXPECT_EQ(mb->getAperture().shape, ApertureShape::Elliptical);
+    EXPECT_DOUBLE_EQ(mb->getAperture().radiusX, 0.04);
+    EXPECT_DOUBLE_EQ(mb->getAperture().radiusY, 0.02);
+
+    // Positions follow at=, refer=entry and from=
+    EXPECT_NEAR(lattice->getSPosition(2), 1.0, 1e-9);
+    EXPECT_EQ(lattice->getComponent(4)->getType(), ComponentType::Monitor);
+    EXPECT_NEAR(lattice->getSPosition(4), 3.5, 1e-9);
+    EXPECT_NEAR(lattice->getSPosition(6), 5.0, 1e-9);
+    EXPECT_EQ(lattice->getComponent(10)->getName(), "m1");
+    EXPECT_NEAR(lattice->getSPosition(10), 8.5, 1e-9);  // 2.5 m after the second mb
+
+    // RBEND lengths are chords
+    auto mr = lattice->getComponent("mr");
+    EXPECT_NEAR(mr->getLength(), 1.0 * 0.05 / std::sin(0.05), 1e-12);
+    EXPECT_NEAR(lattice->getSPosition(11), 8.5, 1e-9);
+}
+
+TEST(LatticeImportTest, SharesRepeatedElementsAndDrifts) {
+    auto lattice = parseMadx(kCellSequence);
+    ASSERT_TRUE(lattice);
+
+    // Both places of mb use one component
+    EXPECT_EQ(lattice->getComponent(2), lattice->getComponent(8));
+
+    // The 0.5 m gaps share a drift
+    EXPECT_EQ(lattice->getComponent(1)->getType(), ComponentType::BeamPipe);
+    EXPECT_EQ(lattice->getComponent(1), lattice->getComponent(3));
+    EXPECT_EQ(lattice->getComponent(1), lattice->getComponent(7));
+    EXPECT_EQ(lattice->getComponent(1), lattice->getComponent(9));
+    EXPECT_NE(lattice->getComponent(1), lattice->getComponent(5));
+}
+
+TEST(LatticeImportTest, GivesEveryMonitorPlaceItsOwnComponent) {
+    constexpr const char* source = R"(
+        bpm: monitor;
+        mb: sbend, l = 1.0, angle = 0.1;
+        ring: sequence, l = 4.0, refer = entry;
+          bpm, at = 0.0;
+          mb, at = 1.0;
+          bpm, at = 2.0;
+          mb, at = 3.0;
+        endsequence;
+    )";
+    auto lattice = parseMadx(source);
+    ASSERT_TRUE(lattice);
+
+    // A shared monitor would mix the centroids of both places in one buffer
+    std::vector<std::shared_ptr<Component>> monitors;
+    std::vector<std::shared_ptr<Component>> bends;
+    for (const auto& component : lattice->getComponents()) {
+        if (component->getType() == ComponentType::Monitor) {
+            monitors.push_back(component);
+        } else if (component->getType() == ComponentType::Dipole) {
+            bends.push_back(component);
+        }
+    }
+    ASSERT_EQ(monitors.size(), 2u);
+    EXPECT_NE(monitors[0], monitors[1]);
+    EXPECT_EQ(monitors[0]->getName(), "bpm");
+    ASSERT_EQ(bends.size(), 2u);
+    EXPECT_EQ(bends[0], bends[1]);
+}
+
+TEST(LatticeImportTest, ConvertsCavitiesAndOverridesBeam) {
+    constexpr const char* source = R"(
+        beam, particle = electron, energy = 3.0;
+        rf: rfcavity, l = 0.5, volt = 2.0, harmon = 100, lag = 0.25;
+        ring: sequence, l = 100.0;
+          rf, at = 50.0;
+        endsequence;
+        return;
+        garbage that is never read
+    )";
+    auto lattice = parseMadx(source);
+    ASSERT_TRUE(lattice);
+    ASSERT_EQ(lattice->getComponentCount(), 3u);
+
+    auto rf = std::dynamic_pointer_cast<RFCavity>(lattice->getComponent("rf"));
+    ASSERT_TRUE(rf);
+    EXPECT_NEAR(rf->getSPosition(), 49.75, 1e-9);  // Centred on at=
+    EXPECT_DOUBLE_EQ(rf->getVoltage(), 2e6);
+    EXPECT_NEAR(rf->getPhase(), 0.5 * constants::pi, 1e-12);
+    EXPECT_NEAR(rf->getFrequency(), constants::c, 1e-6 * constants::c);  // harmon 100 at beta ~ 1
+
+    // The options select the sequence and override the beam
+    LatticeImportOptions options;
+    options.sequence = "missing";
+    EXPECT_FALSE(parseMadx(source, options));
+    options.sequence = "ring";
+    options.referenceMomentum = 10.0 * constants::energy::GeV / constants::c;
+    EXPECT_TRUE(parseMadx(source, options));
+    options.sequence.clear();
+    auto cell = parseMadx(kCellSequence, options);
+    ASSERT_TRUE(cell);
+    auto qf = std::dynamic_pointer_cast<Quadrupole>(cell->getComponent(0));
+    ASSERT_TRUE(qf);
+    EXPECT_NEAR(qf->getGradient(), 0.5 * kRigidity, 1e-9);
+}
+
+TEST(LatticeImportTest, ParsesTfsTable) {
+    constexpr const char* source = R"(@ NAME             %05s "TWISS"
+@ PARTICLE         %06s "PROTON"
+@ PC               %le  10.0
+@ CHARGE           %le  1
+@ LENGTH           %le  10.0
+* NAME     KEYWORD      S     L     ANGLE    K1L     APERTYPE   APER_1  APER_2
+$ %s       %s           %le   %le   %le      %le     %s         %le     %le
+ "START"   "MARKER"     0.0   0.0   0.0      0.0     "NONE"     0.0     0.0
+ "QF"      "QUADRUPOLE" 0.5   0.5   0.0      0.125   "CIRCLE"   0.03    0.0
+ "D1"      "DRIFT"      1.0   0.5   0.0      0.0     "NONE"     0.0     0.0
+ "MB"      "SBEND"      3.0   2.0   0.06     0.0     "NONE"     0.0     0.0
+ "BPM"     "MONITOR"    4.0   0.0   0.0      0.0     "NONE"     0.0     0.0
+ "QD"      "QUADRUPOLE" 5.5   0.5   0.0     -0.125   "NONE"     0.0     0.0
+)";
+    auto lattice = parseTfs(source);
+    ASSERT_TRUE(lattice);
+    EXPECT_NEAR(lattice->getTotalLength(), 10.0, 1e-9);
+
+    // START QF D MB D BPM D QD D
+    ASSERT_EQ(lattice->getComponentCount(), 9u);
+    auto qf = std::dynamic_pointer_cast<Quadrupole>(lattice->getComponent("QF"));
+    ASSERT_TRUE(qf);
+    EXPECT_NEAR(qf->getGradient(), 0.25 * kRigidity, 1e-9);
+    EXPECT_EQ(qf->getAperture().shape, ApertureShape::Circular);
+    EXPECT_DOUBLE_EQ(qf->getAperture().radiusX, 0.03);
+
+    auto mb = std::dynamic_pointer_cast<Dipole>(lattice->getComponent("MB"));
+    ASSERT_TRUE(mb);
+    EXPECT_NEAR(mb->getField(), 0.03 * kRigidity, 1e-9);
+    EXPECT_NEAR(lattice->getSPosition(3), 1.0, 1e-9);
+    EXPECT_NEAR(lattice->getSPosition(5), 4.0, 1e-9);
+
+    EXPECT_FALSE(parseTfs("@ NAME %05s \"X\"\n"));
+}
+
+TEST(LatticeImportTest, ImportsSolenoids) {
+    constexpr const char* sequence = R"(
+        beam, particle = proton, pc = 10.0;
+        sol: solenoid, l = 2.0, ks = 0.1;
+        line: sequence, l = 4.0, refer = entry;
+          sol, at = 1.0;
+        endsequence;
+    )";
+    auto lattice = parseMadx(sequence);
+    ASSERT_TRUE(lattice);
+    auto sol = std::dynamic_pointer_cast<Solenoid>(lattice->getComponent("sol"));
+    ASSERT_TRUE(sol);
+    EXPECT_NEAR(sol->getField(), 0.1 * kRigidity, 1e-9);
+
+    // TWISS tables give the integrated strength KSI = KS * L
+    constexpr const char* table = R"(@ PC               %le  10.0
+@ CHARGE           %le  1
+* NAME     KEYWORD      S     L     KSI
+$ %s       %s           %le   %le   %le
+ "SOL"     "SOLENOID"   3.0   2.0   0.2
+)";
+    auto tfs = parseTfs(table);
+    ASSERT_TRUE(tfs);
+    sol = std::dynamic_pointer_cast<Solenoid>(tfs->getComponent("SOL"));
+    ASSERT_TRUE(sol);
+    EXPECT_NEAR(sol->getField(), 0.1 * kRigidity, 1e-9);
+}
+
+TEST(LatticeImportTest, ImportsFromFile) {
+    const std::string path = ::testing::TempDir() + "pas_import_test.madx";
+    {
+        std::ofstream file(path);
+        file << kCellSequence;
+    }
+    auto lattice = importMadx(path);
+    ASSERT_TRUE(lattice);
+    EXPECT_EQ(lattice->getComponentCount(), 13u);
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(importMadx(path));
+}
+
+TEST(LatticeImportTest, ImportsLargeSequence) {
+    // 20000 elements placed by reference to a few definitions
+    std::string source = "beam, pc = 450;\n"
+                         "qf: quadrupole, l = 3.1, k1 = 0.008;\n"
+                         "qd: quadrupole, l = 3.1, k1 = -0.008;\n"
+                         "mb: sbend, l = 14.3, angle = 0.0002;\n"
+                         "ring: sequence, l = 267500.0, refer = entry;\n";
+    for (int cell = 0; cell < 5000; ++cell) {
+        const double s = cell * 53.5;
+        source += "qf, at = " + std::to_string(s) + ";\n";
+        source += "mb, at = " + std::to_string(s + 4.0) + ";\n";
+        source += "qd, at = " + std::to_string(s + 26.75) + ";\n";
+        source += "mb, at = " + std::to_string(s + 30.75) + ";\n";
+    }
+    source += "endsequence;\n";
+
+    auto lattice = parseMadx(source);
+    ASSERT_TRUE(lattice);
+    EXPECT_EQ(lattice->getComponentCount(), 5000u * 8u);
+    EXPECT_EQ(lattice->getComponent(0), lattice->getComponent(8 * 4999));
+    EXPECT_NEAR(lattice->getTotalLength(), 267500.0, 1e-6);
+}
+
+} // namespace pas::config::tests
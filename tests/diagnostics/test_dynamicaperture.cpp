@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include "diagnostics/DynamicAperture.hpp"
+#include "physics/Constants.hpp"
+
+#include "FODORing.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace pas::diagnostics::tests {
+
+using namespace physics::constants;
+using namespace physics::constants::energy;
+using namespace physics::constants::relativistic;
+
+class DynamicApertureTest : public ::testing::Test {
+protected:
+    double p0 = momentumFromGamma(gammaFromKineticEnergy(1.0 * GeV, m_p), m_p);
+    double brho = p0 / e;
+
+    accelerator::LatticeTracker makeFODOTracker(double k1, double aperture) {
+        accelerator::Aperture ap;
+        ap.radiusX = aperture;
+        ap.radiusY = aperture;
+        return accelerator::LatticeTracker(*pas::tests::makeFODORing(k1, 4, brho, ap), p0);
+    }
+};
+
+TEST_F(DynamicApertureTest, BoundaryIsResolvedByBisection) {
+    DynamicApertureScan scan(makeFODOTracker(2.0, 0.05));
+
+    DynamicApertureConfig config;
+    config.turns = 200;
+    config.rays = 5;
+    config.gridSteps = 10;
+    config.maxAmplitude = 0.1;
+    config.bisections = 10;
+    auto result = scan.run(config);
+
+    ASSERT_EQ(result.contours.size(), 1u);
+    const auto& points = result.contours[0].points;
+    ASSERT_EQ(points.size(), 5u);
+    EXPECT_DOUBLE_EQ(points.front().angle, 0.0);
+    EXPECT_NEAR(points.back().angle, pi / 2.0, 1e-12);
+
+    const double resolution = config.maxAmplitude / config.gridSteps / 1024.0;
+    for (const auto& point : points) {
+        ASSERT_TRUE(point.bounded);
+        EXPECT_GT(point.amplitude, 0.0);
+        EXPECT_LT(point.amplitude, 0.05);
+        EXPECT_TRUE(scan.isStable(point.x, point.y, 0.0, config.turns));
+
+        double outside = point.amplitude + 2.0 * resolution;
+        EXPECT_FALSE(scan.isStable(outside * std::cos(point.angle), outside * std::sin(point.angle),
+                                   0.0, config.turns));
+    }
+    EXPECT_GT(result.contours[0].getArea(), 0.0);
+}
+
+TEST_F(DynamicApertureTest, OuterParticlesAreDroppedEarly) {
+    DynamicApertureScan scan(makeFODOTracker(2.0, 0.05));
+
+    DynamicApertureConfig config;
+    config.turns = 500;
+    config.rays = 3;
+    config.gridSteps = 40;
+    config.maxAmplitude = 0.2;
+    config.blockSize = 4;
+    auto result = scan.run(config);
+
+    EXPECT_GT(result.particlesDropped, 0u);
+    EXPECT_LT(result.turnsTracked, static_cast<uint64_t>(result.particlesLaunched) * config.turns);
+}
+
+TEST_F(DynamicApertureTest, UnboundedWithinScanRange) {
+    DynamicApertureScan scan(makeFODOTracker(2.0, 1.0));
+
+    DynamicApertureConfig config;
+    config.turns = 100;
+    config.maxAmplitude = 0.01;
+    config.deltas = {-1e-3, 0.0, 1e-3};
+    auto result = scan.run(config);
+
+    ASSERT_EQ(result.contours.size(), 3u);
+    EXPECT_DOUBLE_EQ(result.contours[0].delta, -1e-3);
+    for (const auto& contour : result.contours) {
+        EXPECT_DOUBLE_EQ(contour.getMinimumAmplitude(), 0.01);
+        for (const auto& point : contour.points) {
+            EXPECT_FALSE(point.bounded);
+        }
+        // Polygon inscribed in a quarter circle
+        EXPECT_NEAR(contour.getArea(), pi * 1e-4 / 4.0, 1e-6);
+    }
+    EXPECT_EQ(result.particlesDropped, 0u);
+}
+
+TEST_F(DynamicApertureTest, UnstableLatticeHasNoAperture) {
+    // f = 0.5 m with 4.9 m drifts is far outside the FODO stability range
+    DynamicApertureScan scan(makeFODOTracker(20.0, 0.05));
+
+    DynamicApertureConfig config;
+    config.turns = 100;
+    config.rays = 3;
+    auto result = scan.run(config);
+
+    EXPECT_NEAR(result.contours[0].getMinimumAmplitude(), 0.0, 1e-4);
+}
+
+TEST_F(DynamicApertureTest, ExportCSV) {
+    DynamicApertureScan scan(makeFODOTracker(2.0, 0.05));
+    DynamicApertureConfig config;
+    config.turns = 50;
+    config.rays = 3;
+    auto result = scan.run(config);
+
+    std::string path = ::testing::TempDir() + "pas_da.csv";
+    ASSERT_TRUE(result.exportCSV(path));
+
+    std::ifstream file(path);
+    std::string line;
+    size_t lines = 0;
+    while (std::getline(file, line)) {
+        ++lines;
+    }
+    EXPECT_EQ(lines, 2u + 3u);  // Comment, header, one row per ray
+    std::remove(path.c_str());
+}
+
+} // namespace pas::diagnostics::tests
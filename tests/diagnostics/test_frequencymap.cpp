@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include "diagnostics/FrequencyMap.hpp"
+#include "physics/Constants.hpp"
+
+#include "FODORing.hpp"
+
+#include <cstdio>
+
+namespace pas::diagnostics::tests {
+
+using namespace physics::constants;
+using namespace physics::constants::energy;
+using namespace physics::constants::relativistic;
+
+class FrequencyMapTest : public ::testing::Test {
+protected:
+    double p0 = momentumFromGamma(gammaFromKineticEnergy(1.0 * GeV, m_p), m_p);
+    double brho = p0 / e;
+
+    accelerator::LatticeTracker makeFODOTracker(double aperture) {
+        accelerator::Aperture ap;
+        ap.radiusX = aperture;
+        ap.radiusY = aperture;
+        return accelerator::LatticeTracker(*pas::tests::makeFODORing(2.0, 4, brho, ap), p0);
+    }
+};
+
+TEST_F(FrequencyMapTest, LinearLatticeHasNoDiffusion) {
+    FrequencyMap fma(makeFODOTracker(1.0));
+
+    FrequencyMapConfig config;
+    config.turns = 512;
+    config.gridX = 4;
+    config.gridY = 3;
+    config.maxX = 4e-3;
+    config.maxY = 3e-3;
+    auto result = fma.run(config);
+
+    ASSERT_EQ(result.points.size(), 12u);
+    EXPECT_EQ(result.lostCount, 0u);
+
+    // Row-major grid with x fastest
+    EXPECT_DOUBLE_EQ(result.points[0].x, 1e-3);
+    EXPECT_DOUBLE_EQ(result.points[0].y, 1e-3);
+    EXPECT_DOUBLE_EQ(result.points[5].x, 2e-3);
+    EXPECT_DOUBLE_EQ(result.points[5].y, 2e-3);
+
+    // Linear motion: amplitude-independent tunes that never drift
+    for (const auto& point : result.points) {
+        ASSERT_TRUE(point.valid);
+        EXPECT_NEAR(point.tuneX, result.points[0].tuneX, 1e-9);
+        EXPECT_NEAR(point.tuneY, result.points[0].tuneY, 1e-9);
+        EXPECT_LT(point.diffusion, -7.0);
+    }
+    EXPECT_NEAR(result.points[0].tuneX, 2.0 / 3.0, 0.01);
+}
+
+TEST_F(FrequencyMapTest, LostParticlesAreInvalid) {
+    FrequencyMap fma(makeFODOTracker(0.01));
+
+    FrequencyMapConfig config;
+    config.turns = 128;
+    config.gridX = 5;
+    config.gridY = 1;
+    config.maxX = 0.02;
+    config.maxY = 1e-4;
+    auto result = fma.run(config);
+
+    EXPECT_GT(result.lostCount, 0u);
+    EXPECT_LT(result.lostCount, 5u);
+    EXPECT_TRUE(result.points.front().valid);
+    EXPECT_FALSE(result.points.back().valid);
+}
+
+TEST_F(FrequencyMapTest, TooFewTurnsGiveNoTunes) {
+    FrequencyMap fma(makeFODOTracker(1.0));
+
+    FrequencyMapConfig config;
+    config.turns = 2 * TuneAnalyzer::MIN_TURNS - 2;
+    config.gridX = 2;
+    config.gridY = 2;
+    auto result = fma.run(config);
+
+    for (const auto& point : result.points) {
+        EXPECT_FALSE(point.valid);
+    }
+}
+
+TEST_F(FrequencyMapTest, ExportCSV) {
+    FrequencyMap fma(makeFODOTracker(1.0));
+    FrequencyMapConfig config;
+    config.turns = 64;
+    config.gridX = 2;
+    config.gridY = 2;
+    auto result = fma.run(config);
+
+    std::string path = ::testing::TempDir() + "pas_fma.csv";
+    EXPECT_TRUE(result.exportCSV(path));
+    std::remove(path.c_str());
+}
+
+} // namespace pas::diagnostics::tests
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include "diagnostics/LossMap.hpp"
+#include "physics/PhysicsEngine.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace pas::diagnostics::tests {
+
+using physics::LossEvent;
+
+class LossMapTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        accelerator.addDrift(4.0, "D1");
+        accelerator.addDrift(6.0, "D2");
+        accelerator.computeLattice();
+    }
+
+    static LossEvent makeEvent(double s, size_t componentIndex) {
+        LossEvent event;
+        event.sPosition = s;
+        event.componentIndex = componentIndex;
+        return event;
+    }
+
+    accelerator::Accelerator accelerator;
+};
+
+TEST_F(LossMapTest, ConfigureFromLattice) {
+    LossMap map(10);
+    map.configure(accelerator);
+
+    EXPECT_EQ(map.getBinCount(), 10u);
+    EXPECT_DOUBLE_EQ(map.getLength(), 10.0);
+    EXPECT_DOUBLE_EQ(map.getBinWidth(), 1.0);
+    EXPECT_DOUBLE_EQ(map.getBinCenter(3), 3.5);
+    EXPECT_EQ(map.getComponentLosses().size(), 2u);
+    EXPECT_EQ(map.getComponentName(1), "D2");
+}
+
+TEST_F(LossMapTest, BinsBySAndComponent) {
+    LossMap map(10);
+    map.configure(accelerator);
+
+    std::vector<LossEvent> batch = {
+        makeEvent(0.5, 0), makeEvent(0.7, 0), makeEvent(5.5, 1), makeEvent(12.0, LossEvent::NoComponent)
+    };
+    map.accumulate(batch);
+
+    EXPECT_EQ(map.getTotalLosses(), 4u);
+    EXPECT_EQ(map.getSHistogram()[0], 2u);
+    EXPECT_EQ(map.getSHistogram()[5], 1u);
+    EXPECT_EQ(map.getComponentLosses()[0], 2u);
+    EXPECT_EQ(map.getComponentLosses()[1], 1u);
+    EXPECT_EQ(map.getUnassignedLosses(), 1u);
+}
+
+TEST_F(LossMapTest, CircularLatticeWrapsS) {
+    accelerator.closeRing();
+    LossMap map(10);
+    map.configure(accelerator);
+
+    std::vector<LossEvent> batch = { makeEvent(23.5, 0) };
+    map.accumulate(batch);
+
+    EXPECT_EQ(map.getSHistogram()[3], 1u);
+    EXPECT_EQ(map.getUnassignedLosses(), 0u);
+}
+
+TEST_F(LossMapTest, LargeBatchMatchesSerialCounts) {
+    LossMap map(10);
+    map.configure(accelerator);
+
+    std::vector<LossEvent> batch;
+    for (size_t i = 0; i < 100000; ++i) {
+        double s = static_cast<double>(i % 10) + 0.5;
+        batch.push_back(makeEvent(s, s < 4.0 ? 0 : 1));
+    }
+    map.accumulate(batch);
+
+    EXPECT_EQ(map.getTotalLosses(), 100000u);
+    for (uint64_t count : map.getSHistogram()) {
+        EXPECT_EQ(count, 10000u);
+    }
+    EXPECT_EQ(map.getComponentLosses()[0], 40000u);
+    EXPECT_EQ(map.getComponentLosses()[1], 60000u);
+
+    // Thread histograms are reset between batches, so nothing is merged twice
+    std::vector<LossEvent> sparse(5000, makeEvent(0.5, 0));
+    map.accumulate(sparse);
+    EXPECT_EQ(map.getTotalLosses(), 105000u);
+    EXPECT_EQ(map.getSHistogram()[0], 15000u);
+    EXPECT_EQ(map.getSHistogram()[1], 10000u);
+    EXPECT_EQ(map.getComponentLosses()[0], 45000u);
+    EXPECT_EQ(map.getComponentLosses()[1], 60000u);
+}
+
+TEST_F(LossMapTest, ClearResetsCounts) {
+    LossMap map(10);
+    map.configure(accelerator);
+
+    std::vector<LossEvent> batch = { makeEvent(1.5, 0) };
+    map.accumulate(batch);
+    map.clear();
+
+    EXPECT_EQ(map.getTotalLosses(), 0u);
+    EXPECT_EQ(map.getSHistogram()[1], 0u);
+    EXPECT_EQ(map.getComponentLosses()[0], 0u);
+}
+
+TEST_F(LossMapTest, ConnectRecordsEngineLosses) {
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    acc->addDrift(2.0, "D1");
+    acc->computeLattice();
+
+    physics::PhysicsEngine engine;
+    engine.setAccelerator(acc);
+
+    LossMap map(4);
+    map.connect(engine);
+
+    engine.getParticleSystem().addParticle(physics::Particle::proton({0.5, 0.0, 1.2}));
+    engine.step();
+
+    EXPECT_EQ(map.getTotalLosses(), 1u);
+    EXPECT_EQ(map.getSHistogram()[2], 1u);
+    EXPECT_EQ(map.getComponentLosses()[0], 1u);
+
+    map.disconnect();
+    engine.getParticleSystem().addParticle(physics::Particle::proton({0.5, 0.0, 1.2}));
+    engine.step();
+    EXPECT_EQ(map.getTotalLosses(), 1u);
+}
+
+TEST_F(LossMapTest, OutlivesConnectedEngine) {
+    LossMap map(4);
+    {
+        physics::PhysicsEngine engine;
+        map.connect(engine);
+    }
+    map.disconnect();
+    EXPECT_EQ(map.getTotalLosses(), 0u);
+}
+
+TEST_F(LossMapTest, ExportCSV) {
+    LossMap map(10);
+    map.configure(accelerator);
+    std::vector<LossEvent> batch = { makeEvent(1.5, 0) };
+    map.accumulate(batch);
+
+    std::string path = ::testing::TempDir() + "pas_loss_map.csv";
+    ASSERT_TRUE(map.exportCSV(path));
+
+    std::ifstream file(path);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_NE(content.find("s_start,s_end,losses"), std::string::npos);
+    EXPECT_NE(content.find("0,\"D1\",0,1"), std::string::npos);
+    std::remove(path.c_str());
+}
+
+TEST_F(LossMapTest, ExportCSVQuotesComponentNames) {
+    // Imported names may contain separators and quotes
+    accelerator::Accelerator lattice;
+    lattice.addDrift(1.0, "MB.A12,R1 \"LEFT\"");
+    lattice.computeLattice();
+    LossMap map(10);
+    map.configure(lattice);
+
+    std::string path = ::testing::TempDir() + "pas_loss_map_quoted.csv";
+    ASSERT_TRUE(map.exportCSV(path));
+
+    std::ifstream file(path);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_NE(content.find("0,\"MB.A12,R1 \"\"LEFT\"\"\",0,0"), std::string::npos);
+    std::remove(path.c_str());
+}
+
+} // namespace pas::diagnostics::tests
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include "diagnostics/TuneAnalyzer.hpp"
+#include "physics/Constants.hpp"
+
+#include "FODORing.hpp"
+
+#include <cmath>
+
+namespace pas::diagnostics::tests {
+
+using namespace physics::constants;
+using namespace physics::constants::energy;
+using namespace physics::constants::relativistic;
+using pas::tests::makeFODORing;
+
+namespace {
+
+std::vector<double> sineSignal(double tune, size_t turns, double phase = 0.3) {
+    std::vector<double> signal(turns);
+    for (size_t n = 0; n < turns; ++n) {
+        signal[n] = 1e-3 * std::cos(2.0 * pi * tune * static_cast<double>(n) + phase) + 2e-4;
+    }
+    return signal;
+}
+
+} // namespace
+
+class TuneAnalyzerTest : public ::testing::Test {
+protected:
+    double p0 = momentumFromGamma(gammaFromKineticEnergy(1.0 * GeV, m_p), m_p);
+    double brho = p0 / e;
+};
+
+TEST_F(TuneAnalyzerTest, FFTFindsTune) {
+    auto signal = sineSignal(0.2871, 1024);
+    auto tune = TuneAnalyzer::computeTune(signal, TuneMethod::FFT);
+    ASSERT_TRUE(tune.has_value());
+    EXPECT_NEAR(*tune, 0.2871, 1e-4);
+}
+
+TEST_F(TuneAnalyzerTest, NAFFRefinesTune) {
+    auto signal = sineSignal(0.2871, 1024);
+    auto tune = TuneAnalyzer::computeTune(signal, TuneMethod::NAFF);
+    ASSERT_TRUE(tune.has_value());
+    EXPECT_NEAR(*tune, 0.2871, 1e-8);
+}
+
+TEST_F(TuneAnalyzerTest, RealSignalFoldsAboveHalfInteger) {
+    auto signal = sineSignal(0.7, 512);
+    auto tune = TuneAnalyzer::computeTune(signal);
+    ASSERT_TRUE(tune.has_value());
+    EXPECT_NEAR(*tune, 0.3, 1e-8);
+}
+
+TEST_F(TuneAnalyzerTest, PhaseSpaceSignalResolvesHalfInteger) {
+    const double tune = 0.7;
+    const double beta = 12.0;
+    std::vector<double> x(512), px(512);
+    for (size_t n = 0; n < x.size(); ++n) {
+        double phase = 2.0 * pi * tune * static_cast<double>(n);
+        x[n] = 1e-3 * std::cos(phase);
+        px[n] = -1e-3 / beta * std::sin(phase);
+    }
+    auto result = TuneAnalyzer::computeTune(x, px);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_NEAR(*result, 0.7, 1e-8);
+}
+
+TEST_F(TuneAnalyzerTest, RejectsShortOrFlatSignals) {
+    auto shortSignal = sineSignal(0.3, TuneAnalyzer::MIN_TURNS - 1);
+    EXPECT_FALSE(TuneAnalyzer::computeTune(shortSignal).has_value());
+
+    std::vector<double> flat(256, 1e-3);
+    EXPECT_FALSE(TuneAnalyzer::computeTune(flat).has_value());
+}
+
+TEST_F(TuneAnalyzerTest, ChromaticityOfFODORing) {
+    auto ring = makeFODORing(2.0, 4, brho);
+    accelerator::LatticeTracker tracker(*ring, p0);
+
+    std::vector<double> deltas = {-2e-3, -1e-3, 0.0, 1e-3, 2e-3};
+    auto result = TuneAnalyzer::measureChromaticity(tracker, deltas, 512);
+    ASSERT_TRUE(result.valid);
+    ASSERT_EQ(result.tunesX.size(), deltas.size());
+
+    // Thin-lens FODO: Q = 4 * 60/360, xi = -4 * tan(30 deg) / pi
+    EXPECT_NEAR(result.tunesX[2], 2.0 / 3.0, 0.01);
+    EXPECT_NEAR(result.tunesY[2], 2.0 / 3.0, 0.01);
+    double expected = -4.0 * std::tan(pi / 6.0) / pi;
+    EXPECT_NEAR(result.chromaticityX, expected, 0.05 * std::abs(expected));
+    EXPECT_NEAR(result.chromaticityY, expected, 0.05 * std::abs(expected));
+}
+
+TEST_F(TuneAnalyzerTest, SextupolesCorrectChromaticity) {
+    // FODO ring with bends; sextupoles next to the quadrupoles see the dispersion
+    auto makeRing = [this](double k2f, double k2d) {
+        accelerator::Accelerator acc;
+        for (size_t i = 0; i < 8; ++i) {
+            acc.addComponent(std::make_shared<accelerator::Quadrupole>("QF", 0.2, 1.0 * brho));
+            acc.addComponent(std::make_shared<accelerator::Sextupole>("SF", 0.1, k2f * brho));
+            acc.addDrift(0.5);
+            acc.addComponent(std::make_shared<accelerator::Dipole>("B", 4.0, brho * 2.0 * pi / 16.0 / 4.0));
+            acc.addDrift(0.5);
+            acc.addComponent(std::make_shared<accelerator::Quadrupole>("QD", 0.2, -1.0 * brho));
+            acc.addComponent(std::make_shared<accelerator::Sextupole>("SD", 0.1, k2d * brho));
+            acc.addDrift(0.5);
+            acc.addComponent(std::make_shared<accelerator::Dipole>("B", 4.0, brho * 2.0 * pi / 16.0 / 4.0));
+            acc.addDrift(0.5);
+        }
+        acc.closeRing();
+        return acc;
+    };
+
+    std::vector<double> deltas = {-1e-3, 0.0, 1e-3};
+    auto natural = TuneAnalyzer::measureChromaticity(
+        accelerator::LatticeTracker(makeRing(0.0, 0.0), p0), deltas, 512);
+    auto corrected = TuneAnalyzer::measureChromaticity(
+        accelerator::LatticeTracker(makeRing(2.0, -4.0), p0), deltas, 512);
+    ASSERT_TRUE(natural.valid);
+    ASSERT_TRUE(corrected.valid);
+
+    EXPECT_LT(natural.chromaticityX, 0.0);
+    EXPECT_LT(natural.chromaticityY, 0.0);
+    EXPECT_GT(corrected.chromaticityX, natural.chromaticityX);
+    EXPECT_GT(corrected.chromaticityY, natural.chromaticityY);
+
+    // Sextupoles do not change the on-momentum tunes
+    EXPECT_NEAR(corrected.tunesX[1], natural.tunesX[1], 1e-3);
+    EXPECT_NEAR(corrected.tunesY[1], natural.tunesY[1], 1e-3);
+}
+
+TEST_F(TuneAnalyzerTest, BackgroundTrackingAnalysis) {
+    auto ring = makeFODORing(2.0, 4, brho);
+    accelerator::LatticeTracker tracker(*ring, p0);
+
+    TuneAnalyzer analyzer;
+    ASSERT_TRUE(analyzer.analyzeTracking(tracker, {-1e-3, 0.0, 1e-3}, 256));
+    EXPECT_TRUE(analyzer.isBusy());
+    EXPECT_FALSE(analyzer.analyzeTracking(tracker, {}, 256));
+
+    analyzer.wait();
+    EXPECT_FALSE(analyzer.isBusy());
+    const auto& latest = analyzer.getLatest();
+    ASSERT_TRUE(latest.has_value());
+    EXPECT_EQ(latest->turns, 256u);
+    ASSERT_TRUE(latest->tuneX.has_value());
+    EXPECT_NEAR(*latest->tuneX, 2.0 / 3.0, 0.01);
+    ASSERT_TRUE(latest->chromaticity.has_value());
+    EXPECT_LT(latest->chromaticity->chromaticityX, 0.0);
+
+    // The on-momentum tune is the scan's delta = 0 entry
+    ASSERT_TRUE(latest->tuneY.has_value());
+    EXPECT_EQ(*latest->tuneX, latest->chromaticity->tunesX[1]);
+    EXPECT_EQ(*latest->tuneY, latest->chromaticity->tunesY[1]);
+}
+
+TEST_F(TuneAnalyzerTest, AnalyzeMonitorData) {
+    accelerator::BeamPositionMonitor bpm("BPM1", 256);
+    auto x = sineSignal(0.23, 256);
+    auto y = sineSignal(0.41, 256);
+    for (uint64_t turn = 0; turn < 256; ++turn) {
+        accelerator::PlaneCrossing crossing;
+        crossing.turn = turn;
+        crossing.x = x[turn];
+        crossing.y = y[turn];
+        bpm.recordCrossing(crossing);
+        bpm.commitCrossings();
+    }
+    bpm.flush();
+
+    TuneAnalyzer analyzer;
+    ASSERT_TRUE(analyzer.analyzeMonitor(bpm));
+    analyzer.wait();
+
+    const auto& latest = analyzer.getLatest();
+    ASSERT_TRUE(latest.has_value());
+    EXPECT_EQ(latest->source, "BPM1");
+    ASSERT_TRUE(latest->tuneX && latest->tuneY);
+    EXPECT_NEAR(*latest->tuneX, 0.23, 1e-6);
+    EXPECT_NEAR(*latest->tuneY, 0.41, 1e-6);
+}
+
+} // namespace pas::diagnostics::tests
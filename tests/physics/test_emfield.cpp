@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <cmath>
+#include <vector>
 
 #include "physics/EMField.hpp"
 #include "physics/Constants.hpp"
@@ -95,6 +96,166 @@ TEST_F(EMFieldTest, QuadrupoleFieldOutsideApertureIsZero) {
     EXPECT_DOUBLE_EQ(outside.B.y, 0.0);
 }
 
+// MultipoleField tests
+
+TEST_F(EMFieldTest, MultipoleExpansionMatchesQuadrupoleField) {
+    MultipoleExpansion multipoles;
+    multipoles.setNormal(2, 50.0);
+    QuadrupoleField quad(50.0);
+
+    for (double x : {-0.02, 0.0, 0.013}) {
+        for (double y : {-0.01, 0.0, 0.03}) {
+            glm::dvec3 B = multipoles.evaluate(x, y);
+            FieldValue expected = quad.evaluate(glm::dvec3(x, y, 0.0), 0.0);
+            EXPECT_NEAR(B.x, expected.B.x, EPSILON);
+            EXPECT_NEAR(B.y, expected.B.y, EPSILON);
+        }
+    }
+}
+
+TEST_F(EMFieldTest, MultipoleExpansionSextupoleAndSkewTerms) {
+    MultipoleExpansion multipoles;
+    multipoles.setNormal(3, 100.0);  // By + iBx = 100 (x + iy)^2
+    multipoles.setSkew(1, 0.5);      // Constant horizontal field
+    EXPECT_EQ(multipoles.getOrder(), 3);
+    EXPECT_DOUBLE_EQ(multipoles.getNormal(2), 0.0);
+
+    glm::dvec3 B = multipoles.evaluate(0.01, 0.02);
+    EXPECT_NEAR(B.y, 100.0 * (0.01 * 0.01 - 0.02 * 0.02), EPSILON);
+    EXPECT_NEAR(B.x, 100.0 * 2.0 * 0.01 * 0.02 + 0.5, EPSILON);
+}
+
+TEST_F(EMFieldTest, RolledQuadrupoleBecomesSkew) {
+    MultipoleExpansion normal;
+    normal.setNormal(2, 20.0);
+    MultipoleField rolled(normal, glm::dvec3(0.0), 1.0, 0.1, constants::pi / 4.0);
+
+    // A normal quadrupole rolled by 45 degrees is a skew quadrupole: By + iBx = -i G (x + iy)
+    FieldValue value = rolled.evaluate(glm::dvec3(0.01, 0.02, 0.0), 0.0);
+    EXPECT_NEAR(value.B.y, 20.0 * 0.02, EPSILON);
+    EXPECT_NEAR(value.B.x, -20.0 * 0.01, EPSILON);
+}
+
+TEST_F(EMFieldTest, MultipoleFieldUsesOffsetCenter) {
+    MultipoleExpansion multipoles;
+    multipoles.setNormal(2, 10.0);
+    MultipoleField field(multipoles, glm::dvec3(0.001, 0.0, 0.0), 1.0, 0.05);
+
+    EXPECT_NEAR(field.evaluate(glm::dvec3(0.001, 0.0, 0.0), 0.0).B.y, 0.0, EPSILON);
+    EXPECT_NEAR(field.evaluate(glm::dvec3(0.0, 0.0, 0.0), 0.0).B.y, -0.01, EPSILON);
+    EXPECT_DOUBLE_EQ(field.evaluate(glm::dvec3(0.1, 0.0, 0.0), 0.0).B.y, 0.0);
+}
+
+TEST_F(EMFieldTest, MultipoleFieldBatchMatchesSinglePoints) {
+    MultipoleExpansion multipoles;
+    multipoles.setNormal(2, 20.0);
+    multipoles.setNormal(3, 150.0);
+    multipoles.setSkew(5, 3e4);
+    MultipoleField field(multipoles, glm::dvec3(1e-3, -2e-3, 0.0), 1.0, 0.03, 0.01);
+
+    std::vector<glm::dvec3> positions;
+    for (int i = 0; i < 150; ++i) {
+        double t = 0.1 * i;
+        positions.emplace_back(0.03 * std::cos(t), 0.025 * std::sin(1.3 * t), 0.6 * std::sin(0.7 * t));
+    }
+    std::vector<glm::dvec3> fields(positions.size());
+    field.evaluateBatch(positions, fields);
+
+    for (size_t i = 0; i < positions.size(); ++i) {
+        FieldValue expected = field.evaluate(positions[i], 0.0);
+        EXPECT_NEAR(fields[i].x, expected.B.x, 1e-14);
+        EXPECT_NEAR(fields[i].y, expected.B.y, 1e-14);
+        EXPECT_DOUBLE_EQ(fields[i].z, 0.0);
+    }
+}
+
+TEST_F(EMFieldTest, EngeProfileKeepsEffectiveLength) {
+    EngeFunction enge;
+    enge.gap = 0.1;
+    FringeProfile profile(enge, 1.0);
+    EXPECT_NEAR(profile.value(0.0), 1.0, 1e-9);
+    EXPECT_NEAR(profile.value(0.5), 1.0 / (1.0 + std::exp(enge.coefficients[0])), 1e-9);
+    EXPECT_LT(profile.value(profile.getExtent()), 1e-5);
+    EXPECT_GT(profile.getExtent(), 0.5);
+
+    // Field integral of the soft edges equals the hard-edge length
+    double integral = 0.0;
+    const int steps = 20000;
+    const double dz = 2.0 * profile.getExtent() / steps;
+    for (int i = 0; i < steps; ++i) {
+        integral += profile.value(-profile.getExtent() + (i + 0.5) * dz) * dz;
+    }
+    EXPECT_NEAR(integral, 1.0, 1e-3);
+
+    // Derivative is consistent with the value
+    const double h = 1e-6;
+    for (double z : {0.4, 0.5, 0.55, -0.47}) {
+        EXPECT_NEAR(profile.derivative(z), (profile.value(z + h) - profile.value(z - h)) / (2.0 * h), 1e-5);
+    }
+    EXPECT_GT(enge.integrals().fint, 0.0);
+}
+
+TEST_F(EMFieldTest, SolenoidFieldIsDivergenceFree) {
+    EngeFunction enge;
+    enge.gap = 0.1;
+    SolenoidField field(2.0, glm::dvec3(0.0, 0.0, 1.0), 0.5, 0.05, enge);
+
+    EXPECT_NEAR(field.evaluate(glm::dvec3(0.0, 0.0, 1.0), 0.0).B.z, 2.0, 1e-8);
+    EXPECT_GT(field.getBoundingBox().max.z, 1.25);
+
+    // Radial field appears only at the ends, pointing in at the entrance
+    EXPECT_NEAR(field.evaluate(glm::dvec3(0.01, 0.0, 1.0), 0.0).B.x, 0.0, 1e-8);
+    EXPECT_LT(field.evaluate(glm::dvec3(0.01, 0.0, 0.75), 0.0).B.x, -1e-3);
+    EXPECT_GT(field.evaluate(glm::dvec3(0.01, 0.0, 1.25), 0.0).B.x, 1e-3);
+
+    const double h = 1e-6;
+    for (double z : {0.7, 0.75, 0.8, 1.3}) {
+        glm::dvec3 p(0.01, -0.005, z);
+        auto B = [&](const glm::dvec3& q) { return field.evaluate(q, 0.0).B; };
+        double divergence = (B(p + glm::dvec3(h, 0, 0)).x - B(p - glm::dvec3(h, 0, 0)).x +
+                             B(p + glm::dvec3(0, h, 0)).y - B(p - glm::dvec3(0, h, 0)).y +
+                             B(p + glm::dvec3(0, 0, h)).z - B(p - glm::dvec3(0, 0, h)).z) / (2.0 * h);
+        EXPECT_NEAR(divergence, 0.0, 1e-6);
+    }
+}
+
+TEST_F(EMFieldTest, MultipoleFringeFieldIsCurlFree) {
+    MultipoleExpansion multipoles;
+    multipoles.setNormal(2, 20.0);
+    multipoles.setNormal(3, 150.0);
+    EngeFunction enge;
+    enge.gap = 0.08;
+    MultipoleField field(multipoles, glm::dvec3(0.0), 0.4, 0.04, 0.1, enge);
+    ASSERT_TRUE(field.getFringe().has_value());
+
+    auto B = [&](const glm::dvec3& q) { return field.evaluate(q, 0.0).B; };
+    EXPECT_NEAR(B(glm::dvec3(0.01, 0.0, 0.0)).y, 20.0 * 0.01 * std::cos(0.2) + 150.0 * 1e-4 * std::cos(0.3), 1e-6);
+    EXPECT_DOUBLE_EQ(B(glm::dvec3(0.01, 0.0, 0.0)).z, 0.0);
+    EXPECT_GT(std::abs(B(glm::dvec3(0.01, 0.01, 0.22)).z), 1e-4);
+
+    // dBz/dx = dBx/dz and dBz/dy = dBy/dz at the edge
+    const double h = 1e-6;
+    glm::dvec3 p(0.01, 0.007, 0.2);
+    EXPECT_NEAR((B(p + glm::dvec3(h, 0, 0)).z - B(p - glm::dvec3(h, 0, 0)).z) / (2.0 * h),
+                (B(p + glm::dvec3(0, 0, h)).x - B(p - glm::dvec3(0, 0, h)).x) / (2.0 * h), 1e-5);
+    EXPECT_NEAR((B(p + glm::dvec3(0, h, 0)).z - B(p - glm::dvec3(0, h, 0)).z) / (2.0 * h),
+                (B(p + glm::dvec3(0, 0, h)).y - B(p - glm::dvec3(0, 0, h)).y) / (2.0 * h), 1e-5);
+
+    // Batch evaluation includes the fringe
+    std::vector<glm::dvec3> positions;
+    for (int i = 0; i < 100; ++i) {
+        positions.emplace_back(0.02 * std::cos(0.1 * i), 0.02 * std::sin(0.13 * i), 0.005 * i - 0.25);
+    }
+    std::vector<glm::dvec3> fields(positions.size());
+    field.evaluateBatch(positions, fields);
+    for (size_t i = 0; i < positions.size(); ++i) {
+        glm::dvec3 expected = B(positions[i]);
+        EXPECT_NEAR(fields[i].x, expected.x, 1e-14);
+        EXPECT_NEAR(fields[i].y, expected.y, 1e-14);
+        EXPECT_NEAR(fields[i].z, expected.z, 1e-14);
+    }
+}
+
 // RFField tests
 
 TEST_F(EMFieldTest, RFFieldHasCorrectAmplitude) {
@@ -192,6 +353,94 @@ TEST_F(EMFieldTest, ManagerClearRemovesAllSources) {
     EXPECT_EQ(manager.getSourceCount(), 0u);
 }
 
+TEST_F(EMFieldTest, ManagerReplacesSourceInPlace) {
+    EMFieldManager manager;
+    auto first = std::make_shared<UniformBField>(glm::dvec3(1.0, 0.0, 0.0));
+    auto second = std::make_shared<UniformBField>(glm::dvec3(0.0, 2.0, 0.0));
+    auto replacement = std::make_shared<UniformBField>(glm::dvec3(0.0, 0.0, 3.0));
+    manager.addSource(first);
+    manager.addSource(second);
+
+    manager.replaceSource(first, replacement);
+    ASSERT_EQ(manager.getSourceCount(), 2u);
+    EXPECT_EQ(manager.getSources()[0], replacement);
+    EXPECT_NEAR(manager.evaluate(glm::dvec3(0.0), 0.0).B.x, 0.0, EPSILON);
+
+    manager.replaceSource(nullptr, first);
+    EXPECT_EQ(manager.getSourceCount(), 3u);
+    manager.replaceSource(second, nullptr);
+    EXPECT_EQ(manager.getSourceCount(), 2u);
+
+    // The scale multiplies the contribution of a source
+    replacement->setScale(0.5);
+    EXPECT_NEAR(manager.evaluate(glm::dvec3(0.0), 0.0).B.z, 1.5, EPSILON);
+}
+
+TEST_F(EMFieldTest, PlacedFieldMovesAndRotatesSource) {
+    // Quadrupole around the origin, placed at z = 10 and turned 90 degrees about z
+    auto quad = std::make_shared<QuadrupoleField>(10.0, glm::dvec3(0.0), 1.0, 0.1);
+    const glm::dquat rotation = glm::angleAxis(0.5 * pi, glm::dvec3(0.0, 0.0, 1.0));
+    PlacedField placed(quad, glm::dvec3(0.0, 0.0, 10.0), rotation);
+
+    // Local (0.01, 0, 0) is global (0, 0.01, 10); local By = G x turns into -Bx
+    FieldValue field = placed.evaluate(glm::dvec3(0.0, 0.01, 10.0), 0.0);
+    EXPECT_NEAR(field.B.x, -0.1, EPSILON);
+    EXPECT_NEAR(field.B.y, 0.0, EPSILON);
+    EXPECT_NEAR(placed.evaluate(glm::dvec3(0.0, 0.01, 0.0), 0.0).B.x, 0.0, EPSILON);
+    EXPECT_TRUE(placed.getBoundingBox().contains(glm::dvec3(0.0, 0.0, 10.4)));
+    EXPECT_FALSE(placed.getBoundingBox().contains(glm::dvec3(0.0, 0.0, 0.0)));
+
+    // The wrapped source keeps its enable flag; only the placement's scale applies
+    quad->setScale(2.0);
+    EXPECT_NEAR(placed.evaluate(glm::dvec3(0.0, 0.01, 10.0), 0.0).B.x, -0.1, EPSILON);
+    quad->setEnabled(false);
+    EXPECT_NEAR(placed.evaluate(glm::dvec3(0.0, 0.01, 10.0), 0.0).B.x, 0.0, EPSILON);
+
+    placed.setPlacement(glm::dvec3(1.0, 0.0, 0.0), glm::dquat(1.0, 0.0, 0.0, 0.0));
+    EXPECT_TRUE(placed.getBoundingBox().contains(glm::dvec3(1.05, 0.0, 0.0)));
+}
+
+TEST_F(EMFieldTest, FloatEvaluationMatchesDouble) {
+    MultipoleExpansion multipoles;
+    multipoles.setNormal(2, 20.0);
+    multipoles.setNormal(3, 150.0);
+    multipoles.setSkew(1, 0.2);
+    EngeFunction enge;
+    enge.gap = 0.1;
+
+    auto quad = std::make_shared<QuadrupoleField>(10.0, glm::dvec3(0.0), 1.0, 0.1);
+    auto placed = std::make_shared<PlacedField>(
+        quad, glm::dvec3(0.1, 0.0, 0.4), glm::angleAxis(0.3, glm::dvec3(0.0, 1.0, 0.0)));
+    placed->setScale(0.5);
+    std::vector<std::shared_ptr<FieldSource>> sources = {
+        std::make_shared<UniformBField>(glm::dvec3(0.1, -1.2, 0.3)),
+        quad,
+        placed,
+        std::make_shared<MultipoleField>(multipoles, glm::dvec3(1e-3, 0.0, 0.5), 1.0, 0.05, 0.2, enge),
+        std::make_shared<SolenoidField>(2.0, glm::dvec3(0.0, 0.0, 0.5), 0.5, 0.05, enge),
+        std::make_shared<RFField>(1e6, 400e6, 0.3, glm::dvec3(0.0, 0.0, 0.5), 0.5, 0.1)};
+
+    EMFieldManager manager;
+    for (const auto& source : sources) {
+        manager.addSource(source);
+    }
+
+    // Float keeps about 7 digits of the double field
+    for (double z : {0.0, 0.2, 0.25, 0.5, 0.74, 0.9}) {
+        const glm::vec3 position(0.012f, -0.007f, static_cast<float>(z));
+        for (const auto& source : sources) {
+            FieldValue expected = source->evaluate(glm::dvec3(position), 1e-9);
+            FloatFieldValue value = source->evaluateFloat(position, 1e-9);
+            EXPECT_LE(glm::length(glm::dvec3(value.B) - expected.B), 1e-5 * (1.0 + glm::length(expected.B)));
+            EXPECT_LE(glm::length(glm::dvec3(value.E) - expected.E), 1e-5 * (1.0 + glm::length(expected.E)));
+        }
+        FieldValue total = manager.evaluate(glm::dvec3(position), 1e-9);
+        FloatFieldValue value = manager.evaluateFloat(position, 1e-9);
+        EXPECT_LE(glm::length(glm::dvec3(value.B) - total.B), 1e-5 * (1.0 + glm::length(total.B)));
+        EXPECT_LE(glm::length(glm::dvec3(value.E) - total.E), 1e-5 * (1.0 + glm::length(total.E)));
+    }
+}
+
 // FieldValue operations
 
 TEST_F(EMFieldTest, FieldValueAddition) {
@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "physics/EnsembleRunner.hpp"
+#include "physics/Constants.hpp"
+
+namespace pas::physics::tests {
+
+using namespace constants;
+
+class EnsembleRunnerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        lattice = std::make_shared<accelerator::Accelerator>();
+        lattice->addDrift(0.5, "D0");
+        lattice->addComponent(std::make_shared<accelerator::Quadrupole>("QF", 0.2, 20.0));
+        lattice->addDrift(0.5, "D1");
+        lattice->addComponent(std::make_shared<accelerator::Quadrupole>("QD", 0.2, -20.0));
+        lattice->addDrift(0.5, "D2");
+        lattice->addComponent(std::make_shared<accelerator::Detector>("DET"));
+        lattice->addComponent(std::make_shared<accelerator::RFCavity>("RF", 0.3, 1e6, 400e6, 0.0));
+        lattice->addDrift(1.0, "D3");
+        lattice->computeLattice();
+
+        beam.numParticles = 64;
+        beam.kineticEnergy = 1.0 * energy::GeV;
+        beam.sigmaZ = 1e-3;
+        beam.positionOffset = {0.0, 0.0, 0.1};
+        beam.seed = 7;
+
+        config.steps = 60;
+        config.timeStep = 1e-10;
+        config.seed = 11;
+    }
+
+    std::shared_ptr<accelerator::Accelerator> lattice;
+    BeamParameters beam;
+    EnsembleConfig config;
+};
+
+TEST_F(EnsembleRunnerTest, BuilderSharesUnmodifiedComponents) {
+    VariantBuilder builder(*lattice, 0, 1);
+    auto quad = builder.modify<accelerator::Quadrupole>(1);
+    ASSERT_NE(quad, nullptr);
+    quad->setGradient(25.0);
+
+    EXPECT_TRUE(builder.isModified(1));
+    EXPECT_FALSE(builder.isModified(3));
+    EXPECT_EQ(builder.getLattice().getComponent(3), lattice->getComponent(3));
+    EXPECT_NE(builder.getLattice().getComponent(1), lattice->getComponent(1));
+
+    // The base lattice is untouched
+    auto baseQuad = std::dynamic_pointer_cast<accelerator::Quadrupole>(lattice->getComponent(1));
+    EXPECT_DOUBLE_EQ(baseQuad->getGradient(), 20.0);
+
+    // Modifying twice returns the same copy; wrong types give nullptr
+    EXPECT_EQ(builder.modify<accelerator::Quadrupole>(1), quad);
+    EXPECT_EQ(builder.modify<accelerator::Dipole>(1), nullptr);
+    EXPECT_EQ(builder.modify(100), nullptr);
+}
+
+TEST_F(EnsembleRunnerTest, BuildClonesRecordingComponents) {
+    // Sources are built up front, as EnsembleRunner::run() does
+    for (const auto& component : lattice->getComponents()) {
+        component->getFieldSource();
+    }
+    VariantBuilder builder(*lattice, 0, 1);
+    auto variant = builder.build();
+
+    EXPECT_NE(variant->getComponent("DET"), lattice->getComponent("DET"));
+    EXPECT_EQ(variant->getComponent("QF"), lattice->getComponent("QF"));
+    EXPECT_EQ(variant->getComponent("RF"), lattice->getComponent("RF"));
+}
+
+TEST_F(EnsembleRunnerTest, BuildClonesComponentsWithStaleSources) {
+    for (const auto& component : lattice->getComponents()) {
+        component->getFieldSource();
+    }
+    auto rf = std::dynamic_pointer_cast<accelerator::RFCavity>(lattice->getComponent("RF"));
+    auto source = rf->getFieldSource();
+    rf->setVoltage(2e6);
+
+    // Publishing the variant must not update the shared source in place
+    VariantBuilder builder(*lattice, 0, 1);
+    auto variant = builder.build();
+    EXPECT_NE(variant->getComponent("RF"), lattice->getComponent("RF"));
+    EXPECT_EQ(variant->getComponent("QF"), lattice->getComponent("QF"));
+    EXPECT_NE(variant->getComponent("RF")->getFieldSource(), source);
+    EXPECT_FALSE(rf->isFieldSourceCurrent());
+}
+
+TEST_F(EnsembleRunnerTest, ConcurrentVariantsOnlyReadSharedComponents) {
+    // Run with PAS_ENABLE_TSAN to catch writes as races as well
+    struct Snapshot {
+        uint64_t version;
+        std::shared_ptr<FieldSource> source;
+    };
+    EnsembleRunner runner(lattice, beam);
+    config.variants = 8;
+    config.threads = 4;
+    EnsembleResult result = runner.run(config, EnsembleRunner::rfPhaseScan(0.0, 0.1));
+    ASSERT_EQ(result.variants.size(), 8u);
+
+    // The sources built before the run are still current after it
+    std::vector<Snapshot> before;
+    for (const auto& component : lattice->getComponents()) {
+        EXPECT_TRUE(component->isFieldSourceCurrent()) << component->getName();
+        before.push_back({component->getVersion(), component->getFieldSource()});
+    }
+    runner.run(config, EnsembleRunner::rfPhaseScan(0.0, 0.1));
+    for (size_t i = 0; i < before.size(); ++i) {
+        const auto& component = lattice->getComponent(i);
+        EXPECT_EQ(component->getVersion(), before[i].version) << component->getName();
+        EXPECT_EQ(component->getFieldSource(), before[i].source) << component->getName();
+    }
+}
+
+TEST_F(EnsembleRunnerTest, RfPhaseScanSetsPhasePerVariant) {
+    auto setup = EnsembleRunner::rfPhaseScan(0.1, 0.2);
+    VariantBuilder builder(*lattice, 3, 1);
+    setup(builder);
+
+    auto cavity = std::dynamic_pointer_cast<accelerator::RFCavity>(builder.getLattice().getComponent("RF"));
+    EXPECT_DOUBLE_EQ(cavity->getPhase(), 0.1 + 3 * 0.2);
+    EXPECT_FALSE(builder.isModified(1));
+}
+
+TEST_F(EnsembleRunnerTest, ZeroErrorsGiveIdenticalVariants) {
+    EnsembleRunner runner(lattice, beam);
+    config.variants = 3;
+    config.threads = 3;
+    EnsembleResult result = runner.run(config, EnsembleRunner::gradientErrors(0.0));
+
+    ASSERT_EQ(result.variants.size(), 3u);
+    for (size_t i = 0; i < result.variants.size(); ++i) {
+        const auto& variant = result.variants[i];
+        EXPECT_EQ(variant.index, i);
+        EXPECT_EQ(variant.steps, config.steps);
+        EXPECT_EQ(variant.survivingParticles + variant.lostParticles, beam.numParticles);
+        EXPECT_DOUBLE_EQ(variant.emittanceX, result.variants[0].emittanceX);
+        EXPECT_DOUBLE_EQ(variant.emittanceY, result.variants[0].emittanceY);
+        EXPECT_DOUBLE_EQ(variant.meanEnergy, result.variants[0].meanEnergy);
+    }
+    EXPECT_DOUBLE_EQ(result.minSurvival, result.maxSurvival);
+}
+
+TEST_F(EnsembleRunnerTest, ResultsDoNotDependOnThreadCount) {
+    EnsembleRunner runner(lattice, beam);
+    auto setup = EnsembleRunner::combine({EnsembleRunner::gradientErrors(0.05),
+                                          EnsembleRunner::misalignments(1e-4)});
+    config.variants = 4;
+
+    config.threads = 1;
+    EnsembleResult serial = runner.run(config, setup);
+    config.threads = 3;
+    EnsembleResult parallel = runner.run(config, setup);
+
+    ASSERT_EQ(serial.variants.size(), parallel.variants.size());
+    for (size_t i = 0; i < serial.variants.size(); ++i) {
+        EXPECT_EQ(serial.variants[i].survivingParticles, parallel.variants[i].survivingParticles);
+        EXPECT_DOUBLE_EQ(serial.variants[i].emittanceX, parallel.variants[i].emittanceX);
+        EXPECT_DOUBLE_EQ(serial.variants[i].emittanceY, parallel.variants[i].emittanceY);
+    }
+
+    // Different seeds give different errors
+    EXPECT_NE(serial.variants[0].emittanceX, serial.variants[1].emittanceX);
+
+    // The base lattice keeps its settings
+    auto quad = std::dynamic_pointer_cast<accelerator::Quadrupole>(lattice->getComponent("QF"));
+    EXPECT_DOUBLE_EQ(quad->getGradient(), 20.0);
+    EXPECT_DOUBLE_EQ(quad->getPosition().x, 0.0);
+}
+
+TEST_F(EnsembleRunnerTest, MagnetErrorsDifferPerVariant) {
+    accelerator::MagnetErrorModel model;
+    model.randomNormal = {0.0, 10.0, 5.0};
+    model.offsetRms = 1e-4;
+    accelerator::MagnetErrorTable table;
+    table.addFamily(accelerator::ComponentType::Quadrupole, model);
+    auto setup = EnsembleRunner::magnetErrors(table);
+
+    VariantBuilder first(*lattice, 0, 1);
+    VariantBuilder second(*lattice, 1, 1);
+    setup(first);
+    setup(second);
+
+    auto a = std::dynamic_pointer_cast<accelerator::Quadrupole>(first.getLattice().getComponent("QF"));
+    auto b = std::dynamic_pointer_cast<accelerator::Quadrupole>(second.getLattice().getComponent("QF"));
+    ASSERT_TRUE(a->hasErrors());
+    EXPECT_NE(a->getErrors().normal[1], b->getErrors().normal[1]);
+    EXPECT_FALSE(first.isModified(0));
+    EXPECT_FALSE(std::dynamic_pointer_cast<accelerator::Quadrupole>(lattice->getComponent("QF"))->hasErrors());
+}
+
+TEST_F(EnsembleRunnerTest, StreamsResults) {
+    const std::string path = "test_ensemble_stream.csv";
+    EnsembleRunner runner(lattice, beam);
+    config.variants = 5;
+    config.threads = 2;
+    config.outputPath = path;
+
+    size_t callbacks = 0;
+    EnsembleResult result = runner.run(config, EnsembleRunner::rfPhaseScan(0.0, 0.5),
+                                       [&callbacks](const VariantResult&) { callbacks++; });
+    EXPECT_EQ(callbacks, 5u);
+    EXPECT_EQ(result.variants.size(), 5u);
+
+    std::ifstream file(path);
+    ASSERT_TRUE(file.is_open());
+    std::string line;
+    size_t lines = 0;
+    while (std::getline(file, line)) {
+        lines++;
+    }
+    EXPECT_EQ(lines, 6u);  // Header + one row per variant
+    file.close();
+    std::remove(path.c_str());
+}
+
+} // namespace pas::physics::tests
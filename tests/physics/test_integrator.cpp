@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <cmath>
 
 #include "physics/Integrator.hpp"
@@ -192,6 +193,82 @@ TEST_F(IntegratorTest, BorisCyclotronRadius) {
     EXPECT_LT(distFromOrigin, theoreticalRadius * 0.05);
 }
 
+// Reduced precision: divergence from the double-precision reference
+
+namespace {
+
+struct Divergence {
+    double position = 0.0;  // Largest distance from the reference trajectory [m]
+    double momentum = 0.0;  // Largest relative momentum difference
+};
+
+// Track a proton gyrating in 1 T with both, 1000 steps per turn
+template <typename Pusher>
+Divergence compareInBField(Integrator& reference, int steps) {
+    EMFieldManager manager;
+    manager.addSource(std::make_shared<UniformBField>(glm::dvec3(0.0, 0.0, 1.0)));
+
+    Particle particle = Particle::proton();
+    particle.setVelocity(glm::dvec3(0.1 * c, 0.0, 0.01 * c));
+    const Species& species = particle.getSpeciesProperties();
+    typename Pusher::State position(particle.getPosition());
+    typename Pusher::State momentum(particle.getMomentum() / species.massTimesC);
+
+    const double period = 2.0 * constants::pi * particle.getGamma() * species.mass / species.charge;
+    const double dt = period / 1000.0;
+    const double u0 = particle.getMomentumMagnitude() / species.massTimesC;
+
+    Divergence divergence;
+    for (int i = 0; i < steps; ++i) {
+        reference.step(particle, manager, i * dt, dt);
+        Pusher::step(position, momentum, species, manager, i * dt, dt);
+        const glm::dvec3 u = particle.getMomentum() / species.massTimesC;
+        divergence.position =
+            std::max(divergence.position, glm::length(particle.getPosition() - glm::dvec3(position)));
+        divergence.momentum = std::max(divergence.momentum, glm::length(u - glm::dvec3(momentum)) / u0);
+    }
+    return divergence;
+}
+
+} // namespace
+
+TEST_F(IntegratorTest, DoublePrecisionPushersMatchIntegrators) {
+    BorisIntegrator boris;
+    RK4Integrator rk4;
+
+    Divergence b = compareInBField<BorisPusher<DoublePrecision>>(boris, 10000);
+    Divergence r = compareInBField<RK4Pusher<DoublePrecision>>(rk4, 10000);
+    EXPECT_LT(b.position, 1e-10);
+    EXPECT_LT(b.momentum, 1e-10);
+    EXPECT_LT(r.position, 1e-10);
+    EXPECT_LT(r.momentum, 1e-10);
+}
+
+TEST_F(IntegratorTest, ReducedPrecisionBorisStaysNearDouble) {
+    // Ten turns of a ~0.3 m radius orbit
+    BorisIntegrator reference;
+
+    Divergence f = compareInBField<BorisPusher<FloatPrecision>>(reference, 10000);
+    Divergence m = compareInBField<BorisPusher<MixedPrecision>>(reference, 10000);
+
+    // Float: within ~3e-4 of the radius; Mixed an order of magnitude closer
+    EXPECT_LT(f.position, 1e-4);
+    EXPECT_LT(f.momentum, 1e-4);
+    EXPECT_LT(m.position, 1e-5);
+    EXPECT_LT(m.momentum, 1e-5);
+}
+
+TEST_F(IntegratorTest, ReducedPrecisionRK4StaysNearDouble) {
+    RK4Integrator reference;
+
+    Divergence f = compareInBField<RK4Pusher<FloatPrecision>>(reference, 10000);
+    Divergence m = compareInBField<RK4Pusher<MixedPrecision>>(reference, 10000);
+    EXPECT_LT(f.position, 1e-4);
+    EXPECT_LT(f.momentum, 1e-4);
+    EXPECT_LT(m.position, 1e-5);
+    EXPECT_LT(m.momentum, 1e-5);
+}
+
 // Inactive particle tests
 
 TEST_F(IntegratorTest, InactiveParticleIsNotUpdated) {
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include "physics/LossEvents.hpp"
+#include "utils/Parallel.hpp"
+
+namespace pas::physics::tests {
+
+class LossEventBufferTest : public ::testing::Test {
+protected:
+    LossEventBuffer buffer;
+
+    static LossEvent makeEvent(uint64_t id) {
+        LossEvent event;
+        event.particleId = id;
+        event.sPosition = static_cast<double>(id);
+        return event;
+    }
+};
+
+TEST_F(LossEventBufferTest, DrainWithoutEventsPublishesNothing) {
+    size_t calls = 0;
+    buffer.subscribe([&calls](std::span<const LossEvent>) { calls++; });
+
+    EXPECT_EQ(buffer.drain(), 0u);
+    EXPECT_EQ(calls, 0u);
+}
+
+TEST_F(LossEventBufferTest, DrainPublishesSortedBatch) {
+    std::vector<uint64_t> ids;
+    buffer.subscribe([&ids](std::span<const LossEvent> batch) {
+        for (const auto& event : batch) {
+            ids.push_back(event.particleId);
+        }
+    });
+
+    buffer.record(makeEvent(7));
+    buffer.record(makeEvent(3));
+    buffer.record(makeEvent(5));
+    EXPECT_EQ(buffer.getPendingCount(), 3u);
+
+    EXPECT_EQ(buffer.drain(), 3u);
+    EXPECT_EQ(ids, (std::vector<uint64_t>{3, 5, 7}));
+    EXPECT_EQ(buffer.getPendingCount(), 0u);
+}
+
+TEST_F(LossEventBufferTest, MultipleSubscribersReceiveSameBatch) {
+    size_t first = 0, second = 0;
+    buffer.subscribe([&first](std::span<const LossEvent> batch) { first += batch.size(); });
+    buffer.subscribe([&second](std::span<const LossEvent> batch) { second += batch.size(); });
+
+    buffer.record(makeEvent(1));
+    buffer.record(makeEvent(2));
+    buffer.drain();
+
+    EXPECT_EQ(first, 2u);
+    EXPECT_EQ(second, 2u);
+}
+
+TEST_F(LossEventBufferTest, Unsubscribe) {
+    size_t calls = 0;
+    auto id = buffer.subscribe([&calls](std::span<const LossEvent>) { calls++; });
+    EXPECT_EQ(buffer.getSubscriberCount(), 1u);
+
+    buffer.unsubscribe(id);
+    EXPECT_EQ(buffer.getSubscriberCount(), 0u);
+
+    buffer.record(makeEvent(1));
+    buffer.drain();
+    EXPECT_EQ(calls, 0u);
+}
+
+TEST_F(LossEventBufferTest, ScopedSubscriptionEndsWithToken) {
+    size_t calls = 0;
+    {
+        auto subscription = buffer.subscribeScoped([&calls](std::span<const LossEvent>) { calls++; });
+        EXPECT_TRUE(subscription.isActive());
+        EXPECT_EQ(buffer.getSubscriberCount(), 1u);
+        buffer.record(makeEvent(1));
+        buffer.drain();
+    }
+    EXPECT_EQ(buffer.getSubscriberCount(), 0u);
+    buffer.record(makeEvent(2));
+    buffer.drain();
+    EXPECT_EQ(calls, 1u);
+
+    // A token outliving its buffer is inactive and safe to reset
+    LossEventBuffer::Subscription orphan;
+    {
+        LossEventBuffer local;
+        orphan = local.subscribeScoped([](std::span<const LossEvent>) {});
+        EXPECT_TRUE(orphan.isActive());
+    }
+    EXPECT_FALSE(orphan.isActive());
+    orphan.reset();
+}
+
+TEST_F(LossEventBufferTest, ClearDiscardsPending) {
+    buffer.record(makeEvent(1));
+    buffer.clear();
+    EXPECT_EQ(buffer.getPendingCount(), 0u);
+    EXPECT_EQ(buffer.drain(), 0u);
+}
+
+TEST_F(LossEventBufferTest, ParallelRecording) {
+    buffer.prepare(utils::getMaxThreads());
+
+    size_t received = 0;
+    buffer.subscribe([&received](std::span<const LossEvent> batch) { received += batch.size(); });
+
+    constexpr int count = 10000;
+#ifdef PAS_ENABLE_OPENMP
+    #pragma omp parallel for
+#endif
+    for (int i = 0; i < count; ++i) {
+        buffer.record(makeEvent(static_cast<uint64_t>(i)));
+    }
+
+    EXPECT_EQ(buffer.drain(), static_cast<size_t>(count));
+    EXPECT_EQ(received, static_cast<size_t>(count));
+}
+
+} // namespace pas::physics::tests
@@ -0,0 +1,289 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+#include "physics/OrbitCoordinates.hpp"
+#include "accelerator/Accelerator.hpp"
+#include "physics/Constants.hpp"
+
+namespace pas::physics::tests {
+
+using namespace accelerator;
+
+// Ring of bends separated by drifts, with a closed survey
+std::shared_ptr<Accelerator> makeRing(int cells, double bendLength, double driftLength,
+                                      double rigidity) {
+    auto ring = std::make_shared<Accelerator>();
+    const double angle = 2.0 * constants::pi / cells;
+    auto bend = std::make_shared<Dipole>("B", bendLength, angle * rigidity / bendLength);
+    for (int i = 0; i < cells; ++i) {
+        ring->addComponent(bend);
+        ring->addDrift(driftLength);
+    }
+    ring->setReferenceRigidity(rigidity);
+    ring->closeRing();
+    return ring;
+}
+
+TEST(OrbitCoordinatesTest, RoundTripsThroughGlobalCoordinates) {
+    auto ring = makeRing(16, 2.0, 1.5, 10.0);
+    const CompiledLattice& lattice = ring->getCompiledLattice();
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> offset(-0.05, 0.05);
+    std::uniform_real_distribution<double> fraction(0.0, 1.0);
+    for (size_t i = 0; i < lattice.size(); ++i) {
+        OrbitPosition orbit;
+        orbit.index = i;
+        orbit.x = offset(rng);
+        orbit.y = offset(rng);
+        orbit.ds = fraction(rng) * lattice.getLengths()[i];
+
+        // Start from a neighbouring cursor so the walk is exercised
+        const OrbitPosition back = lattice.toOrbit(lattice.toGlobal(orbit), (i + 1) % lattice.size(),
+                                                   true);
+        EXPECT_EQ(back.index, i);
+        EXPECT_NEAR(back.x, orbit.x, 1e-9);
+        EXPECT_NEAR(back.y, orbit.y, 1e-9);
+        EXPECT_NEAR(back.ds, orbit.ds, 1e-9);
+    }
+}
+
+TEST(OrbitCoordinatesTest, KeepsSmallDeviationsInLargeRing) {
+    // 27 km ring: global positions are kilometres, deviations millimetres
+    auto ring = makeRing(1000, 14.3, 12.7, 23349.0);
+    const CompiledLattice& lattice = ring->getCompiledLattice();
+    EXPECT_NEAR(glm::length(lattice.getExitFrame().origin), 0.0, 1e-6);
+
+    OrbitPosition orbit;
+    orbit.index = 1001;
+    orbit.x = 1.234e-3;
+    orbit.y = -0.5e-3;
+    orbit.ds = 3.0;
+    const glm::dvec3 global = lattice.toGlobal(orbit);
+    EXPECT_GT(glm::length(global), 1000.0);
+
+    Particle particle = Particle::proton(global, glm::dvec3(0.0));
+    OrbitCoordinates coordinates;
+    coordinates.resize(1);
+    coordinates.update(0, particle, lattice, true);
+
+    ASSERT_EQ(coordinates.getEntries()[0], 1001u);
+    EXPECT_NEAR(coordinates.getPosition(0, lattice).x, 1.234e-3, 1e-9);
+    EXPECT_NEAR(coordinates.getPosition(0, lattice).y, -0.5e-3, 1e-9);
+    EXPECT_NEAR(coordinates.getS(0, lattice), lattice.getSStarts()[1001] + 3.0, 1e-5);
+    EXPECT_NEAR(glm::length(coordinates.toGlobal(0, lattice) - global), 0.0, 1e-6);
+}
+
+TEST(OrbitCoordinatesTest, FloatStorageKeepsSmallDeviationsInLargeRing) {
+    // Float global positions would resolve only ~0.1 mm here; within the entry ~0.1 um
+    auto ring = makeRing(1000, 14.3, 12.7, 23349.0);
+    const CompiledLattice& lattice = ring->getCompiledLattice();
+
+    OrbitPosition orbit;
+    orbit.index = 1001;
+    orbit.x = 1.234e-3;
+    orbit.y = -0.5e-3;
+    orbit.ds = 3.0;
+    const glm::dvec3 global = lattice.toGlobal(orbit);
+    Particle particle = Particle::proton(global, glm::dvec3(0.0));
+    particle.setKineticEnergy(7e12 * constants::energy::eV, lattice.getReferenceFrame(1001).rotation *
+                                                               glm::dvec3(0.0, 0.0, 1.0));
+    FloatOrbitCoordinates coordinates;
+    coordinates.resize(1);
+    coordinates.update(0, particle, lattice, true);
+
+    ASSERT_EQ(coordinates.getEntries()[0], 1001u);
+    EXPECT_NEAR(coordinates.getPosition(0, lattice).x, 1.234e-3, 1e-9);
+    EXPECT_NEAR(coordinates.getPosition(0, lattice).y, -0.5e-3, 1e-9);
+    EXPECT_NEAR(coordinates.getPosition(0, lattice).ds, 3.0, 1e-6);
+
+    // Carried across the next entrance in float, then written back
+    const FloatOrbitCoordinates::Vec local = coordinates.getLocalPosition(0);
+    coordinates.setLocal(0, local + glm::vec3(0.0f, 0.0f, 9.75f), coordinates.getLocalMomentum(0));
+    coordinates.transfer(0, lattice, true);
+    ASSERT_EQ(coordinates.getEntries()[0], 1002u);
+    EXPECT_NEAR(coordinates.getPosition(0, lattice).x, 1.234e-3, 1e-6);
+    EXPECT_NEAR(coordinates.getS(0, lattice), lattice.getSStarts()[1001] + 12.75, 1e-5);
+
+    coordinates.store(0, particle, lattice);
+    const OrbitPosition back = lattice.toOrbit(particle.getPosition(), 1002, true);
+    EXPECT_EQ(back.index, 1002u);
+    EXPECT_NEAR(back.x, 1.234e-3, 1e-6);
+    EXPECT_NEAR(back.y, -0.5e-3, 1e-6);
+}
+
+TEST(OrbitCoordinatesTest, CountsTurnsAroundRing) {
+    auto ring = makeRing(16, 2.0, 1.5, 10.0);
+    const CompiledLattice& lattice = ring->getCompiledLattice();
+    const double circumference = ring->getTotalLength();
+
+    Particle particle = Particle::proton(glm::dvec3(0.0, 0.0, 0.5), glm::dvec3(0.0));
+    OrbitCoordinates coordinates;
+    coordinates.resize(1);
+    coordinates.update(0, particle, lattice, true);
+    EXPECT_EQ(coordinates.getEntries()[0], 0u);
+
+    // Follow the orbit a quarter element at a time for more than one turn
+    OrbitPosition orbit = coordinates.getPosition(0, lattice);
+    for (int step = 0; step < 4 * 40; ++step) {
+        orbit.ds += 0.25 * lattice.getLengths()[orbit.index];
+        if (orbit.ds >= lattice.getLengths()[orbit.index]) {
+            orbit.ds -= lattice.getLengths()[orbit.index];
+            orbit.index = (orbit.index + 1) % lattice.size();
+        }
+        particle.setPosition(lattice.toGlobal(orbit));
+        coordinates.update(0, particle, lattice, true);
+        ASSERT_EQ(coordinates.getEntries()[0], orbit.index);
+    }
+    EXPECT_EQ(coordinates.getTurns()[0], 1);
+    EXPECT_NEAR(coordinates.getPathLength(0, lattice, circumference),
+                circumference + lattice.getSStarts()[orbit.index] + orbit.ds, 1e-5);
+
+    // A different particle in the slot starts over
+    Particle other = Particle::proton(glm::dvec3(0.0, 0.0, 0.5), glm::dvec3(0.0));
+    coordinates.update(0, other, lattice, true);
+    EXPECT_EQ(coordinates.getTurns()[0], 0);
+    EXPECT_EQ(coordinates.getEntries()[0], 0u);
+}
+
+TEST(OrbitCoordinatesTest, SyncKeepsStateOfCompactedParticles) {
+    auto ring = makeRing(16, 2.0, 1.5, 10.0);
+    const CompiledLattice& lattice = ring->getCompiledLattice();
+
+    // Three particles carried from the last entry across the ring's start
+    std::vector<Particle> particles;
+    OrbitCoordinates coordinates;
+    for (int i = 0; i < 3; ++i) {
+        OrbitPosition orbit;
+        orbit.index = lattice.size() - 1;
+        orbit.x = 1e-3 * i;
+        particles.push_back(Particle::proton(lattice.toGlobal(orbit), glm::dvec3(0.0)));
+    }
+    coordinates.sync(particles);
+    for (size_t i = 0; i < particles.size(); ++i) {
+        coordinates.update(i, particles[i], lattice, true);
+
+        OrbitPosition orbit;
+        orbit.index = 3;
+        orbit.x = 1e-3 * static_cast<double>(i);
+        orbit.ds = 0.5;
+        particles[i].setPosition(lattice.toGlobal(orbit));
+        coordinates.update(i, particles[i], lattice, true);
+        ASSERT_EQ(coordinates.getTurns()[i], 1);
+    }
+
+    // Removing the first particle moves the others down a slot
+    particles.erase(particles.begin());
+    particles.push_back(Particle::proton(glm::dvec3(0.0, 0.0, 0.5), glm::dvec3(0.0)));
+    coordinates.sync(particles);
+    ASSERT_EQ(coordinates.size(), 3u);
+    for (size_t i = 0; i < 2; ++i) {
+        coordinates.update(i, particles[i], lattice, true);
+        EXPECT_EQ(coordinates.getEntries()[i], 3u);
+        EXPECT_EQ(coordinates.getTurns()[i], 1);
+        EXPECT_NEAR(coordinates.getX()[i], 1e-3 * static_cast<double>(i + 1), 1e-9);
+    }
+
+    // Only the new particle is located from scratch
+    coordinates.update(2, particles[2], lattice, true);
+    EXPECT_EQ(coordinates.getEntries()[2], 0u);
+    EXPECT_EQ(coordinates.getTurns()[2], 0);
+}
+
+TEST(OrbitCoordinatesTest, TransferCarriesParticlesIntoNeighbouringEntries) {
+    auto ring = makeRing(16, 2.0, 1.5, 10.0);
+    const CompiledLattice& lattice = ring->getCompiledLattice();
+    const size_t last = lattice.size() - 1;
+
+    // Points one entry ahead and one behind, across the ring's start and end
+    struct Case {
+        size_t from;
+        size_t to;
+        int turns;
+    };
+    for (const Case& c : {Case{3, 4, 0}, Case{4, 3, 0}, Case{last, 0, 1}, Case{0, last, -1}}) {
+        OrbitPosition start;
+        start.index = c.from;
+        start.ds = 0.5;
+        Particle particle = Particle::proton(lattice.toGlobal(start), glm::dvec3(0.0));
+        OrbitCoordinates coordinates;
+        coordinates.resize(1);
+        coordinates.update(0, particle, lattice, true);
+
+        OrbitPosition target;
+        target.index = c.to;
+        target.x = 2e-3;
+        target.y = -1e-3;
+        target.ds = 0.25 * lattice.getLengths()[c.to];
+        const Placement frame = lattice.getReferenceFrame(c.from);
+        const glm::dquat inverse = glm::inverse(frame.rotation);
+        const glm::dvec3 momentum(0.0, 0.0, 1.0);
+        coordinates.setLocal(0, inverse * (lattice.toGlobal(target, c.turns) - frame.origin),
+                             inverse * momentum);
+
+        coordinates.transfer(0, lattice, true);
+        ASSERT_EQ(coordinates.getEntries()[0], c.to);
+        EXPECT_EQ(coordinates.getTurns()[0], c.turns);
+        const OrbitPosition orbit = coordinates.getPosition(0, lattice);
+        EXPECT_NEAR(orbit.x, target.x, 1e-9);
+        EXPECT_NEAR(orbit.y, target.y, 1e-9);
+        EXPECT_NEAR(orbit.ds, target.ds, 1e-9);
+        EXPECT_NEAR(glm::length(coordinates.toGlobalMomentum(0, lattice) - momentum), 0.0, 1e-12);
+    }
+}
+
+TEST(OrbitCoordinatesTest, StoreWritesGlobalState) {
+    auto ring = makeRing(16, 2.0, 1.5, 10.0);
+    const CompiledLattice& lattice = ring->getCompiledLattice();
+
+    OrbitPosition orbit;
+    orbit.index = 5;
+    orbit.x = 1e-3;
+    orbit.ds = 0.7;
+    const glm::dvec3 momentum(1e-22, 0.0, 5e-19);
+    Particle particle = Particle::proton(lattice.toGlobal(orbit), momentum);
+    OrbitCoordinates coordinates;
+    coordinates.resize(1);
+    coordinates.update(0, particle, lattice, true);
+
+    Particle copy = Particle::proton(glm::dvec3(0.0), glm::dvec3(0.0));
+    coordinates.store(0, copy, lattice);
+    EXPECT_NEAR(glm::length(copy.getPosition() - particle.getPosition()), 0.0, 1e-12);
+    EXPECT_NEAR(glm::length(copy.getMomentum() - momentum) / glm::length(momentum), 0.0, 1e-12);
+
+    // Inactive slots leave the particle alone
+    coordinates.setActive(0, false);
+    Particle untouched = Particle::proton(glm::dvec3(1.0), glm::dvec3(0.0));
+    coordinates.store(0, untouched, lattice);
+    EXPECT_EQ(untouched.getPosition(), glm::dvec3(1.0));
+}
+
+TEST(OrbitCoordinatesTest, StraightRingWrapsByItsLength) {
+    Accelerator ring;
+    ring.addDrift(1.0);
+    ring.addDrift(1.0);
+    ring.closeRing();
+    const CompiledLattice& lattice = ring.getCompiledLattice();
+
+    const OrbitPosition orbit = lattice.toOrbit(glm::dvec3(0.01, 0.0, 3.5), 0, true);
+    EXPECT_EQ(orbit.index, 1u);
+    EXPECT_EQ(orbit.wraps, 1);
+    EXPECT_NEAR(orbit.ds, 0.5, 1e-12);
+    EXPECT_NEAR(orbit.x, 0.01, 1e-12);
+    EXPECT_NEAR(lattice.toGlobal(orbit, orbit.wraps).z, 3.5, 1e-12);
+
+    // Positions on later turns are carried back before locating them
+    const OrbitPosition later = lattice.toOrbit(glm::dvec3(0.0, 0.0, 40.5), 0, true, 20);
+    EXPECT_EQ(later.index, 0u);
+    EXPECT_EQ(later.wraps, 0);
+    EXPECT_NEAR(later.ds, 0.5, 1e-12);
+
+    // Open lattices leave the position past the end
+    const OrbitPosition open = lattice.toOrbit(glm::dvec3(0.0, 0.0, 5.5), 0, false);
+    EXPECT_EQ(open.index, 1u);
+    EXPECT_EQ(open.wraps, 0);
+    EXPECT_NEAR(open.ds, 4.5, 1e-12);
+}
+
+} // namespace pas::physics::tests
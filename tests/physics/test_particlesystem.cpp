@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <cmath>
+#include <set>
 
 #include "physics/ParticleSystem.hpp"
 #include "physics/Constants.hpp"
@@ -12,6 +13,31 @@ class ParticleSystemTest : public ::testing::Test {
 protected:
     ParticleSystem system;
 
+    // Central second moment <a b> of two beam-frame coordinates (x, x', y, y', z, delta)
+    double moment(int a, int b) const {
+        const double pRef = system.getReferenceMomentum();
+        auto coordinate = [pRef](const Particle& p, int index) {
+            switch (index) {
+                case 0: return p.getPosition().x;
+                case 1: return p.getMomentum().x / pRef;
+                case 2: return p.getPosition().y;
+                case 3: return p.getMomentum().y / pRef;
+                case 4: return p.getPosition().z;
+                default: return p.getMomentum().z / pRef - 1.0;
+            }
+        };
+        double sumA = 0.0, sumB = 0.0, sumAB = 0.0;
+        for (const auto& p : system.getParticles()) {
+            double va = coordinate(p, a);
+            double vb = coordinate(p, b);
+            sumA += va;
+            sumB += vb;
+            sumAB += va * vb;
+        }
+        double n = static_cast<double>(system.getParticleCount());
+        return sumAB / n - (sumA / n) * (sumB / n);
+    }
+
     BeamParameters createDefaultParams() {
         BeamParameters params;
         params.particleType = BeamParameters::ParticleType::Proton;
@@ -112,6 +138,37 @@ TEST_F(ParticleSystemTest, BeamIsReproducible) {
     }
 }
 
+TEST_F(ParticleSystemTest, GeneratedParticlesHaveUniqueIds) {
+    BeamParameters params = createDefaultParams();
+    params.numParticles = 3000;
+    system.generateBeam(params);
+
+    const auto& particles = system.getParticles();
+    for (size_t i = 1; i < particles.size(); ++i) {
+        EXPECT_EQ(particles[i].getId(), particles[i - 1].getId() + 1);
+    }
+}
+
+TEST_F(ParticleSystemTest, MatchedBeamIdsStayUniqueAcrossGenerations) {
+    // Loss events, detector hits and tracked BPM particles are keyed by ID
+    BeamParameters params = createDefaultParams();
+    params.matching = BeamParameters::Matching::Twiss;
+    params.numParticles = 500;
+
+    std::set<uint64_t> ids;
+    system.generateBeam(params);
+    for (const auto& p : system.getParticles()) {
+        ids.insert(p.getId());
+    }
+    system.generateBeam(params);
+    system.appendBeam(params);
+    for (const auto& p : system.getParticles()) {
+        ids.insert(p.getId());
+    }
+    ids.insert(Particle::proton().getId());
+    EXPECT_EQ(ids.size(), 3u * params.numParticles + 1);
+}
+
 TEST_F(ParticleSystemTest, DifferentSeedsGiveDifferentBeams) {
     BeamParameters params = createDefaultParams();
     params.numParticles = 10;
@@ -191,6 +248,52 @@ TEST_F(ParticleSystemTest, RemoveInactiveParticles) {
     EXPECT_EQ(system.getParticleCount(), 1u);
 }
 
+// Species blocks
+
+TEST_F(ParticleSystemTest, MixedBeamFormsSpeciesBlocks) {
+    BeamParameters params = createDefaultParams();
+    ASSERT_TRUE(system.generateBeam(params));
+    const double protonReference = system.getReferenceMomentum();
+
+    // Electron cloud appended as a second block
+    BeamParameters cloud = createDefaultParams();
+    cloud.particleType = BeamParameters::ParticleType::Electron;
+    cloud.numParticles = 50;
+    cloud.kineticEnergy = 10.0 * energy::eV;
+    ASSERT_TRUE(system.appendBeam(cloud));
+    EXPECT_EQ(system.getParticleCount(), 150u);
+    EXPECT_DOUBLE_EQ(system.getReferenceMomentum(), protonReference);
+
+    auto blocks = system.getSpeciesBlocks();
+    ASSERT_EQ(blocks.size(), 2u);
+    EXPECT_EQ(blocks[0].species, SpeciesTable::PROTON);
+    EXPECT_EQ(blocks[0].end, 100u);
+    EXPECT_EQ(blocks[1].species, SpeciesTable::ELECTRON);
+    EXPECT_EQ(blocks[1].begin, 100u);
+    EXPECT_EQ(blocks[1].end, 150u);
+    EXPECT_EQ(system.getParticle(120).getCharge(), -e);
+
+    // A stray proton opens a third block until the particles are sorted
+    system.addParticle(Particle::proton());
+    ASSERT_EQ(system.getSpeciesBlocks().size(), 3u);
+    const uint64_t firstProton = system.getParticle(0).getId();
+    system.sortBySpecies();
+    blocks = system.getSpeciesBlocks();
+    ASSERT_EQ(blocks.size(), 2u);
+    EXPECT_EQ(blocks[0].species, SpeciesTable::ELECTRON);
+    EXPECT_EQ(blocks[0].end, 50u);
+    EXPECT_EQ(blocks[1].end, 151u);
+    EXPECT_EQ(system.getParticle(50).getId(), firstProton);  // Stable within a species
+
+    // Removing particles rebuilds the blocks
+    for (size_t i = 0; i < 50; ++i) {
+        system.getParticle(i).setActive(false);
+    }
+    system.removeInactiveParticles();
+    ASSERT_EQ(system.getSpeciesBlocks().size(), 1u);
+    EXPECT_EQ(system.getSpeciesBlocks()[0].species, SpeciesTable::PROTON);
+}
+
 // Statistics
 
 TEST_F(ParticleSystemTest, StatisticsOnEmptySystem) {
@@ -290,4 +393,85 @@ TEST_F(ParticleSystemTest, GaussianDistribution) {
     EXPECT_NEAR(stats.rmsSize.y, params.sigmaY, params.sigmaY * tolerance);
 }
 
+// Matched beams
+
+TEST_F(ParticleSystemTest, MatchedBeamHasTargetTwiss) {
+    BeamParameters params = createDefaultParams();
+    params.numParticles = 20000;
+    params.matching = BeamParameters::Matching::Twiss;
+    params.emittanceX = 2e-6;
+    params.betaX = 20.0;
+    params.alphaX = -1.5;
+    params.emittanceY = 1e-6;
+    params.betaY = 5.0;
+    params.alphaY = 0.8;
+
+    for (auto distribution : {BeamParameters::Distribution::Gaussian,
+                              BeamParameters::Distribution::Uniform,
+                              BeamParameters::Distribution::Waterbag}) {
+        params.distribution = distribution;
+        ASSERT_TRUE(system.generateBeam(params));
+
+        double tolerance = 0.05;
+        EXPECT_NEAR(moment(0, 0), 2e-6 * 20.0, 2e-6 * 20.0 * tolerance);
+        EXPECT_NEAR(moment(0, 1), 2e-6 * 1.5, 2e-6 * 1.5 * tolerance);
+        EXPECT_NEAR(moment(2, 2), 1e-6 * 5.0, 1e-6 * 5.0 * tolerance);
+        EXPECT_NEAR(moment(2, 3), -1e-6 * 0.8, 1e-6 * 0.8 * tolerance);
+
+        double emittanceX = std::sqrt(moment(0, 0) * moment(1, 1) - moment(0, 1) * moment(0, 1));
+        EXPECT_NEAR(emittanceX, 2e-6, 2e-6 * tolerance);
+    }
+}
+
+TEST_F(ParticleSystemTest, MatchedBeamIncludesDispersion) {
+    BeamParameters params = createDefaultParams();
+    params.numParticles = 20000;
+    params.matching = BeamParameters::Matching::Twiss;
+    params.sigmaDelta = 1e-3;
+    params.dispersionX = 2.0;
+    ASSERT_TRUE(system.generateBeam(params));
+
+    // <x delta> = D sigma_delta^2
+    EXPECT_NEAR(moment(0, 5), 2.0 * 1e-6, 2.0 * 1e-6 * 0.05);
+    EXPECT_NEAR(moment(1, 5), 0.0, 1e-9);
+}
+
+TEST_F(ParticleSystemTest, SigmaMatrixBeam) {
+    BeamParameters params = createDefaultParams();
+    params.numParticles = 20000;
+    params.matching = BeamParameters::Matching::SigmaMatrix;
+    params.sigmaMatrix.fill(0.0);
+    for (int i = 0; i < 6; ++i) {
+        params.sigmaMatrix[i * 6 + i] = 1e-6;
+    }
+    params.sigmaMatrix[0 * 6 + 4] = params.sigmaMatrix[4 * 6 + 0] = 0.5e-6;
+    ASSERT_TRUE(system.generateBeam(params));
+
+    EXPECT_NEAR(moment(0, 0), 1e-6, 0.05e-6);
+    EXPECT_NEAR(moment(0, 4), 0.5e-6, 0.05e-6);
+    EXPECT_NEAR(moment(2, 4), 0.0, 0.05e-6);
+
+    // Not positive semi-definite
+    params.sigmaMatrix[0 * 6 + 4] = params.sigmaMatrix[4 * 6 + 0] = 2e-6;
+    EXPECT_FALSE(system.generateBeam(params));
+    EXPECT_EQ(system.getParticleCount(), 0u);
+}
+
+TEST_F(ParticleSystemTest, MatchedBeamIsDeterministic) {
+    BeamParameters params = createDefaultParams();
+    params.numParticles = 5000;
+    params.matching = BeamParameters::Matching::Twiss;
+    params.alphaX = 1.0;
+
+    ASSERT_TRUE(system.generateBeam(params));
+    std::vector<Particle> first = system.getParticles();
+    ASSERT_TRUE(system.generateBeam(params));
+
+    // Block streams make the result independent of scheduling
+    for (size_t i = 0; i < first.size(); ++i) {
+        EXPECT_EQ(first[i].getPosition(), system.getParticle(i).getPosition());
+        EXPECT_EQ(first[i].getMomentum(), system.getParticle(i).getMomentum());
+    }
+}
+
 } // namespace pas::physics::tests
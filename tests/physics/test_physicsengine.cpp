@@ -1,8 +1,12 @@
 #include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
 
 #include "physics/PhysicsEngine.hpp"
 #include "physics/Constants.hpp"
 #include "accelerator/Accelerator.hpp"
+#include "FODORing.hpp"
 
 namespace pas::physics::tests {
 
@@ -137,15 +141,606 @@ TEST_F(PhysicsEngineTest, ParticleIntegration) {
     EXPECT_GT(particles[0].getPosition().z, 0.0);
 }
 
-TEST_F(PhysicsEngineTest, LossCallback) {
-    int lossCount = 0;
-    engine.setLossCallback([&lossCount](const Particle&) {
-        lossCount++;
+TEST_F(PhysicsEngineTest, LossBatchSubscription) {
+    auto accelerator = std::make_shared<accelerator::Accelerator>();
+    accelerator->addDrift(2.0, "D1");
+    accelerator->computeLattice();
+    engine.setAccelerator(accelerator);
+
+    std::vector<LossEvent> received;
+    size_t batches = 0;
+    engine.subscribeLosses([&](std::span<const LossEvent> batch) {
+        received.insert(received.end(), batch.begin(), batch.end());
+        batches++;
     });
 
-    // Note: Loss detection requires an accelerator with aperture checking
-    // This test verifies callback mechanism works
-    EXPECT_EQ(lossCount, 0);
+    // One particle far outside the aperture, one on axis
+    Particle lost = Particle::proton({0.5, 0.0, 1.0});
+    Particle kept = Particle::proton({0.0, 0.0, 1.0});
+    engine.getParticleSystem().addParticle(lost);
+    engine.getParticleSystem().addParticle(kept);
+
+    engine.step();
+
+    ASSERT_EQ(received.size(), 1u);
+    EXPECT_EQ(batches, 1u);
+    EXPECT_EQ(received[0].particleId, lost.getId());
+    EXPECT_EQ(received[0].componentIndex, 0u);
+    EXPECT_DOUBLE_EQ(received[0].sPosition, 1.0);
+    EXPECT_EQ(engine.getStats().lostParticleCount, 1u);
+
+    // Already-lost particles are not reported again
+    engine.step();
+    EXPECT_EQ(received.size(), 1u);
+}
+
+TEST_F(PhysicsEngineTest, LossesMatchFullApertureScan) {
+    // Apertures both wider and narrower than the 10 cm fallback, one misaligned
+    auto accelerator = std::make_shared<accelerator::Accelerator>();
+    accelerator::Aperture wide;
+    wide.radiusX = 0.15;
+    wide.radiusY = 0.15;
+    accelerator::Aperture flat;
+    flat.shape = accelerator::ApertureShape::Rectangular;
+    flat.radiusX = 0.2;
+    flat.radiusY = 0.11;
+    accelerator->addComponent(std::make_shared<accelerator::BeamPipe>("D1", 1.0, wide));
+    accelerator->addComponent(std::make_shared<accelerator::Quadrupole>("Q1", 0.2, 1.0));
+    accelerator->addComponent(std::make_shared<accelerator::BeamPipe>("D2", 1.0, flat));
+    accelerator->addComponent(std::make_shared<accelerator::BeamPipe>("D3", 0.3, wide));
+    accelerator->addComponent(std::make_shared<accelerator::BeamPipe>("D4", 1.0, wide));
+    accelerator->getComponent("D3")->setPosition(glm::dvec3(0.05, 0.0, 0.0));
+    accelerator->computeLattice();
+    engine.setAccelerator(accelerator);
+
+    std::mt19937_64 random(5);
+    std::uniform_real_distribution<double> transverse(-0.2, 0.2);
+    std::uniform_real_distribution<double> longitudinal(-0.2, 3.0);
+    for (int i = 0; i < 500; ++i) {
+        Particle p = Particle::proton({transverse(random), transverse(random), longitudinal(random)});
+        p.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+        engine.getParticleSystem().addParticle(p);
+    }
+    engine.setTimeStep(3e-10);
+
+    const auto& particles = engine.getParticleSystem().getParticles();
+    const accelerator::CompiledLattice& lattice = accelerator->getCompiledLattice();
+    size_t lost = 0;
+    for (int step = 0; step < 40; ++step) {
+        std::vector<bool> active;
+        for (const auto& particle : particles) {
+            active.push_back(particle.isActive());
+        }
+        engine.step();
+
+        for (size_t i = 0; i < particles.size(); ++i) {
+            if (!active[i]) {
+                continue;
+            }
+            const glm::dvec3& pos = particles[i].getPosition();
+            const bool outside = !lattice.isInsideAnyAperture(pos) &&
+                                 std::sqrt(pos.x * pos.x + pos.y * pos.y) > 0.1;
+            ASSERT_EQ(particles[i].isActive(), !outside) << "particle " << i << ", step " << step;
+            lost += outside ? 1 : 0;
+        }
+    }
+    EXPECT_GT(lost, 50u);
+    EXPECT_EQ(engine.getStats().lostParticleCount, lost);
+}
+
+TEST_F(PhysicsEngineTest, RampScalesMagnetsWithoutRebuildingSources) {
+    auto ramp = std::make_shared<Waveform>(std::vector<double>{0.0, 1e-9},
+                                           std::vector<double>{0.5, 1.5});
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    auto b1 = std::make_shared<accelerator::Dipole>("B1", 1.0, 1.0);
+    auto q1 = std::make_shared<accelerator::Quadrupole>("Q1", 0.5, 10.0);
+    auto q2 = std::make_shared<accelerator::Quadrupole>("Q2", 0.5, -10.0);
+    b1->setRamp(ramp);
+    q1->setRamp(ramp);
+    acc->addComponent(b1);
+    acc->addComponent(q1);
+    acc->addComponent(q2);
+    acc->computeLattice();
+    engine.setAccelerator(acc);
+    auto source = b1->getFieldSource();
+
+    // A second engine on the same lattice, further along the ramp
+    PhysicsEngine other;
+    other.setAccelerator(acc);
+    other.setTimeStep(5e-10);
+    other.step();
+
+    // Evaluated once at the middle of each step, shared by the circuit
+    Particle p = Particle::proton({0.0, 0.0, 0.5});
+    p.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+    engine.getParticleSystem().addParticle(p);
+    engine.setTimeStep(1e-10);
+    engine.step();
+    EXPECT_EQ(b1->getFieldSource(), source);
+
+    // Ramps scale each engine's placements; the shared sources are never written
+    EXPECT_DOUBLE_EQ(source->getScale(), 1.0);
+    EXPECT_DOUBLE_EQ(q1->getFieldSource()->getScale(), 1.0);
+
+    // Deflection follows this engine's scaled field
+    const double px = engine.getParticleSystem().getParticles()[0].getMomentum().x;
+    const double expected = -constants::e * 0.55 * 1.0 * p.getSpeed() * 1e-10;
+    EXPECT_NEAR(px, expected, std::abs(expected) * 1e-3);
+}
+
+TEST_F(PhysicsEngineTest, RetuningTakesEffectAtNextStep) {
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    auto dipole = std::make_shared<accelerator::Dipole>("B1", 1.0, 1.0);
+    acc->addComponent(dipole);
+    acc->computeLattice();
+    engine.setAccelerator(acc);
+    engine.setTimeStep(1e-10);
+
+    auto kick = [&]() {
+        engine.getParticleSystem().clear();
+        Particle p = Particle::proton({0.0, 0.0, 0.0});
+        p.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+        engine.getParticleSystem().addParticle(p);
+        engine.step();
+        return engine.getParticleSystem().getParticles()[0].getMomentum().x;
+    };
+
+    const double nominal = kick();
+    auto source = dipole->getFieldSource();
+
+    // Knob change is picked up without setAccelerator()
+    dipole->setField(2.0);
+    EXPECT_NEAR(kick(), 2.0 * nominal, std::abs(nominal) * 1e-4);
+    EXPECT_EQ(dipole->getFieldSource(), source);
+
+    // A recreated source is swapped into the field manager
+    accelerator::MagnetErrors errors;
+    errors.normal = {100.0};
+    dipole->setErrors(errors);
+    EXPECT_NEAR(kick(), 2.0 * 1.01 * nominal, std::abs(nominal) * 1e-4);
+}
+
+TEST_F(PhysicsEngineTest, SharedComponentFieldActsAtEveryPlace) {
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    auto dipole = std::make_shared<accelerator::Dipole>("B1", 1.0, 1.0);
+    acc->addComponent(dipole);
+    acc->addDrift(2.0);
+    acc->addComponent(dipole);
+    acc->computeLattice();
+    engine.setAccelerator(acc);
+    engine.setTimeStep(1e-10);
+
+    auto kickAt = [&](double z) {
+        engine.getParticleSystem().clear();
+        Particle p = Particle::proton({0.0, 0.0, z});
+        p.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+        engine.getParticleSystem().addParticle(p);
+        engine.step();
+        return engine.getParticleSystem().getParticles()[0].getMomentum().x;
+    };
+
+    const double first = kickAt(0.3);
+    EXPECT_LT(first, 0.0);
+    EXPECT_NEAR(kickAt(3.3), first, std::abs(first) * 1e-9);
+    EXPECT_DOUBLE_EQ(kickAt(1.5), 0.0);
+}
+
+TEST_F(PhysicsEngineTest, DetectorRecordsPlaneCrossing) {
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    acc->addDrift(1.0, "D1");
+    auto detector = std::make_shared<accelerator::Detector>("DET");
+    acc->addComponent(detector);
+    acc->addDrift(1.0, "D2");
+    acc->computeLattice();
+    engine.setAccelerator(acc);
+
+    Particle p = Particle::proton({0.0, 0.0, 0.9});
+    p.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+    engine.getParticleSystem().addParticle(p);
+
+    double dt = 1e-9;
+    engine.setTimeStep(dt);
+    engine.step();
+
+    const auto& hits = detector->getHits();
+    ASSERT_EQ(hits.size(), 1u);
+    EXPECT_EQ(hits[0].particleId, p.getId());
+    EXPECT_NEAR(hits[0].position.z, 1.0, 1e-12);
+
+    // Crossing time is interpolated inside the step
+    double expectedTime = 0.1 / p.getSpeed();
+    EXPECT_NEAR(hits[0].time, expectedTime, 1e-15);
+    EXPECT_GT(hits[0].time, 0.0);
+    EXPECT_LT(hits[0].time, dt);
+}
+
+TEST_F(PhysicsEngineTest, DetectorRecordsEveryTurnInRing) {
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    acc->addDrift(1.0, "D1");
+    auto detector = std::make_shared<accelerator::Detector>("DET");
+    acc->addComponent(detector);
+    acc->addDrift(0.999, "D2");
+    acc->closeRing();
+    engine.setAccelerator(acc);
+
+    Particle p = Particle::proton({0.0, 0.0, 0.5});
+    p.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+    engine.getParticleSystem().addParticle(p);
+
+    // ~0.26 m per step; 40 steps cover ~10 m, i.e. five passes at s = 1
+    engine.setTimeStep(1e-9);
+    for (int i = 0; i < 40; ++i) {
+        engine.step();
+    }
+
+    EXPECT_EQ(detector->getHitCount(), 5u);
+}
+
+TEST_F(PhysicsEngineTest, MonitorRecordsTurnByTurn) {
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    acc->addDrift(1.0, "D1");
+    auto bpm = std::make_shared<accelerator::BeamPositionMonitor>("BPM", 16);
+    acc->addComponent(bpm);
+    acc->addDrift(0.999, "D2");
+    acc->closeRing();
+    engine.setAccelerator(acc);
+
+    Particle p = Particle::proton({0.002, 0.0, 0.5});
+    p.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+    engine.getParticleSystem().addParticle(p);
+
+    engine.setTimeStep(1e-9);
+    for (int i = 0; i < 40; ++i) {
+        engine.step();
+    }
+    bpm->flush();
+
+    ASSERT_EQ(bpm->getTurnCount(), 5u);
+    auto x = bpm->getCentroidSeries(accelerator::TransversePlane::Horizontal);
+    ASSERT_EQ(x.size(), 5u);
+    EXPECT_NEAR(x[4], 0.002, 1e-12);
+}
+
+TEST_F(PhysicsEngineTest, MonitorMeasuresOffsetsFromCurvedOrbit) {
+    Particle p = Particle::proton({0.002, 0.0, 0.5});
+    p.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+    const double rigidity = glm::length(p.getMomentum()) / constants::e;
+
+    // The BPM sits a drift beyond a bend, tens of centimetres off the global z axis
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    acc->addDrift(1.0, "D1");
+    acc->addComponent(std::make_shared<accelerator::Dipole>("B1", 1.0, 1.0));
+    acc->addDrift(1.0, "D2");
+    auto bpm = std::make_shared<accelerator::BeamPositionMonitor>("BPM", 16);
+    acc->addComponent(bpm);
+    acc->addDrift(1.0, "D3");
+    acc->setReferenceRigidity(rigidity);
+    engine.setAccelerator(acc);
+    ASSERT_GT(std::abs(acc->getCompiledLattice().getReferenceFrame(3).origin.x), 0.1);
+
+    engine.getParticleSystem().addParticle(p);
+    engine.setTimeStep(1e-11);
+    for (int i = 0; i < 1200; ++i) {
+        engine.step();
+    }
+    bpm->flush();
+
+    ASSERT_EQ(bpm->getTurnCount(), 1u);
+    auto turn = bpm->getTurn(0);
+    ASSERT_TRUE(turn.has_value());
+    EXPECT_EQ(turn->count, 1u);
+    // Millimetres off the orbit, not the global x of the plane; the bend focuses by a fraction
+    EXPECT_NEAR(turn->meanX, 0.002, 1e-3);
+    EXPECT_NEAR(turn->meanY, 0.0, 1e-9);
+}
+
+TEST_F(PhysicsEngineTest, LocatesParticlesOnOrbitOfCurvedLattice) {
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    acc->addDrift(1.0, "D1");
+    engine.setAccelerator(acc);
+
+    Particle p = Particle::proton({0.0, 0.0, 0.5});
+    p.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+    engine.getParticleSystem().addParticle(p);
+    engine.setTimeStep(1e-11);
+    engine.step();
+    EXPECT_EQ(engine.getOrbitCoordinates().size(), 0u);
+
+    // A bend with a reference rigidity curves the survey, so z is no longer s
+    acc->addComponent(std::make_shared<accelerator::Dipole>("B1", 1.0, 0.1));
+    acc->setReferenceRigidity(10.0);
+    engine.setAccelerator(acc);
+    ASSERT_NE(acc->getCompiledLattice().getAngles()[1], 0.0);
+    Particle outside = Particle::proton({0.2, 0.0, 0.5});
+    outside.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+    engine.getParticleSystem().addParticle(outside);
+    engine.step();
+
+    const OrbitCoordinates& orbit = engine.getOrbitCoordinates();
+    ASSERT_EQ(orbit.size(), 2u);
+    EXPECT_EQ(orbit.getEntries()[0], 0u);
+    EXPECT_NEAR(orbit.getX()[0], 0.0, 1e-9);
+
+    // The particle outside the beam pipe is lost in the first drift
+    const auto& particles = engine.getParticleSystem().getParticles();
+    EXPECT_TRUE(particles[0].isActive());
+    EXPECT_FALSE(particles[1].isActive());
+}
+
+TEST_F(PhysicsEngineTest, KeepsFrameFieldsWhenSourcesUpdateInPlace) {
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    acc->addDrift(1.0, "D1");
+    auto quad = std::make_shared<accelerator::Quadrupole>("Q1", 0.5, 2.0);
+    acc->addComponent(quad);
+    acc->addComponent(std::make_shared<accelerator::Dipole>("B1", 1.0, 0.1));
+    acc->setReferenceRigidity(10.0);
+    engine.setAccelerator(acc);
+
+    Particle p = Particle::proton({0.0, 0.0, 0.5});
+    p.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+    engine.getParticleSystem().addParticle(p);
+    engine.setTimeStep(1e-11);
+    engine.step();
+    ASSERT_EQ(engine.getFrameFields().size(), 3u);
+    const std::vector<std::shared_ptr<FieldSource>> framed = engine.getFrameFields()[1].getSources();
+    ASSERT_FALSE(framed.empty());
+
+    // A new gradient updates the quadrupole's source in place
+    const auto source = quad->getFieldSource();
+    quad->setGradient(3.0);
+    engine.step();
+    ASSERT_EQ(quad->getFieldSource(), source);
+    EXPECT_EQ(engine.getFrameFields()[1].getSources(), framed);
+
+    const glm::dvec3 offset(1e-2, 0.0, 0.25);
+    EXPECT_NEAR(engine.getFrameFields()[1].evaluate(offset, 0.0).B.y, 3.0 * 1e-2, 1e-12);
+    EXPECT_EQ(engine.getOrbitCoordinates().size(), 1u);
+}
+
+TEST_F(PhysicsEngineTest, FramesOnlyNearbySources) {
+    // A ring of 64 bends and drifts
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    for (int i = 0; i < 64; ++i) {
+        acc->addComponent(std::make_shared<accelerator::Dipole>("B", 1.0, 0.1));
+        acc->addDrift(1.0, "D");
+    }
+    acc->setReferenceRigidity(0.1 * 64.0 / (2.0 * constants::pi));
+    acc->closeRing();
+    engine.setAccelerator(acc);
+    engine.setCoordinateMode(CoordinateMode::ReferenceOrbit);
+
+    // Each entry sees the bends next to it, across the start of the ring too
+    const auto& frameFields = engine.getFrameFields();
+    ASSERT_EQ(frameFields.size(), 128u);
+    for (const EMFieldManager& fields : frameFields) {
+        EXPECT_GE(fields.getSourceCount(), 1u);
+        EXPECT_LE(fields.getSourceCount(), 3u);
+    }
+    const auto first = acc->getComponents()[0]->getFieldSource();
+    const auto& last = frameFields[127].getSources();
+    EXPECT_TRUE(std::any_of(last.begin(), last.end(), [&](const std::shared_ptr<FieldSource>& source) {
+        return std::static_pointer_cast<PlacedField>(source)->getSource() == first;
+    }));
+}
+
+TEST_F(PhysicsEngineTest, TracksRelativeToOrbitLikeGlobalOnStraightLattice) {
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    acc->addDrift(0.5, "D1");
+    acc->addComponent(std::make_shared<accelerator::Quadrupole>("QF", 0.5, 2.0));
+    acc->addDrift(0.5, "D2");
+    acc->addComponent(std::make_shared<accelerator::Quadrupole>("QD", 0.5, -2.0));
+    acc->addDrift(2.0, "D3");
+
+    PhysicsEngine orbital;
+    engine.setAccelerator(acc);
+    orbital.setAccelerator(acc);
+    orbital.setCoordinateMode(CoordinateMode::ReferenceOrbit);
+    for (PhysicsEngine* e : {&engine, &orbital}) {
+        e->setTimeStep(1e-11);
+        for (int i = 0; i < 4; ++i) {
+            Particle p = Particle::proton({1e-3 * i, -5e-4 * i, 0.1});
+            p.setKineticEnergy(1e9 * constants::energy::eV, glm::normalize(glm::dvec3(1e-3, 0.0, 1.0)));
+            e->getParticleSystem().addParticle(p);
+        }
+    }
+
+    // Through both quadrupoles and across the entries between them
+    for (int step = 0; step < 1000; ++step) {
+        engine.step();
+        orbital.step();
+    }
+
+    EXPECT_EQ(orbital.getOrbitCoordinates().size(), 4u);
+    const auto& global = engine.getParticleSystem().getParticles();
+    const auto& relative = orbital.getParticleSystem().getParticles();
+    for (size_t i = 0; i < global.size(); ++i) {
+        ASSERT_TRUE(relative[i].isActive());
+        EXPECT_GT(relative[i].getPosition().z, 1.5);
+        EXPECT_NEAR(glm::length(relative[i].getPosition() - global[i].getPosition()), 0.0, 1e-9);
+        EXPECT_NEAR(glm::length(relative[i].getMomentum() - global[i].getMomentum()) /
+                        glm::length(global[i].getMomentum()), 0.0, 1e-9);
+    }
+}
+
+TEST_F(PhysicsEngineTest, TracksCurvedLatticeInEntryFrames) {
+    // Ring of sixteen bends for a 1 GeV proton, with quadrupoles between them;
+    // wide apertures keep the particle and the sagitta of the orbit in the field boxes
+    Particle p = Particle::proton();
+    p.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+    const double rigidity = glm::length(p.getMomentum()) / constants::e;
+    accelerator::Aperture aperture;
+    aperture.radiusX = 0.3;
+    aperture.radiusY = 0.3;
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    for (int i = 0; i < 16; ++i) {
+        acc->addComponent(std::make_shared<accelerator::Dipole>("B", 1.0, rigidity * constants::pi / 8.0,
+                                                                aperture));
+        acc->addComponent(std::make_shared<accelerator::Quadrupole>("Q", 0.3, i % 2 ? -1.0 : 1.0,
+                                                                    aperture));
+    }
+    acc->setReferenceRigidity(rigidity);
+    acc->closeRing();
+    engine.setAccelerator(acc);
+    engine.setTimeStep(1e-11);
+
+    // Three quarters around the ring, a millimetre off the orbit
+    const accelerator::CompiledLattice& lattice = acc->getCompiledLattice();
+    accelerator::OrbitPosition start;
+    start.index = 24;
+    start.x = 1e-3;
+    p.setPosition(lattice.toGlobal(start));
+    p.setKineticEnergy(1e9 * constants::energy::eV,
+                       lattice.getReferenceFrame(24).rotation * glm::dvec3(0.0, 0.0, 1.0));
+    engine.getParticleSystem().addParticle(p);
+
+    // The same fields in global coordinates, pushed directly
+    EMFieldManager fields;
+    for (size_t i = 0; i < lattice.size(); ++i) {
+        const accelerator::Placement frame = lattice.getCenterFrame(i);
+        fields.addSource(std::make_shared<PlacedField>(acc->getComponents()[i]->getFieldSource(),
+                                                       frame.origin, frame.rotation));
+    }
+    BorisIntegrator boris;
+    Particle reference = p;
+
+    // Through a dozen entries and across the start of the ring
+    const double distance = 0.4 * acc->getCircumference();
+    const int steps = static_cast<int>(distance / (glm::length(p.getVelocity()) * 1e-11));
+    engine.step();
+    boris.step(reference, reference.getSpeciesProperties(), fields, 0.0, 1e-11);
+    const OrbitCoordinates& orbit = engine.getOrbitCoordinates();
+    ASSERT_EQ(orbit.size(), 1u);
+    EXPECT_EQ(orbit.getEntries()[0], 24u);
+    const int startTurn = orbit.getTurns()[0];
+    for (int step = 1; step < steps; ++step) {
+        engine.step();
+        boris.step(reference, reference.getSpeciesProperties(), fields, step * 1e-11, 1e-11);
+    }
+
+    EXPECT_EQ(orbit.getTurns()[0], startTurn + 1);
+    EXPECT_LT(orbit.getEntries()[0], 8u);
+    const Particle& tracked = engine.getParticleSystem().getParticles()[0];
+    ASSERT_TRUE(tracked.isActive());
+    EXPECT_NEAR(glm::length(tracked.getPosition() - reference.getPosition()), 0.0, 1e-8);
+    EXPECT_NEAR(glm::length(tracked.getMomentum() - reference.getMomentum()) /
+                    glm::length(reference.getMomentum()), 0.0, 1e-8);
+}
+
+TEST_F(PhysicsEngineTest, ReducedPrecisionTracksCloseToDouble) {
+    // A turn of a 40 m FODO ring, a few millimetres off the orbit
+    Particle p = Particle::proton();
+    p.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+    const double brho = glm::length(p.getMomentum()) / constants::e;
+    accelerator::Aperture aperture;
+    aperture.radiusX = 0.05;
+    aperture.radiusY = 0.05;
+    auto acc = pas::tests::makeFODORing(2.0, 4, brho, aperture);
+    const int frames = static_cast<int>(acc->getCircumference() / glm::length(p.getVelocity()) / 1e-8) + 1;
+
+    auto track = [&](IntegratorFactory::Type type, Precision precision) {
+        PhysicsEngine tracker;
+        tracker.setAccelerator(acc);
+        tracker.setIntegrator(type);
+        tracker.setPrecision(precision);
+        tracker.setCoordinateMode(CoordinateMode::ReferenceOrbit);
+        tracker.setTimeStep(1e-11);
+        tracker.setTimeScale(1.0);
+        tracker.setMaxStepsPerFrame(1000);
+        tracker.start();
+        for (int i = 0; i < 4; ++i) {
+            Particle particle = p;
+            particle.setPosition(glm::dvec3(1e-3 * i, 2e-3 - 1e-3 * i, 0.5));
+            particle.setMomentum(p.getMomentum() + glm::dvec3(1e-3, -5e-4, 0.0) * glm::length(p.getMomentum()));
+            tracker.getParticleSystem().addParticle(particle);
+        }
+
+        // 1000 steps per frame
+        for (int frame = 0; frame < frames; ++frame) {
+            tracker.update(1e-8 + 1e-20);
+        }
+        EXPECT_EQ(tracker.getStats().stepCount, static_cast<uint64_t>(frames) * 1000);
+        EXPECT_EQ(tracker.getFloatOrbitCoordinates().size(), precision == Precision::Float ? 4u : 0u);
+        return tracker.getParticleSystem().getParticles();
+    };
+
+    for (IntegratorFactory::Type type : {IntegratorFactory::Type::Boris, IntegratorFactory::Type::RK4}) {
+        const std::vector<Particle> reference = track(type, Precision::Double);
+        const std::vector<Particle> single = track(type, Precision::Float);
+        const std::vector<Particle> mixed = track(type, Precision::Mixed);
+        for (size_t i = 0; i < reference.size(); ++i) {
+            ASSERT_TRUE(reference[i].isActive());
+            ASSERT_TRUE(single[i].isActive());
+            ASSERT_TRUE(mixed[i].isActive());
+            const double momentum = glm::length(reference[i].getMomentum());
+            const glm::dvec3 f = single[i].getPosition() - reference[i].getPosition();
+            const glm::dvec3 m = mixed[i].getPosition() - reference[i].getPosition();
+
+            // Float rounding of z within an entry adds up to ~0.3 mm over the turn, enough to
+            // move a quadrupole edge by a step; Mixed accumulates in double and stays close
+            EXPECT_LT(std::hypot(f.x, f.y), 5e-4);
+            EXPECT_LT(std::abs(f.z), 1e-3);
+            EXPECT_LT(glm::length(single[i].getMomentum() - reference[i].getMomentum()) / momentum, 1e-4);
+            EXPECT_LT(std::hypot(m.x, m.y), 1e-7);
+            EXPECT_LT(std::abs(m.z), 2e-5);
+            EXPECT_LT(glm::length(mixed[i].getMomentum() - reference[i].getMomentum()) / momentum, 1e-5);
+        }
+    }
+}
+
+TEST_F(PhysicsEngineTest, UpdateLoadsOrbitCoordinatesOncePerFrame) {
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    acc->addComponent(std::make_shared<accelerator::Quadrupole>("QF", 0.5, 2.0));
+    acc->addDrift(2.0, "D1");
+    PhysicsEngine stepped;
+    for (PhysicsEngine* e : {&engine, &stepped}) {
+        e->setAccelerator(acc);
+        e->setCoordinateMode(CoordinateMode::ReferenceOrbit);
+        e->setTimeStep(1e-11);
+        e->setTimeScale(1e-9);
+        e->start();
+        Particle p = Particle::proton({1e-3, 0.0, 0.1});
+        p.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+        e->getParticleSystem().addParticle(p);
+    }
+
+    // One frame of 50 steps against 50 single steps
+    engine.update(5.05e-1);
+    for (int step = 0; step < 50; ++step) {
+        stepped.step();
+    }
+    ASSERT_EQ(engine.getStats().stepCount, 50u);
+
+    const Particle& batched = engine.getParticleSystem().getParticles()[0];
+    const Particle& single = stepped.getParticleSystem().getParticles()[0];
+    EXPECT_GT(batched.getPosition().z, 0.1);
+    EXPECT_NEAR(glm::length(batched.getPosition() - single.getPosition()), 0.0, 1e-12);
+    EXPECT_NEAR(glm::length(batched.getMomentum() - single.getMomentum()) /
+                    glm::length(single.getMomentum()), 0.0, 1e-12);
+}
+
+TEST_F(PhysicsEngineTest, StepsEachSpeciesBlockWithItsOwnConstants) {
+    auto acc = std::make_shared<accelerator::Accelerator>();
+    acc->addComponent(std::make_shared<accelerator::Dipole>("B1", 1.0, 0.1));
+    acc->computeLattice();
+    engine.setAccelerator(acc);
+    engine.setTimeStep(1e-11);
+
+    // Proton, electron, proton: three blocks
+    Particle proton = Particle::proton({0.0, 0.0, 0.5});
+    proton.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+    Particle electron = Particle::electron({0.0, 0.0, 0.5});
+    electron.setKineticEnergy(1e9 * constants::energy::eV, {0, 0, 1});
+    engine.getParticleSystem().addParticle(proton);
+    engine.getParticleSystem().addParticle(electron);
+    engine.getParticleSystem().addParticle(proton);
+    ASSERT_EQ(engine.getParticleSystem().getSpeciesBlocks().size(), 3u);
+    engine.step();
+
+    // Opposite charges are kicked opposite ways; the protons agree
+    const auto& particles = engine.getParticleSystem().getParticles();
+    EXPECT_LT(particles[0].getMomentum().x, 0.0);
+    EXPECT_GT(particles[1].getMomentum().x, 0.0);
+    EXPECT_DOUBLE_EQ(particles[2].getMomentum().x, particles[0].getMomentum().x);
 }
 
 TEST_F(PhysicsEngineTest, SimulationStats) {
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "physics/Species.hpp"
+#include "physics/Particle.hpp"
+#include "physics/Integrator.hpp"
+
+namespace pas::physics::tests {
+
+using namespace constants;
+
+TEST(SpeciesTest, BuiltinSpeciesHavePrecomputedConstants) {
+    const Species& proton = SpeciesTable::get(SpeciesTable::PROTON);
+    EXPECT_DOUBLE_EQ(proton.mass, m_p);
+    EXPECT_DOUBLE_EQ(proton.charge, e);
+    EXPECT_DOUBLE_EQ(proton.chargeOverMass, e / m_p);
+    EXPECT_DOUBLE_EQ(proton.massTimesC, m_p * c);
+    EXPECT_DOUBLE_EQ(proton.restEnergy, m_p * c2);
+
+    EXPECT_DOUBLE_EQ(SpeciesTable::get(SpeciesTable::ELECTRON).charge, -e);
+    EXPECT_DOUBLE_EQ(SpeciesTable::get(SpeciesTable::ANTIPROTON).charge, -e);
+    EXPECT_EQ(SpeciesTable::find(m_e, e), SpeciesTable::POSITRON);
+}
+
+TEST(SpeciesTest, RegistersNewSpeciesOnce) {
+    // Alpha particle
+    const double mass = 6.6446573357e-27;
+    const size_t before = SpeciesTable::size();
+    const SpeciesId alpha = SpeciesTable::find(mass, 2.0 * e);
+    EXPECT_GE(alpha, 4u);
+    EXPECT_EQ(SpeciesTable::find(mass, 2.0 * e), alpha);
+    EXPECT_LE(SpeciesTable::size(), before + 1);
+
+    Particle p(mass, 2.0 * e);
+    EXPECT_EQ(p.getSpecies(), alpha);
+    EXPECT_DOUBLE_EQ(p.getMass(), mass);
+    EXPECT_DOUBLE_EQ(p.getSpeciesProperties().chargeOverMass, 2.0 * e / mass);
+    EXPECT_EQ(Particle(m_p, e).getSpecies(), SpeciesTable::PROTON);
+}
+
+TEST(SpeciesTest, FullTableRejectsNewSpecies) {
+    // Filling the process-wide table would break later tests, so do it in a child process
+    EXPECT_EXIT({
+        for (size_t i = SpeciesTable::size(); i < SpeciesTable::CAPACITY; ++i) {
+            SpeciesTable::find(m_p * static_cast<double>(i + 1000), e);
+        }
+        try {
+            Particle p(m_p * 999.0, e);
+        } catch (const std::length_error&) {
+            std::exit(0);
+        }
+        std::exit(1);
+    }, ::testing::ExitedWithCode(0), "");
+}
+
+TEST(SpeciesTest, ConcurrentRegistrationAgrees) {
+    // Deuteron-like species registered from several threads at once
+    const double mass = 3.3435837768e-27;
+    std::vector<SpeciesId> ids(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        threads.emplace_back([&ids, i, mass] { ids[i] = SpeciesTable::find(mass, e); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (SpeciesId id : ids) {
+        EXPECT_EQ(id, ids[0]);
+    }
+    EXPECT_DOUBLE_EQ(SpeciesTable::get(ids[0]).mass, mass);
+}
+
+TEST(SpeciesTest, HoistedSpeciesStepMatchesLookup) {
+    EMFieldManager manager;
+    manager.addSource(std::make_shared<UniformBField>(glm::dvec3(0.0, 0.0, 1.0)));
+
+    Particle a = Particle::electron();
+    a.setKineticEnergy(1.0 * energy::MeV, glm::dvec3(1.0, 0.0, 0.0));
+    Particle b = a;
+
+    BorisIntegrator integrator;
+    const Species& species = SpeciesTable::get(SpeciesTable::ELECTRON);
+    for (int i = 0; i < 100; ++i) {
+        integrator.step(a, manager, i * 1e-13, 1e-13);
+        integrator.step(b, species, manager, i * 1e-13, 1e-13);
+    }
+    EXPECT_EQ(a.getPosition(), b.getPosition());
+    EXPECT_EQ(a.getMomentum(), b.getMomentum());
+}
+
+} // namespace pas::physics::tests
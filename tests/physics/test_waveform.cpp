@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+#include "physics/Waveform.hpp"
+
+namespace pas::physics::tests {
+
+TEST(WaveformTest, EmptyWaveformIsNominal) {
+    Waveform waveform;
+    EXPECT_TRUE(waveform.isEmpty());
+    EXPECT_DOUBLE_EQ(waveform.evaluate(0.3), 1.0);
+}
+
+TEST(WaveformTest, LinearInterpolationHoldsEnds) {
+    Waveform ramp({0.0, 1.0, 3.0}, {1.0, 2.0, 0.0});
+    EXPECT_EQ(ramp.getPointCount(), 3u);
+    EXPECT_DOUBLE_EQ(ramp.getStartTime(), 0.0);
+    EXPECT_DOUBLE_EQ(ramp.getEndTime(), 3.0);
+
+    EXPECT_DOUBLE_EQ(ramp.evaluate(0.5), 1.5);
+    EXPECT_DOUBLE_EQ(ramp.evaluate(1.0), 2.0);
+    EXPECT_DOUBLE_EQ(ramp.evaluate(2.0), 1.0);
+    EXPECT_DOUBLE_EQ(ramp.evaluate(-1.0), 1.0);
+    EXPECT_DOUBLE_EQ(ramp.evaluate(10.0), 0.0);
+}
+
+TEST(WaveformTest, SplineIsSmoothAndExactForLines) {
+    // A straight line is reproduced exactly by the natural spline
+    Waveform line({0.0, 0.5, 2.0, 3.0}, {1.0, 2.0, 5.0, 7.0}, Waveform::Interpolation::CubicSpline);
+    EXPECT_NEAR(line.evaluate(1.25), 3.5, 1e-12);
+
+    std::vector<double> times;
+    std::vector<double> values;
+    for (int i = 0; i <= 20; ++i) {
+        times.push_back(0.1 * i);
+        values.push_back(std::sin(times.back()));
+    }
+    Waveform spline(times, values, Waveform::Interpolation::CubicSpline);
+    Waveform linear(times, values);
+    for (double t : {0.05, 0.77, 1.33, 1.91}) {
+        EXPECT_NEAR(spline.evaluate(t), std::sin(t), 2e-4);
+        EXPECT_LT(std::abs(spline.evaluate(t) - std::sin(t)),
+                  std::abs(linear.evaluate(t) - std::sin(t)));
+    }
+    EXPECT_EQ(interpolationToString(spline.getInterpolation()), "spline");
+}
+
+TEST(WaveformTest, InvalidTableIsRejected) {
+    Waveform mismatched({0.0, 1.0}, {1.0});
+    EXPECT_TRUE(mismatched.isEmpty());
+
+    Waveform unordered({0.0, 2.0, 1.0}, {1.0, 2.0, 3.0});
+    EXPECT_TRUE(unordered.isEmpty());
+    EXPECT_DOUBLE_EQ(unordered.evaluate(1.0), 1.0);
+}
+
+} // namespace pas::physics::tests
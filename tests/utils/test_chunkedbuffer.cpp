@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include "utils/ChunkedBuffer.hpp"
+
+namespace pas::utils::tests {
+
+using SmallBuffer = ChunkedBuffer<int, 4>;
+
+TEST(ChunkedBufferTest, StartsEmpty) {
+    SmallBuffer buffer;
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer.size(), 0u);
+    EXPECT_EQ(buffer.getChunkCount(), 0u);
+}
+
+TEST(ChunkedBufferTest, AllocatesChunksAsNeeded) {
+    SmallBuffer buffer;
+    for (int i = 0; i < 9; ++i) {
+        buffer.push_back(i);
+    }
+    EXPECT_EQ(buffer.size(), 9u);
+    EXPECT_EQ(buffer.getChunkCount(), 3u);
+}
+
+TEST(ChunkedBufferTest, ForEachChunkPreservesOrder) {
+    SmallBuffer buffer;
+    for (int i = 0; i < 6; ++i) {
+        buffer.push_back(i);
+    }
+
+    std::vector<int> values;
+    buffer.forEachChunk([&values](std::span<const int> chunk) {
+        values.insert(values.end(), chunk.begin(), chunk.end());
+    });
+    EXPECT_EQ(values, (std::vector<int>{0, 1, 2, 3, 4, 5}));
+}
+
+TEST(ChunkedBufferTest, DrainFullChunksKeepsTail) {
+    SmallBuffer buffer;
+    for (int i = 0; i < 10; ++i) {
+        buffer.push_back(i);
+    }
+
+    std::vector<int> drained;
+    size_t released = buffer.drainFullChunks([&drained](std::span<const int> chunk) {
+        drained.insert(drained.end(), chunk.begin(), chunk.end());
+    });
+
+    EXPECT_EQ(released, 8u);
+    EXPECT_EQ(drained.size(), 8u);
+    EXPECT_EQ(buffer.size(), 2u);
+    EXPECT_EQ(buffer.getChunkCount(), 1u);
+}
+
+TEST(ChunkedBufferTest, MoveIntoEmptiesBuffer) {
+    SmallBuffer buffer;
+    for (int i = 0; i < 5; ++i) {
+        buffer.push_back(i);
+    }
+
+    std::vector<int> out = {-1};
+    buffer.moveInto(out);
+
+    EXPECT_EQ(out, (std::vector<int>{-1, 0, 1, 2, 3, 4}));
+    EXPECT_TRUE(buffer.empty());
+}
+
+} // namespace pas::utils::tests
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include "utils/MappedFile.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace pas::utils::tests {
+
+TEST(MappedFileTest, DefaultIsClosed) {
+    MappedFile file;
+    EXPECT_FALSE(file.isOpen());
+    EXPECT_EQ(file.size(), 0u);
+    EXPECT_EQ(file.data(), nullptr);
+}
+
+TEST(MappedFileTest, CreateAndReadBack) {
+    std::string path = ::testing::TempDir() + "pas_mapped_rw.bin";
+    {
+        MappedFile writer;
+        ASSERT_TRUE(writer.create(path, 16));
+        EXPECT_TRUE(writer.isWritable());
+        EXPECT_EQ(writer.size(), 16u);
+        std::memcpy(writer.data(), "mapped file data", 16);
+
+        // A second mapping sees the writes without a flush
+        MappedFile reader;
+        ASSERT_TRUE(reader.openReadOnly(path));
+        EXPECT_FALSE(reader.isWritable());
+        EXPECT_EQ(reader.view(), "mapped file data");
+    }
+
+    MappedFile reader;
+    ASSERT_TRUE(reader.openReadOnly(path));
+    EXPECT_EQ(reader.view(), "mapped file data");
+    reader.close();
+    EXPECT_FALSE(reader.isOpen());
+    std::remove(path.c_str());
+}
+
+TEST(MappedFileTest, MissingOrEmptyFileFails) {
+    MappedFile file;
+    EXPECT_FALSE(file.openReadOnly(::testing::TempDir() + "pas_mapped_missing.bin"));
+
+    std::string path = ::testing::TempDir() + "pas_mapped_empty.bin";
+    std::ofstream(path).close();
+    EXPECT_FALSE(file.openReadOnly(path));
+    EXPECT_FALSE(file.create(path, 0));
+    std::remove(path.c_str());
+}
+
+TEST(MappedFileTest, MoveTransfersOwnership) {
+    std::string path = ::testing::TempDir() + "pas_mapped_move.bin";
+    MappedFile a;
+    ASSERT_TRUE(a.create(path, 8));
+
+    MappedFile b(std::move(a));
+    EXPECT_FALSE(a.isOpen());
+    EXPECT_TRUE(b.isOpen());
+    EXPECT_EQ(b.size(), 8u);
+    EXPECT_EQ(b.getPath(), path);
+    b.close();
+    std::remove(path.c_str());
+}
+
+} // namespace pas::utils::tests
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <future>
+#include <vector>
+
+#include "utils/ThreadPool.hpp"
+#include "utils/Parallel.hpp"
+
+namespace pas::utils::tests {
+
+TEST(ThreadPoolTest, DefaultsToAvailableThreads) {
+    ThreadPool pool;
+    EXPECT_EQ(pool.getThreadCount(), static_cast<size_t>(getMaxThreads()));
+}
+
+TEST(ThreadPoolTest, FuturesReturnResults) {
+    ThreadPool pool(3);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 20; ++i) {
+        results.push_back(pool.submit([i]() { return i * i; }));
+    }
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(results[i].get(), i * i);
+    }
+}
+
+TEST(ThreadPoolTest, WaitRunsAllTasks) {
+    std::atomic<int> count{0};
+    ThreadPool pool(2);
+    for (int i = 0; i < 100; ++i) {
+        pool.submit([&count]() { count++; });
+    }
+    pool.wait();
+    EXPECT_EQ(count.load(), 100);
+}
+
+TEST(ThreadPoolTest, TasksSeeInnerThreadLimit) {
+    ThreadPool pool(2, 1);
+    EXPECT_EQ(pool.submit([]() { return getMaxThreads(); }).get(), 1);
+}
+
+TEST(ThreadPoolTest, DestructorFinishesQueuedTasks) {
+    std::atomic<int> count{0};
+    {
+        ThreadPool pool(1);
+        for (int i = 0; i < 10; ++i) {
+            pool.submit([&count]() { count++; });
+        }
+    }
+    EXPECT_EQ(count.load(), 10);
+}
+
+} // namespace pas::utils::tests